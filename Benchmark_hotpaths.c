@@ -0,0 +1,487 @@
+// Microbenchmark program for the Rawsock_lib hot paths
+// Rawsock_lib, licensed under GPLv2
+
+/*
+	This program measures the cost of the functions which are called for every packet sent or received through the Rawsock library: the IPv4 and
+	UDP checksums, the encapsulation of the UDP, IPv4 and Ethernet headers, the checksum validation, the checksum path of rawLampSend() and the
+	parsing of received packets (UDPgetpacketpointers() and lampHeadGetData()).
+
+	Each function is called in a tight loop, over a UDP/LaMP frame built in memory, for several payload sizes and for several alignments of the
+	frame buffer (0 to 3 bytes after a cache line boundary). The number of iterations is chosen so that each measurement lasts about the target time,
+	split in several runs, of which the fastest one is reported.
+	For each measurement, the program prints the time per call, in nanoseconds, and the throughput, in GB/s, over the bytes actually read or written
+	by the function. When the "-p" option is specified, the CPU cycles and the instructions executed per call are also read through perf_event_open()
+	(this requires /proc/sys/kernel/perf_event_paranoid to be 2 or less, and it is silently skipped when the counters are not available).
+
+	The checksum path of rawLampSend() and rawLampSendIncr() is measured without sending anything: lampFinalize(), which they call before
+	sendto() (applying the end flag, setting the LaMP timestamp and computing again, or incrementally updating, the UDP checksum), is called
+	directly, so that no system call is included in the reported numbers.
+
+	No network interface and no special privilege are needed: the numbers can thus be compared before and after a change, to decide which
+	optimizations matter and to catch performance regressions.
+
+	This program accepts as (optional) arguments: "-t <ms>" to set the target time of each measurement (default: 200 ms), "-p" to read the
+	hardware performance counters and "-c" to print the results in CSV format, instead of an aligned table.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "Rawsock_lib/rawsock.h"
+#include "Rawsock_lib/rawsock_lamp.h"
+#include "Rawsock_lib/rawsock_clock.h"
+#include "Rawsock_lib/ipcsum_alth.h"
+#include "Rawsock_lib/minirighi_udp_checksum.h"
+
+#define DEFAULT_TARGET_MS 200 // Default target time, in ms, of each measurement
+#define CALIB_ITERATIONS 1000 // Initial number of iterations used to estimate the cost of each function
+#define REPEATS 5 // Number of runs of each measurement (the fastest one is reported, to filter out interrupts and other noise)
+#define BUF_SIZE 4096 // Size of each frame buffer (it must be larger than the largest frame plus the largest alignment offset)
+#define MAX_LAMP_PAYLOAD (1472-sizeof(struct lamphdr)) // Largest LaMP payload fitting inside a standard 1500 B MTU
+
+#define SRCPORT 46772 // UDP source port of the test frame
+#define DSTPORT 46773 // UDP destination port of the test frame
+
+// LaMP payload sizes (the UDP payload is the LaMP header plus the LaMP payload)
+static const size_t payloadsizes[]={0,64,256,512,1024,MAX_LAMP_PAYLOAD};
+// Offsets of the frame buffers from a cache line boundary
+static const size_t alignments[]={0,1,2,3};
+
+// Buffers and headers used by the benchmarked functions
+struct benchctx {
+	byte_t *frame; // Complete and valid UDP/LaMP frame, never modified (except for the fields updated by the rawLampSend() checksum path)
+	byte_t *scratch; // Buffer in which the encapsulation functions write their output
+	byte_t *data; // Source payload (UDP payload, i.e. LaMP header plus LaMP payload)
+	byte_t *out; // Output buffer of lampHeadGetData()
+	size_t payloadsize; // LaMP payload size
+	size_t udppayloadsize; // UDP payload size
+	size_t framesize; // Size of the whole frame
+	struct ether_header etherHeader;
+	struct iphdr IPheader;
+	struct udphdr udpHeader;
+	struct ipaddrs addrs;
+	struct lamphdr *lampHeader; // LaMP header inside 'frame'
+	csum16_t udpcsum; // Valid UDP checksum of 'frame'
+	csum16_t ipcsum; // Valid IPv4 checksum of 'frame'
+	volatile uintptr_t sink; // Results of the benchmarked functions are stored here, so that the calls cannot be optimized out
+};
+
+// Each benchmark calls the function under test once, and it returns the number of bytes read or written by it
+typedef size_t (*benchfn_t)(struct benchctx *ctx);
+
+struct bench {
+	const char *name;
+	benchfn_t fn;
+	bool sized; // false if the cost does not depend on the payload size (the benchmark is then run only once per alignment)
+};
+
+// Result of a single measurement
+struct benchres {
+	double ns; // ns per call
+	double cycles; // CPU cycles per call (or a negative value if not available)
+	double instructions; // Instructions per call (or a negative value if not available)
+};
+
+// perf_event_open() counters (group leader: cycles)
+static int perf_cycles_fd=-1;
+static int perf_instr_fd=-1;
+
+static size_t bench_ip_fast_csum(struct benchctx *ctx) {
+	ctx->sink+=ip_fast_csum(ctx->frame+sizeof(struct ether_header),5);
+	return sizeof(struct iphdr);
+}
+
+static size_t bench_minirighi_udp_checksum(struct benchctx *ctx) {
+	ctx->sink+=minirighi_udp_checksum(ctx->frame+sizeof(struct ether_header)+sizeof(struct iphdr),sizeof(struct udphdr)+ctx->udppayloadsize,ctx->addrs.src,ctx->addrs.dst);
+	return sizeof(struct udphdr)+ctx->udppayloadsize;
+}
+
+static size_t bench_UDPencapsulate(struct benchctx *ctx) {
+	ctx->sink+=UDPencapsulate(ctx->scratch,&ctx->udpHeader,ctx->data,ctx->udppayloadsize,ctx->addrs);
+	return ctx->udppayloadsize;
+}
+
+static size_t bench_IP4Encapsulate(struct benchctx *ctx) {
+	size_t sdusize=sizeof(struct udphdr)+ctx->udppayloadsize;
+
+	ctx->sink+=IP4Encapsulate(ctx->scratch,&ctx->IPheader,ctx->frame+sizeof(struct ether_header)+sizeof(struct iphdr),sdusize);
+	return sizeof(struct iphdr)+sdusize;
+}
+
+static size_t bench_etherEncapsulate(struct benchctx *ctx) {
+	size_t sdusize=ctx->framesize-sizeof(struct ether_header);
+
+	ctx->sink+=etherEncapsulate(ctx->scratch,&ctx->etherHeader,ctx->frame+sizeof(struct ether_header),sdusize);
+	return ctx->framesize;
+}
+
+static size_t bench_validateEthCsum(struct benchctx *ctx) {
+	csum16_t ipcsum=ctx->ipcsum;
+
+	ctx->sink+=validateEthCsum(ctx->frame,ctx->udpcsum,&ipcsum,CSUM_UDPIP,&ctx->udppayloadsize);
+	return sizeof(struct iphdr)+sizeof(struct udphdr)+ctx->udppayloadsize;
+}
+
+// Checksum path of rawLampSend(): the packet is finalized as rawLampSend() does before calling sendto(), computing again the UDP checksum over the whole UDP packet
+static size_t bench_rawLampSend(struct benchctx *ctx) {
+	struct udphdr *udpHeader=(struct udphdr *) ((byte_t *) ctx->lampHeader-sizeof(struct udphdr));
+
+	lampFinalize(ctx->lampHeader,FLG_CONTINUE,UDP,false,NULL,NULL);
+	ctx->sink+=udpHeader->check;
+	return sizeof(struct udphdr)+ctx->udppayloadsize;
+}
+
+// Checksum path of rawLampSendIncr(): the packet is finalized as rawLampSendIncr() does before calling sendto(), incrementally updating the UDP checksum
+static size_t bench_rawLampSendIncr(struct benchctx *ctx) {
+	struct udphdr *udpHeader=(struct udphdr *) ((byte_t *) ctx->lampHeader-sizeof(struct udphdr));
+
+	lampFinalize(ctx->lampHeader,FLG_CONTINUE,UDP,true,NULL,NULL);
+	ctx->sink+=udpHeader->check;
+	// The payload is never read: the checksum is only patched
+	return 0;
+}
+
+static size_t bench_lampHeadGetData(struct benchctx *ctx) {
+	lamptype_t type;
+	unsigned short id, seq, len;
+	struct timeval tv;
+
+	lampHeadGetData((byte_t *) ctx->lampHeader,&type,&id,&seq,&len,&tv,ctx->out);
+	ctx->sink+=type+id+seq+len+tv.tv_usec;
+	return sizeof(struct lamphdr)+ctx->payloadsize;
+}
+
+static size_t bench_UDPgetpacketpointers(struct benchctx *ctx) {
+	struct ether_header *etherHeader;
+	struct iphdr *IPheader;
+	struct udphdr *udpHeader;
+
+	ctx->sink+=(uintptr_t) UDPgetpacketpointers(ctx->frame,&etherHeader,&IPheader,&udpHeader)+(uintptr_t) udpHeader;
+	return 0;
+}
+
+static const struct bench benches[]={
+	{"ip_fast_csum",bench_ip_fast_csum,false},
+	{"minirighi_udp_checksum",bench_minirighi_udp_checksum,true},
+	{"UDPencapsulate",bench_UDPencapsulate,true},
+	{"IP4Encapsulate",bench_IP4Encapsulate,true},
+	{"etherEncapsulate",bench_etherEncapsulate,true},
+	{"validateEthCsum(CSUM_UDPIP)",bench_validateEthCsum,true},
+	{"rawLampSend csum path",bench_rawLampSend,true},
+	{"rawLampSendIncr csum path",bench_rawLampSendIncr,true},
+	{"lampHeadGetData",bench_lampHeadGetData,true},
+	{"UDPgetpacketpointers",bench_UDPgetpacketpointers,false},
+};
+
+// Open a hardware counter, counting user space only, for the calling thread
+static int perfOpen(uint64_t config, int group_fd) {
+	struct perf_event_attr attr;
+
+	memset(&attr,0,sizeof(attr));
+	attr.type=PERF_TYPE_HARDWARE;
+	attr.size=sizeof(attr);
+	attr.config=config;
+	attr.disabled=(group_fd==-1);
+	attr.exclude_kernel=1;
+	attr.exclude_hv=1;
+	attr.read_format=PERF_FORMAT_GROUP;
+
+	return syscall(SYS_perf_event_open,&attr,0,-1,group_fd,0);
+}
+
+static bool perfInit(void) {
+	perf_cycles_fd=perfOpen(PERF_COUNT_HW_CPU_CYCLES,-1);
+	if(perf_cycles_fd<0) {
+		return false;
+	}
+
+	perf_instr_fd=perfOpen(PERF_COUNT_HW_INSTRUCTIONS,perf_cycles_fd);
+	if(perf_instr_fd<0) {
+		close(perf_cycles_fd);
+		perf_cycles_fd=-1;
+		return false;
+	}
+
+	return true;
+}
+
+// Read the cycles and instructions counted since the group was last reset
+static bool perfRead(uint64_t *cycles, uint64_t *instructions) {
+	struct {
+		uint64_t nr;
+		uint64_t values[2];
+	} data;
+
+	if(read(perf_cycles_fd,&data,sizeof(data))!=sizeof(data) || data.nr!=2) {
+		return false;
+	}
+
+	*cycles=data.values[0];
+	*instructions=data.values[1];
+
+	return true;
+}
+
+static void benchLoop(const struct bench *b, struct benchctx *ctx, uint64_t iterations) {
+	uint64_t i;
+
+	for(i=0;i<iterations;i++) {
+		b->fn(ctx);
+		// Compiler barrier: each call must actually be performed, and not merged with the following one
+		__asm__ volatile("" ::: "memory");
+	}
+}
+
+// Run the function under test for about 'target_ns' and compute the cost of a single call
+static void benchMeasureOnce(const struct bench *b, struct benchctx *ctx, struct rsclock *clk, uint64_t target_ns, struct benchres *res) {
+	uint64_t iterations=CALIB_ITERATIONS;
+	uint64_t start, elapsed;
+	uint64_t cycles, instructions;
+
+	// Warm up the caches and estimate the number of iterations needed to last about 'target_ns'
+	while(1) {
+		start=rsclockNowNs(clk);
+		benchLoop(b,ctx,iterations);
+		elapsed=rsclockNowNs(clk)-start;
+
+		if(elapsed>=target_ns/8) {
+			break;
+		}
+
+		iterations*=2;
+	}
+
+	iterations=(uint64_t) ((double) iterations*target_ns/elapsed);
+	if(iterations==0) {
+		iterations=1;
+	}
+
+	if(perf_cycles_fd>=0) {
+		ioctl(perf_cycles_fd,PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+		ioctl(perf_cycles_fd,PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+	}
+
+	start=rsclockNowNs(clk);
+	benchLoop(b,ctx,iterations);
+	elapsed=rsclockNowNs(clk)-start;
+
+	res->ns=(double) elapsed/iterations;
+	res->cycles=-1;
+	res->instructions=-1;
+
+	if(perf_cycles_fd>=0) {
+		ioctl(perf_cycles_fd,PERF_EVENT_IOC_DISABLE,PERF_IOC_FLAG_GROUP);
+
+		if(perfRead(&cycles,&instructions)) {
+			res->cycles=(double) cycles/iterations;
+			res->instructions=(double) instructions/iterations;
+		}
+	}
+}
+
+// Measure the cost of a single call of the function under test, keeping the fastest of REPEATS runs, lasting 'target_ns' in total
+static void benchMeasure(const struct bench *b, struct benchctx *ctx, struct rsclock *clk, uint64_t target_ns, struct benchres *res) {
+	struct benchres curr;
+	unsigned int i;
+
+	benchMeasureOnce(b,ctx,clk,target_ns/REPEATS,res);
+
+	for(i=1;i<REPEATS;i++) {
+		benchMeasureOnce(b,ctx,clk,target_ns/REPEATS,&curr);
+
+		if(curr.ns<res->ns) {
+			*res=curr;
+		}
+	}
+}
+
+// Build a complete UDP/LaMP frame inside 'ctx->frame', with a LaMP payload of 'payloadsize' bytes
+static void benchPrepareFrame(struct benchctx *ctx, size_t payloadsize) {
+	struct lamphdr lampHeader;
+	byte_t lamppacket[sizeof(struct lamphdr)+MAX_LAMP_PAYLOAD];
+	byte_t udppacket[sizeof(struct udphdr)+sizeof(lamppacket)];
+	byte_t ippacket[sizeof(struct iphdr)+sizeof(udppacket)];
+	size_t i, udpsize, ipsize;
+
+	ctx->payloadsize=payloadsize;
+	ctx->udppayloadsize=sizeof(struct lamphdr)+payloadsize;
+
+	for(i=0;i<payloadsize;i++) {
+		lamppacket[sizeof(struct lamphdr)+i]=(byte_t) i;
+	}
+
+	lampHeadPopulate(&lampHeader,CTRL_UNIDIR_CONTINUE,0x1234,0);
+	lampHeadSetTimestamp(&lampHeader,NULL);
+	lampEncapsulate(lamppacket,&lampHeader,lamppacket+sizeof(struct lamphdr),payloadsize);
+	memcpy(ctx->data,lamppacket,ctx->udppayloadsize);
+
+	udpsize=UDPencapsulate(udppacket,&ctx->udpHeader,lamppacket,ctx->udppayloadsize,ctx->addrs);
+	ipsize=IP4Encapsulate(ippacket,&ctx->IPheader,udppacket,udpsize);
+	ctx->framesize=etherEncapsulate(ctx->frame,&ctx->etherHeader,ippacket,ipsize);
+
+	ctx->lampHeader=(struct lamphdr *) (ctx->frame+sizeof(struct ether_header)+sizeof(struct iphdr)+sizeof(struct udphdr));
+	ctx->udpcsum=((struct udphdr *) (ctx->frame+sizeof(struct ether_header)+sizeof(struct iphdr)))->check;
+	ctx->ipcsum=((struct iphdr *) (ctx->frame+sizeof(struct ether_header)))->check;
+}
+
+static void printHeader(bool csv, bool perf) {
+	if(csv) {
+		fprintf(stdout,"function,payload_size,alignment,ns_per_call,gb_per_s%s\n",perf ? ",cycles_per_call,instructions_per_call,ipc" : "");
+	} else {
+		fprintf(stdout,"%-30s %8s %5s %10s %8s",
+			"Function","Payload","Align","ns/call","GB/s");
+		if(perf) {
+			fprintf(stdout," %10s %10s %6s","cycles","instr","IPC");
+		}
+		fprintf(stdout,"\n");
+	}
+}
+
+static void printResult(bool csv, const char *name, long payloadsize, size_t align, struct benchres *res, size_t bytes, bool perf) {
+	double gbps=res->ns>0 ? bytes/res->ns : 0; // bytes per ns = GB/s
+
+	if(csv) {
+		fprintf(stdout,"%s,%ld,%zu,%.3f,%.3f",name,payloadsize,align,res->ns,gbps);
+		if(perf) {
+			fprintf(stdout,",%.1f,%.1f,%.2f",res->cycles,res->instructions,res->cycles>0 ? res->instructions/res->cycles : 0);
+		}
+	} else {
+		if(payloadsize<0) {
+			fprintf(stdout,"%-30s %8s %5zu %10.2f",name,"-",align,res->ns);
+		} else {
+			fprintf(stdout,"%-30s %8ld %5zu %10.2f",name,payloadsize,align,res->ns);
+		}
+
+		if(bytes>0) {
+			fprintf(stdout," %8.2f",gbps);
+		} else {
+			fprintf(stdout," %8s","-");
+		}
+
+		if(perf) {
+			if(res->cycles>=0) {
+				fprintf(stdout," %10.1f %10.1f %6.2f",res->cycles,res->instructions,res->cycles>0 ? res->instructions/res->cycles : 0);
+			} else {
+				fprintf(stdout," %10s %10s %6s","n/a","n/a","n/a");
+			}
+		}
+	}
+
+	fprintf(stdout,"\n");
+}
+
+int main (int argc, char **argv) {
+	struct benchctx ctx;
+	struct benchres res;
+	struct rsclock clk;
+	uint8_t srcmac[MAC_ADDR_SIZE]={0x02,0x00,0x00,0x00,0x00,0x01};
+	uint8_t dstmac[MAC_ADDR_SIZE]={0x02,0x00,0x00,0x00,0x00,0x02};
+	byte_t *framebase, *scratchbase, *database;
+	const struct bench *b;
+	uint64_t target_ns=DEFAULT_TARGET_MS*1000000ULL;
+	size_t bi, si, ai, nsizes, bytes;
+	bool csv=false, perf=false;
+	int opt;
+
+	while((opt=getopt(argc,argv,"t:pc"))!=-1) {
+		switch(opt) {
+			case 't':
+				target_ns=strtoull(optarg,NULL,10)*1000000ULL;
+				if(target_ns==0) {
+					fprintf(stderr,"Error. Invalid target time: %s.\n",optarg);
+					exit(EXIT_FAILURE);
+				}
+			break;
+			case 'p':
+				perf=true;
+			break;
+			case 'c':
+				csv=true;
+			break;
+			default:
+				fprintf(stderr,"Correct usage: <%s> [-t <target time per measurement, ms>] [-p (read perf counters)] [-c (CSV output)]\n",argv[0]);
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	if(perf && !perfInit()) {
+		fprintf(stderr,"Warning: the hardware performance counters are not available (check /proc/sys/kernel/perf_event_paranoid). They will not be reported.\n");
+	}
+
+	// Use the invariant TSC, calibrated against the monotonic clock, if available, otherwise the monotonic clock itself
+	if(rsclockInitTsc(&clk,CLOCKSRC_MONOTONIC,RSCLOCK_CALIB_MS)!=0) {
+		rsclockInit(&clk,CLOCKSRC_MONOTONIC);
+	}
+
+	// The same clock is used to timestamp the LaMP packets, as a latency measurement application would do
+	lampSetClock(&clk,false);
+
+	// Cache line aligned buffers, which are then offset by each alignment value
+	if(posix_memalign((void **) &framebase,64,BUF_SIZE)!=0 || posix_memalign((void **) &scratchbase,64,BUF_SIZE)!=0 ||
+		posix_memalign((void **) &database,64,BUF_SIZE)!=0) {
+		fprintf(stderr,"Error. Cannot allocate the frame buffers.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ctx.out=malloc(BUF_SIZE);
+	if(ctx.out==NULL) {
+		fprintf(stderr,"Error. Cannot allocate the frame buffers.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Headers of the test frame: addresses are fixed, as no interface is used
+	etherheadPopulate(&ctx.etherHeader,srcmac,dstmac,ETHERTYPE_IP);
+
+	ctx.addrs.src=htonl(0xC0A80101); // 192.168.1.1
+	ctx.addrs.dst=htonl(0xC0A80102); // 192.168.1.2
+	memset(&ctx.IPheader,0,sizeof(ctx.IPheader));
+	ctx.IPheader.version=4;
+	ctx.IPheader.ihl=5;
+	ctx.IPheader.ttl=BASIC_UDP_TTL;
+	ctx.IPheader.protocol=IPPROTO_UDP;
+	ctx.IPheader.frag_off=htons(FLAG_NOFRAG_MASK);
+	ctx.IPheader.saddr=ctx.addrs.src;
+	ctx.IPheader.daddr=ctx.addrs.dst;
+	IP4headAddID(&ctx.IPheader,11349);
+
+	UDPheadPopulate(&ctx.udpHeader,SRCPORT,DSTPORT);
+
+	ctx.sink=0;
+
+	printHeader(csv,perf_cycles_fd>=0);
+
+	for(bi=0;bi<sizeof(benches)/sizeof(benches[0]);bi++) {
+		b=&benches[bi];
+		nsizes=b->sized ? sizeof(payloadsizes)/sizeof(payloadsizes[0]) : 1;
+
+		for(si=0;si<nsizes;si++) {
+			for(ai=0;ai<sizeof(alignments)/sizeof(alignments[0]);ai++) {
+				ctx.frame=framebase+alignments[ai];
+				ctx.scratch=scratchbase+alignments[ai];
+				ctx.data=database+alignments[ai];
+				benchPrepareFrame(&ctx,payloadsizes[si]);
+
+				benchMeasure(b,&ctx,&clk,target_ns,&res);
+
+				bytes=b->fn(&ctx);
+				printResult(csv,b->name,b->sized ? (long) payloadsizes[si] : -1,alignments[ai],&res,bytes,perf_cycles_fd>=0);
+			}
+		}
+	}
+
+	free(framebase);
+	free(scratchbase);
+	free(database);
+	free(ctx.out);
+
+	if(perf_cycles_fd>=0) {
+		close(perf_instr_fd);
+		close(perf_cycles_fd);
+	}
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 // Rawsock_lib, licensed under GPLv2
 
 // This program is an example program to receive and display the content of any UDP packet on a wireless interface, using raw sockets
+// The packets are read in place from a memory-mapped TPACKET_V3 RX ring (see rawsock_ring.h), without copying them to a separate buffer
 #include <sys/socket.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,14 +10,20 @@
 #include <unistd.h>
 #include <linux/wireless.h>
 #include "Rawsock_lib/rawsock.h" /// Rawsock_lib is included here
+#include "Rawsock_lib/rawsock_ring.h"
+#include "Rawsock_lib/rawsock_filter.h"
 #include <linux/if_packet.h>
 
-#define NO_FLAGS 0
+#define INDEFINITE_BLOCK -1
 
 int main (int argc, char **argv) {
 	int sFd;
-	ssize_t rcv_bytes;
-	byte_t packet[ETHERMTU]; // Packet buffer with size = Ethernet MTU
+	int rcv_ret;
+	struct rxring rxring; // RX ring, in which the packets are stored by the kernel
+	struct rxframe frame; // Descriptor of the current packet, inside the RX ring
+	struct filterspec filter; // Description of the packets of interest
+	struct filterprog filterprog; // In-kernel filter, built from 'filter'
+	rawsockerr_t ringerr;
 	
 	struct ether_header* etherHeader=NULL;
 	struct iphdr *IPheader=NULL;
@@ -30,11 +37,6 @@ int main (int argc, char **argv) {
 
 	size_t payloadsize;
 
-	socklen_t AddrLen=sizeof(struct sockaddr);
-
-	// Already get the pointers to the headers, given the buffer which will contain the packet
-	payload=UDPgetpacketpointers(packet,&etherHeader,&IPheader,&udpHeader);
-
 	// Look for and bind to wireless interface, other than creating the raw socket
 	ret_wlanl_val=wlanLookup(devname,&ifindex,NULL,NULL,0,WLANLOOKUP_WLAN);
 	if(ret_wlanl_val<=0) {
@@ -43,12 +45,22 @@ int main (int argc, char **argv) {
 		exit(EXIT_FAILURE);
 	}
 
-	sFd=socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	// The socket is created with protocol 0, so that it does not receive any packet before the filter is attached (see below)
+	sFd=socket(AF_PACKET, SOCK_RAW, 0);
 	if(sFd==-1) {
 		perror("Cannot create socket: socket() error");
 		exit(EXIT_FAILURE);
 	}
 
+	// Let the kernel drop any packet which is not UDP over IPv4, before it is copied to the socket
+	filterSpecInit(&filter);
+	filterMatchUDP(&filter,0);
+	if(filterCompile(&filter,&filterprog)!=0 || filterAttach(sFd,&filterprog)!=0) {
+		perror("Cannot attach the UDP filter: setsockopt() error");
+		close(sFd);
+		exit(EXIT_FAILURE);
+	}
+
 	fprintf(stdout,"Using interface: %s - index: 0x%02x - number of VIFs: %d\n",devname,ifindex,ret_wlanl_val);
 
 	// Prepare sockaddr_ll structure
@@ -57,7 +69,7 @@ int main (int argc, char **argv) {
 	addrll.sll_family=AF_PACKET;
 	addrll.sll_protocol=htons(ETH_P_ALL);
 
-	// Bind to the wireless interface
+	// Bind to the wireless interface (from now on, the packets accepted by the filter are received)
 	if(bind(sFd,(struct sockaddr *) &addrll,sizeof(addrll))<0) {
 		perror("Cannot bind to interface: bind() error");
   		close(sFd);
@@ -71,10 +83,27 @@ int main (int argc, char **argv) {
 	// 	exit(EXIT_FAILURE);
 	// }
 
+	// Set up the RX ring, with the default settings
+	ringerr=rxringOpen(&rxring,sFd,NULL);
+	if(ringerr!=0) {
+		rs_printerror(stderr,ringerr);
+		close(sFd);
+		exit(EXIT_FAILURE);
+	}
+
 	fprintf(stdout,"Ready to receive datagrams.\n\n");
 	while(1) {
-		// Receive datagram (blocking)
-		rcv_bytes = recvfrom(sFd,packet,ETHERMTU,NO_FLAGS,(struct sockaddr *)&addrll,&AddrLen);
+		// Get the next datagram from the RX ring (blocking)
+		rcv_ret=rxringNext(&rxring,&frame,INDEFINITE_BLOCK);
+
+		if(rcv_ret<0){
+			rs_printerror(stderr,rcv_ret);
+			fprintf(stderr,"The execution will be terminated now.\n");
+			break;
+		}
+
+		// Get the pointers to the headers, directly inside the RX ring
+		payload=UDPgetpacketpointers(frame.data,&etherHeader,&IPheader,&udpHeader);
 
 		// Go on only if it is a datagram of interest (in our case if it is UDP)
 		if (ntohs(etherHeader->ether_type)!=ETHERTYPE_IP) { 
@@ -86,22 +115,17 @@ int main (int argc, char **argv) {
 
 		// Validate checksum (combined mode: IP+UDP): if it is wrong, discard packet
 		payloadsize=UDPgetpayloadsize(udpHeader);
-		if(!validateEthCsum(packet, udpHeader->check, &(IPheader->check), CSUM_UDPIP, (void *) &payloadsize)) {
+		if(!validateEthCsum(frame.data, udpHeader->check, &(IPheader->check), CSUM_UDPIP, (void *) &payloadsize)) {
 			fprintf(stderr,"Wrong checksum! Packet will be discarded.\n");
 			continue;
 		}
 
-		if(rcv_bytes==-1){
-			perror("An error occurred in receive last message");
-			fprintf(stderr,"The execution will be terminated now.\n");
-			break;
-		}
-
 		// Print payload and source IP address
 		fprintf(stdout,"Received a new packet from %s\n",inet_ntoa(*(struct in_addr*)&IPheader->saddr));
 		display_packetc("Received a new packet with payload:", payload, payloadsize);
 	}
 
+	rxringClose(&rxring);
 	close(sFd);
 
 	return 0;
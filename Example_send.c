@@ -5,8 +5,12 @@
 	This example program has been used to send periodic broadcast UDP packets over a wireless interface, as Rawsock_lib also provides a function 
 	to specifically look for wireless interfaces, under Linux (wlanLookup()).
 
-	This code is using "timers that notify via file descriptors" (timerfd) together with poll() to correctly send packets at the specified time
-	intervals.
+	This code is using a pacer (see rawsock_pacer.h), working with absolute deadlines, to correctly send packets at the specified time
+	intervals: it sleeps until shortly before each deadline and then spins on the clock (a calibrated TSC, when available), so that the
+	packets are sent very regularly, even with sub-millisecond periods. The lateness of each packet is recorded and printed when the program ends.
+
+	Each packet is built directly inside a PACKET_TX_RING slot (see rawsock_ring.h), which is flushed after every packet, as packets are sent
+	periodically. When sending at higher rates, TX_FLUSH_THRESHOLD can be raised to send many packets with a single system call.
 
 	It has been successfully used, after cross-compilation, within the OpenWrt-V2X platform (on a PC Engines APU1D board), available on GitHub: 
 	https://github.com/francescoraves483/OpenWrt-V2X/tree/OpenWrt-V2X-18.06.1
@@ -16,7 +20,6 @@
 	the user through the terminal).
 */
 #include <sys/socket.h>
-#include <sys/timerfd.h>
 #include <sys/ioctl.h>
 #include <linux/wireless.h>
 #include <stdio.h>
@@ -25,67 +28,65 @@
 #include <unistd.h>
 #include <time.h>
 #include <math.h>
-#include <poll.h>
+#include <inttypes.h>
 #include "Rawsock_lib/rawsock.h"
+#include "Rawsock_lib/rawsock_ring.h"
+#include "Rawsock_lib/rawsock_pacer.h"
 #include <linux/if_packet.h>
 
 #define MAX_LEN 1470 // Maximum allowed payload length
 
 #define SEC_TO_NANOSEC 1000000000 // Constant for conversion between seconds and nanoseconds
-#define INDEFINITE_BLOCK -1
-#define NO_FLAGS 0
 #define SRCPORT 46772 // Source port to be used
 #define START_ID 11349 // Initial ID for the first packet
 #define INCR_ID 0 // ID increment for each successive packet (all packets will have the same ID in this case)
+#define TX_FLUSH_THRESHOLD 1 // Number of packets after which the TX ring is flushed
 
 int main (int argc, char **argv) {
 	int sFd;
 	int broadPerm=1;
 	int broadPort;
 	size_t len;
-	int clockFd;
 
-	// Timer management variables
-	struct itimerspec new_value;
+	// Pacing variables
+	struct rsclock clk;
+	struct pacer pacer;
+	struct pacerparams pacerparams;
+	struct lathist lateness;
 	long nanosec;
 	double d_sec;
 	double d_time;
-	struct pollfd timerMon;
-
-	// Junk variable (needed to clear the timer event with read())
-	unsigned long long junk;
 
 	// wlanLookup() variables, for interface name, source MAC address and return value
 	char devname[IFNAMSIZ]={0}; // It will contain the used interface name
 	macaddr_t srcmacaddr=prepareMacAddrT();
 	int ret_wlanl_val;
 
-	// Ethernet header and packet container
+	// Ethernet header
 	struct ether_header etherHeader;
-	byte_t *ethernetpacket;
 
 	// IP header
 	struct iphdr ipHeader;
 	// IP address (src+dest) structure
 	struct ipaddrs ipaddrs;
-	// IP packet container
-	byte_t *ippacket;
 	// id to be inserted in the id field on the IP header
 	unsigned int id=START_ID;
 
 	// UDP header
 	struct udphdr udpHeader;
-	// UDP packet container
-	byte_t *udppacket;
+
+	// Single packet container: the payload is written once and the headers are added in place, in front of it, directly inside the TX ring
+	struct framebuf fb;
+	// PACKET_TX_RING and its settings
+	struct txring txring;
+	struct txringparams txparams;
+	rawsockerr_t ringerr;
 
 	// sockaddr_ll (device-independent physical-layer address)
 	struct sockaddr_ll addrll;
 	// Index of the interface which is used (and returned by wlanLookup())
 	int ifindex;
 
-	// Final packet size
-	size_t finalpktsize;
-
 	// Check command line arguments
 	if(argc!=4) {
 	    fprintf(stderr,"Error. Expected five parameters.\nCorrect usage: <%s> <broadcast port> <time interval> <payload>.\n",argv[0]);
@@ -159,19 +160,22 @@ int main (int argc, char **argv) {
 	//IP4headPopulate(&ipHeader, devname, "10.10.6.103", 0, 0, BASIC_UDP_TTL, IPPROTO_UDP, FLAG_NOFRAG_MASK, &ipaddrs); <- example of use with non broadcast transmission
 	UDPheadPopulate(&udpHeader, SRCPORT, broadPort);
 
-	// Allocating packet buffers
-	udppacket=malloc(UDP_PACKET_SIZE(argv[3]));
-	ippacket=malloc(IP_UDP_PACKET_SIZE(argv[3]));
-	ethernetpacket=malloc(ETH_IP_UDP_PACKET_SIZE(argv[3]));
-
-	// Create monotonic (increasing) timer
-	clockFd=timerfd_create(CLOCK_MONOTONIC,NO_FLAGS);
-	if(clockFd==-1) {
-		perror("timerfd_create() error");
+	// Set up the TX ring, in which the packets will be directly built
+	txringParamsDefault(&txparams);
+	txparams.flush_threshold=TX_FLUSH_THRESHOLD;
+	ringerr=txringOpen(&txring,sFd,addrll,&txparams);
+	if(ringerr!=0) {
+		fprintf(stderr,"Could not set up the TX ring.\n");
+		rs_printerror(stderr,ringerr);
 		close(sFd);
 		exit(EXIT_FAILURE);
 	}
 
+	// Use the invariant TSC, calibrated against the monotonic clock, if available, otherwise the monotonic clock itself
+	if(rsclockInitTsc(&clk,CLOCKSRC_MONOTONIC,RSCLOCK_CALIB_MS)!=0) {
+		rsclockInit(&clk,CLOCKSRC_MONOTONIC);
+	}
+
 	// Get time from command line and convert it to sec and nanosec
 	d_time=strtod(argv[2],NULL);
 	if(d_time==0) {
@@ -181,57 +185,60 @@ int main (int argc, char **argv) {
 	}
 
 	nanosec=SEC_TO_NANOSEC*modf(d_time,&d_sec);
-	new_value.it_value.tv_nsec=nanosec;
-	new_value.it_value.tv_sec=(time_t)d_sec;
-	new_value.it_interval.tv_nsec=nanosec;
-	new_value.it_interval.tv_sec=(time_t)d_sec;
 	// time_t is long in my case, but being implementation dependant, I decided to print just d_sec as double with no decimal digits
 	fprintf(stdout,"Sending period set to %.0f second(s) and %.3f microsecond(s).\n",d_sec,nanosec/1000.0);
 
-	// Fill pollfd structure
-	timerMon.fd=clockFd;
-	timerMon.revents=0;
-	timerMon.events=POLLIN;
-
-	// Start timer
-	if(timerfd_settime(clockFd,NO_FLAGS,&new_value,NULL)==-1) {
-		perror("timerfd_settime() error");
+	// Set up the pacer, measuring how late this system wakes up a sleeping thread
+	lathistInit(&lateness);
+	pacerParamsDefault(&pacerparams);
+	pacerparams.period_ns=(uint64_t)d_sec*SEC_TO_NANOSEC+nanosec;
+	pacerparams.margin_ns=pacerCalibrateMargin(&clk);
+	pacerparams.policy=PACER_SKIP;
+	if(pacerInit(&pacer,&clk,&pacerparams,&lateness)!=0) {
+		fprintf(stderr,"Invalid sending period.\n");
 		close(sFd);
 		exit(EXIT_FAILURE);
 	} else {
-		fprintf(stdout,"Timer successfully started. Sending triggered.\n\n");
+		fprintf(stdout,"Pacer successfully started (sleep margin: %.3f microsecond(s)). Sending triggered.\n\n",pacerparams.margin_ns/1000.0);
 	}
 
 	while(1) {
-		// poll waiting for events happening on the timer descriptor (i.e. wait for timer expiration)
-		if(poll(&timerMon,1,INDEFINITE_BLOCK)>0) {
-			// "Clear the event" by performing a read() on a junk variable
-			read(clockFd,&junk,sizeof(junk));
-			
-			// Prepare datagram
-			IP4headAddID(&ipHeader,(unsigned short) id);
-			id+=INCR_ID;
-			UDPencapsulate(udppacket,&udpHeader,argv[3],strlen(argv[3]),ipaddrs);
-			// 'IP4headAddTotLen' may also be skipped since IP4Encapsulate already takes care of filling the length field
-			// IP4headAddTotLen(&ipHeader, IP_UDP_PACKET_SIZE(argv[5]));
-			IP4Encapsulate(ippacket, &ipHeader, udppacket, UDP_PACKET_SIZE(argv[3]));
-			finalpktsize=etherEncapsulate(ethernetpacket, &etherHeader, ippacket, IP_UDP_PACKET_SIZE(argv[3]));
-
-			// Send datagram
-			if(sendto(sFd,ethernetpacket,finalpktsize,NO_FLAGS,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll))!=finalpktsize) {
-				perror("sendto() for sending broadcasted data failed");
-				fprintf(stderr,"The program will be terminated now");
-				break;
-			}
+		// Wait for the next deadline
+		pacerWait(&pacer);
+
+		// Get the next free slot of the TX ring, with enough headroom for the UDP, IPv4 and Ethernet headers
+		ringerr=txringGetFramebuf(&txring,&fb,ETH_IP_UDP_HEADROOM);
+		if(ringerr!=0) {
+			rs_printerror(stderr,ringerr);
+			fprintf(stderr,"The program will be terminated now");
+			break;
+		}
+
+		// Prepare datagram: the payload is copied only once, then each header is put in place in front of it
+		IP4headAddID(&ipHeader,(unsigned short) id);
+		id+=INCR_ID;
+		framebufCopyPayload(&fb,(byte_t *) argv[3],len);
+		UDPencapsulateInPlace(&fb,&udpHeader,ipaddrs);
+		// 'IP4headAddTotLen' may also be skipped since IP4EncapsulateInPlace already takes care of filling the length field
+		IP4EncapsulateInPlace(&fb,&ipHeader);
+		etherEncapsulateInPlace(&fb,&etherHeader);
+
+		// Send datagram (the ring is flushed every TX_FLUSH_THRESHOLD packets)
+		ringerr=txringCommitFramebuf(&txring,&fb);
+		if(ringerr!=0) {
+			perror("Sending broadcasted data through the TX ring failed");
+			fprintf(stderr,"The program will be terminated now");
+			break;
 		}
 	}
 
+	fprintf(stdout,"Sending lateness: median %" PRIu64 " ns, 99th percentile %" PRIu64 " ns, maximum %" PRIu64 " ns (skipped periods: %" PRIu64 ").\n",
+		lathistPercentile(&lateness,50.0),lathistPercentile(&lateness,99.0),lathistMax(&lateness),pacer.skipped);
+
 	freeMacAddrT(srcmacaddr); // freeing a macaddr_t structure, using a function provided with the Rawsock_lib library
-	free(udppacket);
-	free(ethernetpacket);
-	free(ippacket);
+	txringFlush(&txring);
+	txringClose(&txring);
 	close(sFd);
-	close(clockFd);
 
 	return 0;
 }
\ No newline at end of file
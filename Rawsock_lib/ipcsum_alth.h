@@ -7,7 +7,8 @@
 	It represents an alternative user-space header to access the Linux kernel ip_fast_csum() function.
 
 	This is not an original work: this function comes from the [Linux kernel 4.19.1](https://elixir.bootlin.com/linux/v4.19.1/source/lib/checksum.c#L110), 
-	released under GNU GPL version 2. There is no modification to its code.
+	released under GNU GPL version 2. Its interface is unchanged, but the original do_csum() routine has been replaced by csum_partial() (see rawsock_csum.h),
+	which selects at runtime a vectorized implementation, when supported by the current CPU.
 
 	The function, even though it is used internally in the main Rawsock module, is available through a separate
 	header in order to enable any application to use it separately in user space, when needed.
@@ -1,6 +1,7 @@
 // Rawsock library, licensed under GPLv2
 // Version 0.3.4
 #include "minirighi_udp_checksum.h"
+#include "rawsock_csum.h"
 
 /**
 	\brief Calculate the UDP checksum (calculated with the whole packet) 
@@ -16,32 +17,5 @@
 	\return The result of the checksum.
 **/
 uint16_t minirighi_udp_checksum(const void *buff, size_t len, in_addr_t src_addr, in_addr_t dest_addr) {
-	const uint16_t *buf=buff;
-	uint16_t *ip_src=(void *)&src_addr, *ip_dst=(void *)&dest_addr;
-	uint32_t sum;
-	size_t length=len;
-
-	sum = 0;
-	while (len > 1) {
-		sum += *buf++;
-		if (sum & 0x80000000)
-			sum = (sum & 0xFFFF) + (sum >> 16);
-		len -= 2;
-	}
-
-	if ( len & 1 )
-		sum += *((uint8_t *)buf);
-
-	sum += *(ip_src++);
-	sum += *ip_src;
-	sum += *(ip_dst++);
-	sum += *ip_dst;
-
-	sum += htons(IPPROTO_UDP);
-	sum += htons(length);
-
-	while (sum >> 16)
-		sum = (sum & 0xFFFF) + (sum >> 16);
-
-	return ( (uint16_t)(~sum)  );
+	return csum_tcpudp_magic(src_addr,dest_addr,len,IPPROTO_UDP,csum_partial(buff,len,0));
 }
\ No newline at end of file
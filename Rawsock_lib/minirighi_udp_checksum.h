@@ -5,7 +5,8 @@
 	compute the UDP checksum to be put inside the corresponding field of the UDP header.
 
 	This is not an original work: this function comes from the [Minirighi IA-32 Operating System](http://minirighi.sourceforge.net/html/udp_8c.html), 
-	released under GNU GPL. Except for the name, there is no modification to its code.
+	released under GNU GPL. Its interface is unchanged, except for the name, but the sum of the UDP header and payload is now computed by
+	csum_partial() (see rawsock_csum.h), which selects at runtime a vectorized implementation, when supported by the current CPU.
 
 	Moreover, the original definition can be found at line 29 of file **udp.c** of the Minirighi system.
 
@@ -1,19 +1,76 @@
 // Rawsock library, licensed under GPLv2
 // Version 0.3.4
+#define _GNU_SOURCE // Needed for sendmmsg() and recvmmsg()
 #include "rawsock.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <ifaddrs.h>
 #include <string.h>
 #include <unistd.h>
-#include <linux/wireless.h>
-#include <linux/ethtool.h>
+#include <linux/if.h>
 #include <linux/sockios.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <errno.h>
 #include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#include <linux/if_link.h>
+#include <linux/if_arp.h>
 #include "ipcsum_alth.h"
 #include "minirighi_udp_checksum.h"
+#include "rawsock_csum.h"
+
+// Fill in all the fields of an IPv4 header, except for the source address (the checksum and the ID are initialized to 0)
+static void IP4headFill(struct iphdr *IPhead, in_addr_t daddr, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags) {
+	IPhead->ihl=BASIC_IHL;
+	IPhead->version=IPV4;
+	IPhead->tos=(__u8) tos;
+	IPhead->frag_off=htons(frag_offset);
+	IPhead->frag_off=(IPhead->frag_off) | flags;
+	IPhead->ttl=(__u8) ttl;
+	IPhead->protocol=(__u8) protocol;
+	IPhead->daddr=daddr;
+
+	// Initialize checksum to 0
+	IPhead->check=0;
+
+	// Initialize ID to 0
+	IPhead->id=0;
+}
+
+// Set the source address of an IPv4 header filled in by IP4headFill(), and store both addresses inside 'addrs' (if non-NULL)
+static void IP4headSetSrc(struct iphdr *IPhead, in_addr_t saddr, struct ipaddrs *addrs) {
+	IPhead->saddr=saddr;
+	if(addrs!=NULL) {
+		addrs->src=IPhead->saddr;
+		addrs->dst=IPhead->daddr;
+	}
+}
+
+// Retrieve the IPv4 address of an interface, given its name
+static rawsockerr_t getIfIPv4Addr(const char *devname, struct in_addr *addr) {
+	int sFd;
+	struct ifreq wifireq;
+
+	sFd=socket(AF_INET,SOCK_DGRAM,0);
+	if(sFd==-1) {
+		return ERR_IPHEAD_SOCK;
+	}
+	strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
+	wifireq.ifr_addr.sa_family = AF_INET;
+	if(ioctl(sFd,SIOCGIFADDR,&wifireq)!=0) {
+		close(sFd);
+		return ERR_IPHEAD_NOSRCADDR;
+	}
+	close(sFd);
+
+	*addr=((struct sockaddr_in*)&wifireq.ifr_addr)->sin_addr;
+
+	return 0;
+}
 
 static uint64_t swap64(uint64_t unsignedvalue, uint32_t (*swap_byte_order)(uint32_t)) {
 	#if __BYTE_ORDER == __BIG_ENDIAN
@@ -29,17 +86,6 @@ static uint64_t swap64(uint64_t unsignedvalue, uint32_t (*swap_byte_order)(uint3
 	#endif
 }
 
-static uint8_t is_if_tun(int sFd,char *devname) {
-	struct ethtool_drvinfo drvinfo;
-	struct ifreq ethtool_ifr;
-
-	drvinfo.cmd=ETHTOOL_GDRVINFO;
-	strncpy(ethtool_ifr.ifr_name,devname,IFNAMSIZ);
-	ethtool_ifr.ifr_data=(void *)&drvinfo;
-
-	return ioctl(sFd,SIOCETHTOOL,&ethtool_ifr)!=-1 && strncmp(drvinfo.bus_info,"tun",ETHTOOL_BUSINFO_LEN)==0;
-}
-
 /**
 	\brief Prepare a *macaddr_t* variable
 
@@ -109,202 +155,443 @@ unsigned int macAddrTypeGet(macaddr_t mac) {
 	}
 }
 
-/**
-	\brief Automatically look for available WLAN, non-WLAN or loopback interfaces.
-	
-	This function can be used to automatically look for available and ready WLAN or non-WLAN (depending on _mode_)
-	interfaces in the system.
-
-	From version 0.2.0 it is also possible to specify [WLANLOOKUP_LOOPBACK](\ref WLANLOOKUP_LOOPBACK) as _index_
-	to look for the first available lookback interface, instead of WLAN/non-WLAN ones.
+#define NLDUMP_SEQ_LINK 1
+#define NLDUMP_SEQ_ADDR 2
+#define NLDUMP_SEQ_GENL_FAMILY 3
+#define NLDUMP_SEQ_NL80211 4
+
+// Netlink message callback, used by nlRecvReplies()
+typedef void (*nlmsgcb_t)(struct nlmsghdr *nh, void *arg);
+
+// State of an interface dump
+struct nldumpctx {
+	struct ifrecord *records;
+	unsigned int max;
+	unsigned int n;
+	uint16_t nl80211_id;
+	byte_t *buf; // Receive buffer, of NLDUMP_BUFFER_SIZE bytes
+};
+
+// Send a netlink request, with a payload of 'payloadlen' bytes
+static int nlSendRequest(int fd, uint16_t type, uint16_t flags, uint32_t seq, const void *payload, size_t payloadlen) {
+	struct {
+		struct nlmsghdr nh;
+		byte_t payload[64];
+	} req;
+	struct sockaddr_nl sanl;
+
+	memset(&req,0,sizeof(req));
+	req.nh.nlmsg_len=NLMSG_LENGTH(payloadlen);
+	req.nh.nlmsg_type=type;
+	req.nh.nlmsg_flags=NLM_F_REQUEST | flags;
+	req.nh.nlmsg_seq=seq;
+	memcpy(NLMSG_DATA(&req.nh),payload,payloadlen);
+
+	memset(&sanl,0,sizeof(sanl));
+	sanl.nl_family=AF_NETLINK;
+
+	return sendto(fd,&req,req.nh.nlmsg_len,0,(struct sockaddr *) &sanl,sizeof(sanl))<0 ? -1 : 0;
+}
 
-	When only one interface is available and `0` is specified as index, 
-	that interface name is returned inside `devname`. 
-	Then, if the other three arguments are not NULL, the interface index,
-	the corresponding source MAC address (if available) and
-	the corresponding source IP address (if available) are respectively returned.
+// Read all the replies to the request with sequence number 'seq' inside 'buf' (NLDUMP_BUFFER_SIZE bytes, aligned as a struct nlmsghdr), calling 'callback'
+//  for each of them, until the end of the dump or the acknowledgment is received; returns 0, or -1 in case of error (with errno set, to EMSGSIZE if a reply was truncated)
+static int nlRecvReplies(int fd, byte_t *buf, uint32_t seq, nlmsgcb_t callback, void *arg) {
+	struct nlmsghdr *nh;
+	struct nlmsgerr *nlerr;
+	ssize_t len;
+
+	while(1) {
+		// With MSG_TRUNC, the real length of the datagram is returned, even if it does not fit inside the buffer
+		len=recv(fd,buf,NLDUMP_BUFFER_SIZE,MSG_TRUNC);
+		if(len<0) {
+			if(errno==EINTR) {
+				continue;
+			}
+			return -1;
+		}
 
-	If more than one interface is present, the number of available interfaces of the specified type (WLAN/non-WLAN)
-	is returned by the function and _index_ is used to point to a specific interface 
-	(for instance `index=1` can be used to point to a possible `wlan1` interface when _mode_ is [WLANLOOKUP_WLAN](\ref WLANLOOKUP_WLAN)).
+		if(len>NLDUMP_BUFFER_SIZE) {
+			errno=EMSGSIZE;
+			return -1;
+		}
 
-	To print the available indeces, the user can use vifPrinter().
+		for(nh=(struct nlmsghdr *) buf;NLMSG_OK(nh,len);nh=NLMSG_NEXT(nh,len)) {
+			if(nh->nlmsg_seq!=seq) {
+				continue;
+			}
 
-	\param[out] 	devname 	Name of the WLAN interface.
-	\param[out]		ifindex 	Interface index corresponding to _devname_ (filled in only if non-NULL).
-	\param[out]		mac     	Interface (source) MAC address (filled in only if non-NULL / non-[MAC_NULL](\ref MAC_NULL)).
-	\param[out]		srcIP		Interface (source) IPv4 address (filled in only if non-NULL and returned inside a _struct in_addr_, which should be available in the calling module).
-	\param[in]		index       Integer index used to point to a specific interface of the specified type (i.e. using the specified _mode_), when more than one is available (or equal to [WLANLOOKUP_LOOPBACK](\ref WLANLOOKUP_LOOPBACK) to look for the first available loopback interface).
-	\param[in] 		mode 		Operating mode: [WLANLOOKUP_WLAN](\ref WLANLOOKUP_WLAN) to look for available WLAN interfaces only, [WLANLOOKUP_NONWLAN](\ref WLANLOOKUP_NONWLAN) to look for available non-WLAN/Ethernet interfaces only
+			if(nh->nlmsg_type==NLMSG_DONE) {
+				return 0;
+			} else if(nh->nlmsg_type==NLMSG_ERROR) {
+				nlerr=NLMSG_DATA(nh);
+				if(nlerr->error!=0) {
+					errno=-nlerr->error;
+					return -1;
+				}
+				return 0;
+			}
 
-	\return Number of WLAN/non-WLAN interfaces that were found, <b> > 0 </b>, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
-	- *ERR_WLAN_NOIF* -> no interfaces found
-	- *ERR_WLAN_SOCK* -> cannot create socket to look for available and running interfaces
-	- *ERR_WLAN_GETIFADDRS* -> error in calling `getifaddrs()`
-	- *ERR_WLAN_INDEX* -> invalid index value
-	- *ERR_WLAN_GETSRCMAC* -> unable to get source MAC address (if requested)
-	- *ERR_WLAN_GETIFINDEX* -> unable to get source interface index (if requested)
-	- *ERR_WLAN_GETSRCMAC* -> unable to get source IP address (if requested)
-**/
-rawsockerr_t wlanLookup(char *devname, int *ifindex, macaddr_t mac, struct in_addr *srcIP, int index, int mode) {
-	// Variables for wlan interfaces detection
-	int sFd=-1;
-	// struct ifaddrs used to look for available interfaces and bind to a wireless interface
-	struct ifaddrs *ifaddr_head, *ifaddr_it;
-	// struct ifreq to check whether an interface is wireless or not. The ifr_name field is used to specify which device to affect.
-	struct ifreq wifireq;
-	// Pointers to manage the list containing all valid wireless interfaces
-	struct iflist *iflist_head=NULL; // Head
-	struct iflist *curr_ptr=NULL; // Current element
-	struct iflist *iflist_it=NULL; // To iterate the list
-	struct iflist *iflist_u=NULL; // To free the list
-	int ifno=0;
-	int ioctl_result=0; // Result of the call to ioctl(sFd,SIOCGIWNAME,&wifireq)
-	int return_value=1; // Return value: >0 ok - # of found interfaces, <=0 error 
-								 // (=0 for no WLAN interfaces, =-1 for socket error, =-2 for getifaddrs error)
-							     // (=-3 for wrong index, =-4 unable to get MAC address, =-5 unable to get ifindex)
-
-	// Linked list nodes to store the WLAN interfaces
-	struct iflist {
-		struct iflist *next;
-		struct ifaddrs *ifaddr_ptr;
-	};
-
-	// Open socket (needed)
-	sFd=socket(AF_INET,SOCK_DGRAM,0); // Any socket should be fine (to be better investigated!)
-	if(sFd==-1) {
-		return_value=ERR_WLAN_SOCK;
-		goto sock_error_occurred;
+			callback(nh,arg);
+		}
 	}
+}
 
-	// Getting all interface addresses
-	if(getifaddrs(&ifaddr_head)==-1) {
-		return_value=ERR_WLAN_GETIFADDRS;
-		goto getifaddrs_error_occurred;
+// RTM_GETLINK dump callback: add one record for each link
+static void nlIfDumpLink(struct nlmsghdr *nh, void *arg) {
+	struct nldumpctx *ctx=arg;
+	struct ifinfomsg *ifi=NLMSG_DATA(nh);
+	struct ifrecord *rec;
+	struct rtattr *rta, *nested;
+	int rtalen, nestedlen;
+	bool kind_tun=false;
+
+	if(nh->nlmsg_type!=RTM_NEWLINK || ctx->n>=ctx->max) {
+		return;
 	}
 
-	// Looking for wlan interfaces
-	memset(&wifireq,0,sizeof(wifireq));
-	// Iterating over the interfaces linked list
-	for(ifaddr_it=ifaddr_head;ifaddr_it!=NULL;ifaddr_it=ifaddr_it->ifa_next) {
-		if(index==-1 && ifaddr_it->ifa_addr!=NULL && (ifaddr_it->ifa_flags & IFF_LOOPBACK)) {
-			// This is the first loopback interface
-			strncpy(devname,ifaddr_it->ifa_name,IFNAMSIZ);
+	rec=&ctx->records[ctx->n++];
+	memset(rec,0,sizeof(struct ifrecord));
+	rec->ifindex=ifi->ifi_index;
+	rec->flags=ifi->ifi_flags;
+	rec->type=ifi->ifi_type;
+
+	rtalen=IFLA_PAYLOAD(nh);
+	for(rta=IFLA_RTA(ifi);RTA_OK(rta,rtalen);rta=RTA_NEXT(rta,rtalen)) {
+		switch(rta->rta_type) {
+			case IFLA_IFNAME:
+				strncpy(rec->name,RTA_DATA(rta),IFDESC_NAME_SIZE-1);
+			break;
 
-			// One loopback interface is returned
-			return_value=1;
+			case IFLA_ADDRESS:
+				if(RTA_PAYLOAD(rta)==MAC_ADDR_SIZE) {
+					memcpy(rec->mac,RTA_DATA(rta),MAC_ADDR_SIZE);
+				}
+			break;
 
+			case IFLA_MTU:
+				rec->mtu=*(unsigned int *) RTA_DATA(rta);
 			break;
-		} else {
-			if(ifaddr_it->ifa_addr!=NULL && (ifaddr_it->ifa_addr->sa_family == AF_PACKET || (ifaddr_it->ifa_addr->sa_family == AF_INET && is_if_tun(sFd,ifaddr_it->ifa_name)))) {
-				// fprintf(stdout,"Checking interface %s for use.\n",ifaddr_it->ifa_name);
-				// IFNAMSIZ is defined by system libraries and it "defines the maximum buffer size needed to hold an interface name, 
-				//  including its terminating zero byte"
-				// This is done because (from man7.org) "normally, the user specifies which device to affect by setting
-	            //  ifr_name to the name of the interface"
-				strncpy(wifireq.ifr_name,ifaddr_it->ifa_name,IFNAMSIZ);
-
-				// Trying to get the Wireless Extensions (a socket descriptor must be specified to ioctl())
-				ioctl_result=ioctl(sFd,SIOCGIWNAME,&wifireq);
-
-				// Current interface should be considered
-				if((ioctl_result!=-1 && mode==WLANLOOKUP_WLAN) || (ioctl_result==-1 && mode==WLANLOOKUP_NONWLAN)) {
-					if(ifaddr_it->ifa_addr!=NULL && (ifaddr_it->ifa_flags & IFF_UP) && !(ifaddr_it->ifa_flags & IFF_LOOPBACK)) {
-						// If the interface is up, add it to the head of the "iflist" (it is not added to the tail in order to
-						//  avoid defining an extra pointer)
-						ifno++;
-						curr_ptr=malloc(sizeof(struct iflist));
-						curr_ptr->ifaddr_ptr=ifaddr_it;
-						if(iflist_head==NULL) {
-							iflist_head=curr_ptr;
-							iflist_head->next=NULL;
-						} else {
-							curr_ptr->next=iflist_head;
-							iflist_head=curr_ptr;
-						}
+
+			case IFLA_LINKINFO:
+				nestedlen=RTA_PAYLOAD(rta);
+				for(nested=RTA_DATA(rta);RTA_OK(nested,nestedlen);nested=RTA_NEXT(nested,nestedlen)) {
+					if(nested->rta_type==IFLA_INFO_KIND && strncmp(RTA_DATA(nested),"tun",RTA_PAYLOAD(nested))==0) {
+						kind_tun=true;
 					}
 				}
-			}
+			break;
+		}
+	}
+
+	// tap interfaces are of "tun" kind too, but they are Ethernet interfaces
+	rec->tun=kind_tun && rec->type==ARPHRD_NONE;
+}
+
+// RTM_GETADDR dump callback: store the primary IPv4 address of each interface
+static void nlIfDumpAddr(struct nlmsghdr *nh, void *arg) {
+	struct nldumpctx *ctx=arg;
+	struct ifaddrmsg *ifa=NLMSG_DATA(nh);
+	struct rtattr *rta;
+	bool addr_found=false;
+	struct in_addr addr;
+	unsigned int i;
+	int rtalen;
+
+	if(nh->nlmsg_type!=RTM_NEWADDR || ifa->ifa_family!=AF_INET || (ifa->ifa_flags & IFA_F_SECONDARY)) {
+		return;
+	}
+
+	rtalen=IFA_PAYLOAD(nh);
+	for(rta=IFA_RTA(ifa);RTA_OK(rta,rtalen);rta=RTA_NEXT(rta,rtalen)) {
+		if(rta->rta_type==IFA_LOCAL || (rta->rta_type==IFA_ADDRESS && !addr_found)) {
+			memcpy(&addr,RTA_DATA(rta),sizeof(addr));
+			addr_found=true;
+		}
+	}
+
+	if(!addr_found) {
+		return;
+	}
+
+	for(i=0;i<ctx->n;i++) {
+		if(ctx->records[i].ifindex==(int) ifa->ifa_index && !ctx->records[i].ip_valid) {
+			ctx->records[i].ip=addr;
+			ctx->records[i].ip_valid=true;
+			break;
+		}
+	}
+}
+
+// CTRL_CMD_GETFAMILY callback: get the generic netlink family identifier of nl80211
+static void nlIfDumpGenlFamily(struct nlmsghdr *nh, void *arg) {
+	struct nldumpctx *ctx=arg;
+	struct nlattr *nla;
+	int nlalen;
+
+	nlalen=nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN);
+	for(nla=(struct nlattr *) ((byte_t *) NLMSG_DATA(nh)+GENL_HDRLEN);nlalen>=(int) NLA_HDRLEN && nla->nla_len>=NLA_HDRLEN && nla->nla_len<=nlalen;
+		nlalen-=NLA_ALIGN(nla->nla_len),nla=(struct nlattr *) ((byte_t *) nla+NLA_ALIGN(nla->nla_len))) {
+		if((nla->nla_type & NLA_TYPE_MASK)==CTRL_ATTR_FAMILY_ID) {
+			ctx->nl80211_id=*(uint16_t *) ((byte_t *) nla+NLA_HDRLEN);
 		}
 	}
+}
 
-	// Scan the list of returned interfaces only if lookback was not specified
-	if(index!=-1) {
-		// No wireless interfaces found (the list is empty)
-		if(iflist_head==NULL) {
-			return_value=0;
-			goto error_occurred;
-		} else if(ifno==1) {
-			// Only one wireless interface found
-			if(index>=1) {
-				return_value=ERR_WLAN_INDEX;
-				goto error_occurred;
+// NL80211_CMD_GET_INTERFACE dump callback: mark each reported interface as wireless
+static void nlIfDumpWireless(struct nlmsghdr *nh, void *arg) {
+	struct nldumpctx *ctx=arg;
+	struct nlattr *nla;
+	unsigned int i;
+	int nlalen;
+	int ifindex;
+
+	nlalen=nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN);
+	for(nla=(struct nlattr *) ((byte_t *) NLMSG_DATA(nh)+GENL_HDRLEN);nlalen>=(int) NLA_HDRLEN && nla->nla_len>=NLA_HDRLEN && nla->nla_len<=nlalen;
+		nlalen-=NLA_ALIGN(nla->nla_len),nla=(struct nlattr *) ((byte_t *) nla+NLA_ALIGN(nla->nla_len))) {
+		if((nla->nla_type & NLA_TYPE_MASK)==NL80211_ATTR_IFINDEX) {
+			ifindex=*(uint32_t *) ((byte_t *) nla+NLA_HDRLEN);
+
+			for(i=0;i<ctx->n;i++) {
+				if(ctx->records[i].ifindex==ifindex) {
+					ctx->records[i].wireless=true;
+				}
 			}
-			strncpy(devname,iflist_head->ifaddr_ptr->ifa_name,IFNAMSIZ);
-		} else {
-			// Multiple interfaces found -> use the value of 'index'
-			if(index>=ifno) {
-				return_value=ERR_WLAN_INDEX;
-				goto error_occurred;
+		}
+	}
+}
+
+// Mark the wireless interfaces, through nl80211 (if nl80211 is not available, no interface is wireless)
+static void nlIfDumpNl80211(struct nldumpctx *ctx) {
+	struct {
+		struct genlmsghdr genlhdr;
+		struct nlattr nla;
+		char name[8];
+	} familyreq;
+	struct genlmsghdr genlhdr;
+	int fd;
+
+	fd=socket(AF_NETLINK,SOCK_RAW | SOCK_CLOEXEC,NETLINK_GENERIC);
+	if(fd<0) {
+		return;
+	}
+
+	memset(&familyreq,0,sizeof(familyreq));
+	familyreq.genlhdr.cmd=CTRL_CMD_GETFAMILY;
+	familyreq.genlhdr.version=1;
+	familyreq.nla.nla_type=CTRL_ATTR_FAMILY_NAME;
+	familyreq.nla.nla_len=NLA_HDRLEN+sizeof(NL80211_GENL_NAME);
+	memcpy(familyreq.name,NL80211_GENL_NAME,sizeof(NL80211_GENL_NAME));
+
+	ctx->nl80211_id=0;
+	if(nlSendRequest(fd,GENL_ID_CTRL,NLM_F_ACK,NLDUMP_SEQ_GENL_FAMILY,&familyreq,sizeof(familyreq))<0 ||
+		nlRecvReplies(fd,ctx->buf,NLDUMP_SEQ_GENL_FAMILY,nlIfDumpGenlFamily,ctx)<0 || ctx->nl80211_id==0) {
+		close(fd);
+		return;
+	}
+
+	memset(&genlhdr,0,sizeof(genlhdr));
+	genlhdr.cmd=NL80211_CMD_GET_INTERFACE;
+	genlhdr.version=0;
+
+	if(nlSendRequest(fd,ctx->nl80211_id,NLM_F_DUMP,NLDUMP_SEQ_NL80211,&genlhdr,sizeof(genlhdr))==0) {
+		nlRecvReplies(fd,ctx->buf,NLDUMP_SEQ_NL80211,nlIfDumpWireless,ctx);
+	}
+
+	close(fd);
+}
+
+/**
+	\brief Retrieve all the interfaces available in the system, with all their attributes
+
+	This function fills the _records_ array with one [struct ifrecord](\ref ifrecord) for each interface available in the system (up to _max_),
+	in the same order in which they are listed by the kernel (i.e. by interface index).
+
+	All the attributes are retrieved through a single rtnetlink dump of the links and a single rtnetlink dump of the IPv4 addresses; the wireless interfaces
+	are then identified through an nl80211 dump. The replies are read inside a single buffer of [NLDUMP_BUFFER_SIZE](\ref NLDUMP_BUFFER_SIZE) _bytes_,
+	allocated on the heap for the duration of the call. If nl80211 is not available (e.g. the cfg80211 kernel module is not loaded), no interface is reported as wireless.
+
+	\param[out]	records 	Array of [struct ifrecord](\ref ifrecord) to be filled in.
+	\param[in]	max 		Number of elements of _records_ (the interfaces exceeding this number are ignored).
+
+	\return The number of records filled in, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_NLDUMP_SOCKET* -> unable to create the netlink socket (_errno_ is set by _socket()_)
+	- *ERR_NLDUMP_SEND* -> unable to send the dump requests (_errno_ is set by _sendto()_)
+	- *ERR_NLDUMP_RECV* -> unable to read the dumps (_errno_ is set by _recv()_, to the error reported by the kernel, or to _EMSGSIZE_ if a reply was truncated)
+	- *ERR_NLDUMP_ALLOC* -> unable to allocate the receive buffer
+**/
+int nlIfDump(struct ifrecord *records, unsigned int max) {
+	struct nldumpctx ctx;
+	struct ifinfomsg ifi;
+	struct ifaddrmsg ifa;
+	int ret;
+	int fd;
+
+	ctx.records=records;
+	ctx.max=max;
+	ctx.n=0;
+
+	// malloc() returns memory suitably aligned for any type, including struct nlmsghdr
+	ctx.buf=malloc(NLDUMP_BUFFER_SIZE);
+	if(ctx.buf==NULL) {
+		return ERR_NLDUMP_ALLOC;
+	}
+
+	fd=socket(AF_NETLINK,SOCK_RAW | SOCK_CLOEXEC,NETLINK_ROUTE);
+	if(fd<0) {
+		free(ctx.buf);
+		return ERR_NLDUMP_SOCKET;
+	}
+
+	memset(&ifi,0,sizeof(ifi));
+	ifi.ifi_family=AF_UNSPEC;
+
+	memset(&ifa,0,sizeof(ifa));
+	ifa.ifa_family=AF_INET;
+
+	if(nlSendRequest(fd,RTM_GETLINK,NLM_F_DUMP,NLDUMP_SEQ_LINK,&ifi,sizeof(ifi))<0) {
+		ret=ERR_NLDUMP_SEND;
+	} else if(nlRecvReplies(fd,ctx.buf,NLDUMP_SEQ_LINK,nlIfDumpLink,&ctx)<0) {
+		ret=ERR_NLDUMP_RECV;
+	} else if(nlSendRequest(fd,RTM_GETADDR,NLM_F_DUMP,NLDUMP_SEQ_ADDR,&ifa,sizeof(ifa))<0) {
+		ret=ERR_NLDUMP_SEND;
+	} else if(nlRecvReplies(fd,ctx.buf,NLDUMP_SEQ_ADDR,nlIfDumpAddr,&ctx)<0) {
+		ret=ERR_NLDUMP_RECV;
+	} else {
+		ret=0;
+	}
+
+	close(fd);
+
+	if(ret==0) {
+		nlIfDumpNl80211(&ctx);
+		ret=ctx.n;
+	}
+
+	free(ctx.buf);
+
+	return ret;
+}
+
+// Select, among the 'nrecords' interfaces retrieved by nlIfDump(), the one requested to wlanLookup(), and fill in its outputs
+static int wlanSelect(struct ifrecord *records, int nrecords, char *devname, int *ifindex, macaddr_t mac, struct in_addr *srcIP, int index, int mode) {
+	struct ifrecord *selected=NULL;
+	int i;
+	int ifno=0;
+	int return_value=1; // Return value: >0 ok - # of found interfaces, <=0 error
+
+	if(index==WLANLOOKUP_LOOPBACK) {
+		// Look for the first loopback interface
+		for(i=0;i<nrecords;i++) {
+			if(records[i].flags & IFF_LOOPBACK) {
+				selected=&records[i];
+				break;
 			}
-			return_value=ifno; // Return the number of interfaces found
-			// Iterate the list until the chosen interface is reached
-			iflist_it=iflist_head;
-			while(index<=ifno-2) {
-				iflist_it=iflist_it->next;
-				index++;
+		}
+
+		if(selected==NULL) {
+			return ERR_WLAN_NOIF;
+		}
+	} else {
+		// Scan the interfaces which are up, of the requested type, in the same order in which they are listed by the kernel,
+		//  and select the one corresponding to 'index'
+		for(i=0;i<nrecords;i++) {
+			if((records[i].flags & IFF_UP) && !(records[i].flags & IFF_LOOPBACK) &&
+				records[i].wireless==(mode==WLANLOOKUP_WLAN)) {
+				if(ifno==index) {
+					selected=&records[i];
+				}
+				ifno++;
 			}
-			strncpy(devname,iflist_it->ifaddr_ptr->ifa_name,IFNAMSIZ);
 		}
+
+		if(ifno==0) {
+			return ERR_WLAN_NOIF;
+		} else if(index>=ifno || selected==NULL) {
+			return ERR_WLAN_INDEX;
+		}
+
+		return_value=ifno; // Return the number of interfaces found
 	}
 
-	// Get MAC address of the interface (if requested by the user with a non-NULL mac)
+	strncpy(devname,selected->name,IFNAMSIZ);
+
 	if(mac!=NULL) {
-		strncpy(wifireq.ifr_name,devname,IFNAMSIZ); 
-		if(ioctl(sFd,SIOCGIFHWADDR,&wifireq)!=-1) {
-			memcpy(mac,wifireq.ifr_hwaddr.sa_data,MAC_ADDR_SIZE);
-		} else {
-			return_value=ERR_WLAN_GETSRCMAC;
-			goto error_occurred;
-		}
+		memcpy(mac,selected->mac,MAC_ADDR_SIZE);
 	}
 
-	// Get interface index of the interface (if requested by the user with a non-NULL ifindex)
 	if(ifindex!=NULL) {
-		strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
-		if(ioctl(sFd,SIOCGIFINDEX,&wifireq)!=-1) {
-			*ifindex=wifireq.ifr_ifindex;
-		} else {
-			return_value=ERR_WLAN_GETIFINDEX;
-			goto error_occurred;
-		}
+		*ifindex=selected->ifindex;
 	}
 
-	// Get the IP address of the interface (if requested by the user with a non-NULL struct in_addr)
 	if(srcIP!=NULL) {
-		strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
-		wifireq.ifr_addr.sa_family = AF_INET;
-		if(ioctl(sFd,SIOCGIFADDR,&wifireq)!=-1) {
-			*srcIP=((struct sockaddr_in*)&wifireq.ifr_addr)->sin_addr;
+		if(selected->ip_valid) {
+			*srcIP=selected->ip;
 		} else {
 			return_value=ERR_WLAN_GETSRCIP;
-			// No need to go to error_occurred, as we are already there
 		}
 	}
 
-	error_occurred:
-	// iflist and the other list are no more useful -> free them
-	freeifaddrs(ifaddr_head);
-	for(iflist_it=iflist_head;iflist_it!=NULL;iflist_it=iflist_u) {
-		iflist_u=iflist_it->next;
-		free(iflist_it);
+	return return_value;
+}
+
+/**
+	\brief Automatically look for available WLAN, non-WLAN or loopback interfaces.
+	
+	This function can be used to automatically look for available and ready WLAN or non-WLAN (depending on _mode_)
+	interfaces in the system.
+
+	From version 0.2.0 it is also possible to specify [WLANLOOKUP_LOOPBACK](\ref WLANLOOKUP_LOOPBACK) as _index_
+	to look for the first available lookback interface, instead of WLAN/non-WLAN ones.
+
+	When only one interface is available and `0` is specified as index, 
+	that interface name is returned inside `devname`. 
+	Then, if the other three arguments are not NULL, the interface index,
+	the corresponding source MAC address (if available) and
+	the corresponding source IP address (if available) are respectively returned.
+
+	If more than one interface is present, the number of available interfaces of the specified type (WLAN/non-WLAN)
+	is returned by the function and _index_ is used to point to a specific interface 
+	(for instance `index=1` can be used to point to a possible `wlan1` interface when _mode_ is [WLANLOOKUP_WLAN](\ref WLANLOOKUP_WLAN)).
+
+	The interfaces, with all their attributes, are retrieved through a single netlink dump (see nlIfDump()): an interface is considered
+	to be a WLAN interface if it is reported by nl80211. The indeces follow the order in which the interfaces are listed by the kernel.
+
+	To print the available indeces, the user can use vifPrinter().
+
+	\param[out] 	devname 	Name of the WLAN interface.
+	\param[out]		ifindex 	Interface index corresponding to _devname_ (filled in only if non-NULL).
+	\param[out]		mac     	Interface (source) MAC address (filled in only if non-NULL / non-[MAC_NULL](\ref MAC_NULL)).
+	\param[out]		srcIP		Interface (source) IPv4 address (filled in only if non-NULL and returned inside a _struct in_addr_, which should be available in the calling module).
+	\param[in]		index       Integer index used to point to a specific interface of the specified type (i.e. using the specified _mode_), when more than one is available (or equal to [WLANLOOKUP_LOOPBACK](\ref WLANLOOKUP_LOOPBACK) to look for the first available loopback interface).
+	\param[in] 		mode 		Operating mode: [WLANLOOKUP_WLAN](\ref WLANLOOKUP_WLAN) to look for available WLAN interfaces only, [WLANLOOKUP_NONWLAN](\ref WLANLOOKUP_NONWLAN) to look for available non-WLAN/Ethernet interfaces only
+
+	\return Number of WLAN/non-WLAN interfaces that were found, <b> > 0 </b>, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_WLAN_NOIF* -> no interfaces found
+	- *ERR_WLAN_SOCK* -> cannot create the netlink socket to look for available and running interfaces
+	- *ERR_WLAN_GETIFADDRS* -> error while retrieving the interfaces list through netlink (see nlIfDump()), or while allocating the memory to store it
+	- *ERR_WLAN_INDEX* -> invalid index value
+	- *ERR_WLAN_GETSRCIP* -> the interface has no IPv4 address (if requested); all the other outputs are filled in anyway
+**/
+rawsockerr_t wlanLookup(char *devname, int *ifindex, macaddr_t mac, struct in_addr *srcIP, int index, int mode) {
+	// All the interfaces, with their attributes, retrieved through a single netlink dump
+	struct ifrecord *records;
+	int nrecords;
+	int return_value;
+
+	records=malloc(NLDUMP_MAX_IFRECORDS*sizeof(struct ifrecord));
+	if(records==NULL) {
+		return ERR_WLAN_GETIFADDRS;
+	}
+
+	nrecords=nlIfDump(records,NLDUMP_MAX_IFRECORDS);
+	if(nrecords<0) {
+		return_value=nrecords==ERR_NLDUMP_SOCKET ? ERR_WLAN_SOCK : ERR_WLAN_GETIFADDRS;
+	} else {
+		return_value=wlanSelect(records,nrecords,devname,ifindex,mac,srcIP,index,mode);
 	}
 
-	getifaddrs_error_occurred:
-	// Close socket
-	close(sFd);
+	free(records);
 
-	sock_error_occurred:
 	return return_value;
 }
 
@@ -320,64 +607,115 @@ rawsockerr_t wlanLookup(char *devname, int *ifindex, macaddr_t mac, struct in_ad
 
 	\param[out] 	stream 		File stream to print to (a file, _stdout_ or _stderr_)
 
-	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
-	- *ERR_VIFPRINTER_SOCK* -> cannot create socket to look for available interfaces
-	- *ERR_VIFPRINTER_GETIFADDRS* -> error in calling `getifaddrs()`
+	\return **1** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_VIFPRINTER_SOCK* -> cannot create the netlink socket to look for available interfaces
+	- *ERR_VIFPRINTER_GETIFADDRS* -> error while retrieving the interfaces list through netlink (see nlIfDump()), or while allocating the memory to store it
 **/
 rawsockerr_t vifPrinter(FILE *stream) {
-	int sFd=-1;
-	struct ifaddrs *ifaddr_head, *ifaddr_it;
-	struct ifreq wifireq;
+	struct ifrecord *records;
+	int nrecords;
+	int i;
 	int wlan_ifno=0;
 	int nonwlan_ifno=0;
 
-	// Open socket (needed)
-	sFd=socket(AF_INET,SOCK_DGRAM,0); // Any socket should be fine (to be better investigated!)
-	if(sFd==-1) {
-		return ERR_VIFPRINTER_SOCK;
+	records=malloc(NLDUMP_MAX_IFRECORDS*sizeof(struct ifrecord));
+	if(records==NULL) {
+		return ERR_VIFPRINTER_GETIFADDRS;
 	}
 
-	// Getting all interface addresses
-	if(getifaddrs(&ifaddr_head)==-1) {
-		close(sFd);
-		return ERR_VIFPRINTER_GETIFADDRS;
+	nrecords=nlIfDump(records,NLDUMP_MAX_IFRECORDS);
+	if(nrecords<0) {
+		free(records);
+		return nrecords==ERR_NLDUMP_SOCKET ? ERR_VIFPRINTER_SOCK : ERR_VIFPRINTER_GETIFADDRS;
 	}
 
 	fprintf(stream,"Interface name   | Interface type | Interface internal index\n"
 		 "--------------   | -------------- | ------------------------\n");
 
-	// Looking for wlan interfaces
-	memset(&wifireq,0,sizeof(wifireq));
-	// Iterating over the interfaces linked list
-	for(ifaddr_it=ifaddr_head;ifaddr_it!=NULL;ifaddr_it=ifaddr_it->ifa_next) {
-		if(ifaddr_it->ifa_addr!=NULL && (ifaddr_it->ifa_flags & IFF_LOOPBACK) && ifaddr_it->ifa_addr->sa_family==AF_PACKET) {
-			fprintf(stream,"%s\t\t | %-14s | %s\t\n",ifaddr_it->ifa_name,"Loopback","(lo)");
-		} else {
-			if(ifaddr_it->ifa_addr!=NULL && ifaddr_it->ifa_addr->sa_family==AF_PACKET) {
-				strncpy(wifireq.ifr_name,ifaddr_it->ifa_name,IFNAMSIZ); 
-				if(ioctl(sFd,SIOCGIWNAME,&wifireq)!=-1) {
-					if(ioctl(sFd,SIOCGIFFLAGS,&wifireq)!=-1 && (wifireq.ifr_flags & IFF_UP)) {
-						// If the interface is up, print the information related to such interface
-						fprintf(stream,"%-*s | %-14s | (wlan) %d\t\n",IFNAMSIZ,ifaddr_it->ifa_name,"Wireless",wlan_ifno);
-						wlan_ifno++;
-					}
-				} else {
-					// Interface is not wireless
-					if(ifaddr_it->ifa_addr!=NULL && (ifaddr_it->ifa_flags & IFF_UP)) {
-						fprintf(stream,"%-*s | %-14s | (non-wlan) %d\t\n",IFNAMSIZ,ifaddr_it->ifa_name,"Non-wireless",nonwlan_ifno);
-						nonwlan_ifno++;
-					}
-				}
-			} else if(ifaddr_it->ifa_addr!=NULL && ifaddr_it->ifa_addr->sa_family==AF_INET && is_if_tun(sFd,ifaddr_it->ifa_name)) {
-				fprintf(stream,"%-*s | %-14s | (non-wlan) %d\t\n",IFNAMSIZ,ifaddr_it->ifa_name,"tun (AF_INET)",nonwlan_ifno);
+	for(i=0;i<nrecords;i++) {
+		if(records[i].flags & IFF_LOOPBACK) {
+			fprintf(stream,"%s\t\t | %-14s | %s\t\n",records[i].name,"Loopback","(lo)");
+		} else if(records[i].flags & IFF_UP) {
+			// If the interface is up, print the information related to such interface
+			if(records[i].wireless) {
+				fprintf(stream,"%-*s | %-14s | (wlan) %d\t\n",IFNAMSIZ,records[i].name,"Wireless",wlan_ifno);
+				wlan_ifno++;
+			} else {
+				fprintf(stream,"%-*s | %-14s | (non-wlan) %d\t\n",IFNAMSIZ,records[i].name,records[i].tun ? "tun (AF_INET)" : "Non-wireless",nonwlan_ifno);
 				nonwlan_ifno++;
 			}
 		}
 	}
 
+	free(records);
+
 	return 1;
 }
 
+/**
+	\brief Resolve the properties of an interface into a [struct ifdesc](\ref ifdesc)
+
+	This function retrieves, once, the index, the MAC address, the IPv4 address and the MTU of the interface named _devname_ (for instance
+	the one returned by wlanLookup()), and stores them, together with its name, inside _ifd_.
+
+	The descriptor can then be passed to the [IP4headPopulate*Ifd()](\ref IP4headPopulateIfd) functions, which, unlike [IP4headPopulate*()](\ref IP4headPopulate),
+	do not need to open a socket and to perform an _ioctl()_ every time they are called. It can be kept up to date through the netlink listener
+	of the rawsock_netlink.h module (see nlwatchProcess()).
+
+	An interface without any IPv4 address is not considered an error: in this case, _ip_valid_ is set to _false_.
+
+	\param[out]	ifd 		Pointer to the [struct ifdesc](\ref ifdesc) to be filled in.
+	\param[in]	devname 	Interface name.
+
+	\return **0** if the descriptor was properly filled in, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_IFDESC_SOCK* -> internal socket creation error
+	- *ERR_IFDESC_NOIF* -> the interface does not exist
+	- *ERR_IFDESC_IOCTL* -> unable to retrieve the MAC address or the MTU of the interface
+**/
+rawsockerr_t ifdescResolve(struct ifdesc *ifd, const char *devname) {
+	int sFd;
+	struct ifreq ifreq;
+
+	memset(ifd,0,sizeof(struct ifdesc));
+	strncpy(ifd->name,devname,IFDESC_NAME_SIZE-1);
+
+	sFd=socket(AF_INET,SOCK_DGRAM,0);
+	if(sFd==-1) {
+		return ERR_IFDESC_SOCK;
+	}
+
+	memset(&ifreq,0,sizeof(ifreq));
+	memcpy(ifreq.ifr_name,ifd->name,IFDESC_NAME_SIZE);
+
+	if(ioctl(sFd,SIOCGIFINDEX,&ifreq)!=0) {
+		close(sFd);
+		return ERR_IFDESC_NOIF;
+	}
+	ifd->ifindex=ifreq.ifr_ifindex;
+
+	if(ioctl(sFd,SIOCGIFHWADDR,&ifreq)!=0) {
+		close(sFd);
+		return ERR_IFDESC_IOCTL;
+	}
+	memcpy(ifd->mac,ifreq.ifr_hwaddr.sa_data,MAC_ADDR_SIZE);
+
+	if(ioctl(sFd,SIOCGIFMTU,&ifreq)!=0) {
+		close(sFd);
+		return ERR_IFDESC_IOCTL;
+	}
+	ifd->mtu=ifreq.ifr_mtu;
+
+	ifreq.ifr_addr.sa_family=AF_INET;
+	if(ioctl(sFd,SIOCGIFADDR,&ifreq)==0) {
+		ifd->ip=((struct sockaddr_in*)&ifreq.ifr_addr)->sin_addr;
+		ifd->ip_valid=true;
+	}
+
+	close(sFd);
+
+	return 0;
+}
+
 /**
 	\brief Print more detailed error messages
 
@@ -434,19 +772,288 @@ void rs_printerror(FILE *stream,rawsockerr_t code) {
 			fprintf(stream,"IP4headPopulateB: unable to retrieve source IP address.\n");
 		break;
 
-		default:
-			fprintf(stream,"No error.\n");
-	}
-}
+		case ERR_FRAMEBUF_ALLOC:
+			fprintf(stream,"framebuf: unable to allocate memory for the frame buffer.\n");
+		break;
 
-/**
-	\brief Display packet in hexadecimal form
+		case ERR_FRAMEBUF_HEADROOM:
+			fprintf(stream,"framebuf: the requested headroom does not fit inside the buffer.\n");
+		break;
 
-	This function can be used to display a packet content in hexadecimal form,
-	given the pointer to a buffer of [bytes](\ref byte_t) and its length (_len_).
+		case ERR_FRAMEBUF_NOSPACE:
+			fprintf(stream,"framebuf: the payload does not fit inside the buffer.\n");
+		break;
 
-	_text_ can be used to specify an additional text that will be printer before
-	printing the actual packet content.
+		case ERR_TXRING_PARAMS:
+			fprintf(stream,"txring: invalid frame size or number of frames.\n");
+		break;
+
+		case ERR_TXRING_SOCKOPT:
+			fprintf(stream,"txring: unable to set up the ring on the socket.\n");
+		break;
+
+		case ERR_TXRING_MMAP:
+			fprintf(stream,"txring: mmap() error.\n");
+		break;
+
+		case ERR_TXRING_FULL:
+			fprintf(stream,"txring: no free slot available.\n");
+		break;
+
+		case ERR_TXRING_FRAMESIZE:
+			fprintf(stream,"txring: the frame does not fit inside a slot.\n");
+		break;
+
+		case ERR_TXRING_SEND:
+			fprintf(stream,"txring: unable to flush the ring.\n");
+		break;
+
+		case ERR_RXRING_PARAMS:
+			fprintf(stream,"rxring: invalid block size, number of blocks or frame size.\n");
+		break;
+
+		case ERR_RXRING_SOCKOPT:
+			fprintf(stream,"rxring: unable to set up the ring on the socket or to read its statistics.\n");
+		break;
+
+		case ERR_RXRING_MMAP:
+			fprintf(stream,"rxring: mmap() error.\n");
+		break;
+
+		case ERR_RXRING_POLL:
+			fprintf(stream,"rxring: poll() error.\n");
+		break;
+
+		case ERR_RECVBATCH_SOCKOPT:
+			fprintf(stream,"rawRecvBatch: unable to enable the reception timestamps.\n");
+		break;
+
+		case ERR_RECVBATCH_RECV:
+			fprintf(stream,"rawRecvBatch: recvmmsg() error.\n");
+		break;
+
+		case ERR_XSK_PARAMS:
+			fprintf(stream,"xskOpen: invalid frame size, number of frames or ring size.\n");
+		break;
+
+		case ERR_XSK_SOCKET:
+			fprintf(stream,"xskOpen: unable to create the AF_XDP socket.\n");
+		break;
+
+		case ERR_XSK_UMEM:
+			fprintf(stream,"xskOpen: unable to allocate or register the UMEM.\n");
+		break;
+
+		case ERR_XSK_RINGS:
+			fprintf(stream,"xskOpen: unable to set up or map the rings.\n");
+		break;
+
+		case ERR_XSK_BIND:
+			fprintf(stream,"xskOpen: unable to bind the socket to the interface queue.\n");
+		break;
+
+		case ERR_XSK_PROG:
+			fprintf(stream,"xskOpen: unable to load the XDP program or to create the XSKMAP.\n");
+		break;
+
+		case ERR_XSK_ATTACH:
+			fprintf(stream,"xskOpen: unable to attach the XDP program to the interface.\n");
+		break;
+
+		case ERR_XSK_NOFRAME:
+			fprintf(stream,"xsk: no free UMEM frame is available.\n");
+		break;
+
+		case ERR_XSK_TXFULL:
+			fprintf(stream,"xsk: the TX ring is full.\n");
+		break;
+
+		case ERR_XSK_SEND:
+			fprintf(stream,"xskFlush: the kernel returned an error when sending the queued frames.\n");
+		break;
+
+		case ERR_XSK_POLL:
+			fprintf(stream,"xskRecv: poll() error.\n");
+		break;
+
+		case ERR_FANOUT_PARAMS:
+			fprintf(stream,"fanout: invalid settings, or engine already running.\n");
+		break;
+
+		case ERR_FANOUT_SOCKET:
+			fprintf(stream,"fanoutOpen: unable to create or bind a worker socket.\n");
+		break;
+
+		case ERR_FANOUT_RING:
+			fprintf(stream,"fanoutOpen: unable to set up the RX ring of a worker.\n");
+		break;
+
+		case ERR_FANOUT_JOIN:
+			fprintf(stream,"fanoutOpen: unable to join the PACKET_FANOUT group or to attach the eBPF program.\n");
+		break;
+
+		case ERR_FANOUT_THREAD:
+			fprintf(stream,"fanout: unable to create a worker thread.\n");
+		break;
+
+		case ERR_FANOUT_ALLOC:
+			fprintf(stream,"fanoutOpen: unable to allocate the memory for the workers.\n");
+		break;
+
+		case ERR_FILTER_PARAMS:
+			fprintf(stream,"filterCompile: inconsistent filter description.\n");
+		break;
+
+		case ERR_FILTER_ATTACH:
+			fprintf(stream,"filter: unable to attach or detach the filter.\n");
+		break;
+
+		case ERR_IFDESC_SOCK:
+			fprintf(stream,"ifdescResolve: socket creation error.\n");
+		break;
+
+		case ERR_IFDESC_NOIF:
+			fprintf(stream,"ifdescResolve: the interface does not exist.\n");
+		break;
+
+		case ERR_IFDESC_IOCTL:
+			fprintf(stream,"ifdescResolve: unable to retrieve the MAC address or the MTU.\n");
+		break;
+
+		case ERR_NLWATCH_SOCKET:
+			fprintf(stream,"nlwatchOpen: unable to create the netlink socket.\n");
+		break;
+
+		case ERR_NLWATCH_BIND:
+			fprintf(stream,"nlwatchOpen: unable to subscribe to the netlink notifications.\n");
+		break;
+
+		case ERR_NLWATCH_RECV:
+			fprintf(stream,"nlwatchProcess: recv() error.\n");
+		break;
+
+		case ERR_NLWATCH_POLL:
+			fprintf(stream,"nlwatchProcess: poll() error.\n");
+		break;
+
+		case ERR_NLDUMP_SOCKET:
+			fprintf(stream,"nlIfDump: unable to create the netlink socket.\n");
+		break;
+
+		case ERR_NLDUMP_SEND:
+			fprintf(stream,"nlIfDump: unable to send the netlink dump requests.\n");
+		break;
+
+		case ERR_NLDUMP_RECV:
+			fprintf(stream,"nlIfDump: unable to read the netlink dumps.\n");
+		break;
+
+		case ERR_NLDUMP_ALLOC:
+			fprintf(stream,"nlIfDump: unable to allocate the receive buffer.\n");
+		break;
+
+		case ERR_FLOWTPL_PARAMS:
+			fprintf(stream,"flowtemplateInit: the headers do not describe an IPv4 UDP flow over Ethernet.\n");
+		break;
+
+		case ERR_LAMPTS_SOCKOPT:
+			fprintf(stream,"lampTimestampingEnable: unable to set SO_TIMESTAMPING.\n");
+		break;
+
+		case ERR_LAMPTS_HWCONFIG:
+			fprintf(stream,"lampTimestampingEnable: unable to enable hardware timestamping on the interface.\n");
+		break;
+
+		case ERR_LAMPTS_RECV:
+			fprintf(stream,"lampTxTstampCollect: unable to read the socket error queue.\n");
+		break;
+
+		case ERR_CLOCK_SOURCE:
+			fprintf(stream,"rsclockInit: invalid or unsupported clock source.\n");
+		break;
+
+		case ERR_CLOCK_NOTSC:
+			fprintf(stream,"rsclockInitTsc: no invariant TSC available.\n");
+		break;
+
+		case ERR_CLOCK_CALIB:
+			fprintf(stream,"rsclockInitTsc: TSC calibration failed.\n");
+		break;
+
+		case ERR_LATHIST_NOSPACE:
+			fprintf(stream,"lathistSerialize: the histogram does not fit inside the buffer.\n");
+		break;
+
+		case ERR_LATHIST_FORMAT:
+			fprintf(stream,"lathistDeserialize: invalid or incompatible histogram.\n");
+		break;
+
+		case ERR_LAMPSEQ_ALLOC:
+			fprintf(stream,"lampSeqTablePrepare: unable to allocate the sequence window table.\n");
+		break;
+
+		case ERR_LAMPSEQ_SIZE:
+			fprintf(stream,"lampSeqTable: the table size is not a power of two.\n");
+		break;
+
+		case ERR_LAMPSEQ_FULL:
+			fprintf(stream,"lampSeqTableUpdate: the sequence window table is full.\n");
+		break;
+
+		case ERR_PACER_PARAMS:
+			fprintf(stream,"pacerInit: invalid pacer settings.\n");
+		break;
+		case ERR_TXTIME_SOCKOPT:
+			fprintf(stream,"rawTxtimeEnable: cannot set SO_TXTIME on the socket.\n");
+		break;
+		case ERR_PCAP_OPEN:
+			fprintf(stream,"pcapwriterOpen/pcapreaderOpen: cannot create or open the file.\n");
+		break;
+		case ERR_PCAP_ALLOC:
+			fprintf(stream,"pcapwriterOpen: cannot allocate the write buffer.\n");
+		break;
+		case ERR_PCAP_WRITE:
+			fprintf(stream,"pcapwriter: cannot write to the pcapng file.\n");
+		break;
+		case ERR_PCAP_IFACE:
+			fprintf(stream,"pcapwriter: invalid interface or too many interfaces.\n");
+		break;
+		case ERR_PCAP_FORMAT:
+			fprintf(stream,"pcapreader: invalid, truncated or unsupported pcap/pcapng file.\n");
+		break;
+		case ERR_PCAP_MMAP:
+			fprintf(stream,"pcapreaderOpen: cannot map the file in memory.\n");
+		break;
+
+		case ERR_REPLAY_PARAMS:
+			fprintf(stream,"replayOpen: invalid replay settings or too many remapping rules.\n");
+		break;
+
+		case ERR_REPLAY_IFACE:
+			fprintf(stream,"replayOpen: cannot find the output interface.\n");
+		break;
+
+		case ERR_REPLAY_SOCKET:
+			fprintf(stream,"replayOpen: cannot create the raw socket.\n");
+		break;
+
+		case ERR_REPLAY_ALLOC:
+			fprintf(stream,"replayOpen: cannot allocate the buffer for the modified frames.\n");
+		break;
+
+		default:
+			fprintf(stream,"No error.\n");
+	}
+}
+
+/**
+	\brief Display packet in hexadecimal form
+
+	This function can be used to display a packet content in hexadecimal form,
+	given the pointer to a buffer of [bytes](\ref byte_t) and its length (_len_).
+
+	_text_ can be used to specify an additional text that will be printer before
+	printing the actual packet content.
 
 	\note _stdout_ is always used to print the requested information.
 
@@ -533,6 +1140,232 @@ uint64_t ntoh64 (uint64_t netu64) {
 	return swap64(netu64,&ntohl);
 }
 
+/**
+	\brief Prepare a [struct framebuf](\ref framebuf), allocating a new buffer
+
+	This function allocates a single buffer, big enough to contain _headroom_ bytes, reserved for the lower layer headers,
+	followed by a payload of up to _maxpayloadsize_ bytes, and it initializes the specified [struct framebuf](\ref framebuf) to manage it.
+
+	The payload should then be written, only once, starting from the pointer returned by framebufPayloadPtr() (or copied with framebufCopyPayload()),
+	and the headers should be added in place with UDPencapsulateInPlace(), IP4EncapsulateInPlace() and etherEncapsulateInPlace(), in this order.
+
+	__Example of use:__
+
+		struct framebuf fb;
+
+		framebufPrepare(&fb,ETH_IP_UDP_HEADROOM,MAX_PAYLOAD_SIZE);
+
+	\param[out]	fb 				Pointer to the [struct framebuf](\ref framebuf) to be initialized.
+	\param[in]	headroom 		Space, in _bytes_, to be reserved in front of the payload (for instance [ETH_IP_UDP_HEADROOM](\ref ETH_IP_UDP_HEADROOM) for Ethernet+IPv4+UDP).
+	\param[in]	maxpayloadsize 	Maximum size, in _bytes_, of the payload that will be stored inside the buffer.
+
+	\return **0** if the buffer was properly allocated, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_ALLOC* -> unable to allocate the memory for the buffer (or _headroom_ plus _maxpayloadsize_ exceeds the largest possible size)
+**/
+rawsockerr_t framebufPrepare(struct framebuf *fb, size_t headroom, size_t maxpayloadsize) {
+	byte_t *buf;
+
+	// The total size would wrap around, and a smaller buffer would be allocated
+	if(maxpayloadsize>SIZE_MAX-headroom) {
+		return ERR_FRAMEBUF_ALLOC;
+	}
+
+	buf=malloc(headroom+maxpayloadsize);
+	if(buf==NULL) {
+		return ERR_FRAMEBUF_ALLOC;
+	}
+
+	framebufInit(fb,buf,headroom+maxpayloadsize,headroom);
+	fb->allocated=true;
+
+	return 0;
+}
+
+/**
+	\brief Initialize a [struct framebuf](\ref framebuf) over an already existing buffer
+
+	This function works like framebufPrepare(), but instead of allocating a new buffer, it uses the one specified by the user
+	(for instance a static array, or a memory area which is directly mapped from the kernel), with a total size of _size_ bytes.
+
+	The buffer is never freed by framebufFree() when this function is used.
+
+	\param[out]	fb 			Pointer to the [struct framebuf](\ref framebuf) to be initialized.
+	\param[in]	buf 		Already existing buffer.
+	\param[in]	size 		Total size of _buf_, in _bytes_.
+	\param[in]	headroom 	Space, in _bytes_, to be reserved in front of the payload.
+
+	\return **0** if the structure was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_HEADROOM* -> _headroom_ is larger than _size_
+**/
+rawsockerr_t framebufInit(struct framebuf *fb, byte_t *buf, size_t size, size_t headroom) {
+	if(headroom>size) {
+		return ERR_FRAMEBUF_HEADROOM;
+	}
+
+	fb->buf=buf;
+	fb->size=size;
+	fb->headroom=headroom;
+	fb->data=buf+headroom;
+	fb->len=0;
+	fb->allocated=false;
+	fb->payloadcsum_valid=false;
+
+	return 0;
+}
+
+/**
+	\brief Free a [struct framebuf](\ref framebuf)
+
+	Frees the buffer managed by the specified [struct framebuf](\ref framebuf), only if it was allocated by framebufPrepare().
+
+	\param[in]	fb 		Pointer to a previously prepared [struct framebuf](\ref framebuf).
+
+	\return None.
+**/
+void framebufFree(struct framebuf *fb) {
+	if(fb->allocated) {
+		free(fb->buf);
+	}
+
+	fb->buf=NULL;
+	fb->data=NULL;
+	fb->size=0;
+	fb->len=0;
+	fb->allocated=false;
+	fb->payloadcsum_valid=false;
+}
+
+/**
+	\brief Get the pointer to the payload area of a [struct framebuf](\ref framebuf)
+
+	This function returns the pointer to the first byte after the headroom, i.e. to the memory area in which the payload
+	(for instance a UDP payload) should be directly written. After writing it, framebufSetPayloadSize() should be called.
+
+	As the payload can be modified through the returned pointer, any payload checksum stored by framebufCopyPayload() or framebufSetPayloadCsum()
+	is discarded, and it will be computed again by UDPencapsulateInPlace().
+
+	\warning A payload modified through a pointer obtained before the last call to framebufCopyPayload() or framebufSetPayloadCsum() (e.g. a pointer
+	to a header stored inside the payload) is not detected: in this case, framebufPayloadPtr() or framebufSetPayloadSize() should be called again
+	before encapsulating the payload, otherwise the UDP checksum will be computed over the old payload.
+
+	\param[in,out]	fb 		Pointer to a previously prepared [struct framebuf](\ref framebuf).
+
+	\return The pointer to the payload area, inside the buffer managed by _fb_.
+**/
+byte_t *framebufPayloadPtr(struct framebuf *fb) {
+	fb->payloadcsum_valid=false;
+
+	return fb->buf+fb->headroom;
+}
+
+/**
+	\brief Set the size of the payload stored inside a [struct framebuf](\ref framebuf)
+
+	This function should be called after writing the payload starting from the pointer returned by framebufPayloadPtr().
+	It also resets any header which was previously added, so that the same [struct framebuf](\ref framebuf) can be reused
+	to build a new frame. As the payload may have been changed, the payload checksum will be computed again by UDPencapsulateInPlace().
+
+	\param[in,out]	fb 				Pointer to a previously prepared [struct framebuf](\ref framebuf).
+	\param[in]		payloadsize 	Size, in _bytes_, of the payload.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_NOSPACE* -> the payload does not fit inside the buffer
+**/
+rawsockerr_t framebufSetPayloadSize(struct framebuf *fb, size_t payloadsize) {
+	if(payloadsize>fb->size-fb->headroom) {
+		return ERR_FRAMEBUF_NOSPACE;
+	}
+
+	fb->data=fb->buf+fb->headroom;
+	fb->len=payloadsize;
+	fb->payloadcsum_valid=false;
+
+	return 0;
+}
+
+/**
+	\brief Copy a payload inside a [struct framebuf](\ref framebuf)
+
+	This function can be used, instead of directly writing the payload through framebufPayloadPtr(), when the payload
+	is already stored inside another buffer. It copies _payloadsize_ bytes from _data_ to the payload area and then
+	it behaves like framebufSetPayloadSize().
+
+	The payload is checksummed while it is copied (see csum_partial_copy()), and the result is stored inside _fb_, so that
+	UDPencapsulateInPlace() does not need to read the payload again.
+
+	\param[in,out]	fb 				Pointer to a previously prepared [struct framebuf](\ref framebuf).
+	\param[in]		data 			Buffer containing the payload.
+	\param[in]		payloadsize 	Size, in _bytes_, of the payload.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_NOSPACE* -> the payload does not fit inside the buffer
+**/
+rawsockerr_t framebufCopyPayload(struct framebuf *fb, byte_t *data, size_t payloadsize) {
+	if(payloadsize>fb->size-fb->headroom) {
+		return ERR_FRAMEBUF_NOSPACE;
+	}
+
+	fb->payloadcsum=csum_partial_copy(data,fb->buf+fb->headroom,payloadsize,0);
+
+	fb->data=fb->buf+fb->headroom;
+	fb->len=payloadsize;
+	fb->payloadcsum_valid=true;
+
+	return 0;
+}
+
+/**
+	\brief Set the size of the payload stored inside a [struct framebuf](\ref framebuf), together with its already computed checksum
+
+	This function works like framebufSetPayloadSize(), but it also stores inside _fb_ the partial checksum of the payload, already
+	computed with a [csumacc_t](\ref csumacc_t) accumulator, so that UDPencapsulateInPlace() (or flowtemplateStampInPlace()) does not need
+	to read the payload at all. It is useful when the same payload is sent many times, for instance to many different receivers:
+	its checksum can be computed only once.
+
+	\param[in,out]	fb 			Pointer to a previously prepared [struct framebuf](\ref framebuf).
+	\param[in]		payloadacc 	Accumulator containing the sum of the whole payload, starting from its first byte (its _len_ field is used as payload size).
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_NOSPACE* -> the payload does not fit inside the buffer
+**/
+rawsockerr_t framebufSetPayloadCsum(struct framebuf *fb, const csumacc_t *payloadacc) {
+	rawsockerr_t ret=framebufSetPayloadSize(fb,payloadacc->len);
+
+	if(ret!=0) {
+		return ret;
+	}
+
+	fb->payloadcsum=payloadacc->sum;
+	fb->payloadcsum_valid=true;
+
+	return 0;
+}
+
+/**
+	\brief Make room for a new header in front of the current content of a [struct framebuf](\ref framebuf)
+
+	This function moves the beginning of the frame _hdrsize_ bytes towards the beginning of the buffer, and returns the
+	pointer to the new beginning of the frame, where the header should be written.
+
+	It is internally used by the [*EncapsulateInPlace()](\ref UDPencapsulateInPlace) functions, but it can be used to add in place
+	any other header, not directly supported by the library.
+
+	\param[in,out]	fb 			Pointer to a previously prepared [struct framebuf](\ref framebuf).
+	\param[in]		hdrsize 	Size, in _bytes_, of the header to be added.
+
+	\return The pointer to the area in which the header should be written, or NULL if there is not enough headroom left.
+**/
+byte_t *framebufPush(struct framebuf *fb, size_t hdrsize) {
+	if((size_t)(fb->data-fb->buf)<hdrsize) {
+		return NULL;
+	}
+
+	fb->data-=hdrsize;
+	fb->len+=hdrsize;
+
+	return fb->data;
+}
+
 /**
 	\brief Populate broadcast Ethernet header (variant of etherheadPopulate())
 
@@ -618,6 +1451,29 @@ size_t etherEncapsulate(byte_t *packet,struct ether_header *header,byte_t *sdu,s
 	return packetsize;
 }
 
+/**
+	\brief Add, in place, an Ethernet header to the content of a [struct framebuf](\ref framebuf)
+
+	This function works like etherEncapsulate(), but, instead of copying the SDU inside a new packet buffer, it writes the header
+	directly in front of the SDU already stored inside _fb_ (i.e. inside its headroom), without any additional copy of the SDU.
+
+	\param[in,out]	fb 		[struct framebuf](\ref framebuf) containing the SDU (for instance, after a call to IP4EncapsulateInPlace()).
+	\param[in]		header 	Ethernet header, as *struct ether_header*. Should be filled in with [etherheadPopulate*()](\ref etherheadPopulate()) before being passed to this function.
+
+	\return The full packet size (SDU+PCI), in _bytes_, or **0** if there was not enough headroom left inside _fb_.
+**/
+size_t etherEncapsulateInPlace(struct framebuf *fb,struct ether_header *header) {
+	byte_t *hdrptr=framebufPush(fb,sizeof(struct ether_header));
+
+	if(hdrptr==NULL) {
+		return 0;
+	}
+
+	memcpy(hdrptr,header,sizeof(struct ether_header));
+
+	return fb->len;
+}
+
 /**
 	\brief Retrieve source MAC address field from Ethernet header
 
@@ -677,42 +1533,18 @@ void getSrcMAC(struct ether_header *etherHeader, macaddr_t macsrc) {
 **/
 rawsockerr_t IP4headPopulate(struct iphdr *IPhead, char *devname, char *destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
 	struct in_addr destIPAddr;
-	int sFd; // To get the current IP address
-	struct ifreq wifireq;
+	struct in_addr srcIPAddr;
+	rawsockerr_t ret;
 
-	IPhead->ihl=BASIC_IHL;
-	IPhead->version=IPV4;
-	IPhead->tos=(__u8) tos;
-	IPhead->frag_off=htons(frag_offset);
-	IPhead->frag_off=(IPhead->frag_off) | flags;
-	IPhead->ttl=(__u8) ttl;
-	IPhead->protocol=(__u8) protocol;
 	inet_pton(AF_INET,destIP,(struct in_addr *)&destIPAddr);
-	IPhead->daddr=destIPAddr.s_addr;
+	IP4headFill(IPhead,destIPAddr.s_addr,tos,frag_offset,ttl,protocol,flags);
 
 	// Get own IP address
-	sFd=socket(AF_INET,SOCK_DGRAM,0);
-	if(sFd==-1) {
-		return ERR_IPHEAD_SOCK;
-	}
-	strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
-	wifireq.ifr_addr.sa_family = AF_INET;
-	if(ioctl(sFd,SIOCGIFADDR,&wifireq)!=0) {
-		close(sFd);
-		return ERR_IPHEAD_NOSRCADDR;
+	ret=getIfIPv4Addr(devname,&srcIPAddr);
+	if(ret!=0) {
+		return ret;
 	}
-	close(sFd);
-	IPhead->saddr=((struct sockaddr_in*)&wifireq.ifr_addr)->sin_addr.s_addr;
-	if(addrs!=NULL) {
-		addrs->src=IPhead->saddr;
-		addrs->dst=IPhead->daddr;
-	}
-
-	// Initialize checksum to 0
-	IPhead->check=0;
-
-	// Initialize ID to 0
-	IPhead->id=0;
+	IP4headSetSrc(IPhead,srcIPAddr.s_addr,addrs);
 
 	return 0;
 }
@@ -753,41 +1585,17 @@ rawsockerr_t IP4headPopulate(struct iphdr *IPhead, char *devname, char *destIP,
 	- *ERR_IPHEAD_NOSRCADDR* -> cannot retrieve the source IP address to be inserted inside the header
 **/
 rawsockerr_t IP4headPopulateS(struct iphdr *IPhead, char *devname, struct in_addr destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
-	int sFd; // To get the current IP address
-	struct ifreq wifireq;
+	struct in_addr srcIPAddr;
+	rawsockerr_t ret;
 
-	IPhead->ihl=BASIC_IHL;
-	IPhead->version=IPV4;
-	IPhead->tos=(__u8) tos;
-	IPhead->frag_off=htons(frag_offset);
-	IPhead->frag_off=(IPhead->frag_off) | flags;
-	IPhead->ttl=(__u8) ttl;
-	IPhead->protocol=(__u8) protocol;
-	IPhead->daddr=destIP.s_addr;
+	IP4headFill(IPhead,destIP.s_addr,tos,frag_offset,ttl,protocol,flags);
 
 	// Get own IP address
-	sFd=socket(AF_INET,SOCK_DGRAM,0);
-	if(sFd==-1) {
-		return ERR_IPHEAD_SOCK;
+	ret=getIfIPv4Addr(devname,&srcIPAddr);
+	if(ret!=0) {
+		return ret;
 	}
-	strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
-	wifireq.ifr_addr.sa_family = AF_INET;
-	if(ioctl(sFd,SIOCGIFADDR,&wifireq)!=0) {
-		close(sFd);
-		return ERR_IPHEAD_NOSRCADDR;
-	}
-	close(sFd);
-	IPhead->saddr=((struct sockaddr_in*)&wifireq.ifr_addr)->sin_addr.s_addr;
-	if(addrs!=NULL) {
-		addrs->src=IPhead->saddr;
-		addrs->dst=IPhead->daddr;
-	}
-
-	// Initialize checksum to 0
-	IPhead->check=0;
-
-	// Initialize ID to 0
-	IPhead->id=0;
+	IP4headSetSrc(IPhead,srcIPAddr.s_addr,addrs);
 
 	return 0;
 }
@@ -828,43 +1636,105 @@ rawsockerr_t IP4headPopulateS(struct iphdr *IPhead, char *devname, struct in_add
 	- *ERR_IPHEAD_NOSRCADDR* -> cannot retrieve the source IP address to be inserted inside the header
 **/
 rawsockerr_t IP4headPopulateB(struct iphdr *IPhead, char *devname,unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
-	struct in_addr broadIPAddr;
-	int sFd; // To get the current IP address
-	struct ifreq wifireq;
+	struct in_addr srcIPAddr;
+	rawsockerr_t ret;
 
-	IPhead->ihl=BASIC_IHL;
-	IPhead->version=IPV4;
-	IPhead->tos=(__u8) tos;
-	IPhead->frag_off=htons(frag_offset);
-	IPhead->frag_off=(IPhead->frag_off) | flags;
-	IPhead->ttl=(__u8) ttl;
-	IPhead->protocol=(__u8) protocol;
-	inet_pton(AF_INET,"255.255.255.255",(struct in_addr *)&broadIPAddr);
-	IPhead->daddr=broadIPAddr.s_addr;
+	IP4headFill(IPhead,htonl(INADDR_BROADCAST),tos,frag_offset,ttl,protocol,flags);
 
 	// Get own IP address
-	sFd=socket(AF_INET,SOCK_DGRAM,0);
-	if(sFd==-1) {
-		return ERR_IPHEAD_SOCK;
+	ret=getIfIPv4Addr(devname,&srcIPAddr);
+	if(ret!=0) {
+		return ret;
 	}
-	strncpy(wifireq.ifr_name,devname,IFNAMSIZ);
-	wifireq.ifr_addr.sa_family = AF_INET;
-	if(ioctl(sFd,SIOCGIFADDR,&wifireq)!=0) {
-		close(sFd);
+	IP4headSetSrc(IPhead,srcIPAddr.s_addr,addrs);
+
+	return 0;
+}
+
+/**
+	\brief Populate IP version 4 header, using an interface descriptor (variant of IP4headPopulate())
+
+	This function works exactly like IP4headPopulate(), but the source IP address is taken from a [struct ifdesc](\ref ifdesc), previously filled in
+	with ifdescResolve(), instead of being retrieved from the kernel, through a socket, every time the function is called.
+
+	It is thus the preferred way of populating many IPv4 headers (e.g. one for each destination or session) for the same interface.
+
+	\param[in,out]	IPhead 		Pointer to the IPv4 header structure, used in raw sockets.
+	\param[in]  ifd 			Descriptor of the interface which will be used to send the packet.
+	\param[in]  destIP   		Destination IP address, a string containing the address in a human-readable format.
+	\param[in]  tos   			Type of Service (ToS) field.
+	\param[in]  frag_offset   	IPv4 fragment offset field.
+	\param[in]  ttl 	   		Time To Live (TTL) field.
+	\param[in]  protocol   		Higher layer protocol field.
+	\param[in]  flags 			IPv4 flags (reserved, DF, MF), as in IP4headPopulate().
+	\param[out]  addrs 			Pointer to the [ipaddrs](\ref ipaddrs) structure to be filled in with the destination and source IP addresses, or NULL if no structure has to be filled in.
+
+	\return **0** if the header was filled in properly, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_IPHEAD_NOSRCADDR* -> the interface descriptor does not contain any IPv4 address
+**/
+rawsockerr_t IP4headPopulateIfd(struct iphdr *IPhead, struct ifdesc *ifd, char *destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
+	struct in_addr destIPAddr;
+
+	inet_pton(AF_INET,destIP,(struct in_addr *)&destIPAddr);
+
+	return IP4headPopulateSIfd(IPhead,ifd,destIPAddr,tos,frag_offset,ttl,protocol,flags,addrs);
+}
+
+/**
+	\brief Populate IP version 4 header with *struct in_addr* addresses, using an interface descriptor (variant of IP4headPopulate())
+
+	This function works exactly like IP4headPopulateS(), but the source IP address is taken from a [struct ifdesc](\ref ifdesc)
+	(see IP4headPopulateIfd()).
+
+	\param[in,out]	IPhead 		Pointer to the IPv4 header structure, used in raw sockets.
+	\param[in]  ifd 			Descriptor of the interface which will be used to send the packet.
+	\param[in]  destIP   		Destination IP address, as a _struct in_addr_.
+	\param[in]  tos   			Type of Service (ToS) field.
+	\param[in]  frag_offset   	IPv4 fragment offset field.
+	\param[in]  ttl 	   		Time To Live (TTL) field.
+	\param[in]  protocol   		Higher layer protocol field.
+	\param[in]  flags 			IPv4 flags (reserved, DF, MF), as in IP4headPopulate().
+	\param[out]  addrs 			Pointer to the [ipaddrs](\ref ipaddrs) structure to be filled in with the destination and source IP addresses, or NULL if no structure has to be filled in.
+
+	\return **0** if the header was filled in properly, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_IPHEAD_NOSRCADDR* -> the interface descriptor does not contain any IPv4 address
+**/
+rawsockerr_t IP4headPopulateSIfd(struct iphdr *IPhead, struct ifdesc *ifd, struct in_addr destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
+	IP4headFill(IPhead,destIP.s_addr,tos,frag_offset,ttl,protocol,flags);
+
+	if(!ifd->ip_valid) {
 		return ERR_IPHEAD_NOSRCADDR;
 	}
-	close(sFd);
-	IPhead->saddr=((struct sockaddr_in*)&wifireq.ifr_addr)->sin_addr.s_addr;
-	if(addrs!=NULL) {
-		addrs->src=IPhead->saddr;
-		addrs->dst=IPhead->daddr;
-	}
+	IP4headSetSrc(IPhead,ifd->ip.s_addr,addrs);
 
-	// Initialize checksum to 0
-	IPhead->check=0;
+	return 0;
+}
 
-	// Initialize ID to 0
-	IPhead->id=0;
+/**
+	\brief Populate broadcast IP version 4 header, using an interface descriptor (variant of IP4headPopulate())
+
+	This function works exactly like IP4headPopulateB(), but the source IP address is taken from a [struct ifdesc](\ref ifdesc)
+	(see IP4headPopulateIfd()).
+
+	\param[in,out]	IPhead 		Pointer to the IPv4 header structure, used in raw sockets.
+	\param[in]  ifd 			Descriptor of the interface which will be used to send the packet (the destination address is set to the broadcast address).
+	\param[in]  tos   			Type of Service (ToS) field.
+	\param[in]  frag_offset   	IPv4 fragment offset field.
+	\param[in]  ttl 	   		Time To Live (TTL) field.
+	\param[in]  protocol   		Higher layer protocol field.
+	\param[in]  flags 			IPv4 flags (reserved, DF, MF), as in IP4headPopulate().
+	\param[out]  addrs 			Pointer to the [ipaddrs](\ref ipaddrs) structure to be filled in with the destination and source IP addresses, or NULL if no structure has to be filled in.
+
+	\return **0** if the header was filled in properly, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_IPHEAD_NOSRCADDR* -> the interface descriptor does not contain any IPv4 address
+**/
+rawsockerr_t IP4headPopulateBIfd(struct iphdr *IPhead, struct ifdesc *ifd, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs) {
+	IP4headFill(IPhead,htonl(INADDR_BROADCAST),tos,frag_offset,ttl,protocol,flags);
+
+	if(!ifd->ip_valid) {
+		return ERR_IPHEAD_NOSRCADDR;
+	}
+	IP4headSetSrc(IPhead,ifd->ip.s_addr,addrs);
 
 	return 0;
 }
@@ -878,13 +1748,20 @@ rawsockerr_t IP4headPopulateB(struct iphdr *IPhead, char *devname,unsigned char
 	\note Since IP4headPopulate() and its variants only initialize the identification field to `0`, a call to this function is required to set a specific
 	ID inside an IPv4 header, before sending any packet over raw sockets.
 
+	\note The header checksum is incrementally updated (see csum_replace2()), instead of being computed again: this function can thus be
+	directly applied to a header which is already stored inside a packet (for instance after IP4EncapsulateInPlace()), with a constant cost.
+	If the checksum was not computed yet, it will be anyway computed from scratch by IP4Encapsulate() or IP4EncapsulateInPlace().
+
 	\param[in,out]	IPhead 	IPv4 header structure (_struct iphdr_) in which the ID field has to be set.
 	\param[in]  	id 		16-bit IP identification value
 
 	\return None.
 **/
 void IP4headAddID(struct iphdr *IPhead, unsigned short id) {
-	IPhead->id=htons(id);
+	__be16 newid=htons(id);
+
+	IPhead->check=csum_replace2(IPhead->check,IPhead->id,newid);
+	IPhead->id=newid;
 }
 
 /**
@@ -937,6 +1814,36 @@ size_t IP4Encapsulate(byte_t *packet,struct iphdr *header,byte_t *sdu,size_t sdu
 	return packetsize;
 }
 
+/**
+	\brief Add, in place, an IPv4 header to the content of a [struct framebuf](\ref framebuf)
+
+	This function works like IP4Encapsulate(), but, instead of copying the SDU inside a new packet buffer, it writes the header
+	directly in front of the SDU already stored inside _fb_ (i.e. inside its headroom), without any additional copy of the SDU.
+
+	The _Total Length_ and checksum fields are automatically set, both inside the frame and inside _header_.
+
+	\param[in,out]	fb 		[struct framebuf](\ref framebuf) containing the SDU (for instance, after a call to UDPencapsulateInPlace()).
+	\param[in,out]	header 	IPv4 header, as *struct iphdr*. Should be filled in with [IP4headPopulate*()](\ref IP4headPopulate()) before being passed to this function.
+
+	\return The full packet size (SDU+PCI), in _bytes_, or **0** if there was not enough headroom left inside _fb_.
+**/
+size_t IP4EncapsulateInPlace(struct framebuf *fb,struct iphdr *header) {
+	byte_t *hdrptr=framebufPush(fb,sizeof(struct iphdr));
+
+	if(hdrptr==NULL) {
+		return 0;
+	}
+
+	header->tot_len=htons(fb->len);
+	header->check=0; // Reset to 0 in case of subsequent calls
+
+	header->check=ip_fast_csum((__u8 *)header, BASIC_IHL);
+
+	memcpy(hdrptr,header,sizeof(struct iphdr));
+
+	return fb->len;
+}
+
 /**
 	\brief Populate UDP header
 
@@ -987,20 +1894,407 @@ void UDPheadPopulate(struct udphdr *UDPhead, unsigned short sourceport, unsigned
 **/
 size_t UDPencapsulate(byte_t *packet,struct udphdr *header,byte_t *data,size_t payloadsize,struct ipaddrs addrs) {
 	size_t packetsize=sizeof(struct udphdr)+payloadsize;
+	__u32 sum;
 
 	header->len=htons(packetsize);
 	header->check=0; // Reset to 0 in case of subsequent calls
 
-	memcpy(packet,header,sizeof(struct udphdr));
-	memcpy(packet+sizeof(struct udphdr),data,payloadsize);
+	// The payload is checksummed while it is copied, so that it is read only once
+	sum=csum_partial(header,sizeof(struct udphdr),0);
+	sum=csum_partial_copy(data,packet+sizeof(struct udphdr),payloadsize,sum);
 
-	header->check=minirighi_udp_checksum(packet,packetsize,addrs.src,addrs.dst);
+	header->check=csum_tcpudp_magic(addrs.src,addrs.dst,packetsize,IPPROTO_UDP,sum);
 
 	memcpy(packet,header,sizeof(struct udphdr));
 
 	return packetsize;
 }
 
+/**
+	\brief Add, in place, a UDP header to the payload stored inside a [struct framebuf](\ref framebuf)
+
+	This function works like UDPencapsulate(), but, instead of copying the payload inside a new packet buffer, it writes the header
+	directly in front of the payload already stored inside _fb_ (after a call to framebufSetPayloadSize() or framebufCopyPayload()),
+	without any additional copy of the payload.
+
+	The length and checksum fields are automatically set, both inside the frame and inside _header_. If the payload was stored with
+	framebufCopyPayload() (or with lampEncapsulateInPlace()), its checksum, computed during the copy, is reused and only the header is read.
+
+	__Example of use:__
+
+		memcpy(framebufPayloadPtr(&fb),data,datasize);
+		framebufSetPayloadSize(&fb,datasize);
+
+		UDPencapsulateInPlace(&fb,&udpHeader,ipaddrs);
+		IP4EncapsulateInPlace(&fb,&ipHeader);
+		etherEncapsulateInPlace(&fb,&etherHeader);
+
+		sendto(sFd,fb.data,fb.len,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll));
+
+	\param[in,out]	fb 		[struct framebuf](\ref framebuf) containing the payload.
+	\param[in,out]	header 	UDP header, as *struct udphdr*. Should be filled in with UDPheadPopulate() before being passed to this function.
+	\param[in]		addrs 	[struct ipaddrs](\ref ipaddrs) containing the source and destination IP addresses (needed to compute the checksum).
+
+	\return The full packet size (payload+header), in _bytes_, or **0** if there was not enough headroom left inside _fb_.
+**/
+size_t UDPencapsulateInPlace(struct framebuf *fb,struct udphdr *header,struct ipaddrs addrs) {
+	byte_t *hdrptr=framebufPush(fb,sizeof(struct udphdr));
+
+	if(hdrptr==NULL) {
+		return 0;
+	}
+
+	header->len=htons(fb->len);
+	header->check=0; // Reset to 0 in case of subsequent calls
+
+	if(fb->payloadcsum_valid) {
+		// The payload was already checksummed when it was copied: only the header has to be added
+		header->check=csum_tcpudp_magic(addrs.src,addrs.dst,fb->len,IPPROTO_UDP,csum_partial(header,sizeof(struct udphdr),fb->payloadcsum));
+		memcpy(hdrptr,header,sizeof(struct udphdr));
+	} else {
+		memcpy(hdrptr,header,sizeof(struct udphdr));
+		header->check=minirighi_udp_checksum(hdrptr,fb->len,addrs.src,addrs.dst);
+		((struct udphdr *) hdrptr)->check=header->check;
+	}
+
+	return fb->len;
+}
+
+// Attach to 'msg' an SCM_TXTIME control message, stored inside 'control' (of at least CMSG_SPACE(sizeof(uint64_t)) bytes), carrying the launch time 'txtime'
+static void rawTxtimeSetCmsg(struct msghdr *msg, char *control, uint64_t txtime) {
+	struct cmsghdr *cmsg;
+
+	msg->msg_control=control;
+	msg->msg_controllen=CMSG_SPACE(sizeof(uint64_t));
+
+	cmsg=CMSG_FIRSTHDR(msg);
+	cmsg->cmsg_level=SOL_SOCKET;
+	cmsg->cmsg_type=SCM_TXTIME;
+	cmsg->cmsg_len=CMSG_LEN(sizeof(uint64_t));
+	memcpy(CMSG_DATA(cmsg),&txtime,sizeof(uint64_t));
+}
+
+/**
+	\brief Enable the launch time (_SO_TXTIME_) on a socket
+
+	This function enables the _SO_TXTIME_ socket option, allowing each frame sent on the socket to carry a launch time, i.e. the instant at which
+	it should be put on the wire (see rawSendTxtime(), rawSendBatchTxtime() and txringCommitTxtime()). The frames are then held by the qdisc of the
+	interface until their launch time: an _etf_ qdisc should be configured on the interface (or on one of its TX queues, e.g. below an _mqprio_ or a _taprio_ qdisc),
+	for instance with:
+
+		tc qdisc add dev eth0 root etf clockid CLOCK_TAI delta 200000
+
+	The _fq_ qdisc also honours the launch times, but only with _CLOCK_MONOTONIC_.
+
+	This way, a burst of frames can be queued in advance, while keeping the transmission instants very precise, and without the need of spinning
+	until each deadline in the sender thread (compare with pacerWait()).
+
+	\param[in]	descriptor 	Socket descriptor (raw or UDP socket).
+	\param[in]	clockid 	Reference clock of the launch times: it must match the one of the qdisc (_CLOCK_TAI_ for _etf_, _CLOCK_MONOTONIC_ for _fq_).
+	\param[in]	flags 		Bitwise OR of the _SOF_TXTIME_ flags (see _linux/net_tstamp.h_): _SOF_TXTIME_DEADLINE_MODE_ (the launch time is a deadline, and the frame can be sent earlier)
+							and _SOF_TXTIME_REPORT_ERRORS_ (the frames dropped because their launch time was invalid or already passed are reported on the socket error queue,
+							with _SO_EE_ORIGIN_TXTIME_ as origin), or **0**.
+
+	\return **0** if _SO_TXTIME_ was successfully enabled, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_TXTIME_SOCKOPT* -> _setsockopt()_ failed (_errno_ is set; _SO_TXTIME_ requires Linux 4.19 or later)
+**/
+rawsockerr_t rawTxtimeEnable(int descriptor, clockid_t clockid, unsigned int flags) {
+	struct sock_txtime txtimecfg;
+
+	txtimecfg.clockid=clockid;
+	txtimecfg.flags=flags;
+
+	if(setsockopt(descriptor,SOL_SOCKET,SO_TXTIME,&txtimecfg,sizeof(txtimecfg))<0) {
+		return ERR_TXTIME_SOCKOPT;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Send a frame over a raw socket, with a launch time
+
+	This function works like _sendto()_, but the frame is passed to the kernel together with a launch time (_SCM_TXTIME_ control message),
+	i.e. the absolute instant, in _ns_, read from the clock specified in rawTxtimeEnable(), at which the qdisc should send it.
+
+	\warning _SO_TXTIME_ should have been enabled on the socket with rawTxtimeEnable(), otherwise the frame is refused (_EINVAL_).
+
+	\param[in] 	descriptor 	Socket descriptor related to the raw socket to be used to send the frame.
+	\param[in] 	addrll 		Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in] 	packet 		Pointer to the buffer storing the **whole** frame to be sent.
+	\param[in] 	len 		Size of the whole frame, in _bytes_.
+	\param[in] 	txtime 		Launch time, in _ns_, or **0** to send the frame immediately, as _sendto()_ would do.
+
+	\return The same value returned by _sendto()_ (i.e. the number of sent bytes, or **-1** in case of error, setting _errno_).
+**/
+ssize_t rawSendTxtime(int descriptor, struct sockaddr_ll addrll, byte_t *packet, size_t len, uint64_t txtime) {
+	struct msghdr msg;
+	struct iovec iov;
+	union {
+		char buf[CMSG_SPACE(sizeof(uint64_t))];
+		struct cmsghdr align;
+	} control;
+
+	if(txtime==0) {
+		return sendto(descriptor,packet,len,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll));
+	}
+
+	iov.iov_base=packet;
+	iov.iov_len=len;
+
+	memset(&msg,0,sizeof(msg));
+	msg.msg_name=&addrll;
+	msg.msg_namelen=sizeof(struct sockaddr_ll);
+	msg.msg_iov=&iov;
+	msg.msg_iovlen=1;
+
+	rawTxtimeSetCmsg(&msg,control.buf,txtime);
+
+	return sendmsg(descriptor,&msg,0);
+}
+
+// Send a batch of frames with sendmmsg(), attaching to each one its launch time, if 'txtime' is true
+static int rawSendBatchMsgs(int descriptor, struct sockaddr_ll addrll, struct batchframe *frames, unsigned int n, bool txtime) {
+	struct mmsghdr msgs[RAWSEND_BATCH_MAX];
+	struct iovec iovs[RAWSEND_BATCH_MAX];
+	union {
+		char buf[CMSG_SPACE(sizeof(uint64_t))];
+		struct cmsghdr align;
+	} controls[RAWSEND_BATCH_MAX];
+	unsigned int chunk, i, idx=0;
+	int ret, sent=0;
+
+	while(idx<n) {
+		chunk=n-idx<RAWSEND_BATCH_MAX ? n-idx : RAWSEND_BATCH_MAX;
+
+		memset(msgs,0,chunk*sizeof(struct mmsghdr));
+
+		for(i=0;i<chunk;i++) {
+			iovs[i].iov_base=frames[idx+i].packet;
+			iovs[i].iov_len=frames[idx+i].len;
+			msgs[i].msg_hdr.msg_name=&addrll;
+			msgs[i].msg_hdr.msg_namelen=sizeof(struct sockaddr_ll);
+			msgs[i].msg_hdr.msg_iov=&iovs[i];
+			msgs[i].msg_hdr.msg_iovlen=1;
+
+			if(txtime && frames[idx+i].txtime!=0) {
+				rawTxtimeSetCmsg(&msgs[i].msg_hdr,controls[i].buf,frames[idx+i].txtime);
+			}
+		}
+
+		ret=sendmmsg(descriptor,msgs,chunk,0);
+
+		if(ret<0) {
+			// The first frame of the chunk was refused: record the error and go on with the next one
+			if(errno==EINTR) {
+				continue;
+			}
+
+			frames[idx].err=errno;
+			idx++;
+		} else {
+			// 'ret' frames were sent: if this is less than 'chunk', the next call will start from the first frame which was not sent
+			for(i=0;i<(unsigned int) ret;i++) {
+				frames[idx+i].err=0;
+			}
+
+			idx+=ret;
+			sent+=ret;
+		}
+	}
+
+	return sent;
+}
+
+/**
+	\brief Send many frames with a single system call
+
+	This function sends the _n_ frames described by the _frames_ array over a raw socket, passing them to the kernel with a single
+	_sendmmsg()_ call (or with one call every [RAWSEND_BATCH_MAX](\ref RAWSEND_BATCH_MAX) frames, for larger batches).
+
+	All the frames are always attempted: if the kernel refuses a frame, its _err_ field is set to the corresponding _errno_ value,
+	and the remaining frames are sent with a new _sendmmsg()_ call. The _err_ field of the frames which were successfully sent is set to **0**.
+
+	__Example of use:__
+
+		struct batchframe frames[N];
+
+		for(i=0;i<N;i++) {
+			frames[i].packet=...;
+			frames[i].len=...;
+		}
+
+		sent=rawSendBatch(sFd,addrll,frames,N);
+
+	\param[in] 		descriptor 		Socket descriptor related to the raw socket to be used to send the frames.
+	\param[in] 		addrll 			Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in,out]	frames 			Array of [struct batchframe](\ref batchframe) describing the frames to be sent.
+	\param[in] 		n 				Number of elements of _frames_.
+
+	\return The number of frames which were successfully sent.
+**/
+int rawSendBatch(int descriptor, struct sockaddr_ll addrll, struct batchframe *frames, unsigned int n) {
+	return rawSendBatchMsgs(descriptor,addrll,frames,n,false);
+}
+
+/**
+	\brief Send a batch of frames over a raw socket, each one with its own launch time
+
+	This function works exactly like rawSendBatch(), but the _txtime_ field of each [struct batchframe](\ref batchframe) is passed to the kernel
+	as the launch time of the corresponding frame (see rawSendTxtime()), so that a whole burst of frames can be queued in advance, with a single
+	system call, and then released by the qdisc at the requested instants. Frames with _txtime_ equal to **0** are sent immediately.
+
+	\warning _SO_TXTIME_ should have been enabled on the socket with rawTxtimeEnable(), otherwise all the frames with a non-zero _txtime_ are refused.
+
+	\param[in] 		descriptor 		Socket descriptor related to the raw socket to be used to send the frames.
+	\param[in] 		addrll 			Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in,out]	frames 			Array of [struct batchframe](\ref batchframe) describing the frames to be sent, with their launch times.
+	\param[in] 		n 				Number of elements of _frames_.
+
+	\return The number of frames which were successfully sent.
+**/
+int rawSendBatchTxtime(int descriptor, struct sockaddr_ll addrll, struct batchframe *frames, unsigned int n) {
+	return rawSendBatchMsgs(descriptor,addrll,frames,n,true);
+}
+
+/**
+	\brief Enable the kernel reception timestamps for rawRecvBatch()
+
+	This function enables the _SO_TIMESTAMPNS_ option on the specified socket: after calling it, the _ts_ field of each
+	[struct recvframe](\ref recvframe) filled by rawRecvBatch() contains the time at which the frame was received by the kernel.
+
+	\param[in]	descriptor 	Socket descriptor.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RECVBATCH_SOCKOPT* -> unable to set the _SO_TIMESTAMPNS_ option (_errno_ is set by _setsockopt()_)
+**/
+rawsockerr_t rawRecvBatchEnableTimestamps(int descriptor) {
+	int enable=1;
+
+	if(setsockopt(descriptor,SOL_SOCKET,SO_TIMESTAMPNS,&enable,sizeof(enable))<0) {
+		return ERR_RECVBATCH_SOCKOPT;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Receive many frames with a single system call
+
+	This function receives up to _n_ frames over a raw socket, inside the buffers described by the _frames_ array, with a single
+	_recvmmsg()_ call (or with one call every [RAWRECV_BATCH_MAX](\ref RAWRECV_BATCH_MAX) frames, for larger batches).
+
+	It waits (unless _MSG_DONTWAIT_ is specified inside _flags_ or the socket is non-blocking) until at least one frame is available,
+	then it returns all the frames which are already queued, up to _n_, without waiting for more.
+
+	For each received frame, the header pointers, the payload pointer and the payload size are set inside the corresponding
+	[struct recvframe](\ref recvframe), as UDPgetpacketpointers() and UDPgetpayloadsize() would do, together with the reception timestamp,
+	if enabled with rawRecvBatchEnableTimestamps() or with lampTimestampingEnable() (in this case, the hardware timestamp is used, when available).
+	Frames longer than the _size_ of their buffer are truncated by the kernel: they are still returned, with the _truncated_ field set to _true_.
+
+	__Example of use:__
+
+		struct recvframe frames[N];
+
+		for(i=0;i<N;i++) {
+			frames[i].packet=buffers[i];
+			frames[i].size=BUFFER_SIZE;
+		}
+
+		received=rawRecvBatch(sFd,frames,N,0);
+
+		for(i=0;i<received;i++) {
+			if(!frames[i].truncated && frames[i].payloadsize>0 && frames[i].IPheader->protocol==IPPROTO_UDP) {
+				...
+			}
+		}
+
+	\param[in] 		descriptor 		Socket descriptor related to the raw socket to be used to receive the frames.
+	\param[in,out]	frames 			Array of [struct recvframe](\ref recvframe), with the _packet_ and _size_ fields already set.
+	\param[in] 		n 				Number of elements of _frames_.
+	\param[in] 		flags 			Flags to be passed to _recvmmsg()_ (e.g. _MSG_DONTWAIT_), or **0**.
+
+	\return The number of received frames (stored in the first elements of _frames_), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RECVBATCH_RECV* -> no frame was received because of a _recvmmsg()_ error (_errno_ is set by _recvmmsg()_)
+**/
+int rawRecvBatch(int descriptor, struct recvframe *frames, unsigned int n, int flags) {
+	struct mmsghdr msgs[RAWRECV_BATCH_MAX];
+	struct iovec iovs[RAWRECV_BATCH_MAX];
+	union {
+		struct cmsghdr align; // Only used to properly align the buffer
+		byte_t buf[CMSG_SPACE(3*sizeof(struct timespec))]; // Large enough for both SCM_TIMESTAMPNS and SCM_TIMESTAMPING (struct scm_timestamping)
+	} controls[RAWRECV_BATCH_MAX];
+	struct cmsghdr *cmsg;
+	struct recvframe *frame;
+	struct timespec tss[3];
+	unsigned int chunk, i, idx=0;
+	int ret;
+
+	while(idx<n) {
+		chunk=n-idx<RAWRECV_BATCH_MAX ? n-idx : RAWRECV_BATCH_MAX;
+
+		memset(msgs,0,chunk*sizeof(struct mmsghdr));
+
+		for(i=0;i<chunk;i++) {
+			iovs[i].iov_base=frames[idx+i].packet;
+			iovs[i].iov_len=frames[idx+i].size;
+			msgs[i].msg_hdr.msg_name=&frames[idx+i].addrll;
+			msgs[i].msg_hdr.msg_namelen=sizeof(struct sockaddr_ll);
+			msgs[i].msg_hdr.msg_iov=&iovs[i];
+			msgs[i].msg_hdr.msg_iovlen=1;
+			msgs[i].msg_hdr.msg_control=controls[i].buf;
+			msgs[i].msg_hdr.msg_controllen=sizeof(controls[i].buf);
+		}
+
+		// Only the first chunk can block: the next ones just get the frames which are already queued
+		ret=recvmmsg(descriptor,msgs,chunk,idx==0 ? (flags | MSG_WAITFORONE) : (flags | MSG_DONTWAIT),NULL);
+
+		if(ret<=0) {
+			if(idx==0) {
+				return ERR_RECVBATCH_RECV;
+			}
+			break;
+		}
+
+		for(i=0;i<(unsigned int) ret;i++) {
+			frame=&frames[idx+i];
+
+			frame->len=msgs[i].msg_len;
+			frame->truncated=(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)!=0;
+			frame->payload=UDPgetpacketpointers(frame->packet,&frame->etherHeader,&frame->IPheader,&frame->udpHeader);
+
+			// Set the payload size only if the frame is a complete IPv4/UDP frame (with no IPv4 options, as assumed by UDPgetpacketpointers()), to avoid reading the UDP length outside the received data
+			if(frame->len>=ETH_IP_UDP_HEADROOM && ntohs(frame->etherHeader->ether_type)==ETHERTYPE_IP && frame->IPheader->ihl==5 && frame->IPheader->protocol==IPPROTO_UDP &&
+				ntohs(frame->udpHeader->len)>=sizeof(struct udphdr) && ntohs(frame->udpHeader->len)<=frame->len-sizeof(struct ether_header)-sizeof(struct iphdr)) {
+				frame->payloadsize=UDPgetpayloadsize(frame->udpHeader);
+			} else {
+				frame->payloadsize=0;
+			}
+
+			frame->ts_valid=false;
+			for(cmsg=CMSG_FIRSTHDR(&msgs[i].msg_hdr);cmsg!=NULL;cmsg=CMSG_NXTHDR(&msgs[i].msg_hdr,cmsg)) {
+				if(cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_TIMESTAMPNS) {
+					memcpy(&frame->ts,CMSG_DATA(cmsg),sizeof(struct timespec));
+					frame->ts_valid=true;
+				} else if(cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_TIMESTAMPING) {
+					// struct scm_timestamping: ts[0] contains the software timestamp, ts[2] the hardware one (if any)
+					memcpy(tss,CMSG_DATA(cmsg),sizeof(tss));
+					frame->ts=(tss[2].tv_sec!=0 || tss[2].tv_nsec!=0) ? tss[2] : tss[0];
+					frame->ts_valid=frame->ts.tv_sec!=0 || frame->ts.tv_nsec!=0;
+				}
+			}
+		}
+
+		idx+=ret;
+
+		if((unsigned int) ret<chunk) {
+			break;
+		}
+	}
+
+	return idx;
+}
+
 /**
 	\brief Get pointers to headers and payload in UDP packet buffer
 
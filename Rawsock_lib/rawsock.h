@@ -16,9 +16,14 @@
 #include <linux/udp.h>	
 #include <linux/ip.h>
 #include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
+#include <linux/net_tstamp.h>
+#include "rawsock_csum.h"
 
 #ifdef __ANDROID__
 	#define udphdr __kernel_udphdr
@@ -30,7 +35,7 @@
 // Errors
 #define ERR_WLAN_NOIF 0 /**< __wlanLookup() error definition__: no WLAN interfaces found. */
 #define ERR_WLAN_SOCK -1 /**< __wlanLookup() error definition__: socket creation error. */
-#define ERR_WLAN_GETIFADDRS -2 /**< __wlanLookup() error definition__: getifaddrs() (to obtain interfaces list) error. */
+#define ERR_WLAN_GETIFADDRS -2 /**< __wlanLookup() error definition__: error while retrieving the interfaces list (netlink dump error). */
 #define ERR_WLAN_INDEX -3 /**< __wlanLookup() error definition__: wrong index specified. */
 #define ERR_WLAN_GETSRCMAC -4 /**< __wlanLookup() error definition__: unable to get source MAC address (if requested). */
 #define ERR_WLAN_GETIFINDEX -5 /**<  __wlanLookup() error definition__: unable to get source interface index (if requested). */
@@ -40,7 +45,88 @@
 #define ERR_IPHEAD_NOSRCADDR -11 /**< __[IP4headPopulate*()](\ref IP4headPopulate) error definition__: unable to retrieve current device IP address. */
 
 #define ERR_VIFPRINTER_SOCK -20 /**< __vifPrinter() error definition__: socket creation error. */
-#define ERR_VIFPRINTER_GETIFADDRS -21 /**< __vifPrinter() error definition__: getifaddrs() (to obtain interfaces list) error. */
+#define ERR_VIFPRINTER_GETIFADDRS -21 /**< __vifPrinter() error definition__: error while retrieving the interfaces list (netlink dump error). */
+
+#define ERR_FRAMEBUF_ALLOC -30 /**< __[framebuf*()](\ref framebufPrepare) error definition__: unable to allocate the frame buffer memory. */
+#define ERR_FRAMEBUF_HEADROOM -31 /**< __[framebuf*()](\ref framebufPrepare) error definition__: the requested headroom does not fit inside the buffer. */
+#define ERR_FRAMEBUF_NOSPACE -32 /**< __[framebuf*()](\ref framebufPrepare) error definition__: the payload does not fit inside the space available after the headroom. */
+
+#define ERR_TXRING_PARAMS -40 /**< __[txring*()](\ref txringOpen) error definition__: invalid TX ring frame size or number of frames. */
+#define ERR_TXRING_SOCKOPT -41 /**< __[txring*()](\ref txringOpen) error definition__: unable to set up the TX ring on the socket. */
+#define ERR_TXRING_MMAP -42 /**< __[txring*()](\ref txringOpen) error definition__: unable to map the TX ring. */
+#define ERR_TXRING_FULL -43 /**< __[txring*()](\ref txringOpen) error definition__: no free slot is available inside the TX ring. */
+#define ERR_TXRING_FRAMESIZE -44 /**< __[txring*()](\ref txringOpen) error definition__: the frame does not fit inside a TX ring slot. */
+#define ERR_TXRING_SEND -45 /**< __[txring*()](\ref txringOpen) error definition__: the kernel returned an error when flushing the TX ring. */
+
+#define ERR_RXRING_PARAMS -50 /**< __[rxring*()](\ref rxringOpen) error definition__: invalid RX ring block size, number of blocks or frame size. */
+#define ERR_RXRING_SOCKOPT -51 /**< __[rxring*()](\ref rxringOpen) error definition__: unable to set up the RX ring on the socket, or to read its statistics. */
+#define ERR_RXRING_MMAP -52 /**< __[rxring*()](\ref rxringOpen) error definition__: unable to map the RX ring. */
+#define ERR_RXRING_POLL -53 /**< __[rxring*()](\ref rxringOpen) error definition__: error while waiting for new frames. */
+
+#define ERR_RECVBATCH_SOCKOPT -60 /**< __[rawRecvBatch*()](\ref rawRecvBatch) error definition__: unable to enable the reception timestamps on the socket. */
+#define ERR_RECVBATCH_RECV -61 /**< __[rawRecvBatch*()](\ref rawRecvBatch) error definition__: _recvmmsg()_ error. */
+
+#define ERR_XSK_PARAMS -70 /**< __[xsk*()](\ref xskOpen) error definition__: invalid AF_XDP frame size, number of frames or ring size. */
+#define ERR_XSK_SOCKET -71 /**< __[xsk*()](\ref xskOpen) error definition__: unable to create the AF_XDP socket. */
+#define ERR_XSK_UMEM -72 /**< __[xsk*()](\ref xskOpen) error definition__: unable to allocate or register the UMEM. */
+#define ERR_XSK_RINGS -73 /**< __[xsk*()](\ref xskOpen) error definition__: unable to set up or map the AF_XDP rings. */
+#define ERR_XSK_BIND -74 /**< __[xsk*()](\ref xskOpen) error definition__: unable to bind the AF_XDP socket to the interface queue. */
+#define ERR_XSK_PROG -75 /**< __[xsk*()](\ref xskOpen) error definition__: unable to load the XDP program or to create the XSKMAP. */
+#define ERR_XSK_ATTACH -76 /**< __[xsk*()](\ref xskOpen) error definition__: unable to attach the XDP program to the interface. */
+#define ERR_XSK_NOFRAME -77 /**< __[xsk*()](\ref xskOpen) error definition__: no free UMEM frame is available. */
+#define ERR_XSK_TXFULL -78 /**< __[xsk*()](\ref xskOpen) error definition__: no free entry is available inside the AF_XDP TX ring. */
+#define ERR_XSK_SEND -79 /**< __[xsk*()](\ref xskOpen) error definition__: the kernel returned an error when woken up to send the queued frames. */
+#define ERR_XSK_POLL -80 /**< __[xsk*()](\ref xskOpen) error definition__: error while waiting for new frames. */
+
+#define ERR_FANOUT_PARAMS -90 /**< __[fanout*()](\ref fanoutOpen) error definition__: invalid fanout engine settings (or the engine is already running). */
+#define ERR_FANOUT_SOCKET -91 /**< __[fanout*()](\ref fanoutOpen) error definition__: unable to create or bind a worker socket. */
+#define ERR_FANOUT_RING -92 /**< __[fanout*()](\ref fanoutOpen) error definition__: unable to set up the RX ring of a worker. */
+#define ERR_FANOUT_JOIN -93 /**< __[fanout*()](\ref fanoutOpen) error definition__: unable to join the PACKET_FANOUT group or to attach the eBPF program. */
+#define ERR_FANOUT_THREAD -94 /**< __[fanout*()](\ref fanoutOpen) error definition__: unable to create a worker thread. */
+#define ERR_FANOUT_ALLOC -95 /**< __[fanout*()](\ref fanoutOpen) error definition__: unable to allocate the memory for the workers. */
+
+#define ERR_FILTER_PARAMS -100 /**< __[filter*()](\ref filterCompile) error definition__: inconsistent filter description. */
+#define ERR_FILTER_ATTACH -101 /**< __[filter*()](\ref filterCompile) error definition__: unable to attach or detach the filter. */
+
+#define ERR_IFDESC_SOCK -110 /**< __[ifdesc*()](\ref ifdescResolve) error definition__: internal socket creation error. */
+#define ERR_IFDESC_NOIF -111 /**< __[ifdesc*()](\ref ifdescResolve) error definition__: the interface does not exist. */
+#define ERR_IFDESC_IOCTL -112 /**< __[ifdesc*()](\ref ifdescResolve) error definition__: unable to retrieve the MAC address or the MTU of the interface. */
+
+#define ERR_NLWATCH_SOCKET -120 /**< __[nlwatch*()](\ref nlwatchOpen) error definition__: unable to create the netlink socket. */
+#define ERR_NLWATCH_BIND -121 /**< __[nlwatch*()](\ref nlwatchOpen) error definition__: unable to subscribe to the link and address notifications. */
+#define ERR_NLWATCH_RECV -122 /**< __[nlwatch*()](\ref nlwatchOpen) error definition__: error while reading the netlink notifications. */
+#define ERR_NLWATCH_POLL -123 /**< __[nlwatch*()](\ref nlwatchOpen) error definition__: error while waiting for the netlink notifications. */
+
+#define ERR_NLDUMP_SOCKET -130 /**< __nlIfDump() error definition__: unable to create the netlink socket. */
+#define ERR_NLDUMP_SEND -131 /**< __nlIfDump() error definition__: unable to send the netlink dump requests. */
+#define ERR_NLDUMP_RECV -132 /**< __nlIfDump() error definition__: unable to read the netlink dumps. */
+#define ERR_NLDUMP_ALLOC -133 /**< __nlIfDump() error definition__: unable to allocate the receive buffer. */
+
+#define ERR_FLOWTPL_PARAMS -140 /**< __flowtemplateInit() error definition__: the headers do not describe an IPv4 (without options) UDP flow over Ethernet. */
+
+#define ERR_LAMPTS_SOCKOPT -150 /**< __[lampTimestampingEnable()](\ref lampTimestampingEnable) error definition__: unable to set the _SO_TIMESTAMPING_ option on the socket. */
+#define ERR_LAMPTS_HWCONFIG -151 /**< __[lampTimestampingEnable()](\ref lampTimestampingEnable) error definition__: unable to enable the hardware timestamping on the interface. */
+#define ERR_LAMPTS_RECV -152 /**< __[lampTxTstampCollect()](\ref lampTxTstampCollect) error definition__: error while reading the socket error queue. */
+#define ERR_CLOCK_SOURCE -160 /**< __[rsclockInit()](\ref rsclockInit) error definition__: invalid clock source, or clock not supported by the system. */
+#define ERR_CLOCK_NOTSC -161 /**< __[rsclockInitTsc()](\ref rsclockInitTsc) error definition__: no invariant TSC is available. */
+#define ERR_CLOCK_CALIB -162 /**< __[rsclockInitTsc()](\ref rsclockInitTsc) error definition__: TSC calibration failed. */
+#define ERR_LATHIST_NOSPACE -170 /**< __[lathistSerialize()](\ref lathistSerialize) error definition__: the serialized histogram does not fit inside the buffer. */
+#define ERR_LATHIST_FORMAT -171 /**< __[lathistDeserialize()](\ref lathistDeserialize) error definition__: invalid or incompatible serialized histogram. */
+#define ERR_LAMPSEQ_ALLOC -180 /**< __[lampSeqTable*()](\ref lampSeqTablePrepare) error definition__: unable to allocate the sequence window table. */
+#define ERR_LAMPSEQ_SIZE -181 /**< __[lampSeqTable*()](\ref lampSeqTablePrepare) error definition__: the table size is not a power of two. */
+#define ERR_LAMPSEQ_FULL -182 /**< __[lampSeqTableUpdate()](\ref lampSeqTableUpdate) error definition__: no free slot left for a new session. */
+#define ERR_PACER_PARAMS -190 /**< __[pacerInit()](\ref pacerInit) error definition__: invalid pacer settings. */
+#define ERR_TXTIME_SOCKOPT -200 /**< __[rawTxtimeEnable()](\ref rawTxtimeEnable) error definition__: unable to set the _SO_TXTIME_ option on the socket. */
+#define ERR_PCAP_OPEN -210 /**< __[pcapwriterOpen()](\ref pcapwriterOpen) and [pcapreaderOpen()](\ref pcapreaderOpen) error definition__: unable to create or open the file. */
+#define ERR_PCAP_ALLOC -211 /**< __[pcapwriterOpen()](\ref pcapwriterOpen) error definition__: unable to allocate the write buffer. */
+#define ERR_PCAP_WRITE -212 /**< __[pcapwriter*()](\ref pcapwriterWrite) error definition__: unable to write to the pcapng file. */
+#define ERR_PCAP_IFACE -213 /**< __[pcapwriter*()](\ref pcapwriterAddInterface) error definition__: invalid interface identifier, or too many interfaces. */
+#define ERR_PCAP_FORMAT -214 /**< __[pcapreader*()](\ref pcapreaderNext) error definition__: invalid, truncated or unsupported pcap/pcapng file. */
+#define ERR_PCAP_MMAP -215 /**< __[pcapreaderOpen()](\ref pcapreaderOpen) error definition__: unable to map the file in memory. */
+#define ERR_REPLAY_PARAMS -220 /**< __[replayOpen()](\ref replayOpen) error definition__: invalid replay settings, or too many remapping rules. */
+#define ERR_REPLAY_IFACE -221 /**< __[replayOpen()](\ref replayOpen) error definition__: unable to find the output interface. */
+#define ERR_REPLAY_SOCKET -222 /**< __[replayOpen()](\ref replayOpen) error definition__: unable to create the raw socket. */
+#define ERR_REPLAY_ALLOC -223 /**< __[replayOpen()](\ref replayOpen) error definition__: unable to allocate the buffer for the modified frames. */
 
 // wlanLookup() modes
 #define WLANLOOKUP_WLAN 0 /**< __wlanLookup() mode definition__: look for wireless interfaces only. */
@@ -97,6 +183,8 @@
 #define IP_UDP_PACKET_SIZE_S(size) sizeof(struct iphdr)+sizeof(struct udphdr)+size /**< __Size definition__: given *size*, in _bytes_, the IPv4 + UDP payload size (with basic IHL, i.e. no options) containing a payload with the specified *size* is calculated and returned in _bytes_. */
 #define ETH_IP_UDP_PACKET_SIZE_S(size) sizeof(struct ether_header)+sizeof(struct iphdr)+sizeof(struct udphdr)+size /**< __Size definition__: given *size*, in _bytes_, the IPv4 + UDP payload size (with basic IHL, i.e. no options), **including struct ether_header**, containing a payload with the specified *size* is calculated and returned in _bytes_. */
 
+#define ETH_IP_UDP_HEADROOM (sizeof(struct ether_header)+sizeof(struct iphdr)+sizeof(struct udphdr)) /**< __Size definition__: headroom, in _bytes_, to be reserved inside a [struct framebuf](\ref framebuf) in order to prepend, in place, the UDP, IPv4 (with basic IHL, i.e. no options) and Ethernet headers to a payload. */
+
 #ifndef BYTE_TYPE
 #define BYTE_TYPE
 typedef uint8_t byte_t; /**< Custom type to store a single byte. It should be defined only if it was not defined elsewhere. */
@@ -117,6 +205,123 @@ struct ipaddrs {
 	in_addr_t dst; /**< Destination IPv4 address container.*/
 };
 
+#define IFDESC_NAME_SIZE 16 /**< Size of the interface name buffer inside a [struct ifdesc](\ref ifdesc) (it is the same as _IFNAMSIZ_). */
+
+/**
+	\brief Interface descriptor
+
+	This structure stores the properties of a network interface which are needed to build and send frames: name, index,
+	MAC address, IPv4 address and MTU. It can be filled in once, with ifdescResolve(), and then passed to the [IP4headPopulate*Ifd()](\ref IP4headPopulateIfd)
+	functions, which do not need any system call to retrieve the source IP address.
+
+	It can be kept up to date, when the interface addresses change, through the netlink listener of the rawsock_netlink.h module.
+**/
+struct ifdesc {
+	char name[IFDESC_NAME_SIZE]; /**< Interface name (e.g. _wlan0_). */
+	int ifindex; /**< Interface index. */
+	uint8_t mac[MAC_ADDR_SIZE]; /**< Interface MAC address (it can be passed wherever a [macaddr_t](\ref macaddr_t) is expected). */
+	struct in_addr ip; /**< Interface IPv4 address (valid only if _ip_valid_ is _true_). */
+	bool ip_valid; /**< _true_ if the interface has an IPv4 address. */
+	unsigned int mtu; /**< Interface MTU, in _bytes_. */
+};
+
+#define NLDUMP_BUFFER_SIZE 32768 /**< Size, in _bytes_, of the buffer used to read the netlink dumps (see nlIfDump()). */
+#define NLDUMP_MAX_IFRECORDS 128 /**< Maximum number of interfaces considered by wlanLookup() and vifPrinter(). */
+
+/**
+	\brief Interface record
+
+	Structure containing all the attributes of an interface, as retrieved from the kernel by nlIfDump(), through a single rtnetlink dump of the links and of the IPv4
+	addresses (plus an nl80211 dump to know which interfaces are wireless). This is how wlanLookup() and vifPrinter() look for the available interfaces.
+**/
+struct ifrecord {
+	char name[IFDESC_NAME_SIZE]; /**< Interface name. */
+	int ifindex; /**< Interface index. */
+	unsigned int flags; /**< Interface flags (_IFF_*_, e.g. _IFF_UP_ or _IFF_LOOPBACK_). */
+	unsigned short type; /**< Link type (_ARPHRD_*_). */
+	unsigned int mtu; /**< Interface MTU, in _bytes_. */
+	uint8_t mac[MAC_ADDR_SIZE]; /**< Interface MAC address (all zeros if the interface has no MAC address). */
+	struct in_addr ip; /**< Primary IPv4 address (valid only if _ip_valid_ is _true_). */
+	bool ip_valid; /**< _true_ if the interface has an IPv4 address. */
+	bool wireless; /**< _true_ if the interface is a wireless (nl80211) interface. */
+	bool tun; /**< _true_ if the interface is a layer 3 tun interface. */
+};
+
+#define RAWSEND_BATCH_MAX 64 /**< Maximum number of frames passed to the kernel with a single _sendmmsg()_ call by rawSendBatch() (larger batches are split in chunks of this size). */
+#define RAWRECV_BATCH_MAX 64 /**< Maximum number of frames received with a single _recvmmsg()_ call by rawRecvBatch() (larger batches are split in chunks of this size). */
+
+/**
+	\brief Batch frame descriptor
+
+	This structure describes a single frame to be sent with rawSendBatch() (or rawLampSendBatch(), if the LaMP module is used).
+	The user should set _packet_ and _len_ (and _txtime_, when rawSendBatchTxtime() is used); _err_ is set by the sending function.
+**/
+struct batchframe {
+	byte_t *packet; /**< Pointer to the buffer storing the **whole** frame to be sent (i.e. the same buffer you would pass to a call to <i>sendto()</i>). */
+	size_t len; /**< Size of the whole frame, in _bytes_. */
+	uint64_t txtime; /**< Launch time of the frame, in _ns_ (see rawSendTxtime()), or **0** to send it immediately; it is read only by rawSendBatchTxtime() and rawLampSendBatchTxtime(). */
+	int err; /**< Set to **0** if the frame was sent, or to the _errno_ value returned by the kernel for this frame otherwise. */
+};
+
+/**
+	\brief Batch receive frame descriptor
+
+	This structure describes a single frame received with rawRecvBatch(). The user should set _packet_ and _size_,
+	i.e. the buffer in which the frame will be received, and its size; all the other fields are set by rawRecvBatch().
+
+	The header pointers are set exactly as UDPgetpacketpointers() would do, while _payloadsize_ is set as UDPgetpayloadsize() would do,
+	but only if the frame is really a complete IPv4/UDP frame (otherwise it is set to **0**).
+**/
+struct recvframe {
+	byte_t *packet; /**< Buffer (should be already allocated) in which the frame will be received. */
+	size_t size; /**< Size of _packet_, in _bytes_. */
+	size_t len; /**< Size of the received frame, in _bytes_ (only the part which was actually stored inside _packet_, if _truncated_ is _true_). */
+	bool truncated; /**< _true_ if the frame was longer than _size_ and was truncated by the kernel (_MSG_TRUNC_): in this case, only the first _len_ bytes were received. */
+	struct sockaddr_ll addrll; /**< Link layer address of the frame (interface index, packet type, source address). */
+	struct ether_header *etherHeader; /**< Pointer to the Ethernet header, inside _packet_. */
+	struct iphdr *IPheader; /**< Pointer to the IPv4 header, inside _packet_. */
+	struct udphdr *udpHeader; /**< Pointer to the UDP header, inside _packet_. */
+	byte_t *payload; /**< Pointer to the UDP payload, inside _packet_. */
+	size_t payloadsize; /**< Size of the UDP payload, in _bytes_, or **0** if the frame is not a complete IPv4/UDP frame. */
+	bool ts_valid; /**< _true_ if _ts_ contains a reception timestamp (i.e. if the timestamps were enabled with rawRecvBatchEnableTimestamps()). */
+	struct timespec ts; /**< Kernel reception timestamp (_SO_TIMESTAMPNS_), valid only if _ts_valid_ is _true_. */
+};
+
+/**
+	\brief Received frame descriptor
+
+	This structure describes a frame received through a memory-mapped ring (see rxringNext()) or read from any other frame source.
+	_data_ points directly to the frame (starting from the Ethernet header), so it can be passed as it is to UDPgetpacketpointers().
+**/
+struct rxframe {
+	byte_t *data; /**< Pointer to the first byte of the frame. */
+	uint32_t snaplen; /**< Number of _bytes_ of the frame which are actually available starting from _data_. */
+	uint32_t len; /**< Original length of the frame, in _bytes_ (it may be larger than _snaplen_ if the frame was truncated). */
+	struct timespec ts; /**< Reception timestamp. */
+	int ifindex; /**< Index of the interface on which the frame was received. */
+};
+
+/**
+	\brief Single-buffer frame container, with headroom for the lower layer headers.
+
+	This structure can be used to build a full frame inside a single buffer, without any intermediate copy: the payload is written once,
+	after a certain headroom, and each header is then put in place in front of it by the [*EncapsulateInPlace()](\ref UDPencapsulateInPlace) functions,
+	starting from the highest layer.
+
+	It should be managed with framebufPrepare() (or framebufInit(), for an already existing buffer) and framebufFree().
+	After all the headers have been added, _data_ and _len_ contain the pointer and the size of the frame to be sent (for instance with _sendto()_).
+**/
+struct framebuf {
+	byte_t *buf; /**< Pointer to the beginning of the whole buffer. */
+	size_t size; /**< Total size of _buf_, in _bytes_. */
+	size_t headroom; /**< Space reserved, in _bytes_, in front of the payload, for the lower layer headers. */
+	byte_t *data; /**< Pointer to the first byte of the current content of the frame (it moves towards _buf_ every time a header is added). */
+	size_t len; /**< Size of the current content of the frame, starting from _data_, in _bytes_. */
+	bool allocated; /**< _true_ if _buf_ was allocated by framebufPrepare() and should be freed by framebufFree(). */
+	uint32_t payloadcsum; /**< Partial checksum (see csum_partial()) of the payload, computed while copying it, if _payloadcsum_valid_ is _true_. */
+	bool payloadcsum_valid; /**< _true_ if _payloadcsum_ contains the partial checksum of the current payload, so that it has not to be computed again when encapsulating it (it is reset by framebufPayloadPtr(), as the payload may then be modified in place). */
+};
+
 /**
 	\brief Protocol type enumerator
 
@@ -132,6 +337,8 @@ typedef enum {
 // General utilities
 rawsockerr_t wlanLookup(char *devname, int *ifindex, macaddr_t mac, struct in_addr *srcIP, int index, int mode);
 rawsockerr_t vifPrinter(FILE *stream);
+rawsockerr_t ifdescResolve(struct ifdesc *ifd, const char *devname);
+int nlIfDump(struct ifrecord *records, unsigned int max);
 macaddr_t prepareMacAddrT();
 unsigned int macAddrTypeGet(macaddr_t mac);
 void freeMacAddrT(macaddr_t mac);
@@ -141,23 +348,49 @@ void display_packetc(const char *text,byte_t *packet,unsigned int len);
 uint64_t hton64 (uint64_t hostu64); // Like 'htonl()' but for 64-bits unsigned integers
 uint64_t ntoh64 (uint64_t netu64); // Like 'ntohl()' but for 64-bits unsigned integers
 
+// Single-buffer frame building functions
+rawsockerr_t framebufPrepare(struct framebuf *fb, size_t headroom, size_t maxpayloadsize);
+rawsockerr_t framebufInit(struct framebuf *fb, byte_t *buf, size_t size, size_t headroom);
+void framebufFree(struct framebuf *fb);
+byte_t *framebufPayloadPtr(struct framebuf *fb);
+rawsockerr_t framebufSetPayloadSize(struct framebuf *fb, size_t payloadsize);
+rawsockerr_t framebufCopyPayload(struct framebuf *fb, byte_t *data, size_t payloadsize);
+rawsockerr_t framebufSetPayloadCsum(struct framebuf *fb, const csumacc_t *payloadacc);
+byte_t *framebufPush(struct framebuf *fb, size_t hdrsize);
+
 // Ethernet level functions
 void etherheadPopulateB(struct ether_header *etherHeader, macaddr_t mac, ethertype_t type);
 void etherheadPopulate(struct ether_header *etherHeader, macaddr_t macsrc, macaddr_t macdst, ethertype_t type);
 size_t etherEncapsulate(byte_t *packet,struct ether_header *header,byte_t *sdu,size_t sdusize);
+size_t etherEncapsulateInPlace(struct framebuf *fb,struct ether_header *header);
 void getSrcMAC(struct ether_header *etherHeader, macaddr_t macsrc);
 
 // IP level functions
 rawsockerr_t IP4headPopulateB(struct iphdr *IPhead, char *devname,unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs);
 rawsockerr_t IP4headPopulateS(struct iphdr *IPhead, char *devname, struct in_addr destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs);
 rawsockerr_t IP4headPopulate(struct iphdr *IPhead, char *devname, char *destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs);
+rawsockerr_t IP4headPopulateBIfd(struct iphdr *IPhead, struct ifdesc *ifd, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs); // Like IP4headPopulateB(), but it takes the source IP address from 'ifd', without any system call
+rawsockerr_t IP4headPopulateSIfd(struct iphdr *IPhead, struct ifdesc *ifd, struct in_addr destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs); // Like IP4headPopulateS(), but it takes the source IP address from 'ifd', without any system call
+rawsockerr_t IP4headPopulateIfd(struct iphdr *IPhead, struct ifdesc *ifd, char *destIP, unsigned char tos,unsigned short frag_offset, unsigned char ttl, unsigned char protocol,unsigned int flags,struct ipaddrs *addrs); // Like IP4headPopulate(), but it takes the source IP address from 'ifd', without any system call
 void IP4headAddID(struct iphdr *IPhead, unsigned short id);
 void IP4headAddTotLen(struct iphdr *IPhead, unsigned short len);
 size_t IP4Encapsulate(byte_t *packet,struct iphdr *header,byte_t *sdu,size_t sdusize);
+size_t IP4EncapsulateInPlace(struct framebuf *fb,struct iphdr *header);
 
 // UDP level functions
 void UDPheadPopulate(struct udphdr *UDPhead, unsigned short sourceport, unsigned short destport);
 size_t UDPencapsulate(byte_t *packet,struct udphdr *header,byte_t *data,size_t payloadsize,struct ipaddrs addrs);
+size_t UDPencapsulateInPlace(struct framebuf *fb,struct udphdr *header,struct ipaddrs addrs);
+
+// Batch send/receive functions
+int rawSendBatch(int descriptor, struct sockaddr_ll addrll, struct batchframe *frames, unsigned int n);
+int rawSendBatchTxtime(int descriptor, struct sockaddr_ll addrll, struct batchframe *frames, unsigned int n);
+rawsockerr_t rawRecvBatchEnableTimestamps(int descriptor);
+int rawRecvBatch(int descriptor, struct recvframe *frames, unsigned int n, int flags);
+
+// Launch time (SO_TXTIME) functions
+rawsockerr_t rawTxtimeEnable(int descriptor, clockid_t clockid, unsigned int flags);
+ssize_t rawSendTxtime(int descriptor, struct sockaddr_ll addrll, byte_t *packet, size_t len, uint64_t txtime);
 
 // Receiving device functions
 byte_t *UDPgetpacketpointers(byte_t *pktbuf,struct ether_header **etherHeader, struct iphdr **IPheader,struct udphdr **UDPheader);
@@ -0,0 +1,293 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_clock.h"
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define RSCLOCK_HAS_TSC 1
+#else
+#define RSCLOCK_HAS_TSC 0
+#endif
+
+#define RSCLOCK_SAMPLE_TRIES 5 // Number of attempts to read the TSC and the base clock together, keeping the tightest one
+#define RSCLOCK_RESYNC_MAX_DEV 1000 // A refined TSC frequency is discarded if it differs by more than 1/RSCLOCK_RESYNC_MAX_DEV from the previous one (e.g. if the base clock jumped)
+
+// Read the TSC
+static inline uint64_t rsclockReadTsc(void) {
+#if RSCLOCK_HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Fixed-point TSC helpers: the 128-bit intermediate values are only available (and only needed) on the architectures providing the TSC
+#if RSCLOCK_HAS_TSC
+// Compute the TSC ticks to nanoseconds multiplier, given the nanoseconds and ticks elapsed over the same interval
+static inline uint64_t rsclockTscMult(uint64_t ns, uint64_t ticks) {
+	return (uint64_t) (((unsigned __int128) ns << RSCLOCK_TSC_SHIFT)/ticks);
+}
+
+// Convert a (signed) TSC ticks difference to nanoseconds
+static inline int64_t rsclockTscScale(int64_t delta, uint64_t mult) {
+	return (int64_t) (((__int128) delta*mult) >> RSCLOCK_TSC_SHIFT);
+}
+#else
+static inline uint64_t rsclockTscMult(uint64_t ns, uint64_t ticks) {
+	(void) ns;
+	(void) ticks;
+	return 0;
+}
+
+static inline int64_t rsclockTscScale(int64_t delta, uint64_t mult) {
+	(void) delta;
+	(void) mult;
+	return 0;
+}
+#endif
+
+// Convert a clocksrc_t value to the corresponding clock_gettime() clock, returning false if it does not correspond to any of them
+static bool rsclockSrcToClockid(clocksrc_t src, clockid_t *id) {
+	switch(src) {
+		case CLOCKSRC_REALTIME:
+			*id=CLOCK_REALTIME;
+		break;
+
+		case CLOCKSRC_MONOTONIC:
+			*id=CLOCK_MONOTONIC;
+		break;
+
+		case CLOCKSRC_MONOTONIC_RAW:
+			*id=CLOCK_MONOTONIC_RAW;
+		break;
+
+		default:
+			return false;
+	}
+
+	return true;
+}
+
+// Read the base clock, in ns, together with the TSC value corresponding to the same instant (the middle point of the tightest of a few attempts)
+static rawsockerr_t rsclockSample(clockid_t base, uint64_t *tsc, uint64_t *ns) {
+	uint64_t before, after, span, bestspan=UINT64_MAX;
+	struct timespec ts;
+	int i;
+
+	for(i=0;i<RSCLOCK_SAMPLE_TRIES;i++) {
+		before=rsclockReadTsc();
+		if(clock_gettime(base,&ts)<0) {
+			return ERR_CLOCK_SOURCE;
+		}
+		after=rsclockReadTsc();
+
+		span=after-before;
+		if(span<bestspan) {
+			bestspan=span;
+			*tsc=before+span/2;
+			*ns=(uint64_t) ts.tv_sec*1000000000ULL+ts.tv_nsec;
+		}
+	}
+
+	return 0;
+}
+
+/**
+	\brief Check if an invariant TSC is available
+
+	This function checks whether the CPU provides an invariant TSC, i.e. a TSC ticking at a constant rate, no matter the frequency
+	and power state of the cores, and synchronized among all of them, which is required by [CLOCKSRC_TSC](\ref CLOCKSRC_TSC).
+
+	\return _true_ if an invariant TSC is available, _false_ otherwise (always _false_ on non-x86_64 architectures).
+**/
+bool rsclockTscAvailable(void) {
+#if RSCLOCK_HAS_TSC
+	unsigned int eax, ebx, ecx, edx;
+
+	if(__get_cpuid_max(0x80000000,NULL)<0x80000007) {
+		return false;
+	}
+
+	__cpuid(0x80000007,eax,ebx,ecx,edx);
+
+	// Invariant TSC bit (CPUID.80000007H:EDX[8])
+	return (edx & (1 << 8))!=0;
+#else
+	return false;
+#endif
+}
+
+/**
+	\brief Initialize a [struct rsclock](\ref rsclock) reading a _clock_gettime()_ clock
+
+	\param[out]	clk 	Pointer to the [struct rsclock](\ref rsclock) to be initialized.
+	\param[in]	src 	Clock source ([CLOCKSRC_REALTIME](\ref CLOCKSRC_REALTIME), [CLOCKSRC_MONOTONIC](\ref CLOCKSRC_MONOTONIC) or [CLOCKSRC_MONOTONIC_RAW](\ref CLOCKSRC_MONOTONIC_RAW); rsclockInitTsc() should be used for the TSC).
+
+	\return **0** if the clock was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_CLOCK_SOURCE* -> invalid clock source, or clock not supported by the system
+**/
+rawsockerr_t rsclockInit(struct rsclock *clk, clocksrc_t src) {
+	struct timespec ts;
+
+	memset(clk,0,sizeof(struct rsclock));
+
+	if(!rsclockSrcToClockid(src,&clk->base) || clock_gettime(clk->base,&ts)<0) {
+		return ERR_CLOCK_SOURCE;
+	}
+
+	clk->src=src;
+
+	return 0;
+}
+
+/**
+	\brief Initialize a [struct rsclock](\ref rsclock) reading the invariant TSC
+
+	This function calibrates the TSC against the _base_ clock, by reading both of them at the beginning and at the end of an interval
+	lasting _calib_ms_ milliseconds (during which the calling thread sleeps). After the calibration, the TSC clock returns the same
+	time as the _base_ clock, but it is much cheaper to read.
+
+	The longer the interval, the lower the drift between the TSC clock and the base clock: [RSCLOCK_CALIB_MS](\ref RSCLOCK_CALIB_MS) is a
+	reasonable trade-off, as the frequency estimate is anyway refined by rsclockResync().
+
+	\param[out]	clk 		Pointer to the [struct rsclock](\ref rsclock) to be initialized.
+	\param[in]	base 		Base clock, against which the TSC is calibrated (any source except [CLOCKSRC_TSC](\ref CLOCKSRC_TSC)).
+	\param[in]	calib_ms 	Duration, in _ms_, of the calibration interval (at least **1**).
+
+	\return **0** if the clock was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_CLOCK_SOURCE* -> invalid base clock, or clock not supported by the system
+	- *ERR_CLOCK_NOTSC* -> no invariant TSC is available (see rsclockTscAvailable())
+	- *ERR_CLOCK_CALIB* -> the calibration failed (the TSC or the base clock did not advance during the calibration interval)
+**/
+rawsockerr_t rsclockInitTsc(struct rsclock *clk, clocksrc_t base, unsigned int calib_ms) {
+	uint64_t tscstart, nsstart, tscend, nsend;
+	rawsockerr_t ret;
+
+	if((ret=rsclockInit(clk,base))!=0) {
+		return ret;
+	}
+
+	if(!rsclockTscAvailable()) {
+		return ERR_CLOCK_NOTSC;
+	}
+
+	if((ret=rsclockSample(clk->base,&tscstart,&nsstart))!=0) {
+		return ret;
+	}
+
+	usleep((calib_ms>0 ? calib_ms : 1)*1000);
+
+	if((ret=rsclockSample(clk->base,&tscend,&nsend))!=0) {
+		return ret;
+	}
+
+	if(tscend<=tscstart || nsend<=nsstart) {
+		return ERR_CLOCK_CALIB;
+	}
+
+	clk->src=CLOCKSRC_TSC;
+	clk->mult=rsclockTscMult(nsend-nsstart,tscend-tscstart);
+	clk->tsccal=tscstart;
+	clk->nscal=nsstart;
+	clk->tsc0=tscend;
+	clk->ns0=nsend;
+
+	return 0;
+}
+
+/**
+	\brief Re-align a TSC clock to its base clock
+
+	This function re-aligns a [struct rsclock](\ref rsclock) initialized with rsclockInitTsc() to its base clock, removing the drift accumulated
+	since the last synchronization, and it refines the TSC frequency estimate over the whole interval elapsed since the initial calibration.
+
+	If the base clock was stepped in the meantime (e.g. a _CLOCK_REALTIME_ base clock set by the user or by NTP), the refined frequency is discarded,
+	the previous one is kept and the calibration interval is restarted from the current instant.
+
+	It should be called periodically, outside of the critical path (it reads the base clock a few times); it has no effect on the other clock sources.
+
+	\param[in,out]	clk 	Pointer to the [struct rsclock](\ref rsclock).
+
+	\return **0** if the clock was re-aligned (or if it does not use the TSC), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_CLOCK_SOURCE* -> unable to read the base clock
+**/
+rawsockerr_t rsclockResync(struct rsclock *clk) {
+	uint64_t tsc, ns, mult;
+	rawsockerr_t ret;
+
+	if(clk->src!=CLOCKSRC_TSC) {
+		return 0;
+	}
+
+	if((ret=rsclockSample(clk->base,&tsc,&ns))!=0) {
+		return ret;
+	}
+
+	if(tsc>clk->tsccal && ns>clk->nscal) {
+		mult=rsclockTscMult(ns-clk->nscal,tsc-clk->tsccal);
+
+		if(mult>clk->mult-clk->mult/RSCLOCK_RESYNC_MAX_DEV && mult<clk->mult+clk->mult/RSCLOCK_RESYNC_MAX_DEV) {
+			clk->mult=mult;
+		} else {
+			clk->tsccal=tsc;
+			clk->nscal=ns;
+		}
+	} else {
+		clk->tsccal=tsc;
+		clk->nscal=ns;
+	}
+
+	clk->tsc0=tsc;
+	clk->ns0=ns;
+
+	return 0;
+}
+
+/**
+	\brief Read a clock, in nanoseconds
+
+	\param[in]	clk 	Pointer to a [struct rsclock](\ref rsclock), initialized with rsclockInit() or rsclockInitTsc().
+
+	\return The current time, in _ns_ since the epoch of the (base) clock.
+**/
+uint64_t rsclockNowNs(const struct rsclock *clk) {
+	struct timespec ts;
+	int64_t delta;
+
+	if(clk->src==CLOCKSRC_TSC) {
+		delta=(int64_t) (rsclockReadTsc()-clk->tsc0);
+
+		return clk->ns0+rsclockTscScale(delta,clk->mult);
+	}
+
+	clock_gettime(clk->base,&ts);
+
+	return (uint64_t) ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+/**
+	\brief Read a clock
+
+	This function works like rsclockNowNs(), but it stores the current time inside a _struct timespec_.
+
+	\param[in]	clk 	Pointer to a [struct rsclock](\ref rsclock), initialized with rsclockInit() or rsclockInitTsc().
+	\param[out]	ts 		Pointer to the _struct timespec_ in which the current time is stored.
+
+	\return None.
+**/
+void rsclockNow(const struct rsclock *clk, struct timespec *ts) {
+	uint64_t ns;
+
+	if(clk->src!=CLOCKSRC_TSC) {
+		clock_gettime(clk->base,ts);
+		return;
+	}
+
+	ns=rsclockNowNs(clk);
+	ts->tv_sec=(time_t) (ns/1000000000ULL);
+	ts->tv_nsec=(long) (ns%1000000000ULL);
+}
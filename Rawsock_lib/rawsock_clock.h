@@ -0,0 +1,81 @@
+/** \file
+	Timestamp sources for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, providing the clocks which can be used to timestamp the packets,
+	with a nanosecond resolution. A [struct rsclock](\ref rsclock) can read:
+	- one of the _clock_gettime()_ clocks (_CLOCK_REALTIME_, _CLOCK_MONOTONIC_ or _CLOCK_MONOTONIC_RAW_), which are served through the vDSO,
+	without any system call, when the kernel clock source allows it
+	- the invariant TSC of x86_64 CPUs, calibrated against one of the previous clocks, so that its readings are expressed in the same time base:
+	reading it only costs a _rdtsc_ instruction and a multiplication
+
+	The TSC clock is calibrated once, when it is initialized, by reading both the TSC and the base clock at the beginning and at the end of
+	a short interval. As the calibration error causes the TSC clock to slowly drift away from the base clock, rsclockResync() should be called
+	from time to time (e.g. every few seconds, outside of the critical path), to re-align it and refine its frequency estimate.
+
+	__Example of use:__
+
+		struct rsclock clk;
+		struct timespec ts;
+
+		if(rsclockInitTsc(&clk,CLOCKSRC_REALTIME,RSCLOCK_CALIB_MS)!=0) {
+			rsclockInit(&clk,CLOCKSRC_REALTIME); // No invariant TSC: fall back to clock_gettime()
+		}
+
+		while(...) {
+			rsclockNow(&clk,&ts);
+			...
+		}
+
+	The LaMP module can use a [struct rsclock](\ref rsclock) to timestamp its packets (see [struct lampclock](\ref lampclock) and lampSetClock()).
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_CLOCK_H_INCLUDED
+#define RAWSOCK_CLOCK_H_INCLUDED
+
+#include "rawsock.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define RSCLOCK_CALIB_MS 100 /**< Suggested duration, in _ms_, of the initial TSC calibration interval. */
+#define RSCLOCK_TSC_SHIFT 48 /**< Fixed-point shift of the TSC ticks to nanoseconds multiplier. */
+
+/**
+	\brief Clock source enumerator
+
+	Clock source enumerator, used to select the clock read by a [struct rsclock](\ref rsclock).
+**/
+typedef enum {
+	CLOCKSRC_REALTIME, /**< _CLOCK_REALTIME_ (wall-clock time, the same used by _gettimeofday()_) */
+	CLOCKSRC_MONOTONIC, /**< _CLOCK_MONOTONIC_ (not affected by discontinuous jumps, but slewed by NTP) */
+	CLOCKSRC_MONOTONIC_RAW, /**< _CLOCK_MONOTONIC_RAW_ (not affected by jumps nor by the NTP frequency adjustments) */
+	CLOCKSRC_TSC /**< Invariant TSC, calibrated against one of the other sources (x86_64 only) */
+} clocksrc_t;
+
+/**
+	\brief Clock
+
+	Structure describing a timestamp source, initialized with rsclockInit() or rsclockInitTsc(). Its fields should not be modified directly by the user.
+**/
+struct rsclock {
+	clocksrc_t src; /**< Clock source. */
+	clockid_t base; /**< _clock_gettime()_ clock which is read (or against which the TSC is calibrated). */
+	uint64_t tsc0; /**< TSC value at the last synchronization (TSC source only). */
+	uint64_t ns0; /**< Base clock time, in _ns_, at the last synchronization (TSC source only). */
+	uint64_t mult; /**< TSC ticks to nanoseconds multiplier, shifted by [RSCLOCK_TSC_SHIFT](\ref RSCLOCK_TSC_SHIFT) bits (TSC source only). */
+	uint64_t tsccal; /**< TSC value at the initial calibration (TSC source only). */
+	uint64_t nscal; /**< Base clock time, in _ns_, at the initial calibration (TSC source only). */
+};
+
+bool rsclockTscAvailable(void);
+rawsockerr_t rsclockInit(struct rsclock *clk, clocksrc_t src);
+rawsockerr_t rsclockInitTsc(struct rsclock *clk, clocksrc_t base, unsigned int calib_ms);
+rawsockerr_t rsclockResync(struct rsclock *clk);
+uint64_t rsclockNowNs(const struct rsclock *clk);
+void rsclockNow(const struct rsclock *clk, struct timespec *ts);
+#endif
@@ -0,0 +1,654 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock_csum.h"
+#include <string.h>
+#include <endian.h>
+#include <netinet/in.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define CSUM_HAVE_X86 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+	#include <arm_neon.h>
+	#include <sys/auxv.h>
+	#define CSUM_HAVE_NEON 1
+	#define CSUM_NEON_TARGET
+#elif defined(__arm__) && !defined(__SOFTFP__) && !defined(__clang__) && defined(__GNUC__) && __GNUC__>=9
+	// 32-bit ARM, without NEON enabled at compile time: the NEON kernels are anyway built for NEON, and selected at runtime only if the CPU supports it
+	#include <arm_neon.h>
+	#include <sys/auxv.h>
+	#define CSUM_HAVE_NEON 1
+	#define CSUM_NEON_TARGET __attribute__((target("fpu=neon")))
+#endif
+
+#ifdef CSUM_HAVE_NEON
+	// Defined here to avoid depending on the libc exposing <asm/hwcap.h>
+	#if defined(__aarch64__)
+		#define CSUM_HWCAP_NEON (1 << 1) // HWCAP_ASIMD
+	#else
+		#define CSUM_HWCAP_NEON (1 << 12) // HWCAP_NEON
+	#endif
+#endif
+
+// Every kernel returns a 64-bit (not yet folded) ones' complement sum of the native 32-bit words of 'buff'
+typedef __u64 (*csum_kernel_t)(const unsigned char *buff, size_t len);
+// Every copy kernel copies 'len' bytes from 'src' to 'dst' and returns the same sum that csum_kernel_t would return for 'src'
+typedef __u64 (*csum_copy_kernel_t)(const unsigned char *src, unsigned char *dst, size_t len);
+
+static __u64 csum_kernel_resolve(const unsigned char *buff, size_t len);
+static __u64 csum_copy_kernel_resolve(const unsigned char *src, unsigned char *dst, size_t len);
+
+static csum_kernel_t csum_kernel=csum_kernel_resolve; // Current kernel (resolved the first time it is called)
+static csum_copy_kernel_t csum_copy_kernel=csum_copy_kernel_resolve; // Current copy kernel (selected together with 'csum_kernel')
+static const char *csum_kernel_name="none";
+
+// The kernels can be resolved (or changed with csum_select_impl()) by any thread, while other threads are computing checksums: the pointers are
+//  always read and written atomically (relaxed ordering is enough, as they only point to code and string literals, which never change)
+#define CSUM_LOAD(ptr) __atomic_load_n(ptr,__ATOMIC_RELAXED)
+#define CSUM_STORE(ptr,val) __atomic_store_n(ptr,val,__ATOMIC_RELAXED)
+
+// Fold a 32-bit partial ones' complement sum into 16 bits
+static inline __u16 csum_fold32(__u32 sum) {
+	sum=(sum & 0xFFFF)+(sum >> 16);
+	sum=(sum & 0xFFFF)+(sum >> 16);
+
+	return (__u16) sum;
+}
+
+// Fold a 64-bit partial ones' complement sum into 32 bits
+static inline __u32 csum_fold64(__u64 sum) {
+	sum=(sum & 0xFFFFFFFF)+(sum >> 32);
+	sum=(sum & 0xFFFFFFFF)+(sum >> 32);
+
+	return (__u32) sum;
+}
+
+// Sum the last bytes (less than 8) of a buffer; 'buff' should be at an even offset with respect to the beginning of the checksummed data
+static inline __u64 csum_tail(const unsigned char *buff, size_t len) {
+	__u64 result=0;
+	__u32 w32;
+	__u16 w16;
+
+	if(len & 4) {
+		memcpy(&w32,buff,sizeof(w32));
+		result+=w32;
+		buff+=4;
+	}
+	if(len & 2) {
+		memcpy(&w16,buff,sizeof(w16));
+		result+=w16;
+		buff+=2;
+	}
+	if(len & 1) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+		result+=*buff;
+#else
+		result+=(*buff << 8);
+#endif
+	}
+
+	return result;
+}
+
+// Portable kernel: unaligned 64-bit loads (through memcpy), each split into two 32-bit words added to a 64-bit accumulator (no carry to be managed)
+static __u64 csum_kernel_generic(const unsigned char *buff, size_t len) {
+	__u64 result=0;
+	__u64 w0, w1, w2, w3;
+
+	while(len>=32) {
+		memcpy(&w0,buff,sizeof(w0));
+		memcpy(&w1,buff+8,sizeof(w1));
+		memcpy(&w2,buff+16,sizeof(w2));
+		memcpy(&w3,buff+24,sizeof(w3));
+		result+=(w0 & 0xFFFFFFFF)+(w0 >> 32);
+		result+=(w1 & 0xFFFFFFFF)+(w1 >> 32);
+		result+=(w2 & 0xFFFFFFFF)+(w2 >> 32);
+		result+=(w3 & 0xFFFFFFFF)+(w3 >> 32);
+		buff+=32;
+		len-=32;
+	}
+	while(len>=8) {
+		memcpy(&w0,buff,sizeof(w0));
+		result+=(w0 & 0xFFFFFFFF)+(w0 >> 32);
+		buff+=8;
+		len-=8;
+	}
+
+	return result+csum_tail(buff,len);
+}
+
+// Portable copy kernel: every 64-bit word is summed while it is stored to the destination
+static __u64 csum_copy_kernel_generic(const unsigned char *src, unsigned char *dst, size_t len) {
+	__u64 result=0;
+	__u64 w0, w1, w2, w3;
+
+	while(len>=32) {
+		memcpy(&w0,src,sizeof(w0));
+		memcpy(&w1,src+8,sizeof(w1));
+		memcpy(&w2,src+16,sizeof(w2));
+		memcpy(&w3,src+24,sizeof(w3));
+		memcpy(dst,&w0,sizeof(w0));
+		memcpy(dst+8,&w1,sizeof(w1));
+		memcpy(dst+16,&w2,sizeof(w2));
+		memcpy(dst+24,&w3,sizeof(w3));
+		result+=(w0 & 0xFFFFFFFF)+(w0 >> 32);
+		result+=(w1 & 0xFFFFFFFF)+(w1 >> 32);
+		result+=(w2 & 0xFFFFFFFF)+(w2 >> 32);
+		result+=(w3 & 0xFFFFFFFF)+(w3 >> 32);
+		src+=32;
+		dst+=32;
+		len-=32;
+	}
+	while(len>=8) {
+		memcpy(&w0,src,sizeof(w0));
+		memcpy(dst,&w0,sizeof(w0));
+		result+=(w0 & 0xFFFFFFFF)+(w0 >> 32);
+		src+=8;
+		dst+=8;
+		len-=8;
+	}
+
+	memcpy(dst,src,len);
+
+	return result+csum_tail(src,len);
+}
+
+#ifdef CSUM_HAVE_X86
+// SSE2 kernel: 32-bit words are zero-extended to 64-bit lanes and accumulated, 32 bytes per iteration
+__attribute__((target("sse2")))
+static __u64 csum_kernel_sse2(const unsigned char *buff, size_t len) {
+	const __m128i zero=_mm_setzero_si128();
+	__m128i acc0=_mm_setzero_si128(), acc1=_mm_setzero_si128();
+	__m128i v0, v1;
+	__u64 lanes[2];
+
+	while(len>=32) {
+		v0=_mm_loadu_si128((const __m128i *) buff);
+		v1=_mm_loadu_si128((const __m128i *) (buff+16));
+		acc0=_mm_add_epi64(acc0,_mm_unpacklo_epi32(v0,zero));
+		acc1=_mm_add_epi64(acc1,_mm_unpackhi_epi32(v0,zero));
+		acc0=_mm_add_epi64(acc0,_mm_unpacklo_epi32(v1,zero));
+		acc1=_mm_add_epi64(acc1,_mm_unpackhi_epi32(v1,zero));
+		buff+=32;
+		len-=32;
+	}
+
+	_mm_storeu_si128((__m128i *) lanes,_mm_add_epi64(acc0,acc1));
+
+	return lanes[0]+lanes[1]+csum_kernel_generic(buff,len);
+}
+
+// SSE2 copy kernel: like the SSE2 kernel, storing each loaded vector to the destination
+__attribute__((target("sse2")))
+static __u64 csum_copy_kernel_sse2(const unsigned char *src, unsigned char *dst, size_t len) {
+	const __m128i zero=_mm_setzero_si128();
+	__m128i acc0=_mm_setzero_si128(), acc1=_mm_setzero_si128();
+	__m128i v0, v1;
+	__u64 lanes[2];
+
+	while(len>=32) {
+		v0=_mm_loadu_si128((const __m128i *) src);
+		v1=_mm_loadu_si128((const __m128i *) (src+16));
+		_mm_storeu_si128((__m128i *) dst,v0);
+		_mm_storeu_si128((__m128i *) (dst+16),v1);
+		acc0=_mm_add_epi64(acc0,_mm_unpacklo_epi32(v0,zero));
+		acc1=_mm_add_epi64(acc1,_mm_unpackhi_epi32(v0,zero));
+		acc0=_mm_add_epi64(acc0,_mm_unpacklo_epi32(v1,zero));
+		acc1=_mm_add_epi64(acc1,_mm_unpackhi_epi32(v1,zero));
+		src+=32;
+		dst+=32;
+		len-=32;
+	}
+
+	_mm_storeu_si128((__m128i *) lanes,_mm_add_epi64(acc0,acc1));
+
+	return lanes[0]+lanes[1]+csum_copy_kernel_generic(src,dst,len);
+}
+
+// AVX2 kernel: same as the SSE2 one, but with 256-bit registers, 64 bytes per iteration
+__attribute__((target("avx2")))
+static __u64 csum_kernel_avx2(const unsigned char *buff, size_t len) {
+	const __m256i zero=_mm256_setzero_si256();
+	__m256i acc0=_mm256_setzero_si256(), acc1=_mm256_setzero_si256();
+	__m256i v0, v1;
+	__u64 lanes[4];
+
+	while(len>=64) {
+		v0=_mm256_loadu_si256((const __m256i *) buff);
+		v1=_mm256_loadu_si256((const __m256i *) (buff+32));
+		acc0=_mm256_add_epi64(acc0,_mm256_unpacklo_epi32(v0,zero));
+		acc1=_mm256_add_epi64(acc1,_mm256_unpackhi_epi32(v0,zero));
+		acc0=_mm256_add_epi64(acc0,_mm256_unpacklo_epi32(v1,zero));
+		acc1=_mm256_add_epi64(acc1,_mm256_unpackhi_epi32(v1,zero));
+		buff+=64;
+		len-=64;
+	}
+
+	_mm256_storeu_si256((__m256i *) lanes,_mm256_add_epi64(acc0,acc1));
+	// Avoid any AVX to SSE transition penalty in the code handling the last bytes
+	_mm256_zeroupper();
+
+	return lanes[0]+lanes[1]+lanes[2]+lanes[3]+csum_kernel_generic(buff,len);
+}
+
+// AVX2 copy kernel: like the AVX2 kernel, storing each loaded vector to the destination
+__attribute__((target("avx2")))
+static __u64 csum_copy_kernel_avx2(const unsigned char *src, unsigned char *dst, size_t len) {
+	const __m256i zero=_mm256_setzero_si256();
+	__m256i acc0=_mm256_setzero_si256(), acc1=_mm256_setzero_si256();
+	__m256i v0, v1;
+	__u64 lanes[4];
+
+	while(len>=64) {
+		v0=_mm256_loadu_si256((const __m256i *) src);
+		v1=_mm256_loadu_si256((const __m256i *) (src+32));
+		_mm256_storeu_si256((__m256i *) dst,v0);
+		_mm256_storeu_si256((__m256i *) (dst+32),v1);
+		acc0=_mm256_add_epi64(acc0,_mm256_unpacklo_epi32(v0,zero));
+		acc1=_mm256_add_epi64(acc1,_mm256_unpackhi_epi32(v0,zero));
+		acc0=_mm256_add_epi64(acc0,_mm256_unpacklo_epi32(v1,zero));
+		acc1=_mm256_add_epi64(acc1,_mm256_unpackhi_epi32(v1,zero));
+		src+=64;
+		dst+=64;
+		len-=64;
+	}
+
+	_mm256_storeu_si256((__m256i *) lanes,_mm256_add_epi64(acc0,acc1));
+	// Avoid any AVX to SSE transition penalty in the code handling the last bytes
+	_mm256_zeroupper();
+
+	return lanes[0]+lanes[1]+lanes[2]+lanes[3]+csum_copy_kernel_generic(src,dst,len);
+}
+#endif
+
+#ifdef CSUM_HAVE_NEON
+// NEON kernel: pairs of 32-bit words are added and accumulated into 64-bit lanes (vpadalq_u32), 32 bytes per iteration
+CSUM_NEON_TARGET
+static __u64 csum_kernel_neon(const unsigned char *buff, size_t len) {
+	uint64x2_t acc0=vdupq_n_u64(0), acc1=vdupq_n_u64(0);
+
+	while(len>=32) {
+		acc0=vpadalq_u32(acc0,vreinterpretq_u32_u8(vld1q_u8(buff)));
+		acc1=vpadalq_u32(acc1,vreinterpretq_u32_u8(vld1q_u8(buff+16)));
+		buff+=32;
+		len-=32;
+	}
+
+	acc0=vaddq_u64(acc0,acc1);
+
+	return vgetq_lane_u64(acc0,0)+vgetq_lane_u64(acc0,1)+csum_kernel_generic(buff,len);
+}
+
+// NEON copy kernel: like the NEON kernel, storing each loaded vector to the destination
+CSUM_NEON_TARGET
+static __u64 csum_copy_kernel_neon(const unsigned char *src, unsigned char *dst, size_t len) {
+	uint64x2_t acc0=vdupq_n_u64(0), acc1=vdupq_n_u64(0);
+	uint8x16_t v0, v1;
+
+	while(len>=32) {
+		v0=vld1q_u8(src);
+		v1=vld1q_u8(src+16);
+		vst1q_u8(dst,v0);
+		vst1q_u8(dst+16,v1);
+		acc0=vpadalq_u32(acc0,vreinterpretq_u32_u8(v0));
+		acc1=vpadalq_u32(acc1,vreinterpretq_u32_u8(v1));
+		src+=32;
+		dst+=32;
+		len-=32;
+	}
+
+	acc0=vaddq_u64(acc0,acc1);
+
+	return vgetq_lane_u64(acc0,0)+vgetq_lane_u64(acc0,1)+csum_copy_kernel_generic(src,dst,len);
+}
+#endif
+
+// Select a kernel: it returns 0 if the requested kernel is supported by the current CPU, -1 otherwise
+static int csum_kernel_set(csumimpl_t impl) {
+	switch(impl) {
+		case CSUM_IMPL_GENERIC:
+			CSUM_STORE(&csum_kernel,csum_kernel_generic);
+			CSUM_STORE(&csum_copy_kernel,csum_copy_kernel_generic);
+			CSUM_STORE(&csum_kernel_name,"generic");
+		return 0;
+
+#ifdef CSUM_HAVE_X86
+		case CSUM_IMPL_SSE2:
+			__builtin_cpu_init();
+			if(!__builtin_cpu_supports("sse2")) {
+				return -1;
+			}
+			CSUM_STORE(&csum_kernel,csum_kernel_sse2);
+			CSUM_STORE(&csum_copy_kernel,csum_copy_kernel_sse2);
+			CSUM_STORE(&csum_kernel_name,"sse2");
+		return 0;
+
+		case CSUM_IMPL_AVX2:
+			__builtin_cpu_init();
+			if(!__builtin_cpu_supports("avx2")) {
+				return -1;
+			}
+			CSUM_STORE(&csum_kernel,csum_kernel_avx2);
+			CSUM_STORE(&csum_copy_kernel,csum_copy_kernel_avx2);
+			CSUM_STORE(&csum_kernel_name,"avx2");
+		return 0;
+#endif
+
+#ifdef CSUM_HAVE_NEON
+		case CSUM_IMPL_NEON:
+			if(!(getauxval(AT_HWCAP) & CSUM_HWCAP_NEON)) {
+				return -1;
+			}
+			CSUM_STORE(&csum_kernel,csum_kernel_neon);
+			CSUM_STORE(&csum_copy_kernel,csum_copy_kernel_neon);
+			CSUM_STORE(&csum_kernel_name,"neon");
+		return 0;
+#endif
+
+		case CSUM_IMPL_AUTO:
+			if(csum_kernel_set(CSUM_IMPL_AVX2)==0 || csum_kernel_set(CSUM_IMPL_SSE2)==0 || csum_kernel_set(CSUM_IMPL_NEON)==0) {
+				return 0;
+			}
+		return csum_kernel_set(CSUM_IMPL_GENERIC);
+
+		default:
+		return -1;
+	}
+}
+
+// Initial value of 'csum_kernel': it selects the best kernel, then it calls it
+static __u64 csum_kernel_resolve(const unsigned char *buff, size_t len) {
+	csum_kernel_set(CSUM_IMPL_AUTO);
+
+	return CSUM_LOAD(&csum_kernel)(buff,len);
+}
+
+// Initial value of 'csum_copy_kernel': it selects the best kernels, then it calls the copy one
+static __u64 csum_copy_kernel_resolve(const unsigned char *src, unsigned char *dst, size_t len) {
+	csum_kernel_set(CSUM_IMPL_AUTO);
+
+	return CSUM_LOAD(&csum_copy_kernel)(src,dst,len);
+}
+
+/**
+	\brief Compute the partial Internet checksum of a buffer
+
+	This function computes the 32-bit ones' complement sum of the 16-bit words contained inside _buff_, adding it to _sum_.
+	The result is not folded and not complemented: it can be passed as _sum_ to a subsequent call, to checksum non contiguous data,
+	and it should be finally converted to a checksum with csum_fold() (or with csum_tcpudp_magic(), for UDP).
+
+	_buff_ does not need to be aligned, and _len_ can be odd (the last byte is padded with zeros); when checksumming non contiguous data, however,
+	every call except the last one should be related to a buffer with an even length.
+
+	The computation is performed by the best kernel supported by the current CPU (see csum_impl_name()).
+
+	__Example of use:__
+
+		struct iphdr header;
+
+		header.check=csum_fold(csum_partial(&header,header.ihl*4,0));
+
+	\param[in]	buff 	Pointer to the data to be checksummed.
+	\param[in]	len 	Length, in _bytes_, of the data to be checksummed.
+	\param[in]	sum 	Partial sum to which the sum of _buff_ should be added (**0** when starting a new checksum).
+
+	\return The updated partial sum.
+**/
+__u32 csum_partial(const void *buff, size_t len, __u32 sum) {
+	return csum_fold64(CSUM_LOAD(&csum_kernel)((const unsigned char *) buff,len)+sum);
+}
+
+/**
+	\brief Copy a buffer and compute its partial Internet checksum, in a single pass
+
+	This function copies _len_ bytes from _src_ to _dst_ (which should not overlap) and, at the same time, it computes the partial
+	sum of the copied data, exactly as csum_partial() would do on _src_, adding it to _sum_.
+
+	It should be preferred to a _memcpy()_ followed by csum_partial(), as each byte is read only once and it is checksummed while it is
+	still inside the CPU registers, halving the memory traffic for large buffers.
+
+	\param[in]	src 	Pointer to the data to be copied and checksummed.
+	\param[out]	dst 	Pointer to the destination buffer (should be already allocated, with at least _len_ bytes).
+	\param[in]	len 	Length, in _bytes_, of the data to be copied and checksummed.
+	\param[in]	sum 	Partial sum to which the sum of _src_ should be added (**0** when starting a new checksum).
+
+	\return The updated partial sum.
+**/
+__u32 csum_partial_copy(const void *src, void *dst, size_t len, __u32 sum) {
+	return csum_fold64(CSUM_LOAD(&csum_copy_kernel)((const unsigned char *) src,(unsigned char *) dst,len)+sum);
+}
+
+/**
+	\brief Fold a partial checksum into the final 16-bit Internet checksum
+
+	This function folds a 32-bit partial sum, returned by csum_partial(), into 16 bits, and complements it.
+
+	\param[in]	sum 	Partial sum, computed by csum_partial().
+
+	\return The final checksum, ready to be inserted inside a packet.
+**/
+__sum16 csum_fold(__u32 sum) {
+	return (__sum16) ~csum_fold32(sum);
+}
+
+/**
+	\brief Compute a UDP (or TCP) checksum, including the IPv4 pseudo-header
+
+	This function adds the IPv4 pseudo-header (source and destination addresses, protocol and length) to a partial sum,
+	related to the UDP header and payload and computed by csum_partial(), and returns the final checksum.
+
+	\param[in]	saddr 	Source IPv4 address (**network** byte order).
+	\param[in]	daddr 	Destination IPv4 address (**network** byte order).
+	\param[in]	len 	Length, in _bytes_, of the UDP header and payload (**host** byte order).
+	\param[in]	proto 	Protocol number (e.g. _IPPROTO_UDP_).
+	\param[in]	sum 	Partial sum of the UDP header and payload, computed by csum_partial().
+
+	\return The final checksum, ready to be inserted inside the UDP header.
+**/
+__sum16 csum_tcpudp_magic(__be32 saddr, __be32 daddr, __u32 len, __u8 proto, __u32 sum) {
+	__u64 result=sum;
+
+	result+=saddr;
+	result+=daddr;
+	result+=htons((__u16) proto);
+	result+=htons((__u16) len);
+
+	return csum_fold(csum_fold64(result));
+}
+
+/**
+	\brief Force a specific checksum kernel
+
+	This function can be used to force csum_partial() to use a specific implementation, instead of the one automatically selected.
+	It is mainly useful for testing and benchmarking purposes. It can be called while other threads are computing checksums: each of them
+	switches to the new kernel at its next call.
+
+	\param[in]	impl 	Requested kernel (see [csumimpl_t](\ref csumimpl_t)): [CSUM_IMPL_AUTO](\ref CSUM_IMPL_AUTO) restores the automatic selection.
+
+	\return **0** if the requested kernel is supported by the current CPU and it was selected, **-1** otherwise (the previous kernel is kept).
+**/
+int csum_select_impl(csumimpl_t impl) {
+	return csum_kernel_set(impl);
+}
+
+/**
+	\brief Get the name of the checksum kernel in use
+
+	\return A string containing the name of the kernel used by csum_partial() ("generic", "sse2", "avx2" or "neon"),
+	or "none" if no checksum was computed yet.
+**/
+const char *csum_impl_name(void) {
+	return CSUM_LOAD(&csum_kernel_name);
+}
+
+// Swap the two bytes of a 16-bit partial sum, obtaining the partial sum of the same data when it starts at an odd offset
+static inline __u32 csum_rotate16(__u16 sum) {
+	return (__u32) ((sum >> 8) | ((sum & 0xFF) << 8));
+}
+
+/**
+	\brief Initialize a checksum accumulator
+
+	\param[out]	acc 	Pointer to the [csumacc_t](\ref csumacc_t) accumulator to be initialized.
+
+	\return None.
+**/
+void csumacc_init(csumacc_t *acc) {
+	acc->sum=0;
+	acc->len=0;
+}
+
+/**
+	\brief Add a piece of data to a checksum accumulator
+
+	This function adds the sum of the _len_ bytes contained inside _buff_ to _acc_, as if they were stored directly after all
+	the data already added. Unlike csum_partial(), any piece can have an odd length.
+
+	\param[in,out]	acc 	Pointer to a [csumacc_t](\ref csumacc_t) accumulator, initialized with csumacc_init().
+	\param[in]		buff 	Pointer to the data to be checksummed.
+	\param[in]		len 	Length, in _bytes_, of the data to be checksummed.
+
+	\return None.
+**/
+void csumacc_partial(csumacc_t *acc, const void *buff, size_t len) {
+	csumacc_t piece;
+
+	if((acc->len & 1)==0) {
+		acc->sum=csum_partial(buff,len,acc->sum);
+		acc->len+=len;
+	} else {
+		piece.sum=csum_partial(buff,len,0);
+		piece.len=len;
+		csumacc_add(acc,&piece);
+	}
+}
+
+/**
+	\brief Copy a piece of data and add it to a checksum accumulator, in a single pass
+
+	This function works like csumacc_partial(), but it also copies the data from _src_ to _dst_ (see csum_partial_copy()).
+
+	\param[in,out]	acc 	Pointer to a [csumacc_t](\ref csumacc_t) accumulator, initialized with csumacc_init().
+	\param[in]		src 	Pointer to the data to be copied and checksummed.
+	\param[out]		dst 	Pointer to the destination buffer (should be already allocated, with at least _len_ bytes).
+	\param[in]		len 	Length, in _bytes_, of the data to be copied and checksummed.
+
+	\return None.
+**/
+void csumacc_partial_copy(csumacc_t *acc, const void *src, void *dst, size_t len) {
+	csumacc_t piece;
+
+	if((acc->len & 1)==0) {
+		acc->sum=csum_partial_copy(src,dst,len,acc->sum);
+		acc->len+=len;
+	} else {
+		piece.sum=csum_partial_copy(src,dst,len,0);
+		piece.len=len;
+		csumacc_add(acc,&piece);
+	}
+}
+
+/**
+	\brief Combine two checksum accumulators
+
+	This function adds to _acc_ the sum stored inside _piece_, as if the data summed by _piece_ were stored directly after all
+	the data already added to _acc_. The data is not read again: the cost is constant, no matter how many bytes were summed by _piece_.
+
+	\param[in,out]	acc 	Pointer to a [csumacc_t](\ref csumacc_t) accumulator, initialized with csumacc_init().
+	\param[in]		piece 	Pointer to the [csumacc_t](\ref csumacc_t) accumulator to be added (it is not modified).
+
+	\return None.
+**/
+void csumacc_add(csumacc_t *acc, const csumacc_t *piece) {
+	__u32 sum=csum_fold32(piece->sum);
+
+	if(acc->len & 1) {
+		sum=csum_rotate16(sum);
+	}
+
+	acc->sum=csum_fold32(csum_fold32(acc->sum)+sum);
+	acc->len+=piece->len;
+}
+
+/**
+	\brief Get the final 16-bit Internet checksum of the data added to a checksum accumulator
+
+	\param[in]	acc 	Pointer to a [csumacc_t](\ref csumacc_t) accumulator.
+
+	\return The final checksum (folded and complemented, see csum_fold()).
+**/
+__sum16 csumacc_fold(const csumacc_t *acc) {
+	return csum_fold(acc->sum);
+}
+
+/**
+	\brief Incrementally update a checksum after a 16-bit field has changed
+
+	This function computes, as described in [RFC 1624](https://tools.ietf.org/html/rfc1624) (eqn. 3), the new value of an Internet checksum
+	after a 16-bit field, covered by the checksum, has been changed from _oldval_ to _newval_.
+
+	__Example of use:__
+
+		struct iphdr *header;
+		__be16 newid=htons(id);
+
+		header->check=csum_replace2(header->check,header->id,newid);
+		header->id=newid;
+
+	\param[in]	check 		Current value of the checksum, as stored inside the packet.
+	\param[in]	oldval 		Old value of the field (**network** byte order).
+	\param[in]	newval 		New value of the field (**network** byte order).
+
+	\return The updated checksum, ready to be stored inside the packet in place of _check_.
+**/
+__sum16 csum_replace2(__sum16 check, __be16 oldval, __be16 newval) {
+	__u32 sum;
+
+	sum=(__u16) ~check;
+	sum+=(__u16) ~oldval;
+	sum+=(__u16) newval;
+
+	return (__sum16) ~csum_fold32(sum);
+}
+
+/**
+	\brief Incrementally update a checksum after a 32-bit field has changed
+
+	This function works like csum_replace2(), but for a 32-bit field (for instance an IPv4 address).
+
+	\param[in]	check 		Current value of the checksum, as stored inside the packet.
+	\param[in]	oldval 		Old value of the field (**network** byte order).
+	\param[in]	newval 		New value of the field (**network** byte order).
+
+	\return The updated checksum, ready to be stored inside the packet in place of _check_.
+**/
+__sum16 csum_replace4(__sum16 check, __be32 oldval, __be32 newval) {
+	__u32 sum;
+
+	sum=(__u16) ~check;
+	sum+=(~oldval & 0xFFFF)+(~oldval >> 16);
+	sum+=(newval & 0xFFFF)+(newval >> 16);
+
+	return (__sum16) ~csum_fold32(sum);
+}
+
+/**
+	\brief Incrementally update a checksum after a 64-bit field has changed
+
+	This function works like csum_replace2(), but for a 64-bit field (for instance the LaMP timestamp fields).
+
+	\param[in]	check 		Current value of the checksum, as stored inside the packet.
+	\param[in]	oldval 		Old value of the field (**network** byte order).
+	\param[in]	newval 		New value of the field (**network** byte order).
+
+	\return The updated checksum, ready to be stored inside the packet in place of _check_.
+**/
+__sum16 csum_replace8(__sum16 check, __be64 oldval, __be64 newval) {
+	__u32 sum;
+
+	sum=(__u16) ~check;
+	sum+=csum_fold32((__u32) (~oldval & 0xFFFFFFFF))+csum_fold32((__u32) (~oldval >> 32));
+	sum+=csum_fold32((__u32) (newval & 0xFFFFFFFF))+csum_fold32((__u32) (newval >> 32));
+
+	return (__sum16) ~csum_fold32(sum);
+}
@@ -0,0 +1,102 @@
+/** \file 
+	Checksum utilities of the Rawsock library.
+
+	This header file gives access to the Internet (ones' complement) checksum routines used by the whole library.
+
+	csum_partial() computes the 32-bit partial sum of any buffer, with no alignment requirement. Several implementations
+	(kernels) are available: a portable one and vectorized ones, using SSE2 or AVX2 on x86 and NEON on ARM (on 32-bit ARM, the NEON kernel is built with GCC 9 or later, even when NEON is not enabled at compile time, except with the soft-float ABI). The best kernel supported
+	by the current CPU is automatically selected at runtime, the first time a checksum is computed (it can also be forced with csum_select_impl()).
+	Both ip_fast_csum() and minirighi_udp_checksum() rely on it.
+	csum_partial_copy() does the same while copying the data to another buffer, in a single pass.
+
+	When the data to be checksummed is split in several pieces, a [csumacc_t](\ref csumacc_t) accumulator can be used instead:
+	csumacc_partial() adds a piece of any length, at any offset (the pieces starting at an odd offset are automatically taken into account),
+	and csumacc_add() combines two accumulators without reading the data again. This allows, for instance, to checksum a constant payload
+	only once, and then to combine its sum with the headers of many different packets.
+
+	__Example of use:__
+
+		csumacc_t payloadacc, acc;
+
+		csumacc_init(&payloadacc);
+		csumacc_partial(&payloadacc,payload,payloadsize); // Computed only once
+
+		for(...) {
+			csumacc_init(&acc);
+			csumacc_partial(&acc,&udpHeader,sizeof(struct udphdr));
+			csumacc_add(&acc,&payloadacc);
+			udpHeader.check=csum_tcpudp_magic(saddr,daddr,acc.len,IPPROTO_UDP,acc.sum);
+		}
+
+	This header file also gives access to a set of functions that can be used to update an already computed Internet checksum
+	(such as the IPv4 header checksum or the UDP checksum) when only some fields of the checksummed data are changed, in an
+	incremental way, as described in [RFC 1624](https://tools.ietf.org/html/rfc1624).
+
+	Instead of computing again the checksum over the whole header or packet, the new checksum is obtained from the old one and from
+	the old and new values of the modified fields: the cost is constant, no matter the size of the packet.
+
+	All the values passed to these functions should be in **network** byte order, i.e. exactly as they are stored inside the packet.
+	The modified fields should always start at an even offset with respect to the beginning of the checksummed data, which is
+	true for all the fields of the IPv4, UDP and LaMP headers.
+
+	The functions, even though they are used internally in the main Rawsock module and in the LaMP module, are available through a separate
+	header in order to enable any application to use them separately, when needed.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+
+#ifndef RAWSOCK_CSUM_H_INCLUDED
+#define RAWSOCK_CSUM_H_INCLUDED
+
+#include <linux/types.h>
+#include <stddef.h>
+
+/**
+	\brief Checksum kernel enumerator
+
+	Checksum kernel enumerator, which can be used to force a specific implementation of csum_partial() with csum_select_impl() (for instance to compare them).
+**/
+typedef enum {
+	CSUM_IMPL_AUTO,		/**< Automatically select the best implementation supported by the current CPU (default) */
+	CSUM_IMPL_GENERIC,	/**< Portable implementation, 64-bit accumulator (always available) */
+	CSUM_IMPL_SSE2,		/**< x86 SSE2 implementation */
+	CSUM_IMPL_AVX2,		/**< x86 AVX2 implementation */
+	CSUM_IMPL_NEON		/**< ARM NEON (Advanced SIMD) implementation */
+} csumimpl_t;
+
+/**
+	\brief Checksum accumulator
+
+	Partial Internet checksum of a sequence of pieces of data, each added with csumacc_partial() (or csumacc_partial_copy()), or combined
+	from another accumulator with csumacc_add(). It should be initialized with csumacc_init().
+
+	_sum_ can be directly passed to csum_fold() or csum_tcpudp_magic() (csumacc_fold() can be used as well).
+**/
+typedef struct {
+	__u32 sum; /**< Partial sum (see csum_partial()) of all the data added so far. */
+	size_t len; /**< Number of _bytes_ added so far (its parity tells whether the next piece starts at an odd offset). */
+} csumacc_t;
+
+// Full and partial checksum computation
+__u32 csum_partial(const void *buff, size_t len, __u32 sum);
+__u32 csum_partial_copy(const void *src, void *dst, size_t len, __u32 sum);
+__sum16 csum_fold(__u32 sum);
+__sum16 csum_tcpudp_magic(__be32 saddr, __be32 daddr, __u32 len, __u8 proto, __u32 sum);
+int csum_select_impl(csumimpl_t impl);
+const char *csum_impl_name(void);
+
+// Checksum accumulator, for data split in several pieces
+void csumacc_init(csumacc_t *acc);
+void csumacc_partial(csumacc_t *acc, const void *buff, size_t len);
+void csumacc_partial_copy(csumacc_t *acc, const void *src, void *dst, size_t len);
+void csumacc_add(csumacc_t *acc, const csumacc_t *piece);
+__sum16 csumacc_fold(const csumacc_t *acc);
+
+// Incremental checksum update functions (RFC 1624)
+__sum16 csum_replace2(__sum16 check, __be16 oldval, __be16 newval);
+__sum16 csum_replace4(__sum16 check, __be32 oldval, __be32 newval);
+__sum16 csum_replace8(__sum16 check, __be64 oldval, __be64 newval);
+
+#endif
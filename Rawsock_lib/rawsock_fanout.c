@@ -0,0 +1,413 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#define _GNU_SOURCE // Needed for pthread_attr_setaffinity_np()
+#include "rawsock.h"
+#include "rawsock_fanout.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+
+static void *fanoutWorkerThread(void *arg) {
+	struct fanoutworker *worker=arg;
+	struct fanoutengine *engine=worker->engine;
+	int ret;
+
+	while(!__atomic_load_n(&engine->stop,__ATOMIC_ACQUIRE)) {
+		if(engine->batchcb!=NULL) {
+			ret=rxringNextBatch(&worker->ring,worker->frames,engine->batch_max,FANOUT_POLL_TIMEOUT);
+		} else {
+			ret=rxringNext(&worker->ring,worker->frames,FANOUT_POLL_TIMEOUT);
+		}
+
+		if(ret<0) {
+			if(errno==EINTR) {
+				continue;
+			}
+
+			worker->err=ret;
+			break;
+		} else if(ret==0) {
+			continue;
+		}
+
+		if(engine->batchcb!=NULL) {
+			engine->batchcb(worker->frames,ret,worker->index,engine->arg);
+		} else {
+			engine->framecb(worker->frames,worker->index,engine->arg);
+		}
+
+		__atomic_fetch_add(&worker->received,ret,__ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+static rawsockerr_t fanoutStart(struct fanoutengine *engine) {
+	pthread_attr_t attr;
+	cpu_set_t cpuset;
+	unsigned int i;
+	int ret;
+
+	if(engine->running) {
+		return ERR_FANOUT_PARAMS;
+	}
+
+	__atomic_store_n(&engine->stop,0,__ATOMIC_RELEASE);
+
+	for(i=0;i<engine->nworkers;i++) {
+		struct fanoutworker *worker=&engine->workers[i];
+
+		worker->err=0;
+
+		pthread_attr_init(&attr);
+		if(worker->cpu>=0) {
+			CPU_ZERO(&cpuset);
+			CPU_SET(worker->cpu,&cpuset);
+			pthread_attr_setaffinity_np(&attr,sizeof(cpuset),&cpuset);
+		}
+
+		ret=pthread_create(&worker->thread,&attr,fanoutWorkerThread,worker);
+		pthread_attr_destroy(&attr);
+
+		if(ret!=0) {
+			errno=ret;
+			engine->running=true;
+			fanoutStop(engine);
+			return ERR_FANOUT_THREAD;
+		}
+
+		worker->started=true;
+	}
+
+	engine->running=true;
+
+	return 0;
+}
+
+/**
+	\brief Initialize a [struct fanoutparams](\ref fanoutparams) with the default settings
+
+	By default, one worker per online CPU is created, each pinned to a different core, and the frames are distributed by flow hash.
+
+	\param[out]	params 	Pointer to the [struct fanoutparams](\ref fanoutparams) to be initialized.
+
+	\return None.
+**/
+void fanoutParamsDefault(struct fanoutparams *params) {
+	long ncpus=sysconf(_SC_NPROCESSORS_ONLN);
+
+	params->nworkers=ncpus>0 ? ncpus : 1;
+	params->mode=FANOUT_MODE_HASH;
+	params->bpf_fd=-1;
+	params->group_id=0;
+	params->protocol=ETH_P_ALL;
+	params->first_cpu=0;
+	params->defrag=false;
+	params->rollover=false;
+	params->batch_max=FANOUT_DEFAULT_BATCH_MAX;
+	params->ringparams=NULL;
+}
+
+/**
+	\brief Open a fanout reception engine on an interface
+
+	This function creates, for each worker, an *AF_PACKET* socket bound to the interface with index _ifindex_ (which can be obtained,
+	for instance, with wlanLookup()), sets up its RX ring and adds it to the _PACKET_FANOUT_ group. The worker threads are not started:
+	fanoutStartFrames() or fanoutStartBatch() should be called after this function.
+
+	The sockets join the group in the order of the worker indices: with [FANOUT_MODE_CPU](\ref fanoutmode_t) and the default settings,
+	the frames received by each CPU are thus passed to the worker pinned to the same CPU.
+
+	\param[out]	engine 		Pointer to the [struct fanoutengine](\ref fanoutengine) to be initialized.
+	\param[in]	ifindex 	Interface index.
+	\param[in]	params 		Engine settings (it can be NULL to use the default ones, see fanoutParamsDefault()).
+
+	\return **0** if the engine was properly opened, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FANOUT_PARAMS* -> invalid number of workers, batch size or eBPF program
+	- *ERR_FANOUT_ALLOC* -> unable to allocate the memory for the workers
+	- *ERR_FANOUT_SOCKET* -> unable to create or bind a worker socket (_errno_ is set by _socket()_ or _bind()_)
+	- *ERR_FANOUT_RING* -> unable to set up the RX ring of a worker
+	- *ERR_FANOUT_JOIN* -> unable to join the _PACKET_FANOUT_ group, or to attach the eBPF program (_errno_ is set by _setsockopt()_)
+**/
+rawsockerr_t fanoutOpen(struct fanoutengine *engine, int ifindex, struct fanoutparams *params) {
+	struct fanoutparams defparams;
+	struct sockaddr_ll addrll;
+	uint16_t group_id;
+	long ncpus;
+	int fanout_type, fanout_arg;
+	unsigned int i;
+	rawsockerr_t err;
+
+	if(params==NULL) {
+		fanoutParamsDefault(&defparams);
+		params=&defparams;
+	}
+
+	memset(engine,0,sizeof(struct fanoutengine));
+
+	if(params->nworkers==0 || params->batch_max==0 || (params->mode==FANOUT_MODE_EBPF && params->bpf_fd<0)) {
+		return ERR_FANOUT_PARAMS;
+	}
+
+	switch(params->mode) {
+		case FANOUT_MODE_CPU:
+			fanout_type=PACKET_FANOUT_CPU;
+		break;
+
+		case FANOUT_MODE_LB:
+			fanout_type=PACKET_FANOUT_LB;
+		break;
+
+		case FANOUT_MODE_EBPF:
+			fanout_type=PACKET_FANOUT_EBPF;
+		break;
+
+		default:
+			fanout_type=PACKET_FANOUT_HASH;
+	}
+
+	if(params->defrag) {
+		fanout_type|=PACKET_FANOUT_FLAG_DEFRAG;
+	}
+
+	if(params->rollover) {
+		fanout_type|=PACKET_FANOUT_FLAG_ROLLOVER;
+	}
+
+	group_id=params->group_id!=0 ? params->group_id : (uint16_t) getpid();
+	fanout_arg=group_id | (fanout_type << 16);
+
+	ncpus=sysconf(_SC_NPROCESSORS_ONLN);
+	if(ncpus<=0) {
+		ncpus=1;
+	}
+
+	engine->workers=calloc(params->nworkers,sizeof(struct fanoutworker));
+	if(engine->workers==NULL) {
+		return ERR_FANOUT_ALLOC;
+	}
+
+	engine->ifindex=ifindex;
+	engine->batch_max=params->batch_max;
+
+	memset(&addrll,0,sizeof(addrll));
+	addrll.sll_family=AF_PACKET;
+	addrll.sll_protocol=htons(params->protocol);
+	addrll.sll_ifindex=ifindex;
+
+	for(i=0;i<params->nworkers;i++) {
+		struct fanoutworker *worker=&engine->workers[i];
+
+		worker->engine=engine;
+		worker->index=i;
+		worker->cpu=params->first_cpu>=0 ? (params->first_cpu+i)%ncpus : -1;
+
+		// Increase the number of workers first, so that fanoutClose() can free all the resources allocated so far
+		engine->nworkers++;
+
+		worker->frames=malloc(params->batch_max*sizeof(struct rxframe));
+		if(worker->frames==NULL) {
+			worker->descriptor=-1;
+			err=ERR_FANOUT_ALLOC;
+			goto error;
+		}
+
+		worker->descriptor=socket(AF_PACKET,SOCK_RAW,htons(params->protocol));
+		if(worker->descriptor<0 || bind(worker->descriptor,(struct sockaddr *) &addrll,sizeof(addrll))<0) {
+			err=ERR_FANOUT_SOCKET;
+			goto error;
+		}
+
+		if(rxringOpen(&worker->ring,worker->descriptor,params->ringparams)!=0) {
+			err=ERR_FANOUT_RING;
+			goto error;
+		}
+
+		if(setsockopt(worker->descriptor,SOL_PACKET,PACKET_FANOUT,&fanout_arg,sizeof(fanout_arg))<0) {
+			err=ERR_FANOUT_JOIN;
+			goto error;
+		}
+
+		// The eBPF program is shared by the whole group: it is enough to attach it through the first socket
+		if(i==0 && params->mode==FANOUT_MODE_EBPF &&
+			setsockopt(worker->descriptor,SOL_PACKET,PACKET_FANOUT_DATA,&params->bpf_fd,sizeof(params->bpf_fd))<0) {
+			err=ERR_FANOUT_JOIN;
+			goto error;
+		}
+	}
+
+	return 0;
+
+error:
+	{
+		int saved_errno=errno;
+		fanoutClose(engine);
+		errno=saved_errno;
+	}
+
+	return err;
+}
+
+/**
+	\brief Start the worker threads of a fanout engine, with a per-frame callback
+
+	This function starts one thread per worker: each thread calls _callback_ for every frame received through its socket,
+	until fanoutStop() is called.
+
+	\param[in,out]	engine 		Pointer to a [struct fanoutengine](\ref fanoutengine), opened with fanoutOpen().
+	\param[in]		callback 	Callback to be called for each received frame.
+	\param[in]		arg 		User pointer passed to _callback_.
+
+	\return **0** if all the threads were started, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FANOUT_PARAMS* -> NULL callback, or the threads were already started
+	- *ERR_FANOUT_THREAD* -> unable to create a worker thread (_errno_ is set to the _pthread_create()_ error); no thread is left running
+**/
+rawsockerr_t fanoutStartFrames(struct fanoutengine *engine, fanoutframecb_t callback, void *arg) {
+	if(callback==NULL) {
+		return ERR_FANOUT_PARAMS;
+	}
+
+	engine->framecb=callback;
+	engine->batchcb=NULL;
+	engine->arg=arg;
+
+	return fanoutStart(engine);
+}
+
+/**
+	\brief Start the worker threads of a fanout engine, with a per-batch callback
+
+	This function works like fanoutStartFrames(), but _callback_ is called with batches of up to _batch_max_ frames
+	(see [struct fanoutparams](\ref fanoutparams)), taken from the same block of the RX ring of the worker, without any copy.
+
+	\param[in,out]	engine 		Pointer to a [struct fanoutengine](\ref fanoutengine), opened with fanoutOpen().
+	\param[in]		callback 	Callback to be called for each batch of received frames.
+	\param[in]		arg 		User pointer passed to _callback_.
+
+	\return **0** if all the threads were started, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see fanoutStartFrames()).
+**/
+rawsockerr_t fanoutStartBatch(struct fanoutengine *engine, fanoutbatchcb_t callback, void *arg) {
+	if(callback==NULL) {
+		return ERR_FANOUT_PARAMS;
+	}
+
+	engine->framecb=NULL;
+	engine->batchcb=callback;
+	engine->arg=arg;
+
+	return fanoutStart(engine);
+}
+
+/**
+	\brief Stop the worker threads of a fanout engine
+
+	This function asks all the worker threads to terminate, and waits for them. Each thread terminates after the callback which is currently
+	running (if any) returns, or, at the latest, after [FANOUT_POLL_TIMEOUT](\ref FANOUT_POLL_TIMEOUT) milliseconds.
+	The engine can then be started again, or closed with fanoutClose().
+
+	\param[in,out]	engine 	Pointer to a [struct fanoutengine](\ref fanoutengine), opened with fanoutOpen().
+
+	\return None.
+**/
+void fanoutStop(struct fanoutengine *engine) {
+	unsigned int i;
+
+	if(!engine->running) {
+		return;
+	}
+
+	__atomic_store_n(&engine->stop,1,__ATOMIC_RELEASE);
+
+	for(i=0;i<engine->nworkers;i++) {
+		if(engine->workers[i].started) {
+			pthread_join(engine->workers[i].thread,NULL);
+			engine->workers[i].started=false;
+		}
+	}
+
+	engine->running=false;
+}
+
+/**
+	\brief Close a fanout engine
+
+	This function stops the worker threads (if they are running), and closes the sockets and the RX rings of all the workers.
+
+	\param[in]	engine 	Pointer to the [struct fanoutengine](\ref fanoutengine) to be closed.
+
+	\return None.
+**/
+void fanoutClose(struct fanoutengine *engine) {
+	unsigned int i;
+
+	fanoutStop(engine);
+
+	for(i=0;i<engine->nworkers;i++) {
+		rxringClose(&engine->workers[i].ring);
+
+		if(engine->workers[i].descriptor>=0) {
+			close(engine->workers[i].descriptor);
+		}
+
+		free(engine->workers[i].frames);
+	}
+
+	free(engine->workers);
+	engine->workers=NULL;
+	engine->nworkers=0;
+}
+
+/**
+	\brief Get the number of workers of a fanout engine
+
+	\param[in]	engine 	Pointer to a [struct fanoutengine](\ref fanoutengine), opened with fanoutOpen().
+
+	\return The number of workers.
+**/
+unsigned int fanoutWorkersNr(struct fanoutengine *engine) {
+	return engine->nworkers;
+}
+
+/**
+	\brief Get the statistics of a fanout engine
+
+	This function can be called also while the worker threads are running.
+
+	\param[in]	engine 		Pointer to a [struct fanoutengine](\ref fanoutengine), opened with fanoutOpen().
+	\param[out]	received 	If not NULL, the total number of frames passed to the callbacks, since the engine was opened, is stored here.
+	\param[out]	drops 		If not NULL, the total number of frames dropped by the kernel, since the last call to this function, is stored here.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RXRING_SOCKOPT* -> unable to read the RX ring statistics of a worker (_errno_ is set by _getsockopt()_)
+**/
+rawsockerr_t fanoutStats(struct fanoutengine *engine, unsigned long long *received, unsigned int *drops) {
+	unsigned long long total_received=0;
+	unsigned int total_drops=0, worker_drops;
+	unsigned int i;
+	rawsockerr_t err=0;
+
+	for(i=0;i<engine->nworkers;i++) {
+		total_received+=__atomic_load_n(&engine->workers[i].received,__ATOMIC_RELAXED);
+
+		if(drops!=NULL) {
+			if(rxringStats(&engine->workers[i].ring,NULL,&worker_drops,NULL)!=0) {
+				err=ERR_RXRING_SOCKOPT;
+			} else {
+				total_drops+=worker_drops;
+			}
+		}
+	}
+
+	if(received!=NULL) {
+		*received=total_received;
+	}
+
+	if(drops!=NULL) {
+		*drops=total_drops;
+	}
+
+	return err;
+}
@@ -0,0 +1,149 @@
+/** \file
+	PACKET_FANOUT multi-threaded reception support for the Rawsock library.
+
+	This file represents an optional module of the Rawsock library, allowing to spread the reception of the frames arriving on an interface
+	over several worker threads, each one pinned to a different core.
+
+	Each worker owns an *AF_PACKET* socket, with its own _TPACKET_V3_ RX ring (see rawsock_ring.h); all the sockets join the same
+	_PACKET_FANOUT_ group, and the kernel distributes the received frames among them, depending on the selected [mode](\ref fanoutmode_t):
+	by flow hash (all the frames of the same flow are always received by the same worker), by the CPU which received the frame,
+	or through an eBPF program provided by the application.
+
+	Every received frame is passed, in place, to a user callback, which is called by the worker thread which received it, either for each frame
+	([fanoutframecb_t](\ref fanoutframecb_t)) or for each batch of frames ([fanoutbatchcb_t](\ref fanoutbatchcb_t)).
+	The callbacks of different workers run concurrently: any state shared among them should be protected by the application
+	(or, better, kept per worker, using the worker index passed to the callback).
+
+	__Example of use:__
+
+		void frameCallback(struct rxframe *frame, unsigned int worker, void *arg) {
+			payload=UDPgetpacketpointers(frame->data,&etherHeader,&IPheader,&udpHeader);
+			...
+		}
+
+		struct fanoutparams params;
+		struct fanoutengine engine;
+
+		wlanLookup(devname,&ifindex,mac,&srcIP,0,WLANLOOKUP_WLAN);
+
+		fanoutParamsDefault(&params);
+		params.nworkers=4;
+		fanoutOpen(&engine,ifindex,&params);
+
+		fanoutStartFrames(&engine,frameCallback,NULL);
+		...
+		fanoutStop(&engine);
+		fanoutClose(&engine);
+
+	\warning This module requires the _pthread_ library: rawsock_fanout.c should be compiled only if this module is actually used,
+	linking the final program with `-pthread`.
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_FANOUT_H_INCLUDED
+#define RAWSOCK_FANOUT_H_INCLUDED
+
+#include "rawsock.h"
+#include "rawsock_ring.h"
+#include <pthread.h>
+
+#define FANOUT_DEFAULT_BATCH_MAX 64 /**< __Fanout default setting__: maximum number of frames passed to a [fanoutbatchcb_t](\ref fanoutbatchcb_t) callback at once. */
+#define FANOUT_POLL_TIMEOUT 100 /**< Maximum time, in _milliseconds_, after which a worker thread notices that fanoutStop() was called, when no frame is received. */
+
+/**
+	\brief Fanout mode
+
+	Policy used by the kernel to choose the worker which receives each frame (see [struct fanoutparams](\ref fanoutparams)).
+**/
+typedef enum {
+	FANOUT_MODE_HASH,	/**< The worker is chosen through the flow hash of the frame (_PACKET_FANOUT_HASH_): all the frames of a flow are received by the same worker. */
+	FANOUT_MODE_CPU,	/**< The worker is chosen depending on the CPU which received the frame (_PACKET_FANOUT_CPU_): worker _i_ receives the frames of the CPUs whose index, modulo the number of workers, is _i_. */
+	FANOUT_MODE_LB,		/**< The frames are distributed in a round-robin fashion (_PACKET_FANOUT_LB_), without preserving the flow ordering. */
+	FANOUT_MODE_EBPF	/**< The worker is chosen by an eBPF socket filter program, loaded by the application, returning the worker index (_PACKET_FANOUT_EBPF_). */
+} fanoutmode_t;
+
+/**
+	\brief Fanout engine settings
+
+	Structure containing the settings of a [struct fanoutengine](\ref fanoutengine), to be passed to fanoutOpen().
+	It can be initialized with the default values through fanoutParamsDefault().
+**/
+struct fanoutparams {
+	unsigned int nworkers; /**< Number of worker threads (default: number of online CPUs). */
+	fanoutmode_t mode; /**< Fanout mode (default: [FANOUT_MODE_HASH](\ref fanoutmode_t)). */
+	int bpf_fd; /**< Descriptor of the eBPF program (of type _BPF_PROG_TYPE_SOCKET_FILTER_) used with [FANOUT_MODE_EBPF](\ref fanoutmode_t) (default: **-1**). */
+	uint16_t group_id; /**< _PACKET_FANOUT_ group identifier (default: **0**, meaning that it is derived from the process ID). */
+	uint16_t protocol; /**< Ethertype of the frames to be received, in host byte order (default: _ETH_P_ALL_). */
+	int first_cpu; /**< Core to which worker 0 is pinned: worker _i_ is pinned to core (_first_cpu_+_i_) modulo the number of online CPUs (default: **0**; **-1** to disable the pinning). */
+	bool defrag; /**< _true_ to ask the kernel to reassemble the fragmented IP packets before distributing them (default: _false_). */
+	bool rollover; /**< _true_ to pass a frame to another worker when the ring of the selected one is full (default: _false_). */
+	unsigned int batch_max; /**< Maximum number of frames passed to each call of a [fanoutbatchcb_t](\ref fanoutbatchcb_t) callback (default: [FANOUT_DEFAULT_BATCH_MAX](\ref FANOUT_DEFAULT_BATCH_MAX)). */
+	struct rxringparams *ringparams; /**< Settings of the RX ring of each worker (default: NULL, to use the default RX ring settings). */
+};
+
+/**
+	\brief Per-frame fanout callback
+
+	Callback called by a worker thread for each received frame. _frame_ remains valid only until the callback returns.
+	_worker_ is the index of the worker which received the frame (from **0** to _nworkers_-1), and _arg_ is the user pointer passed to fanoutStartFrames().
+**/
+typedef void (*fanoutframecb_t)(struct rxframe *frame, unsigned int worker, void *arg);
+
+/**
+	\brief Per-batch fanout callback
+
+	Callback called by a worker thread for each batch of _n_ received frames (_n_ is always at least **1**). The frames remain valid only until the callback returns.
+	_worker_ is the index of the worker which received the frames (from **0** to _nworkers_-1), and _arg_ is the user pointer passed to fanoutStartBatch().
+**/
+typedef void (*fanoutbatchcb_t)(struct rxframe *frames, unsigned int n, unsigned int worker, void *arg);
+
+struct fanoutengine;
+
+/**
+	\brief Fanout worker
+
+	Structure describing a worker of a [struct fanoutengine](\ref fanoutengine). Its fields should not be modified directly by the user.
+**/
+struct fanoutworker {
+	struct fanoutengine *engine; /**< Engine the worker belongs to. */
+	unsigned int index; /**< Worker index. */
+	int descriptor; /**< _AF_PACKET_ socket of the worker. */
+	int cpu; /**< Core the worker is pinned to (**-1** if it is not pinned). */
+	struct rxring ring; /**< RX ring of the worker. */
+	struct rxframe *frames; /**< Array of _batch_max_ frames, passed to the callback. */
+	pthread_t thread; /**< Worker thread. */
+	bool started; /**< _true_ if the worker thread is running. */
+	unsigned long long received; /**< Number of frames passed to the callback (it can be safely read after fanoutStop()). */
+	rawsockerr_t err; /**< Error which caused the worker thread to terminate (**0** if none). */
+};
+
+/**
+	\brief Fanout engine descriptor
+
+	Structure describing a fanout reception engine, opened with fanoutOpen(). Its fields should not be modified directly by the user.
+**/
+struct fanoutengine {
+	int ifindex; /**< Index of the interface the frames are received from. */
+	unsigned int nworkers; /**< Number of workers. */
+	struct fanoutworker *workers; /**< Array of _nworkers_ workers. */
+	unsigned int batch_max; /**< Maximum number of frames passed to the batch callback. */
+	fanoutframecb_t framecb; /**< Per-frame callback (or NULL). */
+	fanoutbatchcb_t batchcb; /**< Per-batch callback (or NULL). */
+	void *arg; /**< User pointer passed to the callbacks. */
+	int stop; /**< Set to **1** to ask the worker threads to terminate. */
+	bool running; /**< _true_ if the worker threads were started. */
+};
+
+void fanoutParamsDefault(struct fanoutparams *params);
+rawsockerr_t fanoutOpen(struct fanoutengine *engine, int ifindex, struct fanoutparams *params);
+rawsockerr_t fanoutStartFrames(struct fanoutengine *engine, fanoutframecb_t callback, void *arg);
+rawsockerr_t fanoutStartBatch(struct fanoutengine *engine, fanoutbatchcb_t callback, void *arg);
+void fanoutStop(struct fanoutengine *engine);
+void fanoutClose(struct fanoutengine *engine);
+unsigned int fanoutWorkersNr(struct fanoutengine *engine);
+rawsockerr_t fanoutStats(struct fanoutengine *engine, unsigned long long *received, unsigned int *drops);
+#endif
@@ -0,0 +1,230 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_filter.h"
+#include "rawsock_lamp.h"
+#include <stddef.h>
+#include <sys/socket.h>
+
+#define FILTER_JUMP_DROP 0xFF // Placeholder for the jump offsets to the final "drop" instruction, patched by filterCompile()
+
+#define ETH_HDR_LEN sizeof(struct ether_header)
+#define IP_FRAG_OFFSET_MASK 0x1FFF
+
+// Append a classic BPF instruction to 'prog'
+static inline void filterEmit(struct filterprog *prog, uint16_t code, uint8_t jt, uint8_t jf, uint32_t k) {
+	struct sock_filter insn=BPF_JUMP(code,k,jt,jf);
+
+	prog->code[prog->len++]=insn;
+}
+
+/**
+	\brief Initialize a [struct filterspec](\ref filterspec)
+
+	This function initializes a filter description which accepts any frame. It can be then restricted with filterMatchEthertype(),
+	filterMatchUDP() and filterMatchLamp().
+
+	\param[out]	spec 	Pointer to the [struct filterspec](\ref filterspec) to be initialized.
+
+	\return None.
+**/
+void filterSpecInit(struct filterspec *spec) {
+	spec->match=0;
+	spec->ethertype=0;
+	spec->udp_dport=0;
+	spec->lamp_id=0;
+}
+
+/**
+	\brief Accept only the frames with a given EtherType
+
+	\param[in,out]	spec 		Pointer to a [struct filterspec](\ref filterspec), initialized with filterSpecInit().
+	\param[in]		ethertype 	EtherType, in host byte order (for instance _ETHERTYPE_IP_, [ETHERTYPE_GEONET](\ref ETHERTYPE_GEONET) or [ETHERTYPE_LAMP](\ref ETHERTYPE_LAMP)).
+
+	\return None.
+**/
+void filterMatchEthertype(struct filterspec *spec, uint16_t ethertype) {
+	spec->match|=FILTER_MATCH_ETHERTYPE;
+	spec->ethertype=ethertype;
+}
+
+/**
+	\brief Accept only the IPv4 UDP datagrams, optionally with a given destination port
+
+	\param[in,out]	spec 	Pointer to a [struct filterspec](\ref filterspec), initialized with filterSpecInit().
+	\param[in]		dport 	UDP destination port, in host byte order (**0** to accept any port).
+
+	\return None.
+**/
+void filterMatchUDP(struct filterspec *spec, uint16_t dport) {
+	spec->match|=FILTER_MATCH_UDP;
+
+	if(dport!=0) {
+		spec->match|=FILTER_MATCH_UDP_DPORT;
+		spec->udp_dport=dport;
+	}
+}
+
+/**
+	\brief Accept only the LaMP packets, optionally belonging to a given session
+
+	LaMP packets are looked for inside IPv4 UDP datagrams, if filterMatchUDP() was called, or directly after the Ethernet header,
+	if filterMatchEthertype() was called with [ETHERTYPE_LAMP](\ref ETHERTYPE_LAMP). One of the two functions should always be called too.
+
+	\param[in,out]	spec 		Pointer to a [struct filterspec](\ref filterspec), initialized with filterSpecInit().
+	\param[in]		match_id 	_true_ to accept only the LaMP packets with identifier _id_, _false_ to accept any LaMP packet.
+	\param[in]		id 			LaMP session identifier, in host byte order (ignored if _match_id_ is _false_).
+
+	\return None.
+**/
+void filterMatchLamp(struct filterspec *spec, bool match_id, uint16_t id) {
+	spec->match|=FILTER_MATCH_LAMP;
+
+	if(match_id) {
+		spec->match|=FILTER_MATCH_LAMP_ID;
+		spec->lamp_id=id;
+	}
+}
+
+/**
+	\brief Build a classic BPF program from a filter description
+
+	This function translates a [struct filterspec](\ref filterspec) into a classic BPF program, which accepts (entirely) only the frames
+	matching all the conditions of the description, and drops any other frame.
+
+	As IPv4 options are taken into account when looking for the UDP header, the filter works with any IPv4 header length.
+	Non-first IPv4 fragments are always dropped when matching UDP datagrams, as they do not contain the UDP header.
+
+	\param[in]	spec 	Pointer to the [struct filterspec](\ref filterspec) describing the frames to be accepted.
+	\param[out]	prog 	Pointer to the [struct filterprog](\ref filterprog) in which the program is stored.
+
+	\return **0** if the program was properly built, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FILTER_PARAMS* -> inconsistent description (UDP datagrams requested with an EtherType other than _ETHERTYPE_IP_, or LaMP packets requested
+	without specifying whether they are encapsulated in UDP or directly in Ethernet frames)
+**/
+rawsockerr_t filterCompile(struct filterspec *spec, struct filterprog *prog) {
+	unsigned int match=spec->match;
+	uint16_t ethertype=spec->ethertype;
+	uint16_t lamp_mode=BPF_ABS; // Addressing mode used to read the LaMP header (absolute, or relative to the UDP header, through the X register)
+	uint32_t lamp_offset=ETH_HDR_LEN;
+	unsigned short i;
+
+	if(match & FILTER_MATCH_UDP_DPORT) {
+		match|=FILTER_MATCH_UDP;
+	}
+
+	if(match & FILTER_MATCH_LAMP_ID) {
+		match|=FILTER_MATCH_LAMP;
+	}
+
+	if(match & FILTER_MATCH_UDP) {
+		if((match & FILTER_MATCH_ETHERTYPE) && ethertype!=ETHERTYPE_IP) {
+			return ERR_FILTER_PARAMS;
+		}
+
+		match|=FILTER_MATCH_ETHERTYPE;
+		ethertype=ETHERTYPE_IP;
+	} else if((match & FILTER_MATCH_LAMP) && (!(match & FILTER_MATCH_ETHERTYPE) || ethertype!=ETHERTYPE_LAMP)) {
+		return ERR_FILTER_PARAMS;
+	}
+
+	prog->len=0;
+
+	if(match & FILTER_MATCH_ETHERTYPE) {
+		filterEmit(prog,BPF_LD | BPF_H | BPF_ABS,0,0,offsetof(struct ether_header,ether_type));
+		filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,ethertype);
+	}
+
+	if(match & FILTER_MATCH_UDP) {
+		// IPv4 protocol and fragment offset
+		filterEmit(prog,BPF_LD | BPF_B | BPF_ABS,0,0,ETH_HDR_LEN+offsetof(struct iphdr,protocol));
+		filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,IPPROTO_UDP);
+		filterEmit(prog,BPF_LD | BPF_H | BPF_ABS,0,0,ETH_HDR_LEN+offsetof(struct iphdr,frag_off));
+		filterEmit(prog,BPF_JMP | BPF_JSET | BPF_K,FILTER_JUMP_DROP,0,IP_FRAG_OFFSET_MASK);
+
+		// X = IPv4 header length
+		filterEmit(prog,BPF_LDX | BPF_B | BPF_MSH,0,0,ETH_HDR_LEN);
+
+		if(match & FILTER_MATCH_UDP_DPORT) {
+			filterEmit(prog,BPF_LD | BPF_H | BPF_IND,0,0,ETH_HDR_LEN+offsetof(struct udphdr,dest));
+			filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,spec->udp_dport);
+		}
+
+		lamp_mode=BPF_IND;
+		lamp_offset=ETH_HDR_LEN+sizeof(struct udphdr);
+	}
+
+	if(match & FILTER_MATCH_LAMP) {
+		filterEmit(prog,BPF_LD | BPF_B | lamp_mode,0,0,lamp_offset+offsetof(struct lamphdr,reserved));
+		filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,PROTO_LAMP);
+		filterEmit(prog,BPF_LD | BPF_B | lamp_mode,0,0,lamp_offset+offsetof(struct lamphdr,ctrl));
+		filterEmit(prog,BPF_ALU | BPF_AND | BPF_K,0,0,0xF0);
+		filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,PROTO_LAMP_CTRL_MASK);
+
+		if(match & FILTER_MATCH_LAMP_ID) {
+			filterEmit(prog,BPF_LD | BPF_H | lamp_mode,0,0,lamp_offset+offsetof(struct lamphdr,id));
+			filterEmit(prog,BPF_JMP | BPF_JEQ | BPF_K,0,FILTER_JUMP_DROP,spec->lamp_id);
+		}
+	}
+
+	// Accept the whole frame
+	filterEmit(prog,BPF_RET | BPF_K,0,0,0xFFFFFFFF);
+
+	// Drop the frame (all the failed checks jump here)
+	filterEmit(prog,BPF_RET | BPF_K,0,0,0);
+
+	for(i=0;i<prog->len;i++) {
+		if(BPF_CLASS(prog->code[i].code)==BPF_JMP) {
+			if(prog->code[i].jt==FILTER_JUMP_DROP) {
+				prog->code[i].jt=prog->len-1-(i+1);
+			}
+			if(prog->code[i].jf==FILTER_JUMP_DROP) {
+				prog->code[i].jf=prog->len-1-(i+1);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+	\brief Attach a classic BPF program to a socket
+
+	This function attaches a program built by filterCompile() to a socket, with _SO_ATTACH_FILTER_. Any filter previously attached
+	to the same socket is replaced.
+
+	\param[in]	descriptor 	Socket descriptor (it can be any raw socket, including the ones with a PACKET_RX_RING, or a fanout engine socket).
+	\param[in]	prog 		Pointer to the [struct filterprog](\ref filterprog) to be attached.
+
+	\return **0** if the filter was attached, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FILTER_ATTACH* -> unable to attach or detach the filter (_errno_ is set by _setsockopt()_)
+**/
+rawsockerr_t filterAttach(int descriptor, struct filterprog *prog) {
+	struct sock_fprog fprog;
+
+	fprog.len=prog->len;
+	fprog.filter=prog->code;
+
+	if(setsockopt(descriptor,SOL_SOCKET,SO_ATTACH_FILTER,&fprog,sizeof(fprog))<0) {
+		return ERR_FILTER_ATTACH;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Detach the classic BPF program attached to a socket
+
+	\param[in]	descriptor 	Socket descriptor.
+
+	\return **0** if the filter was detached, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see filterAttach()).
+**/
+rawsockerr_t filterDetach(int descriptor) {
+	int dummy=0;
+
+	if(setsockopt(descriptor,SOL_SOCKET,SO_DETACH_FILTER,&dummy,sizeof(dummy))<0) {
+		return ERR_FILTER_ATTACH;
+	}
+
+	return 0;
+}
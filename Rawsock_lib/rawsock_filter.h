@@ -0,0 +1,88 @@
+/** \file
+	In-kernel frame filtering (classic BPF) support for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to build a classic BPF program from a simple description
+	of the frames of interest (EtherType, IPv4 UDP destination port, LaMP reserved field and session identifier), and to attach it to a raw socket
+	with _SO_ATTACH_FILTER_.
+
+	The kernel runs the program on every frame, before copying it to the socket (or to its RX ring): all the frames not matching the description are dropped
+	inside the kernel, without being passed to the application. This is particularly useful on busy interfaces shared with other applications,
+	where a socket bound with _ETH_P_ALL_ would otherwise receive every frame.
+
+	__Example of use (IPv4 UDP datagrams with destination port 46000, carrying LaMP packets with id 10):__
+
+		struct filterspec spec;
+		struct filterprog prog;
+
+		filterSpecInit(&spec);
+		filterMatchUDP(&spec,46000);
+		filterMatchLamp(&spec,true,10);
+
+		if(filterCompile(&spec,&prog)==0) {
+			filterAttach(sFd,&prog);
+		}
+
+	__Example of use (frames with EtherType ETHERTYPE_GEONET):__
+
+		filterSpecInit(&spec);
+		filterMatchEthertype(&spec,ETHERTYPE_GEONET);
+
+	The frames which were already queued on the socket before filterAttach() is called are not filtered: in order to avoid receiving them,
+	the socket can be created with protocol **0** (which does not receive any frame), and bound to the desired protocol (e.g. _ETH_P_ALL_) only
+	after attaching the filter.
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_FILTER_H_INCLUDED
+#define RAWSOCK_FILTER_H_INCLUDED
+
+#include "rawsock.h"
+#include <linux/filter.h>
+
+#define FILTER_MAX_LEN 32 /**< Maximum number of instructions of a classic BPF program built by filterCompile(). */
+
+// Filter match flags (to be combined inside the 'match' field of struct filterspec)
+#define FILTER_MATCH_ETHERTYPE 0x01 /**< __Filter match flag__: match the EtherType of the frame. */
+#define FILTER_MATCH_UDP 0x02 /**< __Filter match flag__: match unfragmented IPv4 UDP datagrams (or the first fragment of a fragmented datagram). */
+#define FILTER_MATCH_UDP_DPORT 0x04 /**< __Filter match flag__: match the UDP destination port (it implies [FILTER_MATCH_UDP](\ref FILTER_MATCH_UDP)). */
+#define FILTER_MATCH_LAMP 0x08 /**< __Filter match flag__: match LaMP packets, i.e. check the LaMP reserved and control fields. */
+#define FILTER_MATCH_LAMP_ID 0x10 /**< __Filter match flag__: match the LaMP session identifier (it implies [FILTER_MATCH_LAMP](\ref FILTER_MATCH_LAMP)). */
+
+/**
+	\brief Frame filter description
+
+	Structure describing the frames which should be accepted by a filter, to be compiled with filterCompile().
+	It should be initialized with filterSpecInit() (which accepts any frame), and then restricted with the filterMatch*() functions.
+
+	LaMP packets are looked for inside IPv4 UDP datagrams, if [FILTER_MATCH_UDP](\ref FILTER_MATCH_UDP) is set, or directly after the Ethernet header,
+	if the EtherType is matched against [ETHERTYPE_LAMP](\ref ETHERTYPE_LAMP).
+**/
+struct filterspec {
+	unsigned int match; /**< Combination of _FILTER_MATCH_*_ flags. */
+	uint16_t ethertype; /**< EtherType, in host byte order. */
+	uint16_t udp_dport; /**< UDP destination port, in host byte order. */
+	uint16_t lamp_id; /**< LaMP session identifier, in host byte order. */
+};
+
+/**
+	\brief Compiled frame filter
+
+	Structure containing a classic BPF program, built by filterCompile() and ready to be attached to a socket with filterAttach().
+**/
+struct filterprog {
+	struct sock_filter code[FILTER_MAX_LEN]; /**< BPF instructions. */
+	unsigned short len; /**< Number of instructions. */
+};
+
+void filterSpecInit(struct filterspec *spec);
+void filterMatchEthertype(struct filterspec *spec, uint16_t ethertype);
+void filterMatchUDP(struct filterspec *spec, uint16_t dport); // 'dport' can be 0 to accept any UDP datagram
+void filterMatchLamp(struct filterspec *spec, bool match_id, uint16_t id);
+rawsockerr_t filterCompile(struct filterspec *spec, struct filterprog *prog);
+rawsockerr_t filterAttach(int descriptor, struct filterprog *prog);
+rawsockerr_t filterDetach(int descriptor);
+#endif
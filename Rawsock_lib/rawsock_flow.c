@@ -0,0 +1,166 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_flow.h"
+#include "rawsock_csum.h"
+#include <string.h>
+#include <arpa/inet.h>
+
+#define FLOWTPL_IP_OFFSET (sizeof(struct ether_header))
+#define FLOWTPL_UDP_OFFSET (sizeof(struct ether_header)+sizeof(struct iphdr))
+
+// Fold a partial sum into 16 bits, without complementing it (so that it can be added to other partial sums without any overflow)
+static inline __u32 flowtemplateFoldSum(__u32 sum) {
+	return (__u16) ~csum_fold(sum);
+}
+
+// Copy the headers of 'tpl' in front of a payload of 'payloadsize' bytes, whose partial sum is 'payloadsum', and patch all the variable fields
+static inline size_t flowtemplateWrite(struct flowtemplate *tpl, byte_t *packet, size_t payloadsize, __u32 payloadsum, unsigned short id) {
+	struct iphdr *IPhead=(struct iphdr *) (packet+FLOWTPL_IP_OFFSET);
+	struct udphdr *UDPhead=(struct udphdr *) (packet+FLOWTPL_UDP_OFFSET);
+	__be16 totlen=htons(sizeof(struct iphdr)+sizeof(struct udphdr)+payloadsize);
+	__be16 udplen=htons(sizeof(struct udphdr)+payloadsize);
+	__be16 ipid=htons(id);
+	__sum16 udpcheck;
+
+	memcpy(packet,tpl->prefix,FLOWTPL_PREFIX_SIZE);
+
+	IPhead->tot_len=totlen;
+	IPhead->id=ipid;
+	IPhead->check=csum_fold(tpl->ipsum+totlen+ipid);
+
+	// The UDP length is covered twice by the checksum: once inside the header and once inside the pseudo-header
+	udpcheck=csum_fold(flowtemplateFoldSum(payloadsum)+tpl->udpsum+udplen+udplen);
+	UDPhead->len=udplen;
+	// A computed checksum equal to 0 is transmitted as all ones, as 0 means that no checksum was computed (RFC 768)
+	UDPhead->check=udpcheck==0 ? 0xFFFF : udpcheck;
+
+	return FLOWTPL_PREFIX_SIZE+payloadsize;
+}
+
+/**
+	\brief Initialize a [struct flowtemplate](\ref flowtemplate)
+
+	This function serializes the specified Ethernet, IPv4 and UDP headers, already filled in with etherheadPopulate(), [IP4headPopulate*()](\ref IP4headPopulate)
+	and UDPheadPopulate(), inside the template, and it computes the partial checksums of all their constant fields.
+
+	The IPv4 identification, _Total Length_ and checksum, and the UDP length and checksum, are ignored: they are set for each frame by the
+	[flowtemplateStamp*()](\ref flowtemplateStamp) functions. The headers are not modified and can be discarded after calling this function.
+
+	\param[out]	tpl 			Pointer to the [struct flowtemplate](\ref flowtemplate) to be initialized.
+	\param[in]	etherHeader 	Ethernet header (its EtherType should be _ETHERTYPE_IP_).
+	\param[in]	IPhead 			IPv4 header (without options, with _IPPROTO_UDP_ as protocol).
+	\param[in]	UDPhead 		UDP header.
+
+	\return **0** if the template was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FLOWTPL_PARAMS* -> the headers do not describe an IPv4 (without options) UDP flow over Ethernet
+**/
+rawsockerr_t flowtemplateInit(struct flowtemplate *tpl, struct ether_header *etherHeader, struct iphdr *IPhead, struct udphdr *UDPhead) {
+	struct iphdr *tplIPhead=(struct iphdr *) (tpl->prefix+FLOWTPL_IP_OFFSET);
+	struct udphdr *tplUDPhead=(struct udphdr *) (tpl->prefix+FLOWTPL_UDP_OFFSET);
+	__u32 sum;
+
+	if(ntohs(etherHeader->ether_type)!=ETHERTYPE_IP || IPhead->ihl!=BASIC_IHL || IPhead->protocol!=IPPROTO_UDP) {
+		return ERR_FLOWTPL_PARAMS;
+	}
+
+	memcpy(tpl->prefix,etherHeader,sizeof(struct ether_header));
+	memcpy(tplIPhead,IPhead,sizeof(struct iphdr));
+	memcpy(tplUDPhead,UDPhead,sizeof(struct udphdr));
+
+	tplIPhead->tot_len=0;
+	tplIPhead->id=0;
+	tplIPhead->check=0;
+	tplUDPhead->len=0;
+	tplUDPhead->check=0;
+
+	tpl->ipsum=flowtemplateFoldSum(csum_partial(tplIPhead,sizeof(struct iphdr),0));
+
+	// Pseudo-header (except for the UDP length) and UDP ports
+	sum=csum_partial(&tplIPhead->saddr,sizeof(tplIPhead->saddr),0);
+	sum=csum_partial(&tplIPhead->daddr,sizeof(tplIPhead->daddr),sum);
+	sum+=htons(IPPROTO_UDP);
+	tpl->udpsum=flowtemplateFoldSum(csum_partial(tplUDPhead,sizeof(struct udphdr),sum));
+
+	return 0;
+}
+
+/**
+	\brief Stamp a frame with the headers of a flow, in front of an already stored payload
+
+	This function writes the headers stored inside _tpl_ at the beginning of _packet_, in front of the payload, which should be
+	already stored starting from `packet+FLOWTPL_PREFIX_SIZE`. The IPv4 identification is set to _id_, and all the length and checksum fields
+	are filled in: only the payload is read, to compute the UDP checksum.
+
+	\param[in]		tpl 			Pointer to a [struct flowtemplate](\ref flowtemplate), initialized with flowtemplateInit().
+	\param[in,out]	packet 			Frame buffer, containing the payload starting from [FLOWTPL_PREFIX_SIZE](\ref FLOWTPL_PREFIX_SIZE).
+	\param[in]		payloadsize 	Size, in _bytes_, of the payload.
+	\param[in]		id 				16-bit IPv4 identification value.
+
+	\return The full frame size (headers+payload), in _bytes_.
+**/
+size_t flowtemplateStamp(struct flowtemplate *tpl, byte_t *packet, size_t payloadsize, unsigned short id) {
+	return flowtemplateWrite(tpl,packet,payloadsize,csum_partial(packet+FLOWTPL_PREFIX_SIZE,payloadsize,0),id);
+}
+
+/**
+	\brief Stamp a frame with the headers of a flow, copying the payload inside it
+
+	This function works like flowtemplateStamp(), but it also copies the payload from _data_ to `packet+FLOWTPL_PREFIX_SIZE`:
+	the payload is checksummed while it is copied (see csum_partial_copy()), so that it is read only once.
+
+	\param[in]		tpl 			Pointer to a [struct flowtemplate](\ref flowtemplate), initialized with flowtemplateInit().
+	\param[out]		packet 			Frame buffer (should be already allocated, with at least `FLOWTPL_PREFIX_SIZE+payloadsize` bytes).
+	\param[in]		data 			Buffer containing the payload.
+	\param[in]		payloadsize 	Size, in _bytes_, of the payload.
+	\param[in]		id 				16-bit IPv4 identification value.
+
+	\return The full frame size (headers+payload), in _bytes_.
+**/
+size_t flowtemplateStampCopy(struct flowtemplate *tpl, byte_t *packet, byte_t *data, size_t payloadsize, unsigned short id) {
+	return flowtemplateWrite(tpl,packet,payloadsize,csum_partial_copy(data,packet+FLOWTPL_PREFIX_SIZE,payloadsize,0),id);
+}
+
+/**
+	\brief Stamp a frame with the headers of a flow, in front of a payload whose checksum is already known
+
+	This function works like flowtemplateStamp(), but the sum of the payload, stored starting from `packet+FLOWTPL_PREFIX_SIZE`, is taken
+	from _payloadacc_: the payload is not read at all, and the cost is constant, no matter the payload size.
+
+	\param[in]		tpl 		Pointer to a [struct flowtemplate](\ref flowtemplate), initialized with flowtemplateInit().
+	\param[in,out]	packet 		Frame buffer, containing the payload starting from [FLOWTPL_PREFIX_SIZE](\ref FLOWTPL_PREFIX_SIZE).
+	\param[in]		payloadacc 	Accumulator containing the sum of the whole payload, computed with csumacc_partial() (its _len_ field is used as payload size).
+	\param[in]		id 			16-bit IPv4 identification value.
+
+	\return The full frame size (headers+payload), in _bytes_.
+**/
+size_t flowtemplateStampCsum(struct flowtemplate *tpl, byte_t *packet, const csumacc_t *payloadacc, unsigned short id) {
+	return flowtemplateWrite(tpl,packet,payloadacc->len,payloadacc->sum,id);
+}
+
+/**
+	\brief Stamp, in place, the headers of a flow in front of the payload stored inside a [struct framebuf](\ref framebuf)
+
+	This function works like flowtemplateStamp(), writing the headers inside the headroom of _fb_, directly in front of the payload
+	(stored with framebufSetPayloadSize(), framebufCopyPayload() or framebufSetPayloadCsum()). If the payload was stored with framebufCopyPayload()
+	or framebufSetPayloadCsum(), its already computed checksum is reused and the payload is not read at all.
+
+	It replaces the sequence of UDPencapsulateInPlace(), IP4EncapsulateInPlace() and etherEncapsulateInPlace().
+
+	\param[in]		tpl 	Pointer to a [struct flowtemplate](\ref flowtemplate), initialized with flowtemplateInit().
+	\param[in,out]	fb 		[struct framebuf](\ref framebuf) containing the payload, with at least [FLOWTPL_PREFIX_SIZE](\ref FLOWTPL_PREFIX_SIZE) bytes of headroom.
+	\param[in]		id 		16-bit IPv4 identification value.
+
+	\return The full frame size (headers+payload), in _bytes_, or **0** if there was not enough headroom left inside _fb_.
+**/
+size_t flowtemplateStampInPlace(struct flowtemplate *tpl, struct framebuf *fb, unsigned short id) {
+	size_t payloadsize=fb->len;
+	byte_t *hdrptr=framebufPush(fb,FLOWTPL_PREFIX_SIZE);
+
+	if(hdrptr==NULL) {
+		return 0;
+	}
+
+	return flowtemplateWrite(tpl,hdrptr,payloadsize,
+		fb->payloadcsum_valid ? fb->payloadcsum : csum_partial(hdrptr+FLOWTPL_PREFIX_SIZE,payloadsize,0),id);
+}
@@ -0,0 +1,69 @@
+/** \file
+	Precomputed header templates for persistent flows, for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, targeted at traffic generators which send many frames belonging
+	to the same flow, i.e. with the same MAC addresses, IPv4 addresses, UDP ports, TOS and TTL.
+
+	For such a flow, everything inside the 42 bytes of the Ethernet, IPv4 and UDP headers is constant, except for the IPv4 identification,
+	the IPv4 _Total Length_, the UDP length and the two checksums. Instead of filling in and byte-swapping all the header fields for each frame
+	(with etherheadPopulate(), IP4headPopulate() and UDPheadPopulate()) and then checksumming the headers again, a [struct flowtemplate](\ref flowtemplate)
+	stores the already serialized headers, together with the partial checksums of all their constant fields (IPv4 pseudo-header included).
+
+	Each frame is then _stamped_ with a single 42-byte copy, plus a few field patches: the checksums are obtained by adding the variable fields
+	to the stored partial sums, so that only the payload is actually read to compute the UDP checksum.
+
+	__Example of use:__
+
+		struct flowtemplate tpl;
+
+		// The headers are populated only once, as usual
+		etherheadPopulate(&etherHeader,srcmac,dstmac,ETHERTYPE_IP);
+		IP4headPopulateS(&ipHeader,devname,destIP,0,0,BASIC_UDP_TTL,IPPROTO_UDP,FLAG_NOFRAG_MASK,&ipaddrs);
+		UDPheadPopulate(&udpHeader,srcport,dstport);
+
+		flowtemplateInit(&tpl,&etherHeader,&ipHeader,&udpHeader);
+
+		while(...) {
+			// 'packet' is a buffer of at least FLOWTPL_PREFIX_SIZE+datasize bytes
+			packetsize=flowtemplateStampCopy(&tpl,packet,data,datasize,id++);
+
+			sendto(sFd,packet,packetsize,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll));
+		}
+
+	When the same payload is sent to many receivers, each one with its own template, the payload can be checksummed only once,
+	with a [csumacc_t](\ref csumacc_t) accumulator, and its sum passed to flowtemplateStampCsum(), which does not read the payload at all.
+
+	flowtemplateStampInPlace() can be used instead to stamp a frame inside a [struct framebuf](\ref framebuf), for instance a TX ring slot
+	obtained with txringGetFramebuf().
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_FLOW_H_INCLUDED
+#define RAWSOCK_FLOW_H_INCLUDED
+
+#include "rawsock.h"
+
+#define FLOWTPL_PREFIX_SIZE ETH_IP_UDP_HEADROOM /**< Size, in _bytes_, of the Ethernet, IPv4 (with basic IHL, i.e. no options) and UDP headers stored inside a [struct flowtemplate](\ref flowtemplate) (i.e. 42 _bytes_). */
+
+/**
+	\brief Flow template
+
+	Structure containing the serialized Ethernet, IPv4 and UDP headers of a flow, together with the partial checksums of their constant fields.
+	It should be initialized with flowtemplateInit(); its fields should not be modified directly by the user.
+**/
+struct flowtemplate {
+	byte_t prefix[FLOWTPL_PREFIX_SIZE]; /**< Serialized headers, with the IPv4 identification, _Total Length_, UDP length and checksums set to **0**. */
+	__u32 ipsum; /**< Partial sum (see csum_partial()) of the constant fields of the IPv4 header. */
+	__u32 udpsum; /**< Partial sum of the constant fields of the UDP header and of the IPv4 pseudo-header. */
+};
+
+rawsockerr_t flowtemplateInit(struct flowtemplate *tpl, struct ether_header *etherHeader, struct iphdr *IPhead, struct udphdr *UDPhead);
+size_t flowtemplateStamp(struct flowtemplate *tpl, byte_t *packet, size_t payloadsize, unsigned short id);
+size_t flowtemplateStampCopy(struct flowtemplate *tpl, byte_t *packet, byte_t *data, size_t payloadsize, unsigned short id);
+size_t flowtemplateStampCsum(struct flowtemplate *tpl, byte_t *packet, const csumacc_t *payloadacc, unsigned short id);
+size_t flowtemplateStampInPlace(struct flowtemplate *tpl, struct framebuf *fb, unsigned short id);
+#endif
@@ -0,0 +1,426 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_hist.h"
+#include <string.h>
+
+#define LATHIST_MAGIC 0x4C // First byte of a serialized histogram ('L')
+#define LATHIST_FORMAT_VERSION 2 // Version of the serialization format
+
+// Counters are only written by the thread owning the histogram, but they can be read at any time by other threads (e.g. by lathistMerge()):
+//  relaxed atomic loads and stores prevent torn values, without any locked instruction on the writer side
+#define LATHIST_LOAD(ptr) __atomic_load_n(ptr,__ATOMIC_RELAXED)
+#define LATHIST_STORE(ptr,val) __atomic_store_n(ptr,val,__ATOMIC_RELAXED)
+
+// Get the index of the bucket in which 'value' falls
+static inline unsigned int lathistIndex(uint64_t value) {
+	unsigned int shift;
+
+	if(value>LATHIST_MAX_VALUE) {
+		value=LATHIST_MAX_VALUE;
+	}
+
+	if(value<2*LATHIST_HALF_BUCKETS) {
+		return (unsigned int) value;
+	}
+
+	// The first LATHIST_SUB_BITS significant bits of the value select the sub-bucket, the position of the most significant bit selects the range
+	shift=(63-__builtin_clzll(value))-LATHIST_SUB_BITS+1;
+
+	return shift*LATHIST_HALF_BUCKETS+(unsigned int) (value >> shift);
+}
+
+// Get the highest value falling inside the bucket with index 'idx'
+static inline uint64_t lathistBucketHighest(unsigned int idx) {
+	unsigned int shift;
+
+	if(idx<2*LATHIST_HALF_BUCKETS) {
+		return idx;
+	}
+
+	shift=idx/LATHIST_HALF_BUCKETS-1;
+
+	return (((uint64_t) (idx-shift*LATHIST_HALF_BUCKETS)+1) << shift)-1;
+}
+
+// Write 'value' as a variable-length integer (7 bits per byte, least significant group first), returning the number of written bytes, or 0 if it does not fit
+static size_t lathistPutVarint(byte_t *buf, size_t size, uint64_t value) {
+	size_t i=0;
+
+	do {
+		if(i>=size) {
+			return 0;
+		}
+
+		buf[i++]=(byte_t) ((value & 0x7F) | (value>=0x80 ? 0x80 : 0x00));
+		value>>=7;
+	} while(value!=0);
+
+	return i;
+}
+
+// Read a variable-length integer, returning the number of read bytes, or 0 if it is truncated or too long
+static size_t lathistGetVarint(const byte_t *buf, size_t size, uint64_t *value) {
+	unsigned int shift=0;
+	size_t i=0;
+
+	*value=0;
+
+	while(i<size && shift<64) {
+		*value|=(uint64_t) (buf[i] & 0x7F) << shift;
+
+		if((buf[i++] & 0x80)==0) {
+			return i;
+		}
+
+		shift+=7;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Initialize (or reset) a [struct lathist](\ref lathist)
+
+	\param[out]	hist 	Pointer to the [struct lathist](\ref lathist) to be initialized.
+
+	\return None.
+**/
+void lathistInit(struct lathist *hist) {
+	memset(hist,0,sizeof(struct lathist));
+	hist->min=UINT64_MAX;
+}
+
+/**
+	\brief Record a value inside a [struct lathist](\ref lathist)
+
+	This function records a new value (e.g. a latency), in constant time. It should be called only by the thread owning the histogram.
+
+	\param[in,out]	hist 	Pointer to the [struct lathist](\ref lathist).
+	\param[in]		value 	Value to be recorded, in _ns_ (values larger than [LATHIST_MAX_VALUE](\ref LATHIST_MAX_VALUE) are recorded as [LATHIST_MAX_VALUE](\ref LATHIST_MAX_VALUE)).
+
+	\return None.
+**/
+void lathistRecord(struct lathist *hist, uint64_t value) {
+	unsigned int idx=lathistIndex(value);
+
+	if(value>LATHIST_MAX_VALUE) {
+		value=LATHIST_MAX_VALUE;
+	}
+
+	LATHIST_STORE(&hist->buckets[idx],hist->buckets[idx]+1);
+	LATHIST_STORE(&hist->count,hist->count+1);
+	LATHIST_STORE(&hist->sum,hist->sum+value);
+
+	if(value<hist->min) {
+		LATHIST_STORE(&hist->min,value);
+	}
+
+	if(value>hist->max) {
+		LATHIST_STORE(&hist->max,value);
+	}
+}
+
+/**
+	\brief Merge two histograms
+
+	This function adds all the values recorded inside _src_ to _dst_. It can be called while another thread is recording new values inside _src_
+	(e.g. to periodically aggregate the per-thread shards): each counter is read atomically, but the values recorded during the merge may be
+	taken into account only in part (they will be anyway counted by the next merge, if _dst_ is reset in the meantime).
+
+	\param[in,out]	dst 	Pointer to the destination [struct lathist](\ref lathist), owned by the calling thread.
+	\param[in]		src 	Pointer to the [struct lathist](\ref lathist) to be merged into _dst_.
+
+	\return None.
+**/
+void lathistMerge(struct lathist *dst, const struct lathist *src) {
+	uint64_t count=0, bucket, min, max;
+	unsigned int i;
+
+	for(i=0;i<LATHIST_BUCKETS;i++) {
+		bucket=LATHIST_LOAD(&src->buckets[i]);
+		dst->buckets[i]+=bucket;
+		count+=bucket;
+	}
+
+	// The count is taken from the buckets, so that it is always consistent with them
+	dst->count+=count;
+	dst->sum+=LATHIST_LOAD(&src->sum);
+
+	min=LATHIST_LOAD(&src->min);
+	max=LATHIST_LOAD(&src->max);
+
+	if(min<dst->min) {
+		dst->min=min;
+	}
+
+	if(max>dst->max) {
+		dst->max=max;
+	}
+}
+
+/**
+	\brief Get the number of values recorded inside a histogram
+
+	\param[in]	hist 	Pointer to the [struct lathist](\ref lathist).
+
+	\return The number of recorded values.
+**/
+uint64_t lathistCount(const struct lathist *hist) {
+	return LATHIST_LOAD(&hist->count);
+}
+
+/**
+	\brief Get the minimum value recorded inside a histogram
+
+	\param[in]	hist 	Pointer to the [struct lathist](\ref lathist).
+
+	\return The minimum recorded value, in _ns_ (exact, not affected by the bucket resolution), or **0** if no value was recorded.
+**/
+uint64_t lathistMin(const struct lathist *hist) {
+	uint64_t min=LATHIST_LOAD(&hist->min);
+
+	return min==UINT64_MAX ? 0 : min;
+}
+
+/**
+	\brief Get the maximum value recorded inside a histogram
+
+	\param[in]	hist 	Pointer to the [struct lathist](\ref lathist).
+
+	\return The maximum recorded value, in _ns_ (exact, not affected by the bucket resolution), or **0** if no value was recorded.
+**/
+uint64_t lathistMax(const struct lathist *hist) {
+	return LATHIST_LOAD(&hist->max);
+}
+
+/**
+	\brief Get the mean of the values recorded inside a histogram
+
+	\param[in]	hist 	Pointer to the [struct lathist](\ref lathist).
+
+	\return The mean of the recorded values, in _ns_ (exact, not affected by the bucket resolution), or **0** if no value was recorded.
+**/
+double lathistMean(const struct lathist *hist) {
+	uint64_t count=LATHIST_LOAD(&hist->count);
+
+	return count==0 ? 0 : (double) LATHIST_LOAD(&hist->sum)/count;
+}
+
+/**
+	\brief Get a percentile of the values recorded inside a histogram
+
+	This function returns the value below which (or at which) _percentile_ percent of the recorded values fall. As all the values inside
+	the same bucket are equivalent, the highest value of the bucket is returned (without exceeding the maximum recorded value).
+
+	\param[in]	hist 		Pointer to the [struct lathist](\ref lathist).
+	\param[in]	percentile 	Percentile, between **0** and **100** (e.g. **99.9**).
+
+	\return The requested percentile, in _ns_, or **0** if no value was recorded.
+**/
+uint64_t lathistPercentile(const struct lathist *hist, double percentile) {
+	uint64_t count=0, target, cumulative=0, value, max;
+	unsigned int i;
+
+	for(i=0;i<LATHIST_BUCKETS;i++) {
+		count+=LATHIST_LOAD(&hist->buckets[i]);
+	}
+
+	if(count==0) {
+		return 0;
+	}
+
+	if(percentile<0.0) {
+		percentile=0.0;
+	} else if(percentile>100.0) {
+		percentile=100.0;
+	}
+
+	// Rank of the requested value (at least the first one)
+	target=(uint64_t) (percentile/100.0*count+0.5);
+	if(target==0) {
+		target=1;
+	}
+
+	for(i=0;i<LATHIST_BUCKETS;i++) {
+		cumulative+=LATHIST_LOAD(&hist->buckets[i]);
+
+		if(cumulative>=target) {
+			break;
+		}
+	}
+
+	value=lathistBucketHighest(i<LATHIST_BUCKETS ? i : LATHIST_BUCKETS-1);
+	max=LATHIST_LOAD(&hist->max);
+
+	return value>max ? max : value;
+}
+
+// Serialize 'hist' after merging each group of 2^'reduction' adjacent buckets into a single one, returning the size of the serialized histogram, or 0 if it does not fit
+static size_t lathistSerializeReduced(const struct lathist *hist, byte_t *buf, size_t size, unsigned int reduction) {
+	uint64_t fields[5], bucket=0;
+	unsigned int i, group, prevgroup=0, nonempty=0;
+	unsigned int mask=(1U << reduction)-1;
+	size_t pos, len;
+
+	if(size<5) {
+		return 0;
+	}
+
+	buf[0]=LATHIST_MAGIC;
+	buf[1]=LATHIST_FORMAT_VERSION;
+	buf[2]=LATHIST_SUB_BITS;
+	buf[3]=LATHIST_MAX_BITS;
+	buf[4]=(byte_t) reduction;
+	pos=5;
+
+	for(i=0;i<LATHIST_BUCKETS;i++) {
+		bucket+=LATHIST_LOAD(&hist->buckets[i]);
+
+		if((i & mask)==mask) {
+			if(bucket!=0) {
+				nonempty++;
+			}
+			bucket=0;
+		}
+	}
+
+	fields[0]=LATHIST_LOAD(&hist->count);
+	fields[1]=LATHIST_LOAD(&hist->sum);
+	fields[2]=lathistMin(hist);
+	fields[3]=lathistMax(hist);
+	fields[4]=nonempty;
+
+	for(i=0;i<5;i++) {
+		if((len=lathistPutVarint(buf+pos,size-pos,fields[i]))==0) {
+			return 0;
+		}
+		pos+=len;
+	}
+
+	// Groups never span two power-of-two ranges, as LATHIST_HALF_BUCKETS is a multiple of 2^reduction
+	for(i=0;i<LATHIST_BUCKETS && nonempty>0;i++) {
+		bucket+=LATHIST_LOAD(&hist->buckets[i]);
+
+		if((i & mask)!=mask || bucket==0) {
+			continue;
+		}
+
+		group=i >> reduction;
+
+		if((len=lathistPutVarint(buf+pos,size-pos,group-prevgroup))==0) {
+			return 0;
+		}
+		pos+=len;
+
+		if((len=lathistPutVarint(buf+pos,size-pos,bucket))==0) {
+			return 0;
+		}
+		pos+=len;
+
+		prevgroup=group;
+		bucket=0;
+		nonempty--;
+	}
+
+	return pos;
+}
+
+/**
+	\brief Serialize a histogram
+
+	This function stores a compact representation of the histogram inside _buf_: only the non-empty buckets are stored, with their index
+	(relative to the previous one) and count encoded as variable-length integers, so that the size depends on how spread the recorded values are
+	(a few hundred _bytes_ for a typical latency distribution). The result can be sent, for instance, as the payload of a LaMP report, and it can be
+	read back with lathistDeserialize().
+
+	The serialized histogram never exceeds [LATHIST_SERIALIZED_MAX_SIZE](\ref LATHIST_SERIALIZED_MAX_SIZE) _bytes_ (nor _size_): if it does not fit
+	at full resolution, each group of 2, 4, ..., 2^([LATHIST_SUB_BITS](\ref LATHIST_SUB_BITS)-1) adjacent buckets is merged into a single one, until it
+	fits. The relative error of the percentiles computed on the deserialized histogram increases accordingly (up to 100% when all the sub-buckets
+	of each power-of-two range are merged), while the minimum, maximum and mean are not affected.
+
+	\param[in]	hist 	Pointer to the [struct lathist](\ref lathist).
+	\param[out]	buf 	Buffer in which the serialized histogram is stored.
+	\param[in]	size 	Size, in _bytes_, of _buf_ ([LATHIST_SERIALIZED_MAX_SIZE](\ref LATHIST_SERIALIZED_MAX_SIZE) _bytes_ are always enough).
+
+	\return The size, in _bytes_, of the serialized histogram, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LATHIST_NOSPACE* -> the serialized histogram does not fit inside _buf_, even at the coarsest resolution
+**/
+int lathistSerialize(const struct lathist *hist, byte_t *buf, size_t size) {
+	unsigned int reduction;
+	size_t len;
+
+	if(size>LATHIST_SERIALIZED_MAX_SIZE) {
+		size=LATHIST_SERIALIZED_MAX_SIZE;
+	}
+
+	for(reduction=0;reduction<LATHIST_SUB_BITS;reduction++) {
+		if((len=lathistSerializeReduced(hist,buf,size,reduction))!=0) {
+			return (int) len;
+		}
+	}
+
+	return ERR_LATHIST_NOSPACE;
+}
+
+/**
+	\brief Read a serialized histogram
+
+	This function initializes _hist_ with the content of a histogram serialized with lathistSerialize() (possibly on another device).
+	lathistMerge() can then be used to aggregate it with other histograms. If the histogram was serialized at a coarser resolution, the count of
+	each group of merged buckets is stored inside the last bucket of the group, so that the percentiles are never underestimated.
+
+	\param[out]	hist 	Pointer to the [struct lathist](\ref lathist) to be filled in.
+	\param[in]	buf 	Buffer containing the serialized histogram.
+	\param[in]	size 	Size, in _bytes_, of the serialized histogram.
+
+	\return **0** if the histogram was properly read, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LATHIST_FORMAT* -> the buffer does not contain a valid histogram, or it was serialized with a different bucket configuration
+**/
+rawsockerr_t lathistDeserialize(struct lathist *hist, const byte_t *buf, size_t size) {
+	uint64_t fields[5], delta, bucket;
+	unsigned int i, group=0, reduction;
+	size_t pos, len;
+
+	lathistInit(hist);
+
+	if(size<5 || buf[0]!=LATHIST_MAGIC || buf[1]!=LATHIST_FORMAT_VERSION || buf[2]!=LATHIST_SUB_BITS || buf[3]!=LATHIST_MAX_BITS || buf[4]>=LATHIST_SUB_BITS) {
+		return ERR_LATHIST_FORMAT;
+	}
+	reduction=buf[4];
+	pos=5;
+
+	for(i=0;i<5;i++) {
+		if((len=lathistGetVarint(buf+pos,size-pos,&fields[i]))==0) {
+			return ERR_LATHIST_FORMAT;
+		}
+		pos+=len;
+	}
+
+	for(i=0;i<fields[4];i++) {
+		if((len=lathistGetVarint(buf+pos,size-pos,&delta))==0) {
+			return ERR_LATHIST_FORMAT;
+		}
+		pos+=len;
+
+		if((len=lathistGetVarint(buf+pos,size-pos,&bucket))==0) {
+			return ERR_LATHIST_FORMAT;
+		}
+		pos+=len;
+
+		if(delta>=(LATHIST_BUCKETS >> reduction)-group) {
+			lathistInit(hist);
+			return ERR_LATHIST_FORMAT;
+		}
+
+		group+=(unsigned int) delta;
+		hist->buckets[((group+1) << reduction)-1]=bucket;
+	}
+
+	hist->count=fields[0];
+	hist->sum=fields[1];
+	hist->min=fields[0]==0 ? UINT64_MAX : fields[2];
+	hist->max=fields[3];
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+/** \file
+	Streaming latency histograms for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to collect latency statistics (e.g. LaMP RTTs or one-way delays)
+	over sessions of any duration, without storing the single samples. A [struct lathist](\ref lathist) is a log-linear histogram (HDR-like):
+	each power-of-two range of values is split into the same number of linear sub-buckets, so that every value is recorded with a bounded
+	relative error (lower than 1/2^([LATHIST_SUB_BITS](\ref LATHIST_SUB_BITS)-1), i.e. lower than 1% by default), using a constant amount of memory.
+	Recording a value costs a few instructions, with no allocation and no search.
+
+	Values are expressed in nanoseconds, from **0** up to [LATHIST_MAX_VALUE](\ref LATHIST_MAX_VALUE) (about 18 minutes): any larger value is counted
+	in the last bucket.
+
+	Each histogram should be written by a single thread. When several threads collect samples, each one should record them into its own histogram
+	(_shard_): the counters are updated with relaxed atomic stores, so that any other thread can, at any time, merge the shards with lathistMerge()
+	without taking any lock and without slowing down the writers.
+
+	A histogram can be serialized with lathistSerialize() into a compact buffer (only the non-empty buckets are stored, as variable-length integers),
+	for instance to be sent inside the payload of a LaMP report (_CTRL_UNIDIR_REPORT_), and read back with lathistDeserialize(). The serialized
+	histogram never exceeds [LATHIST_SERIALIZED_MAX_SIZE](\ref LATHIST_SERIALIZED_MAX_SIZE) _bytes_, so that a report always fits inside a single
+	1500 B MTU frame: when the recorded values are too spread, adjacent buckets are merged before being stored (the minimum, maximum and mean are
+	always kept exact).
+
+	__Example of use:__
+
+		struct lathist hist, peerhist;
+		byte_t payload[LATHIST_SERIALIZED_MAX_SIZE];
+		int size;
+
+		lathistInit(&hist);
+
+		while(...) {
+			... // Receive a LaMP reply, storing its reception timestamp inside 'rxts'
+			lampHistRecord(&hist,lampHeader,&rxts,NULL);
+		}
+
+		printf("min %lu, p50 %lu, p99 %lu, max %lu ns\n",lathistMin(&hist),lathistPercentile(&hist,50.0),lathistPercentile(&hist,99.0),lathistMax(&hist));
+
+		size=lathistSerialize(&hist,payload,sizeof(payload));
+		lampEncapsulate(packet,&reportHeader,payload,size);
+
+		// On the other side
+		lathistDeserialize(&peerhist,payload,size);
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_HIST_H_INCLUDED
+#define RAWSOCK_HIST_H_INCLUDED
+
+#include "rawsock.h"
+#include <stdint.h>
+
+#define LATHIST_SUB_BITS 8 /**< Number of bits used to index the sub-buckets of each power-of-two range: the relative error of the recorded values is lower than 1/2^(LATHIST_SUB_BITS-1). */
+#define LATHIST_MAX_BITS 40 /**< Number of bits of the largest value which can be recorded. */
+#define LATHIST_MAX_VALUE ((1ULL << LATHIST_MAX_BITS)-1) /**< Largest value, in _ns_, which can be recorded (larger values are counted as this one). */
+#define LATHIST_HALF_BUCKETS (1U << (LATHIST_SUB_BITS-1)) /**< Number of sub-buckets of each power-of-two range (except the first one). */
+#define LATHIST_BUCKETS ((LATHIST_MAX_BITS-LATHIST_SUB_BITS+2)*LATHIST_HALF_BUCKETS) /**< Total number of buckets of a [struct lathist](\ref lathist). */
+#define LATHIST_SERIALIZED_MAX_SIZE 1448 /**< Maximum size, in _bytes_, of a serialized histogram: it fits, after the 24 B LaMP header, inside the UDP payload of a single 1500 B MTU frame (1500 B - 20 B IPv4 header - 8 B UDP header - 24 B LaMP header). Histograms with too many non-empty buckets are serialized at a coarser resolution, in order not to exceed it. */
+
+/**
+	\brief Latency histogram
+
+	Structure containing a log-linear latency histogram. It should be initialized with lathistInit(), and its fields should not be modified directly by the user.
+**/
+struct lathist {
+	uint64_t count; /**< Number of recorded values. */
+	uint64_t sum; /**< Sum of the recorded values, in _ns_. */
+	uint64_t min; /**< Minimum recorded value, in _ns_ (UINT64_MAX if no value was recorded). */
+	uint64_t max; /**< Maximum recorded value, in _ns_. */
+	uint64_t buckets[LATHIST_BUCKETS]; /**< Number of recorded values falling inside each bucket. */
+};
+
+void lathistInit(struct lathist *hist);
+void lathistRecord(struct lathist *hist, uint64_t value);
+void lathistMerge(struct lathist *dst, const struct lathist *src);
+uint64_t lathistCount(const struct lathist *hist);
+uint64_t lathistMin(const struct lathist *hist);
+uint64_t lathistMax(const struct lathist *hist);
+double lathistMean(const struct lathist *hist);
+uint64_t lathistPercentile(const struct lathist *hist, double percentile);
+int lathistSerialize(const struct lathist *hist, byte_t *buf, size_t size);
+rawsockerr_t lathistDeserialize(struct lathist *hist, const byte_t *buf, size_t size);
+#endif
@@ -3,8 +3,157 @@
 #include "rawsock.h"
 #include "rawsock_lamp.h"
 #include "minirighi_udp_checksum.h"
+#include "rawsock_csum.h"
+#include "rawsock_ring.h"
+#include "rawsock_clock.h"
+#include "rawsock_hist.h"
 #include <sys/time.h>
+#include <sys/ioctl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <net/if.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+
+#define LAMPTS_CONTROL_SIZE 512 // Size of the ancillary data buffer used to receive the timestamps
+
+#define LAMPSEQ_F_USED 0x01 // The struct lampseqwin is in use (inside a struct lampseqtable)
+#define LAMPSEQ_F_STARTED 0x02 // At least one sequence number was received
+
+// Process default LaMP clock, set by lampSetClock() and used whenever no session clock is specified
+static struct lampclock lampdefclk={NULL,false};
+
+// Get the clock to be used: the session clock 'lclk', if specified, or the process default one
+static inline const struct lampclock *lampClockGet(const struct lampclock *lclk) {
+	return lclk!=NULL ? lclk : &lampdefclk;
+}
+
+// Get the current time from a LaMP clock
+static inline void lampNow(const struct lampclock *lclk, struct timespec *ts) {
+	if(lclk->clk!=NULL) {
+		rsclockNow(lclk->clk,ts);
+	} else {
+		clock_gettime(CLOCK_REALTIME,ts);
+	}
+}
+
+// Map a zero checksum, resulting from an incremental update, to 0xFFFF, as a zero UDP checksum means that no checksum was computed (RFC 768)
+static inline csum16_t lampCsumNonZero(csum16_t csum) {
+	return csum==0 ? 0xFFFF : csum;
+}
+
+// Get the offset, in ns, between the LaMP clock 'lclk' and the clock used by the qdisc to interpret the launch times of the socket 'descriptor'
+//  (see rawTxtimeEnable()), so that a launch time can be expressed as a LaMP timestamp; it returns false if SO_TXTIME is not enabled
+static bool lampTxtimeOffset(int descriptor, const struct lampclock *lclk, int64_t *offset) {
+	struct sock_txtime txtimecfg;
+	socklen_t optlen=sizeof(txtimecfg);
+	struct timespec lampts, txts;
+
+	if(getsockopt(descriptor,SOL_SOCKET,SO_TXTIME,&txtimecfg,&optlen)<0 || clock_gettime(txtimecfg.clockid,&txts)<0) {
+		return false;
+	}
+	lampNow(lampClockGet(lclk),&lampts);
+
+	*offset=(int64_t) (lampts.tv_sec-txts.tv_sec)*1000000000LL+(lampts.tv_nsec-txts.tv_nsec);
+
+	return true;
+}
+
+// Convert a launch time to the corresponding LaMP timestamp, given the offset computed by lampTxtimeOffset()
+static inline void lampTxtimeToTs(uint64_t txtime, int64_t offset, struct timespec *ts) {
+	uint64_t ns=txtime+offset;
+
+	ts->tv_sec=(time_t) (ns/1000000000ULL);
+	ts->tv_nsec=(long) (ns%1000000000ULL);
+}
+
+// Get the LaMP timestamp of a packet with launch time 'txtime', sent over the socket 'descriptor': it returns 'ts', filled in with the
+//  launch time, or NULL if the packet should be timestamped with the current time (no launch time, or SO_TXTIME not enabled)
+static struct timespec *lampLaunchTimestamp(int descriptor, uint64_t txtime, const struct lampclock *lclk, struct timespec *ts) {
+	int64_t offset;
+
+	if(txtime==0 || !lampTxtimeOffset(descriptor,lclk,&offset)) {
+		return NULL;
+	}
+
+	lampTxtimeToTs(txtime,offset,ts);
+
+	return ts;
+}
+
+/**
+	\brief Finalize a LaMP packet, just before sending it
+
+	This function performs all the operations done by rawLampSend() and by the other raw send functions before passing the packet to the kernel:
+	it applies the end flag, sets the timestamp (when needed) and then updates the checksum of the protocol encapsulating LaMP, either by computing
+	it again over the whole packet or, if _incremental_ is _true_, by patching it with the old and new field values (as rawLampSendIncr() does).
+
+	It can be used to send LaMP packets through any other path (e.g. an AF_XDP socket), or to measure the cost of the raw send functions without any system call.
+
+	\param[in,out]	inpacket_headerptr 		Pointer to the LaMP header **inside** the full packet.
+	\param[in] 		end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		incremental 			_true_ to incrementally update the checksum, which must be valid (see rawLampSendIncr()), _false_ to compute it again.
+	\param[in] 		tstamp 					Pointer to a custom timestamp (e.g. a launch time), or NULL to use the current time.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return None.
+**/
+void lampFinalize(struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, bool incremental, struct timespec *tstamp, const struct lampclock *lclk) {
+	struct udphdr *inpacket_headerptr_udp=NULL;
+	struct iphdr *inpacket_headerptr_ipv4=NULL;
+	csum16_t *csumptr=NULL;
+	uint16_t oldctrlword, newctrlword; // Reserved + control fields, as a single 16-bit word
+	size_t packetsize;
+
+	if(llprot==UDP) {
+		// Try to obtain the UDP header pointer by subtracting a certain offset to the LaMP inpacket_headerptr
+		inpacket_headerptr_udp=(struct udphdr *) ((byte_t *)inpacket_headerptr-sizeof(struct udphdr));
+		// Try to obtain the IPv4 header pointer by subtracting a certain offset to the LaMP inpacket_headerptr
+		inpacket_headerptr_ipv4=(struct iphdr *) ((byte_t *)inpacket_headerptr_udp-sizeof(struct iphdr));
+
+		// A zero UDP checksum (no checksum computed) is left as it is
+		if(incremental && inpacket_headerptr_udp->check!=0) {
+			csumptr=&(inpacket_headerptr_udp->check);
+		}
+	}
+
+	memcpy(&oldctrlword,inpacket_headerptr,sizeof(uint16_t));
+
+	if(IS_UNIDIR(inpacket_headerptr->ctrl) && end_flag==FLG_STOP) {
+		inpacket_headerptr->ctrl=CTRL_UNIDIR_STOP;
+	} else if(IS_PINGLIKE(inpacket_headerptr->ctrl) && end_flag==FLG_STOP) {
+		if(inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ) {
+			inpacket_headerptr->ctrl=CTRL_PINGLIKE_ENDREQ;
+		} else if(inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ_TLESS) {
+			inpacket_headerptr->ctrl=CTRL_PINGLIKE_ENDREQ_TLESS;
+		}
+	}
+
+	if(csumptr!=NULL) {
+		memcpy(&newctrlword,inpacket_headerptr,sizeof(uint16_t));
+		*csumptr=lampCsumNonZero(csum_replace2(*csumptr,oldctrlword,newctrlword));
+	}
+
+	if(IS_UNIDIR(inpacket_headerptr->ctrl) || inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ || inpacket_headerptr->ctrl==CTRL_PINGLIKE_ENDREQ) {
+		// Set timestamp as very last operation, only if it is not a ping-like reply
+		lampHeadSetTimestampTs(inpacket_headerptr,tstamp,csumptr,lclk);
+	}
+
+	// Compute again the checksum depending on the lower layer protocol (UDP is supported as of now), if it was not incrementally updated
+	if(llprot==UDP && !incremental) {
+		inpacket_headerptr_udp->check=0;
+		if(IS_INIT(inpacket_headerptr->ctrl) || IS_FOLLOWUP_CTRL(inpacket_headerptr->ctrl)) {
+			packetsize=sizeof(struct udphdr)+LAMP_HDR_SIZE();
+		} else {
+			packetsize=sizeof(struct udphdr)+LAMP_HDR_PAYLOAD_SIZE(ntohs(inpacket_headerptr->len));
+		}
+
+		inpacket_headerptr_udp->check=minirighi_udp_checksum(inpacket_headerptr_udp,packetsize,inpacket_headerptr_ipv4->saddr,inpacket_headerptr_ipv4->daddr);
+	}
+}
 
 /**
 	\brief Populate a LaMP header
@@ -54,13 +203,13 @@ void lampHeadPopulate(struct lamphdr *lampHeader, unsigned char ctrl, unsigned s
 	\note Like all the other functions inside the Rawsock library, it already takes care of byte ordering.
 
 	\param[in,out]		initLampHeader 		Pointer to the LaMP header structure, already populated by lampHeadPopulate().
-	\param[in]			mode_index			INIT type index to be used (see [INIT_PINGLIKE_INDEX](\ref INIT_PINGLIKE_INDEX) and [INIT_UNIDIR_INDEX](\ref INIT_UNIDIR_INDEX))
+	\param[in]			mode_index			INIT type index to be used (see [INIT_PINGLIKE_INDEX](\ref INIT_PINGLIKE_INDEX) and [INIT_UNIDIR_INDEX](\ref INIT_UNIDIR_INDEX)), optionally ORed with [INIT_FLAG_NSEC](\ref INIT_FLAG_NSEC)
 
 	\return None.
 **/
 void lampHeadSetConnType(struct lamphdr *initLampHeader, uint16_t mode_index) {
 	// If packet type is not INIT, ignore any operation on the LaMP header
-	if(initLampHeader->ctrl==CTRL_CONN_INIT && IS_INIT_INDEX_VALID(mode_index)) {
+	if(initLampHeader->ctrl==CTRL_CONN_INIT && IS_INIT_INDEX_VALID(INIT_GET_INDEX(mode_index)) && (mode_index & ~(INIT_INDEX_MASK | INIT_FLAG_NSEC))==0) {
 		initLampHeader->len=htons(mode_index);
 	}
 }
@@ -95,30 +244,89 @@ void lampHeadSetFollowupCtrlType(struct lamphdr *followupLampHeader, uint16_t fo
 	If tStampPtr is NULL, the timestamp is set to the time instant in which this function was called and started its execution.
 	If it is not NULL, it will be set using the values stored inside the specified struct timeval.
 
-	<b>A realtime clock is used</b> (i.e. the one used for _gettimeofday()_).
+	<b>A realtime clock is used</b> (i.e. the one used for _gettimeofday()_), unless a different clock was selected with lampSetClock().
+	In the nanosecond mode (see lampSetClock()), the "usec" field is filled in with nanoseconds.
 
 	This function has no effect if the packet is timestampless (i.e. if the control field is indicating a "TLESS" type)
 
 	\note Like all the other functions inside the Rawsock library, it already takes care of byte ordering.
 
+	\note If the LaMP header is already stored inside a packet, with a valid checksum, lampHeadSetTimestampCsum() can be used to
+	update the checksum too.
+
 	\param[in,out]		lampHeader 		Pointer to the LaMP header structure.
 	\param[in]			tStampPtr		Pointer to a struct timeval to store a custom timestamp, or NULL to use the current time
 
 	\return None.
 **/
 void lampHeadSetTimestamp(struct lamphdr *lampHeader, struct timeval *tStampPtr) {
-	struct timeval currtime;
+	lampHeadSetTimestampCsum(lampHeader,tStampPtr,NULL);
+}
+
+/**
+	\brief Set the timestamp inside a LaMP Header, incrementally updating the checksum of the encapsulating packet
+
+	This function works exactly like lampHeadSetTimestamp(), but, if _csum_ is non-NULL, it also incrementally updates (see csum_replace8())
+	the checksum pointed by _csum_, which should be the checksum of the protocol encapsulating LaMP (for instance the _check_ field
+	of the UDP header, inside the same packet), in order to take into account the new timestamp value.
+
+	As in UDP (RFC 768), a zero checksum means that no checksum was computed: it is left untouched, and an updated checksum equal to zero is stored as _0xFFFF_.
+
+	The cost of this operation is constant, no matter the size of the LaMP payload.
+
+	\param[in,out]		lampHeader 		Pointer to the LaMP header structure, stored inside a packet.
+	\param[in]			tStampPtr		Pointer to a struct timeval to store a custom timestamp, or NULL to use the current time
+	\param[in,out]		csum 			Pointer to the checksum to be updated, or NULL to leave any checksum untouched.
+
+	\return None.
+**/
+void lampHeadSetTimestampCsum(struct lamphdr *lampHeader, struct timeval *tStampPtr, csum16_t *csum) {
+	struct timespec tStamp;
+
+	if(tStampPtr==NULL) {
+		lampHeadSetTimestampTs(lampHeader,NULL,csum,NULL);
+	} else {
+		tStamp.tv_sec=tStampPtr->tv_sec;
+		tStamp.tv_nsec=tStampPtr->tv_usec*1000;
+		lampHeadSetTimestampTs(lampHeader,&tStamp,csum,NULL);
+	}
+}
+
+/**
+	\brief Set the timestamp inside a LaMP Header, from a _struct timespec_
+
+	This function works exactly like lampHeadSetTimestampCsum(), but the custom timestamp, if any, is specified as a _struct timespec_:
+	in the nanosecond mode (see [struct lampclock](\ref lampclock)), its full resolution is kept inside the LaMP header.
+
+	\param[in,out]		lampHeader 		Pointer to the LaMP header structure.
+	\param[in]			tStampPtr		Pointer to a struct timespec to store a custom timestamp, or NULL to use the current time (read from _lclk_)
+	\param[in,out]		csum 			Pointer to the checksum to be updated, or NULL to leave any checksum untouched.
+	\param[in]			lclk 			Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return None.
+**/
+void lampHeadSetTimestampTs(struct lamphdr *lampHeader, struct timespec *tStampPtr, csum16_t *csum, const struct lampclock *lclk) {
+	struct timespec currtime;
+	uint64_t sec, usec;
+
+	lclk=lampClockGet(lclk);
 
 	if(lampHeader->ctrl!=CTRL_PINGLIKE_REQ_TLESS && lampHeader->ctrl!=CTRL_PINGLIKE_REPLY_TLESS && lampHeader->ctrl!=CTRL_PINGLIKE_ENDREQ_TLESS && lampHeader->ctrl!=CTRL_PINGLIKE_ENDREPLY_TLESS) {
 		if(tStampPtr==NULL) {
-			gettimeofday(&currtime,NULL); // Set timestamp as very last operation, only if it is not a TLESS packet
+			lampNow(lclk,&currtime); // Set timestamp as very last operation, only if it is not a TLESS packet
+			tStampPtr=&currtime;
+		}
 
-			lampHeader->sec=hton64((uint64_t) currtime.tv_sec);
-			lampHeader->usec=hton64((uint64_t) currtime.tv_usec);
-		} else {
-			lampHeader->sec=hton64((uint64_t) tStampPtr->tv_sec);
-			lampHeader->usec=hton64((uint64_t) tStampPtr->tv_usec);
+		sec=hton64((uint64_t) tStampPtr->tv_sec);
+		usec=hton64((uint64_t) (lclk->nsec ? tStampPtr->tv_nsec : tStampPtr->tv_nsec/1000));
+
+		if(csum!=NULL && *csum!=0) {
+			*csum=csum_replace8(*csum,lampHeader->sec,sec);
+			*csum=lampCsumNonZero(csum_replace8(*csum,lampHeader->usec,usec));
 		}
+
+		lampHeader->sec=sec;
+		lampHeader->usec=usec;
 	}
 }
 
@@ -130,11 +338,36 @@ void lampHeadSetTimestamp(struct lamphdr *lampHeader, struct timeval *tStampPtr)
 
 	The function takes as input the pointer to a LaMP header (i.e. to a memory area where a _struct lamphdr_ is stored).
 
+	\note If the LaMP header is already stored inside a packet, with a valid checksum, lampHeadIncreaseSeqCsum() can be used to
+	update the checksum too.
+
 	\param[in,out]		inpacket_headerptr 		Pointer to the LaMP header structure, in which the sequence number will be increased by 1.
 
 	\return None.
 **/
 void lampHeadIncreaseSeq(struct lamphdr *inpacket_headerptr) {
+	lampHeadIncreaseSeqCsum(inpacket_headerptr,NULL);
+}
+
+/**
+	\brief Increase the sequence number inside a LaMP header, incrementally updating the checksum of the encapsulating packet
+
+	This function works exactly like lampHeadIncreaseSeq(), but, if _csum_ is non-NULL, it also incrementally updates (see csum_replace2())
+	the checksum pointed by _csum_, which should be the checksum of the protocol encapsulating LaMP (for instance the _check_ field
+	of the UDP header, inside the same packet), in order to take into account the new sequence number.
+
+	As in UDP (RFC 768), a zero checksum means that no checksum was computed: it is left untouched, and an updated checksum equal to zero is stored as _0xFFFF_.
+
+	__Example of use (LaMP over UDP, inside a full Ethernet packet):__
+
+		lampHeadIncreaseSeqCsum(lampHeader,&(udpHeader->check));
+
+	\param[in,out]		inpacket_headerptr 		Pointer to the LaMP header structure, in which the sequence number will be increased by 1.
+	\param[in,out]		csum 					Pointer to the checksum to be updated, or NULL to leave any checksum untouched.
+
+	\return None.
+**/
+void lampHeadIncreaseSeqCsum(struct lamphdr *inpacket_headerptr, csum16_t *csum) {
 	uint16_t seq=htons(inpacket_headerptr->seq); // Get current sequence number in the proper bit order
 	// Take into account ciclicity in the sequence numbers
 	if(inpacket_headerptr->seq==UINT16_MAX) {
@@ -142,6 +375,11 @@ void lampHeadIncreaseSeq(struct lamphdr *inpacket_headerptr) {
 	} else {
 		seq++;
 	}
+
+	if(csum!=NULL && *csum!=0) {
+		*csum=lampCsumNonZero(csum_replace2(*csum,inpacket_headerptr->seq,ntohs(seq)));
+	}
+
 	inpacket_headerptr->seq=ntohs(seq);
 }
 
@@ -250,6 +488,48 @@ void lampEncapsulate(byte_t *packet, struct lamphdr *lampHeader, byte_t *data, s
 	memcpy(packet+sizeof(struct lamphdr),data,payloadsize);
 }
 
+/**
+	\brief Combine LaMP payload and header directly inside a [struct framebuf](\ref framebuf)
+
+	This function works like lampEncapsulate(), but it writes the LaMP header and payload in the payload area of a
+	[struct framebuf](\ref framebuf), which can then be passed to UDPencapsulateInPlace() (or to any other
+	[*EncapsulateInPlace()](\ref UDPencapsulateInPlace) function).
+
+	The LaMP packet is checksummed while it is copied (see csum_partial_copy()): this way, UDPencapsulateInPlace() does not need
+	to read it again to compute the UDP checksum, and the whole frame is built with a single pass over the payload.
+
+	\note The "length" field of the LaMP header is automatically set.
+
+	\param[in,out]	fb 			Pointer to a previously prepared [struct framebuf](\ref framebuf).
+	\param[in]		lampHeader 	LaMP header, as [struct lamphdr](\ref lamhdr). Should be filled in with [lampHeadPopulate()](\ref lampHeadPopulate()) before being passed to this function.
+	\param[in]		data    	Buffer containing the payload (it can be NULL if _payloadsize_ is 0).
+	\param[in]		payloadsize	Size, in _bytes_, of the payload.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_FRAMEBUF_NOSPACE* -> the LaMP packet does not fit inside the buffer
+**/
+rawsockerr_t lampEncapsulateInPlace(struct framebuf *fb, struct lamphdr *lampHeader, byte_t *data, size_t payloadsize) {
+	byte_t *payloadptr=framebufPayloadPtr(fb);
+	__u32 sum;
+
+	if(LAMP_HDR_PAYLOAD_SIZE(payloadsize)>fb->size-fb->headroom) {
+		return ERR_FRAMEBUF_NOSPACE;
+	}
+
+	lampHeader->len=htons(payloadsize);
+
+	sum=csum_partial_copy(lampHeader,payloadptr,sizeof(struct lamphdr),0);
+	if(payloadsize>0) {
+		sum=csum_partial_copy(data,payloadptr+sizeof(struct lamphdr),payloadsize,sum);
+	}
+
+	framebufSetPayloadSize(fb,LAMP_HDR_PAYLOAD_SIZE(payloadsize));
+	fb->payloadcsum=sum;
+	fb->payloadcsum_valid=true;
+
+	return 0;
+}
+
 /**
 	\brief Send LaMP packet over a raw socket, automatically setting some fields such as the timestamp (when needed)
 
@@ -271,87 +551,1063 @@ void lampEncapsulate(byte_t *packet, struct lamphdr *lampHeader, byte_t *data, s
 	\param[in] 	end_flag 				End flag value: see [endflag_t](\ref endflag_t).
 	\param[in] 	llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
 
+	\note The checksum of the protocol encapsulating LaMP is computed again over the whole packet. If the checksum stored inside the packet is always
+	kept up to date (i.e. if the in-packet LaMP header is only modified through lampHeadIncreaseSeqCsum() and lampHeadSetTimestampCsum()), rawLampSendIncr()
+	can be used instead.
+
 	\return It returns **1** if the packet was successfully sent, **0** otherwise.
 **/
 int rawLampSend(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot) {
-	struct timeval currtime;
-	struct udphdr *inpacket_headerptr_udp;
-	struct iphdr *inpacket_headerptr_ipv4;
-	size_t packetsize;
+	return rawLampSendClk(descriptor,addrll,inpacket_headerptr,ethernetpacket,finalpacketsize,end_flag,llprot,NULL);
+}
 
-	if(IS_UNIDIR(inpacket_headerptr->ctrl) && end_flag==FLG_STOP) {
-		inpacket_headerptr->ctrl=CTRL_UNIDIR_STOP;
-	} else if(IS_PINGLIKE(inpacket_headerptr->ctrl) && end_flag==FLG_STOP) {
-		if(inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ) {
-			inpacket_headerptr->ctrl=CTRL_PINGLIKE_ENDREQ;
-		} else if(inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ_TLESS) {
-			inpacket_headerptr->ctrl=CTRL_PINGLIKE_ENDREQ_TLESS;
-		}
-	}
+/**
+	\brief Send LaMP packet over a raw socket, using the clock of a given session
 
-	if(IS_UNIDIR(inpacket_headerptr->ctrl) || inpacket_headerptr->ctrl==CTRL_PINGLIKE_REQ || inpacket_headerptr->ctrl==CTRL_PINGLIKE_ENDREQ) {
-		gettimeofday(&currtime,NULL); // Set timestamp as very last operation, only if it is not a ping-like reply
+	This function works exactly like rawLampSend(), but the timestamp is read from, and scaled according to, the clock of the session
+	the packet belongs to (see lampClockInit()), instead of the process default one: a server can thus reply to microsecond and nanosecond
+	sessions at the same time.
 
-		inpacket_headerptr->sec=hton64((uint64_t) currtime.tv_sec);
-		inpacket_headerptr->usec=hton64((uint64_t) currtime.tv_usec);
-	}
+	\param[in] 	descriptor 				Socket descriptor related to the raw socket to be used to send the packet.
+	\param[in] 	addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  inpacket_headerptr 		Pointer to the LaMP header **inside** the full packet, passed as _ethernetpacket_.
+	\param[in] 	ethernetpacket 			Pointer to the buffer storing the **whole** packet to be sent.
+	\param[in] 	finalpacketsize 		Size of the whole packet.
+	\param[in] 	end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 	llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 	lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
 
-	// Compute again the checksum depending on the lower layer protocol (UDP is supported as of now)
-	switch(llprot) {
-		case UDP:
-			// Try to obtain the UDP header pointer by subtracting a certain offset to the LaMP inpacket_headerptr
-			inpacket_headerptr_udp=(struct udphdr *) ((byte_t *)inpacket_headerptr-sizeof(struct udphdr));
-			// Try to obtain the IPv4 header pointer by subtracting a certain offset to the LaMP inpacket_headerptr
-			inpacket_headerptr_ipv4=(struct iphdr *) ((byte_t *)inpacket_headerptr_udp-sizeof(struct iphdr));
+	\return It returns **1** if the packet was successfully sent, **0** otherwise.
+**/
+int rawLampSendClk(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	lampFinalize(inpacket_headerptr,end_flag,llprot,false,NULL,lclk);
 
-			inpacket_headerptr_udp->check=0;
-			if(IS_INIT(inpacket_headerptr->ctrl) || IS_FOLLOWUP_CTRL(inpacket_headerptr->ctrl)) {
-				packetsize=sizeof(struct udphdr)+LAMP_HDR_SIZE();
-			} else {
-				packetsize=sizeof(struct udphdr)+LAMP_HDR_PAYLOAD_SIZE(ntohs(inpacket_headerptr->len));
+	return (sendto(descriptor,ethernetpacket,finalpacketsize,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll))==(ssize_t) finalpacketsize);
+}
+
+/**
+	\brief Send LaMP packet over a raw socket, incrementally updating the checksum
+
+	This function works exactly like rawLampSend(), but the checksum of the protocol encapsulating LaMP is incrementally updated
+	(see csum_replace2() and csum_replace8()) to take into account the new control field and timestamp values, instead of being
+	computed again over the whole packet. Its cost is thus constant, no matter the size of the LaMP payload.
+
+	\warning The checksum stored inside _ethernetpacket_ must be valid when this function is called: the packet should have been built with
+	UDPencapsulate() or UDPencapsulateInPlace() and, after that, the LaMP header should have been modified only through the functions updating the
+	checksum too, such as lampHeadIncreaseSeqCsum() and lampHeadSetTimestampCsum(). Otherwise, rawLampSend() should be used.
+
+	\param[in] 	descriptor 				Socket descriptor related to the raw socket to be used to send the packet.
+	\param[in] 	addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  inpacket_headerptr 		Pointer to the LaMP header **inside** the full packet, passed as _ethernetpacket_.
+	\param[in] 	ethernetpacket 			Pointer to the buffer storing the **whole** packet to be sent (i.e. the same buffer you would pass to a call to <i>sendto()</i>).
+	\param[in] 	finalpacketsize 		Size of the whole packet (i.e. the same size you would pass to a call to <i>sendto()</i>).
+	\param[in] 	end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 	llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 	lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return It returns **1** if the packet was successfully sent, **0** otherwise.
+**/
+int rawLampSendIncr(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	lampFinalize(inpacket_headerptr,end_flag,llprot,true,NULL,lclk);
+
+	return (sendto(descriptor,ethernetpacket,finalpacketsize,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll))==(ssize_t) finalpacketsize);
+}
+
+// Finalize and send a batch of LaMP packets: each chunk of RAWSEND_BATCH_MAX packets is finalized just before being passed to rawSendBatch()
+//  (or to rawSendBatchTxtime(), if 'txtime' is true), to keep the timestamps as close as possible to the actual transmission time
+static int lampSendBatch(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, bool incremental, bool txtime, const struct lampclock *lclk) {
+	unsigned int chunk, i, idx=0;
+	struct timespec launchts;
+	int64_t offset;
+	bool launchstamp;
+	int sent=0;
+
+	// The packets with a launch time are timestamped with it, instead of the current time
+	launchstamp=txtime && lampTxtimeOffset(descriptor,lclk,&offset);
+
+	while(idx<n) {
+		chunk=n-idx<RAWSEND_BATCH_MAX ? n-idx : RAWSEND_BATCH_MAX;
+
+		for(i=idx;i<idx+chunk;i++) {
+			if(launchstamp && frames[i].txtime!=0) {
+				lampTxtimeToTs(frames[i].txtime,offset,&launchts);
 			}
 
-			inpacket_headerptr_udp->check=minirighi_udp_checksum(inpacket_headerptr_udp,packetsize,inpacket_headerptr_ipv4->saddr,inpacket_headerptr_ipv4->daddr);
-		break;
-		default: // case UNSET_P -> do nothing
-		break;
+			// The end flag is applied only to the last packet of the batch
+			lampFinalize(inpacket_headerptrs[i],(i==n-1 || end_flag!=FLG_STOP) ? end_flag : FLG_CONTINUE,llprot,incremental,
+				(launchstamp && frames[i].txtime!=0) ? &launchts : NULL,lclk);
+		}
+
+		if(txtime) {
+			sent+=rawSendBatchTxtime(descriptor,addrll,frames+idx,chunk);
+		} else {
+			sent+=rawSendBatch(descriptor,addrll,frames+idx,chunk);
+		}
+		idx+=chunk;
 	}
 
-	return (sendto(descriptor,ethernetpacket,finalpacketsize,0,(struct sockaddr *)&addrll,sizeof(struct sockaddr_ll))!=finalpacketsize);
+	return sent;
 }
 
 /**
-	\brief Extract relevant data from a LaMP packet
+	\brief Send a batch of LaMP packets over a raw socket, with a single system call
 
-	This function can be used to extract all the relevant data, already converted to host byte order, from a LaMP packet.
+	This function works like rawLampSend(), but it sends _n_ LaMP packets, described by the _frames_ array (see [struct batchframe](\ref batchframe)),
+	with a single _sendmmsg()_ call (see rawSendBatch()). Each packet is finalized as rawLampSend() would do (setting its timestamp, when needed,
+	and computing again its checksum) just before passing it to the kernel.
 
-	The function takes as input the pointer to the LaMP packet (i.e. to a memory area where a _struct lamphdr_, **plus the payload**, is stored).
+	It is mainly meant for high rate unidirectional sessions, when a PACKET_TX_RING (see rawsock_ring.h) is not available on the selected interface.
 
-	\param[in]		lampPacket 		Pointer to the LaMP packet buffer (with type [byte_t](\ref byte_t)).
-	\param[out]		id 				Identification field (LaMP ID) value.
-	\param[out]		seq 			Current sequence number inside the header.
-	\param[out]		len  			Value stored inside the "length or INIT type" field.
-	\param[out]     timestamp 		_struct timeval_ which is filled using the timestamp stored inside the LaMP header.
-	\param[out]		payload 		If this pointer is non-NULL, it should be related to a memory area big enough to contain a possible LaMP payload. Then, the function will copy the payload contained inside the LaMP packet buffer to that memory area. Il the length field is **0** (or NULL is specified), no copy operation will be performed.
+	\param[in] 		descriptor 				Socket descriptor related to the raw socket to be used to send the packets.
+	\param[in] 		addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  	inpacket_headerptrs 	Array of _n_ pointers, each one to the LaMP header **inside** the packet stored in the corresponding element of _frames_.
+	\param[in,out]	frames 					Array of _n_ [struct batchframe](\ref batchframe), describing the packets to be sent; the _err_ field of each of them is set as described in rawSendBatch().
+	\param[in] 		n 						Number of packets to be sent.
+	\param[in] 		end_flag 				End flag value (see [endflag_t](\ref endflag_t)): [FLG_STOP](\ref endflag_t) is applied only to the last packet of the batch.
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
 
-	\return None.
+	\return The number of packets which were successfully sent.
 **/
-void lampHeadGetData(byte_t *lampPacket, lamptype_t *type, unsigned short *id, unsigned short *seq, unsigned short *len, struct timeval *timestamp, byte_t *payload) {
-	struct lamphdr *lampHeader=(struct lamphdr *) lampPacket;
-	byte_t *payloadptr=(lampPacket+LAMP_HDR_SIZE());
+int rawLampSendBatch(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	return lampSendBatch(descriptor,addrll,inpacket_headerptrs,frames,n,end_flag,llprot,false,false,lclk);
+}
 
-	if(type) *type=(lampHeader->ctrl) & 0x0F;
-	if(id) *id=ntohs(lampHeader->id);
-	if(seq) *seq=ntohs(lampHeader->seq);
-	if(len) *len=ntohs(lampHeader->len);
-	if(timestamp) {
-		timestamp->tv_sec=(time_t) ntoh64(lampHeader->sec);
-		timestamp->tv_usec=(suseconds_t) ntoh64(lampHeader->usec);
-	}
+/**
+	\brief Send a batch of LaMP packets over a raw socket, with a single system call, incrementally updating the checksums
 
-	if(payload && lampHeader->len!=0x00) {
-		memcpy(payload,payloadptr,lampHeader->len);
-	}
+	This function works exactly like rawLampSendBatch(), but the checksum of each packet is incrementally updated, as rawLampSendIncr() does.
+
+	\warning The checksum stored inside each packet must be valid when this function is called (see rawLampSendIncr()).
+
+	\param[in] 		descriptor 				Socket descriptor related to the raw socket to be used to send the packets.
+	\param[in] 		addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  	inpacket_headerptrs 	Array of _n_ pointers, each one to the LaMP header **inside** the packet stored in the corresponding element of _frames_.
+	\param[in,out]	frames 					Array of _n_ [struct batchframe](\ref batchframe), describing the packets to be sent.
+	\param[in] 		n 						Number of packets to be sent.
+	\param[in] 		end_flag 				End flag value (see [endflag_t](\ref endflag_t)): [FLG_STOP](\ref endflag_t) is applied only to the last packet of the batch.
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return The number of packets which were successfully sent.
+**/
+int rawLampSendBatchIncr(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	return lampSendBatch(descriptor,addrll,inpacket_headerptrs,frames,n,end_flag,llprot,true,false,lclk);
+}
+
+/**
+	\brief Queue a LaMP packet inside a PACKET_TX_RING, automatically setting some fields such as the timestamp (when needed)
+
+	This function works like rawLampSendIncr(), but, instead of sending the packet with a separate _sendto()_ call, it commits it
+	inside a [struct txring](\ref txring), in which it was built in place (see txringGetFramebuf()). The packet is then sent together with the
+	other packets committed in the same ring, when the ring is flushed (see txringCommit() and txringFlush()).
+
+	\note The timestamp is set when the packet is committed, not when the ring is flushed: the flush threshold of the ring should be kept low
+	(e.g. **1**, for a flush at every packet) if the timestamp should be as close as possible to the actual transmission time.
+
+	\param[in,out]	ring 					Pointer to the [struct txring](\ref txring) in which the packet was built.
+	\param[in] 		fb 						Pointer to the [struct framebuf](\ref framebuf), prepared with txringGetFramebuf(), containing the whole packet.
+	\param[in]  	inpacket_headerptr 		Pointer to the LaMP header **inside** the packet stored in _fb_.
+	\param[in] 		end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return **0** if the packet was successfully committed, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see txringCommit()).
+**/
+rawsockerr_t rawLampSendTxring(struct txring *ring, struct framebuf *fb, struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	lampFinalize(inpacket_headerptr,end_flag,llprot,true,NULL,lclk);
+
+	return txringCommitFramebuf(ring,fb);
+}
+
+/**
+	\brief Send LaMP packet over a raw socket, with a launch time
+
+	This function works exactly like rawLampSendClk(), but the packet is passed to the kernel together with a launch time (see rawSendTxtime()),
+	so that it is put on the wire by the qdisc (e.g. _etf_) exactly at the instant _txtime_. _SO_TXTIME_ should have been enabled on the socket with rawTxtimeEnable().
+
+	\note When a launch time is specified, the LaMP timestamp is set to the launch time itself (converted from the _SO_TXTIME_ clock to the LaMP clock,
+	_lclk_), and not to the instant in which this function is called: the latency measured on the receiving side thus does not include the time
+	spent by the packet inside the qdisc, waiting for its launch time.
+
+	\param[in] 	descriptor 				Socket descriptor related to the raw socket to be used to send the packet.
+	\param[in] 	addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  inpacket_headerptr 		Pointer to the LaMP header **inside** the full packet, passed as _ethernetpacket_.
+	\param[in] 	ethernetpacket 			Pointer to the buffer storing the **whole** packet to be sent.
+	\param[in] 	finalpacketsize 		Size of the whole packet.
+	\param[in] 	end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 	llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 	txtime 					Launch time, in _ns_, read from the clock specified in rawTxtimeEnable(), or **0** to send the packet immediately.
+	\param[in] 	lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return It returns **1** if the packet was successfully sent, **0** otherwise.
+**/
+int rawLampSendTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk) {
+	struct timespec launchts;
+
+	lampFinalize(inpacket_headerptr,end_flag,llprot,false,lampLaunchTimestamp(descriptor,txtime,lclk,&launchts),lclk);
+
+	return (rawSendTxtime(descriptor,addrll,ethernetpacket,finalpacketsize,txtime)==(ssize_t) finalpacketsize);
+}
+
+/**
+	\brief Send LaMP packet over a raw socket, with a launch time, incrementally updating the checksum
+
+	This function works exactly like rawLampSendTxtime(), but the checksum is incrementally updated, as rawLampSendIncr() does.
+
+	\param[in] 	descriptor 				Socket descriptor related to the raw socket to be used to send the packet.
+	\param[in] 	addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  inpacket_headerptr 		Pointer to the LaMP header **inside** the full packet, passed as _ethernetpacket_.
+	\param[in] 	ethernetpacket 			Pointer to the buffer storing the **whole** packet to be sent.
+	\param[in] 	finalpacketsize 		Size of the whole packet.
+	\param[in] 	end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 	llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 	txtime 					Launch time, in _ns_, or **0** to send the packet immediately.
+	\param[in] 	lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return It returns **1** if the packet was successfully sent, **0** otherwise.
+**/
+int rawLampSendIncrTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk) {
+	struct timespec launchts;
+
+	lampFinalize(inpacket_headerptr,end_flag,llprot,true,lampLaunchTimestamp(descriptor,txtime,lclk,&launchts),lclk);
+
+	return (rawSendTxtime(descriptor,addrll,ethernetpacket,finalpacketsize,txtime)==(ssize_t) finalpacketsize);
+}
+
+/**
+	\brief Send a batch of LaMP packets over a raw socket, with a single system call, each one with its own launch time
+
+	This function works exactly like rawLampSendBatch(), but the _txtime_ field of each [struct batchframe](\ref batchframe) is used as the launch time
+	of the corresponding packet (see rawSendBatchTxtime()): a whole burst of periodic LaMP packets can thus be queued in advance, and released by the qdisc
+	at the requested instants, without keeping the sender thread busy. As in rawLampSendTxtime(), each packet with a launch time is timestamped with it.
+
+	\param[in] 		descriptor 				Socket descriptor related to the raw socket to be used to send the packets.
+	\param[in] 		addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  	inpacket_headerptrs 	Array of _n_ pointers, each one to the LaMP header **inside** the packet stored in the corresponding element of _frames_.
+	\param[in,out]	frames 					Array of _n_ [struct batchframe](\ref batchframe), describing the packets to be sent, with their launch times.
+	\param[in] 		n 						Number of packets to be sent.
+	\param[in] 		end_flag 				End flag value (see [endflag_t](\ref endflag_t)): [FLG_STOP](\ref endflag_t) is applied only to the last packet of the batch.
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return The number of packets which were successfully sent.
+**/
+int rawLampSendBatchTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	return lampSendBatch(descriptor,addrll,inpacket_headerptrs,frames,n,end_flag,llprot,false,true,lclk);
+}
+
+/**
+	\brief Send a batch of LaMP packets over a raw socket, with a single system call, each one with its own launch time, incrementally updating the checksums
+
+	This function works exactly like rawLampSendBatchTxtime(), but the checksum of each packet is incrementally updated, as rawLampSendIncr() does.
+
+	\param[in] 		descriptor 				Socket descriptor related to the raw socket to be used to send the packets.
+	\param[in] 		addrll 					Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>).
+	\param[in]  	inpacket_headerptrs 	Array of _n_ pointers, each one to the LaMP header **inside** the packet stored in the corresponding element of _frames_.
+	\param[in,out]	frames 					Array of _n_ [struct batchframe](\ref batchframe), describing the packets to be sent, with their launch times.
+	\param[in] 		n 						Number of packets to be sent.
+	\param[in] 		end_flag 				End flag value (see [endflag_t](\ref endflag_t)): [FLG_STOP](\ref endflag_t) is applied only to the last packet of the batch.
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return The number of packets which were successfully sent.
+**/
+int rawLampSendBatchIncrTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk) {
+	return lampSendBatch(descriptor,addrll,inpacket_headerptrs,frames,n,end_flag,llprot,true,true,lclk);
+}
+
+/**
+	\brief Queue a LaMP packet inside a PACKET_TX_RING, with a launch time
+
+	This function works exactly like rawLampSendTxring(), but the packet is committed with the launch time _txtime_ (see txringCommitTxtime()),
+	which is also used as its LaMP timestamp, as in rawLampSendTxtime().
+
+	\param[in,out]	ring 					Pointer to the [struct txring](\ref txring) in which the packet was built.
+	\param[in] 		fb 						Pointer to the [struct framebuf](\ref framebuf), prepared with txringGetFramebuf(), containing the whole packet.
+	\param[in]  	inpacket_headerptr 		Pointer to the LaMP header **inside** the packet stored in _fb_.
+	\param[in] 		end_flag 				End flag value: see [endflag_t](\ref endflag_t).
+	\param[in] 		llprot 					Protocol type, using the [protocol_t](\ref protocol_t) definition inside rawsock.h.
+	\param[in] 		txtime 					Launch time, in _ns_, read from the clock specified in rawTxtimeEnable(), or **0** to send the packet immediately.
+	\param[in] 		lclk 					Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return **0** if the packet was successfully committed, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see txringCommit()).
+**/
+rawsockerr_t rawLampSendTxringTxtime(struct txring *ring, struct framebuf *fb, struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk) {
+	struct timespec launchts;
+
+	lampFinalize(inpacket_headerptr,end_flag,llprot,true,lampLaunchTimestamp(ring->descriptor,txtime,lclk,&launchts),lclk);
+
+	return txringCommitFramebufTxtime(ring,fb,txtime);
+}
+
+// Enable the hardware timestamping of all the transmitted and received packets on the interface named 'devname'
+static rawsockerr_t lampTimestampingEnableHw(int descriptor, const char *devname) {
+	struct hwtstamp_config hwconfig;
+	struct ifreq ifreq;
+
+	memset(&hwconfig,0,sizeof(hwconfig));
+	hwconfig.tx_type=HWTSTAMP_TX_ON;
+	hwconfig.rx_filter=HWTSTAMP_FILTER_ALL;
+
+	memset(&ifreq,0,sizeof(ifreq));
+	strncpy(ifreq.ifr_name,devname,IFNAMSIZ-1);
+	ifreq.ifr_data=(void *) &hwconfig;
+
+	if(ioctl(descriptor,SIOCSHWTSTAMP,&ifreq)<0) {
+		return ERR_LAMPTS_HWCONFIG;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Enable the kernel timestamps on a socket
+
+	This function enables, through the _SO_TIMESTAMPING_ socket option, the kernel timestamps corresponding to the specified follow-up request type,
+	on a raw or UDP socket:
+	- [FOLLOWUP_REQUEST_T_KRN_RX](\ref FOLLOWUP_REQUEST_T_KRN_RX) -> software RX timestamps only
+	- [FOLLOWUP_REQUEST_T_KRN](\ref FOLLOWUP_REQUEST_T_KRN) -> software RX and TX timestamps
+	- [FOLLOWUP_REQUEST_T_HW](\ref FOLLOWUP_REQUEST_T_HW) -> hardware RX and TX timestamps (the hardware timestamping is also enabled on the interface, if _devname_ is non-NULL)
+	- [FOLLOWUP_REQUEST_T_APP](\ref FOLLOWUP_REQUEST_T_APP) -> no kernel timestamp (the kernel timestamps are disabled)
+
+	The RX timestamps can then be read with lampRecvTstamp() (or lampTstampFromCmsg()), or by rawRecvBatch(). The TX timestamps are
+	queued inside the socket error queue, tagged with a per-socket counter (_SOF_TIMESTAMPING_OPT_ID_), and they should be
+	collected with lampTxTstampCollect(): the [struct lamptxtstamps](\ref lamptxtstamps) should be initialized just after calling this function.
+
+	\param[in]	descriptor 		Socket descriptor (raw or UDP socket).
+	\param[in]	devname 		Name of the interface on which the hardware timestamping should be enabled (used only for [FOLLOWUP_REQUEST_T_HW](\ref FOLLOWUP_REQUEST_T_HW), it can be NULL if it was already enabled, e.g. by another application).
+	\param[in]	followup_type 	Follow-up request type, selecting which kernel timestamps should be enabled.
+
+	\return **0** if the timestamps were enabled, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LAMPTS_SOCKOPT* -> unable to set the _SO_TIMESTAMPING_ option, or unknown follow-up request type (_errno_ is set by _setsockopt()_)
+	- *ERR_LAMPTS_HWCONFIG* -> unable to enable the hardware timestamping on the interface (_errno_ is set by _ioctl()_)
+**/
+rawsockerr_t lampTimestampingEnable(int descriptor, const char *devname, uint16_t followup_type) {
+	unsigned int flags;
+
+	switch(followup_type) {
+		case FOLLOWUP_REQUEST_T_APP:
+			flags=0;
+		break;
+
+		case FOLLOWUP_REQUEST_T_KRN_RX:
+			flags=SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+		break;
+
+		case FOLLOWUP_REQUEST_T_KRN:
+			flags=SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+				SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+		break;
+
+		case FOLLOWUP_REQUEST_T_HW:
+			if(devname!=NULL && lampTimestampingEnableHw(descriptor,devname)!=0) {
+				return ERR_LAMPTS_HWCONFIG;
+			}
+
+			flags=SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+				SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+		break;
+
+		default:
+			errno=EINVAL;
+		return ERR_LAMPTS_SOCKOPT;
+	}
+
+	if(setsockopt(descriptor,SOL_SOCKET,SO_TIMESTAMPING,&flags,sizeof(flags))<0) {
+		return ERR_LAMPTS_SOCKOPT;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Extract a kernel timestamp from the ancillary data of a received message
+
+	This function looks for an _SCM_TIMESTAMPING_ control message inside _msg_, as filled in by _recvmsg()_ on a socket on which the kernel
+	timestamps were enabled with lampTimestampingEnable(). The hardware timestamp is returned, if available, otherwise the software one.
+
+	\param[in]	msg 	Pointer to the _struct msghdr_ filled in by _recvmsg()_.
+	\param[out]	ts 		Pointer to the _struct timespec_ in which the timestamp is stored.
+
+	\return _true_ if a timestamp was found, _false_ otherwise (_ts_ is left untouched).
+**/
+bool lampTstampFromCmsg(struct msghdr *msg, struct timespec *ts) {
+	struct scm_timestamping tss;
+	struct cmsghdr *cmsg;
+
+	for(cmsg=CMSG_FIRSTHDR(msg);cmsg!=NULL;cmsg=CMSG_NXTHDR(msg,cmsg)) {
+		if(cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_TIMESTAMPING) {
+			memcpy(&tss,CMSG_DATA(cmsg),sizeof(tss));
+
+			// ts[2] contains the hardware timestamp, ts[0] the software one
+			if(tss.ts[2].tv_sec!=0 || tss.ts[2].tv_nsec!=0) {
+				*ts=tss.ts[2];
+			} else if(tss.ts[0].tv_sec!=0 || tss.ts[0].tv_nsec!=0) {
+				*ts=tss.ts[0];
+			} else {
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+	\brief Receive a packet together with its kernel reception timestamp
+
+	This function works like _recv()_, but it also returns the kernel reception timestamp of the packet, enabled with lampTimestampingEnable().
+	It can be used both on raw and UDP sockets.
+
+	\param[in]	descriptor 	Socket descriptor.
+	\param[out]	buf 		Buffer in which the packet is stored.
+	\param[in]	len 		Size, in _bytes_, of _buf_.
+	\param[in]	flags 		Flags to be passed to _recvmsg()_ (e.g. _MSG_DONTWAIT_), or **0**.
+	\param[out]	rxts 		Pointer to the _struct timespec_ in which the reception timestamp is stored (it is set to zero if no timestamp is available).
+
+	\return The number of received _bytes_, or **-1** in case of error (_errno_ is set by _recvmsg()_).
+**/
+ssize_t lampRecvTstamp(int descriptor, byte_t *buf, size_t len, int flags, struct timespec *rxts) {
+	union {
+		struct cmsghdr align; // Only used to properly align the buffer
+		byte_t buf[LAMPTS_CONTROL_SIZE];
+	} control;
+	struct msghdr msg;
+	struct iovec iov;
+	ssize_t ret;
+
+	iov.iov_base=buf;
+	iov.iov_len=len;
+
+	memset(&msg,0,sizeof(msg));
+	msg.msg_iov=&iov;
+	msg.msg_iovlen=1;
+	msg.msg_control=control.buf;
+	msg.msg_controllen=sizeof(control.buf);
+
+	ret=recvmsg(descriptor,&msg,flags);
+
+	if(ret>=0 && !lampTstampFromCmsg(&msg,rxts)) {
+		rxts->tv_sec=0;
+		rxts->tv_nsec=0;
+	}
+
+	return ret;
+}
+
+/**
+	\brief Initialize a [struct lamptxtstamps](\ref lamptxtstamps)
+
+	\param[out]	txts 	Pointer to the [struct lamptxtstamps](\ref lamptxtstamps) to be initialized.
+
+	\return None.
+**/
+void lampTxTstampInit(struct lamptxtstamps *txts) {
+	memset(txts,0,sizeof(struct lamptxtstamps));
+}
+
+/**
+	\brief Register a transmitted LaMP packet, in order to match its TX timestamp
+
+	This function should be called once for each packet transmitted over a socket with TX timestamps enabled, just after it was sent,
+	and in the same order in which the packets were sent (including any non-LaMP packet, as the kernel counts all of them).
+
+	\param[in,out]	txts 		Pointer to a [struct lamptxtstamps](\ref lamptxtstamps), initialized with lampTxTstampInit().
+	\param[in]		lampHeader 	Pointer to the LaMP header of the transmitted packet (or NULL for non-LaMP packets).
+
+	\return None.
+**/
+void lampTxTstampRegister(struct lamptxtstamps *txts, struct lamphdr *lampHeader) {
+	struct lamptxslot *slot=&txts->slots[txts->next_key % LAMP_TXTSTAMP_SLOTS];
+
+	slot->key=txts->next_key++;
+	slot->registered=lampHeader!=NULL;
+	slot->stamped=false;
+
+	if(lampHeader!=NULL) {
+		slot->seq=ntohs(lampHeader->seq);
+	}
+}
+
+/**
+	\brief Collect the TX timestamps queued inside the error queue of a socket
+
+	This function reads, without blocking, all the TX timestamps queued by the kernel inside the error queue of the socket, and it stores them
+	inside the slots of the corresponding packets, registered with lampTxTstampRegister(). The timestamps of the packets which are no longer tracked
+	(i.e. older than the last [LAMP_TXTSTAMP_SLOTS](\ref LAMP_TXTSTAMP_SLOTS) ones) are discarded.
+
+	As the TX timestamps are generated asynchronously, a timestamp may not be available yet just after the packet was sent: in this case,
+	the socket can be polled for _POLLERR_ before calling this function again.
+
+	\param[in]		descriptor 	Socket descriptor, on which the TX timestamps were enabled with lampTimestampingEnable().
+	\param[in,out]	txts 		Pointer to the [struct lamptxtstamps](\ref lamptxtstamps) tracking the packets transmitted over the socket.
+
+	\return The number of collected timestamps, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LAMPTS_RECV* -> error while reading the socket error queue (_errno_ is set by _recvmsg()_)
+**/
+int lampTxTstampCollect(int descriptor, struct lamptxtstamps *txts) {
+	union {
+		struct cmsghdr align; // Only used to properly align the buffer
+		byte_t buf[LAMPTS_CONTROL_SIZE];
+	} control;
+	byte_t data[64]; // Any data looped back together with the timestamp (none, with SOF_TIMESTAMPING_OPT_TSONLY) is discarded
+	struct sock_extended_err *serr;
+	struct lamptxslot *slot;
+	struct cmsghdr *cmsg;
+	struct timespec ts;
+	struct msghdr msg;
+	struct iovec iov;
+	int collected=0;
+
+	while(1) {
+		iov.iov_base=data;
+		iov.iov_len=sizeof(data);
+
+		memset(&msg,0,sizeof(msg));
+		msg.msg_iov=&iov;
+		msg.msg_iovlen=1;
+		msg.msg_control=control.buf;
+		msg.msg_controllen=sizeof(control.buf);
+
+		if(recvmsg(descriptor,&msg,MSG_ERRQUEUE | MSG_DONTWAIT)<0) {
+			if(errno==EAGAIN || errno==EWOULDBLOCK) {
+				break;
+			} else if(errno==EINTR) {
+				continue;
+			}
+			return ERR_LAMPTS_RECV;
+		}
+
+		if(!lampTstampFromCmsg(&msg,&ts)) {
+			continue;
+		}
+
+		// The timestamp key is stored inside the extended error, reported with a protocol-dependent level (SOL_IP, SOL_IPV6 or SOL_PACKET)
+		for(cmsg=CMSG_FIRSTHDR(&msg);cmsg!=NULL;cmsg=CMSG_NXTHDR(&msg,cmsg)) {
+			if((cmsg->cmsg_level==SOL_IP && cmsg->cmsg_type==IP_RECVERR) || (cmsg->cmsg_level==SOL_IPV6 && cmsg->cmsg_type==IPV6_RECVERR) ||
+				(cmsg->cmsg_level==SOL_PACKET && cmsg->cmsg_type==PACKET_TX_TIMESTAMP)) {
+				serr=(struct sock_extended_err *) CMSG_DATA(cmsg);
+
+				if(serr->ee_errno!=ENOMSG || serr->ee_origin!=SO_EE_ORIGIN_TIMESTAMPING || serr->ee_info!=SCM_TSTAMP_SND) {
+					continue;
+				}
+
+				slot=&txts->slots[serr->ee_data % LAMP_TXTSTAMP_SLOTS];
+
+				if(slot->key==serr->ee_data && slot->registered) {
+					slot->ts=ts;
+					slot->stamped=true;
+					collected++;
+				}
+			}
+		}
+	}
+
+	return collected;
+}
+
+/**
+	\brief Get the TX timestamp of a LaMP packet
+
+	This function looks for the most recent packet with sequence number _seq_, among the ones registered with lampTxTstampRegister(),
+	and it returns its TX timestamp, if it was already collected with lampTxTstampCollect().
+
+	\param[in]	txts 	Pointer to the [struct lamptxtstamps](\ref lamptxtstamps) tracking the packets transmitted over the socket.
+	\param[in]	seq 	LaMP sequence number (host byte order).
+	\param[out]	ts 		Pointer to the _struct timespec_ in which the TX timestamp is stored.
+
+	\return _true_ if the TX timestamp of the packet is available, _false_ otherwise (_ts_ is left untouched).
+**/
+bool lampTxTstampGet(struct lamptxtstamps *txts, uint16_t seq, struct timespec *ts) {
+	struct lamptxslot *slot;
+	unsigned int i;
+
+	// Start from the last registered packet, as the most recent ones are the most likely to be looked for
+	for(i=1;i<=LAMP_TXTSTAMP_SLOTS;i++) {
+		slot=&txts->slots[(txts->next_key-i) % LAMP_TXTSTAMP_SLOTS];
+
+		if(slot->registered && slot->seq==seq) {
+			if(slot->stamped) {
+				*ts=slot->ts;
+				return true;
+			}
+			return false;
+		}
+	}
+
+	return false;
+}
+
+/**
+	\brief Fill in a follow-up data message with the delta between two kernel timestamps
+
+	This function stores (with a nanosecond resolution, in the nanosecond mode, see [struct lampclock](\ref lampclock)), inside the timestamp fields of a LaMP header with type [CTRL_FOLLOWUP_DATA](\ref CTRL_FOLLOWUP_DATA), the delta between the
+	transmission of a reply (_txts_) and the reception of the corresponding request (_rxts_), and it sets the "payload length or packet type" field to
+	the follow-up request type describing how the timestamps were obtained. The header should have the same identifier and sequence number of the reply.
+
+	As lampHeadSetConnType() does, this function has no effect if the header does not carry a "FOLLOWUP_DATA" packet type.
+
+	\note Like all the other functions inside the Rawsock library, it already takes care of byte ordering.
+
+	\param[in,out]	followupLampHeader 	Pointer to the LaMP header structure, already populated by lampHeadPopulate().
+	\param[in]		followup_type 		Follow-up request type (e.g. [FOLLOWUP_REQUEST_T_KRN](\ref FOLLOWUP_REQUEST_T_KRN)).
+	\param[in]		rxts 				Reception timestamp of the request.
+	\param[in]		txts 				Transmission timestamp of the reply.
+	\param[in]		lclk 				Pointer to the clock of the session (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return None.
+**/
+void lampHeadSetFollowupData(struct lamphdr *followupLampHeader, uint16_t followup_type, struct timespec *rxts, struct timespec *txts, const struct lampclock *lclk) {
+	int64_t deltans;
+
+	if(followupLampHeader->ctrl!=CTRL_FOLLOWUP_DATA) {
+		return;
+	}
+
+	deltans=(int64_t) (txts->tv_sec-rxts->tv_sec)*1000000000LL+(txts->tv_nsec-rxts->tv_nsec);
+	if(deltans<0) {
+		deltans=0;
+	}
+
+	followupLampHeader->len=htons(followup_type);
+	followupLampHeader->sec=hton64((uint64_t) (deltans/1000000000LL));
+	followupLampHeader->usec=hton64((uint64_t) (lampClockGet(lclk)->nsec ? deltans%1000000000LL : (deltans%1000000000LL)/1000));
+}
+
+/**
+	\brief Extract relevant data from a LaMP packet
+
+	This function can be used to extract all the relevant data, already converted to host byte order, from a LaMP packet.
+
+	The function takes as input the pointer to the LaMP packet (i.e. to a memory area where a _struct lamphdr_, **plus the payload**, is stored).
+
+	\param[in]		lampPacket 		Pointer to the LaMP packet buffer (with type [byte_t](\ref byte_t)).
+	\param[out]		id 				Identification field (LaMP ID) value.
+	\param[out]		seq 			Current sequence number inside the header.
+	\param[out]		len  			Value stored inside the "length or INIT type" field.
+	\param[out]     timestamp 		_struct timeval_ which is filled using the timestamp stored inside the LaMP header, interpreted according to the process default clock (see lampSetClock()) and truncated to microseconds in the nanosecond mode: lampHeadGetTimestamp() should be used to get the full resolution, or to read a timestamp with the clock of a specific session.
+	\param[out]		payload 		If this pointer is non-NULL, it should be related to a memory area big enough to contain a possible LaMP payload. Then, the function will copy the payload contained inside the LaMP packet buffer to that memory area. Il the length field is **0** (or NULL is specified), no copy operation will be performed.
+
+	\return None.
+**/
+void lampHeadGetData(byte_t *lampPacket, lamptype_t *type, unsigned short *id, unsigned short *seq, unsigned short *len, struct timeval *timestamp, byte_t *payload) {
+	struct lamphdr *lampHeader=(struct lamphdr *) lampPacket;
+	byte_t *payloadptr=(lampPacket+LAMP_HDR_SIZE());
+
+	if(type) *type=(lampHeader->ctrl) & 0x0F;
+	if(id) *id=ntohs(lampHeader->id);
+	if(seq) *seq=ntohs(lampHeader->seq);
+	if(len) *len=ntohs(lampHeader->len);
+	if(timestamp) {
+		timestamp->tv_sec=(time_t) ntoh64(lampHeader->sec);
+		timestamp->tv_usec=(suseconds_t) (lampdefclk.nsec ? ntoh64(lampHeader->usec)/1000 : ntoh64(lampHeader->usec));
+	}
+
+	if(payload && lampHeader->len!=0x00) {
+		memcpy(payload,payloadptr,ntohs(lampHeader->len));
+	}
+}
+
+/**
+	\brief Get the timestamp stored inside a LaMP header
+
+	This function returns the timestamp stored inside a LaMP header (for instance a received one), with the full resolution
+	available: nanoseconds in the nanosecond mode (see [struct lampclock](\ref lampclock)), microseconds otherwise.
+
+	\param[in]		lampHeader 		Pointer to the LaMP header structure.
+	\param[out]		ts 				Pointer to the _struct timespec_ in which the timestamp is stored.
+	\param[in]		lclk 			Pointer to the clock of the session the packet belongs to (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return None.
+**/
+void lampHeadGetTimestamp(struct lamphdr *lampHeader, struct timespec *ts, const struct lampclock *lclk) {
+	ts->tv_sec=(time_t) ntoh64(lampHeader->sec);
+	ts->tv_nsec=(long) (lampClockGet(lclk)->nsec ? ntoh64(lampHeader->usec) : ntoh64(lampHeader->usec)*1000);
+}
+
+/**
+	\brief Initialize a LaMP session clock
+
+	This function initializes a [struct lampclock](\ref lampclock), selecting the clock used to timestamp the packets of a session, when no custom
+	timestamp is specified, and the resolution of its timestamps.
+
+	If _nsec_ is _true_, the nanosecond mode is enabled: the "usec" field of the LaMP headers carries nanoseconds instead of microseconds,
+	both when setting and when reading the timestamps (see lampHeadSetTimestampTs() and lampHeadGetTimestamp()).
+	The nanosecond mode should be enabled only after both sides agreed on it, through the [INIT_FLAG_NSEC](\ref INIT_FLAG_NSEC) flag of the INIT packet.
+
+	\note The [struct rsclock](\ref rsclock) is not copied, and it should stay valid as long as the session clock is used.
+
+	\param[out]	lclk 	Pointer to the [struct lampclock](\ref lampclock) to be initialized.
+	\param[in]	clk 	Pointer to a [struct rsclock](\ref rsclock), initialized with rsclockInit() or rsclockInitTsc(), or NULL to use _CLOCK_REALTIME_.
+	\param[in]	nsec 	_true_ to enable the nanosecond mode, _false_ to use microseconds.
+
+	\return None.
+**/
+void lampClockInit(struct lampclock *lclk, const struct rsclock *clk, bool nsec) {
+	lclk->clk=clk;
+	lclk->nsec=nsec;
+}
+
+/**
+	\brief Select the process default clock and resolution of the LaMP timestamps
+
+	This function works like lampClockInit(), but it sets the process default clock, used by the functions without a clock parameter (such as
+	lampHeadSetTimestamp(), lampHeadSetTimestampCsum(), lampHeadGetData() and the [rawLampSend*()](\ref rawLampSend) functions) and by the
+	functions taking a [struct lampclock](\ref lampclock) when NULL is passed. By default, _CLOCK_REALTIME_ is used, with microseconds.
+
+	\warning The setting is global to the whole process, and it is not thread-safe: it should be changed only when no other thread is
+	sending or receiving LaMP packets. A process handling several sessions, which may have negotiated different modes (e.g. a server),
+	should instead keep a [struct lampclock](\ref lampclock) per session.
+
+	\param[in]	clk 	Pointer to a [struct rsclock](\ref rsclock), initialized with rsclockInit() or rsclockInitTsc(), or NULL to use _CLOCK_REALTIME_.
+	\param[in]	nsec 	_true_ to enable the nanosecond mode, _false_ to use microseconds (default).
+
+	\return None.
+**/
+void lampSetClock(const struct rsclock *clk, bool nsec) {
+	lampClockInit(&lampdefclk,clk,nsec);
+}
+
+/**
+	\brief Record the latency of a received LaMP packet inside a histogram
+
+	This function computes the latency of a received LaMP packet, as the difference between its reception timestamp and the timestamp
+	stored inside its header, and it records it inside a [struct lathist](\ref lathist):
+	- for ping-like replies (and end replies), which carry the timestamp of the corresponding request, it is the round-trip time
+	- for unidirectional packets, it is the one-way delay (meaningful only if the clocks of the two devices are synchronized)
+
+	Any other packet (including timestampless replies) is ignored. The timestamp resolution (microseconds or nanoseconds) is the one
+	of the session clock _lclk_.
+
+	\param[in,out]	hist 		Pointer to the [struct lathist](\ref lathist), owned by the calling thread.
+	\param[in]		lampHeader 	Pointer to the LaMP header of the received packet.
+	\param[in]		rxts 		Reception timestamp of the packet (e.g. obtained with lampRecvTstamp()), or NULL to use the current time (read from _lclk_).
+	\param[in]		lclk 		Pointer to the clock of the session the packet belongs to (see lampClockInit()), or NULL to use the process default one (see lampSetClock()).
+
+	\return _true_ if the latency was recorded, _false_ if the packet does not carry a timestamp or if the latency is negative (e.g. because of unsynchronized clocks).
+**/
+bool lampHistRecord(struct lathist *hist, struct lamphdr *lampHeader, struct timespec *rxts, const struct lampclock *lclk) {
+	struct timespec txts, now;
+	int64_t latency;
+
+	if(lampHeader->ctrl!=CTRL_PINGLIKE_REPLY && lampHeader->ctrl!=CTRL_PINGLIKE_ENDREPLY && !IS_UNIDIR(lampHeader->ctrl)) {
+		return false;
+	}
+
+	if(rxts==NULL) {
+		lampNow(lampClockGet(lclk),&now);
+		rxts=&now;
+	}
+
+	lampHeadGetTimestamp(lampHeader,&txts,lclk);
+	latency=(int64_t) (rxts->tv_sec-txts.tv_sec)*1000000000LL+(rxts->tv_nsec-txts.tv_nsec);
+
+	if(latency<0) {
+		return false;
+	}
+
+	lathistRecord(hist,(uint64_t) latency);
+
+	return true;
+}
+
+// Shift the sequence window bitmap by 'n' positions (i.e. make room for 'n' newer sequence numbers)
+static inline void lampSeqWinShift(uint64_t *window, unsigned int n) {
+	unsigned int words=n/64, bits=n%64;
+	uint64_t val;
+	int i;
+
+	if(n>=LAMP_SEQWIN_BITS) {
+		memset(window,0,LAMP_SEQWIN_WORDS*sizeof(uint64_t));
+		return;
+	}
+
+	for(i=LAMP_SEQWIN_WORDS-1;i>=0;i--) {
+		val=i>=(int) words ? window[i-words] : 0;
+
+		if(bits!=0) {
+			val<<=bits;
+
+			if(i-(int) words-1>=0) {
+				val|=window[i-words-1] >> (64-bits);
+			}
+		}
+
+		window[i]=val;
+	}
+}
+
+// Get the slot of the hash table in which the search for 'id' should start (Fibonacci hashing)
+static inline unsigned int lampSeqTableSlot(struct lampseqtable *table, uint16_t id) {
+	return (unsigned int) (((uint32_t) id*2654435769U) >> table->shift);
+}
+
+/**
+	\brief Initialize a [struct lampseqwin](\ref lampseqwin)
+
+	\param[out]	win 	Pointer to the [struct lampseqwin](\ref lampseqwin) to be initialized.
+	\param[in]	id 		LaMP identifier of the session (only stored for reference).
+
+	\return None.
+**/
+void lampSeqWinInit(struct lampseqwin *win, uint16_t id) {
+	memset(win,0,sizeof(struct lampseqwin));
+	win->id=id;
+	win->flags=LAMPSEQ_F_USED;
+}
+
+/**
+	\brief Update a sequence window with a received sequence number
+
+	This function classifies a received sequence number with respect to the ones already received within the same session, and it updates
+	the counters of the window, in constant time. The wraparound of the 16-bit sequence numbers is taken into account by considering as newer
+	any sequence number which is less than 32768 steps ahead of the highest received one (serial number arithmetic).
+
+	When a sequence number is skipped, the missing packets are immediately counted as lost: if one of them is then received, as long
+	as it is still within the window (i.e. less than [LAMP_SEQWIN_BITS](\ref LAMP_SEQWIN_BITS) packets older than the highest received one), it
+	is counted as reordered and no longer as lost.
+
+	\param[in,out]	win 	Pointer to the [struct lampseqwin](\ref lampseqwin) of the session.
+	\param[in]		seq 	Received sequence number (host byte order).
+
+	\return The classification of the received packet (see [lampseq_t](\ref lampseq_t)).
+**/
+lampseq_t lampSeqWinUpdate(struct lampseqwin *win, uint16_t seq) {
+	int16_t delta;
+	unsigned int back;
+
+	if(!(win->flags & LAMPSEQ_F_STARTED)) {
+		win->flags|=LAMPSEQ_F_STARTED;
+		win->highest=seq;
+		win->window[0]=1;
+		win->received++;
+
+		return LAMPSEQ_NEW;
+	}
+
+	delta=(int16_t) (uint16_t) (seq-win->highest);
+
+	if(delta>0) {
+		lampSeqWinShift(win->window,delta);
+		win->window[0]|=1;
+		win->highest=seq;
+		win->lost+=delta-1;
+		win->received++;
+
+		return LAMPSEQ_NEW;
+	}
+
+	if(delta==0) {
+		win->duplicated++;
+
+		return LAMPSEQ_DUPLICATE;
+	}
+
+	back=(unsigned int) -(int) delta;
+
+	if(back>=LAMP_SEQWIN_BITS) {
+		win->late++;
+
+		return LAMPSEQ_LATE;
+	}
+
+	if(win->window[back/64] & (1ULL << (back%64))) {
+		win->duplicated++;
+
+		return LAMPSEQ_DUPLICATE;
+	}
+
+	win->window[back/64]|=1ULL << (back%64);
+	win->lost--;
+	win->reordered++;
+	win->received++;
+
+	return LAMPSEQ_REORDERED;
+}
+
+/**
+	\brief Allocate a [struct lampseqtable](\ref lampseqtable)
+
+	This function allocates a hash table able to track up to _size_ concurrent LaMP sessions (64 _bytes_ each), and it initializes it.
+
+	\param[out]	table 	Pointer to the [struct lampseqtable](\ref lampseqtable) to be initialized.
+	\param[in]	size 	Number of slots of the table (power of two, at least **2**): it should be larger than the maximum number of concurrent sessions, to keep the lookups short.
+
+	\return **0** if the table was properly allocated, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LAMPSEQ_SIZE* -> _size_ is not a power of two
+	- *ERR_LAMPSEQ_ALLOC* -> unable to allocate the memory for the table
+**/
+rawsockerr_t lampSeqTablePrepare(struct lampseqtable *table, unsigned int size) {
+	struct lampseqwin *wins;
+	rawsockerr_t ret;
+
+	if(size<2 || (size & (size-1))!=0) {
+		return ERR_LAMPSEQ_SIZE;
+	}
+
+	wins=aligned_alloc(sizeof(struct lampseqwin),size*sizeof(struct lampseqwin));
+	if(wins==NULL) {
+		return ERR_LAMPSEQ_ALLOC;
+	}
+
+	if((ret=lampSeqTableInit(table,wins,size))!=0) {
+		free(wins);
+		return ret;
+	}
+
+	table->allocated=true;
+
+	return 0;
+}
+
+/**
+	\brief Initialize a [struct lampseqtable](\ref lampseqtable) over an already existing array
+
+	This function works like lampSeqTablePrepare(), but instead of allocating the slots, it uses the array specified by the user
+	(for instance a static array). The array is never freed by lampSeqTableFree() when this function is used.
+
+	\param[out]	table 	Pointer to the [struct lampseqtable](\ref lampseqtable) to be initialized.
+	\param[in]	wins 	Array of _size_ [struct lampseqwin](\ref lampseqwin).
+	\param[in]	size 	Number of elements of _wins_ (power of two, at least **2**).
+
+	\return **0** if the table was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LAMPSEQ_SIZE* -> _size_ is not a power of two
+**/
+rawsockerr_t lampSeqTableInit(struct lampseqtable *table, struct lampseqwin *wins, unsigned int size) {
+	if(size<2 || (size & (size-1))!=0) {
+		return ERR_LAMPSEQ_SIZE;
+	}
+
+	memset(wins,0,size*sizeof(struct lampseqwin));
+
+	table->wins=wins;
+	table->size=size;
+	table->shift=32-__builtin_ctz(size);
+	table->nsessions=0;
+	table->allocated=false;
+
+	return 0;
+}
+
+/**
+	\brief Free a [struct lampseqtable](\ref lampseqtable)
+
+	Frees the slots of the specified table, only if they were allocated by lampSeqTablePrepare().
+
+	\param[in]	table 	Pointer to the [struct lampseqtable](\ref lampseqtable).
+
+	\return None.
+**/
+void lampSeqTableFree(struct lampseqtable *table) {
+	if(table->allocated) {
+		free(table->wins);
+	}
+
+	table->wins=NULL;
+	table->size=0;
+	table->nsessions=0;
+	table->allocated=false;
+}
+
+/**
+	\brief Look for the sequence window of a session
+
+	\param[in]	table 	Pointer to the [struct lampseqtable](\ref lampseqtable).
+	\param[in]	id 		LaMP identifier of the session.
+
+	\return Pointer to the [struct lampseqwin](\ref lampseqwin) of the session, or NULL if no packet of the session was received yet.
+**/
+struct lampseqwin *lampSeqTableLookup(struct lampseqtable *table, uint16_t id) {
+	unsigned int slot=lampSeqTableSlot(table,id), i;
+
+	// Linear probing: the search stops at the first free slot
+	for(i=0;i<table->size;i++,slot=(slot+1) & (table->size-1)) {
+		if(!(table->wins[slot].flags & LAMPSEQ_F_USED)) {
+			return NULL;
+		}
+
+		if(table->wins[slot].id==id) {
+			return &table->wins[slot];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+	\brief Update the sequence window of a session with a received LaMP packet
+
+	This function looks for the session of the received packet (adding it to the table, if it is a new one), and it updates its
+	sequence window with lampSeqWinUpdate().
+
+	\param[in,out]	table 		Pointer to the [struct lampseqtable](\ref lampseqtable).
+	\param[in]		lampHeader 	Pointer to the LaMP header of the received packet.
+
+	\return The classification of the received packet (see [lampseq_t](\ref lampseq_t)), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_LAMPSEQ_FULL* -> the packet belongs to a new session, but there is no free slot left inside the table
+**/
+int lampSeqTableUpdate(struct lampseqtable *table, struct lamphdr *lampHeader) {
+	uint16_t id=ntohs(lampHeader->id);
+	unsigned int slot=lampSeqTableSlot(table,id), i;
+	struct lampseqwin *win;
+
+	for(i=0;i<table->size;i++,slot=(slot+1) & (table->size-1)) {
+		win=&table->wins[slot];
+
+		if(!(win->flags & LAMPSEQ_F_USED)) {
+			lampSeqWinInit(win,id);
+			table->nsessions++;
+			break;
+		}
+
+		if(win->id==id) {
+			break;
+		}
+	}
+
+	if(i==table->size) {
+		return ERR_LAMPSEQ_FULL;
+	}
+
+	return lampSeqWinUpdate(win,ntohs(lampHeader->seq));
+}
+
+/**
+	\brief Remove a session from a [struct lampseqtable](\ref lampseqtable)
+
+	This function frees the slot of a session (e.g. after its end packet was received), so that it can be reused by a new one.
+	Any pointer to the windows stored inside the table, returned by lampSeqTableLookup(), should be considered invalid after calling this function.
+
+	\param[in,out]	table 	Pointer to the [struct lampseqtable](\ref lampseqtable).
+	\param[in]		id 		LaMP identifier of the session to be removed.
+
+	\return None.
+**/
+void lampSeqTableRemove(struct lampseqtable *table, uint16_t id) {
+	struct lampseqwin *win=lampSeqTableLookup(table,id);
+	unsigned int hole, slot, home, mask=table->size-1;
+
+	if(win==NULL) {
+		return;
+	}
+
+	hole=win-table->wins;
+	table->nsessions--;
+
+	// Backward shift deletion: move back any following entry which would no longer be reachable from its home slot, so that no tombstone is needed
+	for(slot=(hole+1) & mask;table->wins[slot].flags & LAMPSEQ_F_USED;slot=(slot+1) & mask) {
+		home=lampSeqTableSlot(table,table->wins[slot].id);
+
+		if(((slot-home) & mask)>=((slot-hole) & mask)) {
+			table->wins[hole]=table->wins[slot];
+			hole=slot;
+		}
+	}
+
+	memset(&table->wins[hole],0,sizeof(struct lampseqwin));
 }
 
 /**
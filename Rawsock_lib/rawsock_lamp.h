@@ -8,6 +8,84 @@
 	This file uses rawsock.h, but it is not included within the main module, allowing the user to include the Rawsock library
 	without forcing him/her to include also the LaMP module, if he/she does not need it.
 
+	Kernel timestamps (software or hardware, see _SO_TIMESTAMPING_) can be used instead of application-level ones, both on raw and on UDP sockets:
+	lampTimestampingEnable() turns them on, lampRecvTstamp() receives a packet together with its reception timestamp and
+	a [struct lamptxtstamps](\ref lamptxtstamps) collects the transmission timestamps from the socket error queue, matching them to the LaMP sequence numbers.
+	The resulting delta between the reception of a request and the transmission of the corresponding reply can then be sent inside a
+	follow-up data message, with lampHeadSetFollowupData().
+
+	__Example of use (ping-like server, LaMP over UDP socket):__
+
+		struct lamptxtstamps txts;
+		struct timespec rxts, txts_reply;
+
+		lampTimestampingEnable(sFd,NULL,FOLLOWUP_REQUEST_T_KRN);
+		lampTxTstampInit(&txts);
+
+		while(...) {
+			lampRecvTstamp(sFd,packet,sizeof(packet),0,&rxts);
+			... // Send the reply
+			lampTxTstampRegister(&txts,replyLampHeader);
+
+			lampTxTstampCollect(sFd,&txts);
+			if(lampTxTstampGet(&txts,seq,&txts_reply)) {
+				lampHeadPopulate(&followupLampHeader,CTRL_FOLLOWUP_DATA,id,seq);
+				lampHeadSetFollowupData(&followupLampHeader,FOLLOWUP_REQUEST_T_KRN,&rxts,&txts_reply,NULL);
+				... // Send the follow-up
+			}
+		}
+
+	By default, the timestamps are taken from _CLOCK_REALTIME_ and carried with a microsecond resolution. A [struct lampclock](\ref lampclock),
+	initialized with lampClockInit(), allows to select any [struct rsclock](\ref rsclock) (e.g. a calibrated TSC, which is much cheaper to read) and,
+	if both sides agreed on it, to switch to the nanosecond mode, in which the "usec" field of the LaMP header carries nanoseconds instead of microseconds.
+	The nanosecond mode is negotiated by setting the [INIT_FLAG_NSEC](\ref INIT_FLAG_NSEC) flag inside the INIT packet: a receiver not supporting it will
+	see an invalid INIT type (see [IS_INIT_INDEX_VALID](\ref IS_INIT_INDEX_VALID)) and refuse the connection, so that the client can retry without the flag.
+
+	As the mode is negotiated by each client, a server should keep one [struct lampclock](\ref lampclock) per session, and pass it to the functions
+	reading or writing the timestamps (lampHeadGetTimestamp(), lampHistRecord(), lampHeadSetFollowupData() and lampHeadSetTimestampTs()), as well as
+	to the raw send functions setting them (rawLampSendClk(), rawLampSendIncr(), rawLampSendBatch(), rawLampSendTxring() and their variants).
+	The functions without a clock parameter (i.e. rawLampSend() and lampHeadGetData()), as well as the previous ones when NULL is passed, use instead
+	the process default clock, selected with lampSetClock().
+
+		// Client
+		rsclockInitTsc(&clk,CLOCKSRC_REALTIME,RSCLOCK_CALIB_MS);
+		lampHeadPopulate(&lampHeader,CTRL_CONN_INIT,id,0);
+		lampHeadSetConnType(&lampHeader,INIT_PINGLIKE_INDEX | INIT_FLAG_NSEC);
+		... // Send the INIT and wait for the ACK
+		lampSetClock(&clk,true); // Used by the rawLampSend*() functions, when NULL is passed as clock
+
+		// Server, after receiving the INIT of a new session
+		if(IS_INIT_INDEX_VALID(INIT_GET_INDEX(len))) {
+			lampClockInit(&session->lclk,&clk,IS_INIT_NSEC(len));
+			... // Send the ACK
+		}
+
+		// Server, for each packet of the session
+		lampHistRecord(&hist,lampHeader,&rxts,&session->lclk);
+
+	Every raw send function has a _Txtime_ variant (e.g. rawLampSendTxtime(), rawLampSendBatchTxtime() and rawLampSendTxringTxtime()), taking the launch time
+	of each packet: once _SO_TXTIME_ is enabled with rawTxtimeEnable() and an _etf_ qdisc is configured on the interface, the packets can be queued
+	in advance and are put on the wire by the kernel at the requested instants. Each _Txtime_ variant returns the same values as the function it derives from:
+	rawLampSend(), rawLampSendClk(), rawLampSendIncr() and their _Txtime_ variants return **1** when the packet was successfully sent and **0** otherwise.
+
+	On the receiving side, a [struct lampseqtable](\ref lampseqtable) keeps, for each LaMP session (i.e. for each LaMP identifier), a sliding window
+	over the last received sequence numbers, taking into account their wraparound, in order to count the lost, duplicated, reordered and late packets
+	in constant time. Each session takes exactly one cache line, so that thousands of concurrent sessions can be tracked without leaving the L2 cache.
+
+		struct lampseqtable seqtable;
+
+		lampSeqTablePrepare(&seqtable,1024); // Up to 1024 concurrent sessions
+
+		while(...) {
+			... // Receive a LaMP packet
+			lampSeqTableUpdate(&seqtable,lampHeader);
+		}
+
+		win=lampSeqTableLookup(&seqtable,id); // NULL if no packet was received from session 'id'
+		printf("Received: %u, lost: %u, duplicated: %u\n",win->received,win->lost,win->duplicated);
+
+		lampSeqTableFree(&seqtable);
+
 	The version number of this module is set to be the same as the main Rawsock library version number.
 
 	\version 0.3.4
@@ -18,6 +96,9 @@
 #define RAWSOCK_LAMP_H_INCLUDED
 
 #include "rawsock.h"
+#include "rawsock_ring.h"
+#include "rawsock_clock.h"
+#include "rawsock_hist.h"
 #include <linux/if_packet.h>
 #include <sys/time.h>
 
@@ -63,6 +144,10 @@
 
 #define INIT_PINGLIKE_INDEX 0x0001 /**< **INIT type field value**: ping-like. */
 #define INIT_UNIDIR_INDEX 0x0002 /**< **INIT type field value**: undirectional. */
+#define INIT_FLAG_NSEC 0x0100 /**< **INIT type flag**: to be ORed to the INIT type field value, it requests the nanosecond mode, in which the "usec" timestamp field carries nanoseconds (see [struct lampclock](\ref lampclock)). */
+#define INIT_INDEX_MASK 0x00FF /**< **INIT type field mask**: mask selecting the INIT type index, without the flags (such as [INIT_FLAG_NSEC](\ref INIT_FLAG_NSEC)). */
+#define INIT_GET_INDEX(field) ((field) & INIT_INDEX_MASK) /**< **INIT type macro**: it returns the INIT type index stored inside a (host byte order) "payload length or packet type" field of an INIT packet, without the flags. */
+#define IS_INIT_NSEC(field) (((field) & INIT_FLAG_NSEC)==INIT_FLAG_NSEC) /**< **LaMP Test macro**: checks if the (host byte order) "payload length or packet type" field of an INIT packet requests the nanosecond mode. */
 
 #define IS_INIT_INDEX_VALID(idx) (idx == INIT_PINGLIKE_INDEX || idx == INIT_UNIDIR_INDEX) /**< **LaMP Test macro**: checks whether the given INIT type field value (which can be extracted, for instance, from a received LaMP header and specified as _idx_) is valid or not. */
 #define IS_INIT(ctrl) (ctrl == CTRL_CONN_INIT) /**< **LaMP Test macro**: checks if the given control field value (specified as _ctrl_) is corresponding to "Connection INIT". */
@@ -135,6 +220,95 @@ typedef enum {
 	FLG_NONE /**< Flag **NONE**: the user does not want/need to specify any flag to rawLampSend() */
 } endflag_t;
 
+/**
+	\brief LaMP session clock
+
+	Structure describing the clock and the timestamp resolution used within a LaMP session, initialized with lampClockInit().
+	Each session should have its own [struct lampclock](\ref lampclock), as the nanosecond mode is negotiated separately by each client.
+**/
+struct lampclock {
+	const struct rsclock *clk; /**< Clock used to read the current time, or NULL to use _CLOCK_REALTIME_. */
+	bool nsec; /**< _true_ if the "usec" timestamp field carries nanoseconds (nanosecond mode). */
+};
+
+#define LAMP_TXTSTAMP_SLOTS 256 /**< Number of transmitted packets whose kernel TX timestamp can be kept inside a [struct lamptxtstamps](\ref lamptxtstamps), waiting to be retrieved with lampTxTstampGet(). */
+
+/**
+	\brief LaMP TX timestamp slot
+
+	Structure describing a packet transmitted over a socket with TX timestamps enabled, inside a [struct lamptxtstamps](\ref lamptxtstamps).
+**/
+struct lamptxslot {
+	uint32_t key; /**< Timestamp key (_SOF_TIMESTAMPING_OPT_ID_ counter) assigned by the kernel to the packet. */
+	uint16_t seq; /**< LaMP sequence number of the packet (host byte order). */
+	bool registered; /**< _true_ if the slot describes a packet registered with lampTxTstampRegister(). */
+	bool stamped; /**< _true_ if the TX timestamp of the packet was received. */
+	struct timespec ts; /**< Kernel TX timestamp (valid only if _stamped_ is _true_). */
+};
+
+/**
+	\brief LaMP TX timestamps tracker
+
+	Structure used to match the TX timestamps reported by the kernel, through the socket error queue, to the LaMP sequence numbers
+	of the transmitted packets. It should be initialized with lampTxTstampInit(), just after enabling the TX timestamps with lampTimestampingEnable().
+	Its fields should not be modified directly by the user.
+**/
+struct lamptxtstamps {
+	uint32_t next_key; /**< Key which will be assigned by the kernel to the next transmitted packet. */
+	struct lamptxslot slots[LAMP_TXTSTAMP_SLOTS]; /**< Last transmitted packets, indexed by key. */
+};
+
+#define LAMP_SEQWIN_WORDS 4 /**< Number of 64-bit words of the sequence window bitmap inside a [struct lampseqwin](\ref lampseqwin). */
+#define LAMP_SEQWIN_BITS (LAMP_SEQWIN_WORDS*64) /**< Size of the sequence window (i.e. maximum reordering distance, in packets, which is detected as such): older packets are counted as late. */
+
+/**
+	\brief LaMP sequence number classification
+
+	Classification of a received packet, returned by lampSeqWinUpdate() and lampSeqTableUpdate().
+**/
+typedef enum {
+	LAMPSEQ_NEW, /**< New highest sequence number (in order, or after a gap: the missing packets are counted as lost) */
+	LAMPSEQ_DUPLICATE, /**< Duplicated packet (already received, within the window) */
+	LAMPSEQ_REORDERED, /**< Packet older than the highest received one, but not received yet and still within the window (it is no longer counted as lost) */
+	LAMPSEQ_LATE /**< Packet older than the window: it cannot be told apart from an old duplicate, and it remains counted as lost */
+} lampseq_t;
+
+/**
+	\brief LaMP sequence window
+
+	Structure tracking the sequence numbers received within a LaMP session, with a sliding bitmap of the last [LAMP_SEQWIN_BITS](\ref LAMP_SEQWIN_BITS)
+	sequence numbers, up to the highest received one. The structure takes exactly one cache line (64 _bytes_).
+
+	It can be used alone (see lampSeqWinInit()), or inside a [struct lampseqtable](\ref lampseqtable). Its counters can be read directly
+	by the user, but they should not be modified.
+**/
+struct lampseqwin {
+	uint64_t window[LAMP_SEQWIN_WORDS]; /**< Bitmap of the received sequence numbers: bit _i_ is set if the sequence number _highest-i_ was received. */
+	uint32_t received; /**< Number of received packets (excluding duplicates). */
+	uint32_t lost; /**< Number of lost packets (i.e. missing sequence numbers, not received within the window). */
+	uint32_t duplicated; /**< Number of duplicated packets. */
+	uint32_t reordered; /**< Number of packets received out of order, within the window. */
+	uint32_t late; /**< Number of packets received after leaving the window. */
+	uint16_t id; /**< LaMP identifier of the session. */
+	uint16_t highest; /**< Highest received sequence number (taking into account the wraparound). */
+	uint8_t flags; /**< Internal flags. */
+	uint8_t reserved[7]; /**< Padding (up to 64 _bytes_). */
+} __attribute__((aligned(64)));
+
+/**
+	\brief LaMP sequence window table
+
+	Hash table of [struct lampseqwin](\ref lampseqwin), indexed by LaMP identifier, prepared with lampSeqTablePrepare() or lampSeqTableInit().
+	Its fields should not be modified directly by the user.
+**/
+struct lampseqtable {
+	struct lampseqwin *wins; /**< Array of windows (hash table slots). */
+	unsigned int size; /**< Number of slots (power of two). */
+	unsigned int shift; /**< Shift used to compute the slot index from the hash of an identifier. */
+	unsigned int nsessions; /**< Number of sessions currently stored inside the table. */
+	bool allocated; /**< _true_ if the slots were allocated by lampSeqTablePrepare(). */
+};
+
 /**
 	\brief Main LaMP packet header structure.
 
@@ -151,12 +325,28 @@ struct lamphdr {
 	uint16_t seq; /**< Sequence field, 2 B: it is used to store cyclically increasing sequence numbers, up to 65535, that can be used to identify lost packets and to associate replies with requests. */
 	uint16_t len; /**< Payload length or packet type, 2 B: it store the (optional) payload length, up to 65535 B, or, if the message type is INIT or FOLLOWUP, the type of the connection that should be established (pinglike or unidirectional) or the kind of follow-up message. */
 	uint64_t sec; /**< 64-bit seconds timestamp, 8 B: it stores the seconds of the current packet timestamp. */
-	uint64_t usec; /**< 64-bit microseconds timestamp, 8 B: it stores the microseconds of the current packet timestamp. */
+	uint64_t usec; /**< 64-bit microseconds timestamp, 8 B: it stores the microseconds of the current packet timestamp (or the nanoseconds, in the nanosecond mode, see [struct lampclock](\ref lampclock)). */
 };
 
 void lampHeadPopulate(struct lamphdr *lampHeader, unsigned char ctrl, unsigned short id, unsigned short seq);
 void lampHeadSetTimestamp(struct lamphdr *lampHeader, struct timeval *tStampPtr); // Sets the LaMP header timestamp (specify NULL as struct timeval *tStampPtr to use the current time instead of a custom timestamp) -> to be used with non-raw sockets, in which rawLampSend() cannot be used
+void lampHeadSetTimestampCsum(struct lamphdr *lampHeader, struct timeval *tStampPtr, csum16_t *csum); // Like lampHeadSetTimestamp(), but it also incrementally updates the checksum pointed by 'csum' (if non-NULL)
+void lampHeadSetTimestampTs(struct lamphdr *lampHeader, struct timespec *tStampPtr, csum16_t *csum, const struct lampclock *lclk); // Like lampHeadSetTimestampCsum(), but it takes a struct timespec, keeping the nanoseconds in the nanosecond mode
+void lampHeadGetTimestamp(struct lamphdr *lampHeader, struct timespec *ts, const struct lampclock *lclk);
+void lampClockInit(struct lampclock *lclk, const struct rsclock *clk, bool nsec);
+void lampSetClock(const struct rsclock *clk, bool nsec);
+bool lampHistRecord(struct lathist *hist, struct lamphdr *lampHeader, struct timespec *rxts, const struct lampclock *lclk);
+
+void lampSeqWinInit(struct lampseqwin *win, uint16_t id);
+lampseq_t lampSeqWinUpdate(struct lampseqwin *win, uint16_t seq);
+rawsockerr_t lampSeqTablePrepare(struct lampseqtable *table, unsigned int size);
+rawsockerr_t lampSeqTableInit(struct lampseqtable *table, struct lampseqwin *wins, unsigned int size);
+void lampSeqTableFree(struct lampseqtable *table);
+struct lampseqwin *lampSeqTableLookup(struct lampseqtable *table, uint16_t id);
+int lampSeqTableUpdate(struct lampseqtable *table, struct lamphdr *lampHeader);
+void lampSeqTableRemove(struct lampseqtable *table, uint16_t id);
 void lampEncapsulate(byte_t *packet, struct lamphdr *lampHeader, byte_t *data, size_t payloadsize);
+rawsockerr_t lampEncapsulateInPlace(struct framebuf *fb, struct lamphdr *lampHeader, byte_t *data, size_t payloadsize); // Like lampEncapsulate(), but it writes the LaMP packet inside a struct framebuf, computing its checksum during the copy
 void lampSetUnidirStop(struct lamphdr *lampHeader);
 void lampSetPinglikeEndreq(struct lamphdr *lampHeader);
 void lampSetPinglikeEndreqTless(struct lamphdr *lampHeader);
@@ -165,7 +355,28 @@ void lampHeadSetConnType(struct lamphdr *initLampHeader, uint16_t mode_index);
 void lampHeadSetFollowupCtrlType(struct lamphdr *followupLampHeader, uint16_t followup_type);
 
 void lampHeadIncreaseSeq(struct lamphdr *inpacket_headerptr);
+void lampHeadIncreaseSeqCsum(struct lamphdr *inpacket_headerptr, csum16_t *csum);
+void lampFinalize(struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, bool incremental, struct timespec *tstamp, const struct lampclock *lclk);
 int rawLampSend(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot);
+int rawLampSendClk(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+int rawLampSendIncr(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+int rawLampSendBatch(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+int rawLampSendBatchIncr(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+rawsockerr_t rawLampSendTxring(struct txring *ring, struct framebuf *fb, struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+int rawLampSendTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk);
+int rawLampSendIncrTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr *inpacket_headerptr, byte_t *ethernetpacket, size_t finalpacketsize, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk);
+int rawLampSendBatchTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+int rawLampSendBatchIncrTxtime(int descriptor, struct sockaddr_ll addrll, struct lamphdr **inpacket_headerptrs, struct batchframe *frames, unsigned int n, endflag_t end_flag, protocol_t llprot, const struct lampclock *lclk);
+rawsockerr_t rawLampSendTxringTxtime(struct txring *ring, struct framebuf *fb, struct lamphdr *inpacket_headerptr, endflag_t end_flag, protocol_t llprot, uint64_t txtime, const struct lampclock *lclk);
+
+rawsockerr_t lampTimestampingEnable(int descriptor, const char *devname, uint16_t followup_type);
+bool lampTstampFromCmsg(struct msghdr *msg, struct timespec *ts);
+ssize_t lampRecvTstamp(int descriptor, byte_t *buf, size_t len, int flags, struct timespec *rxts);
+void lampTxTstampInit(struct lamptxtstamps *txts);
+void lampTxTstampRegister(struct lamptxtstamps *txts, struct lamphdr *lampHeader);
+int lampTxTstampCollect(int descriptor, struct lamptxtstamps *txts);
+bool lampTxTstampGet(struct lamptxtstamps *txts, uint16_t seq, struct timespec *ts);
+void lampHeadSetFollowupData(struct lamphdr *followupLampHeader, uint16_t followup_type, struct timespec *rxts, struct timespec *txts, const struct lampclock *lclk);
 
 void lampHeadGetData(byte_t *lampPacket, lamptype_t *type, unsigned short *id, unsigned short *seq, unsigned short *len, struct timeval *timestamp, byte_t *payload);
 byte_t *lampGetPacketPointers(byte_t *pktbuf,struct lamphdr **lampHeader);
@@ -0,0 +1,278 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_netlink.h"
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+// Find the interface descriptor with a given index, inside an array of 'n' descriptors
+static struct ifdesc *nlwatchFindIfd(struct ifdesc *ifds, unsigned int n, int ifindex) {
+	unsigned int i;
+
+	for(i=0;i<n;i++) {
+		if(ifds[i].ifindex==ifindex) {
+			return &ifds[i];
+		}
+	}
+
+	return NULL;
+}
+
+// Resolve again an interface descriptor, by name (if this is not possible, the descriptor is kept, without any IPv4 address)
+static void nlwatchResolve(struct ifdesc *ifd) {
+	struct ifdesc resolved;
+
+	if(ifdescResolve(&resolved,ifd->name)==0) {
+		*ifd=resolved;
+	} else {
+		ifd->ip_valid=false;
+	}
+}
+
+// Process an RTM_NEWLINK or RTM_DELLINK message; returns 1 if the descriptor was updated, 0 otherwise
+static int nlwatchLink(struct nlmsghdr *nh, struct ifdesc *ifds, unsigned int n) {
+	struct ifinfomsg *ifi=NLMSG_DATA(nh);
+	struct ifdesc *ifd=nlwatchFindIfd(ifds,n,ifi->ifi_index);
+	struct rtattr *rta;
+	int rtalen;
+
+	if(ifd==NULL) {
+		return 0;
+	}
+
+	if(nh->nlmsg_type==RTM_DELLINK) {
+		ifd->ip_valid=false;
+		return 1;
+	}
+
+	rtalen=IFLA_PAYLOAD(nh);
+	for(rta=IFLA_RTA(ifi);RTA_OK(rta,rtalen);rta=RTA_NEXT(rta,rtalen)) {
+		switch(rta->rta_type) {
+			case IFLA_IFNAME:
+				strncpy(ifd->name,RTA_DATA(rta),IFDESC_NAME_SIZE-1);
+				ifd->name[IFDESC_NAME_SIZE-1]='\0';
+			break;
+
+			case IFLA_ADDRESS:
+				if(RTA_PAYLOAD(rta)==MAC_ADDR_SIZE) {
+					memcpy(ifd->mac,RTA_DATA(rta),MAC_ADDR_SIZE);
+				}
+			break;
+
+			case IFLA_MTU:
+				ifd->mtu=*(unsigned int *) RTA_DATA(rta);
+			break;
+		}
+	}
+
+	return 1;
+}
+
+// Process an RTM_NEWADDR or RTM_DELADDR message; returns 1 if the descriptor was updated, 0 otherwise
+static int nlwatchAddr(struct nlmsghdr *nh, struct ifdesc *ifds, unsigned int n) {
+	struct ifaddrmsg *ifa=NLMSG_DATA(nh);
+	struct ifdesc *ifd=nlwatchFindIfd(ifds,n,ifa->ifa_index);
+	struct rtattr *rta;
+	struct in_addr addr;
+	bool addr_found=false;
+	int rtalen;
+
+	if(ifd==NULL || ifa->ifa_family!=AF_INET) {
+		return 0;
+	}
+
+	// IFA_LOCAL is the address of the interface; IFA_ADDRESS is the same, except on point-to-point links, where it is the peer address
+	rtalen=IFA_PAYLOAD(nh);
+	for(rta=IFA_RTA(ifa);RTA_OK(rta,rtalen);rta=RTA_NEXT(rta,rtalen)) {
+		if(rta->rta_type==IFA_LOCAL || (rta->rta_type==IFA_ADDRESS && !addr_found)) {
+			memcpy(&addr,RTA_DATA(rta),sizeof(addr));
+			addr_found=true;
+		}
+	}
+
+	if(!addr_found) {
+		return 0;
+	}
+
+	if(nh->nlmsg_type==RTM_NEWADDR) {
+		// Secondary addresses never replace the current one
+		if(ifd->ip_valid && ((ifa->ifa_flags & IFA_F_SECONDARY) || ifd->ip.s_addr==addr.s_addr)) {
+			return 0;
+		}
+
+		ifd->ip=addr;
+		ifd->ip_valid=true;
+
+		return 1;
+	}
+
+	if(ifd->ip_valid && ifd->ip.s_addr==addr.s_addr) {
+		// The current address was removed: look for another one (if any)
+		nlwatchResolve(ifd);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Open a netlink listener
+
+	This function opens a _NETLINK_ROUTE_ socket, subscribed to the notifications related to links and IPv4 addresses.
+	The notifications are then read, and applied to the interface descriptors, by nlwatchProcess().
+
+	\param[out]	watch 	Pointer to the [struct nlwatch](\ref nlwatch) to be initialized.
+
+	\return **0** if the listener was properly opened, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_NLWATCH_SOCKET* -> unable to create the netlink socket (_errno_ is set by _socket()_)
+	- *ERR_NLWATCH_BIND* -> unable to subscribe to the notifications (_errno_ is set by _bind()_)
+**/
+rawsockerr_t nlwatchOpen(struct nlwatch *watch) {
+	struct sockaddr_nl sanl;
+
+	watch->descriptor=socket(AF_NETLINK,SOCK_RAW | SOCK_CLOEXEC,NETLINK_ROUTE);
+	if(watch->descriptor<0) {
+		return ERR_NLWATCH_SOCKET;
+	}
+
+	memset(&sanl,0,sizeof(sanl));
+	sanl.nl_family=AF_NETLINK;
+	sanl.nl_groups=RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+
+	if(bind(watch->descriptor,(struct sockaddr *) &sanl,sizeof(sanl))<0) {
+		close(watch->descriptor);
+		watch->descriptor=-1;
+		return ERR_NLWATCH_BIND;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Close a netlink listener
+
+	\param[in]	watch 	Pointer to the [struct nlwatch](\ref nlwatch) to be closed.
+
+	\return None.
+**/
+void nlwatchClose(struct nlwatch *watch) {
+	if(watch->descriptor>=0) {
+		close(watch->descriptor);
+	}
+
+	watch->descriptor=-1;
+}
+
+/**
+	\brief Get the descriptor of a netlink listener
+
+	The returned descriptor can be used inside _poll()_ or _select()_, to know when nlwatchProcess() should be called.
+
+	\param[in]	watch 	Pointer to a [struct nlwatch](\ref nlwatch), opened with nlwatchOpen().
+
+	\return The netlink socket descriptor.
+**/
+int nlwatchGetDescriptor(struct nlwatch *watch) {
+	return watch->descriptor;
+}
+
+/**
+	\brief Apply the pending netlink notifications to a set of interface descriptors
+
+	This function reads all the notifications which were received by the listener, and updates accordingly the name, MAC address, MTU and
+	IPv4 address of the [struct ifdesc](\ref ifdesc) descriptors with a matching interface index. The notifications related to other interfaces are discarded.
+	If no notification is pending, it waits for one, up to _timeout_ milliseconds.
+
+	If some notifications were lost (because they were not read fast enough), all the descriptors are resolved again through ifdescResolve().
+
+	\param[in,out]	watch 		Pointer to a [struct nlwatch](\ref nlwatch), opened with nlwatchOpen().
+	\param[in,out]	ifds 		Array of interface descriptors, filled in with ifdescResolve().
+	\param[in]		n 			Number of elements of _ifds_.
+	\param[in]		timeout 	Maximum time to wait for a notification, in _milliseconds_ (**-1** to wait indefinitely, **0** to return immediately).
+
+	\return The number of notifications which caused an update of the descriptors (**0** if nothing changed), or, in case of error,
+	a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_NLWATCH_RECV* -> error while reading the notifications (_errno_ is set by _recv()_)
+	- *ERR_NLWATCH_POLL* -> error while waiting for the notifications (_errno_ is set by _poll()_)
+**/
+int nlwatchProcess(struct nlwatch *watch, struct ifdesc *ifds, unsigned int n, int timeout) {
+	// Aligned as required by the netlink macros
+	byte_t buf[NLWATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct nlmsghdr))));
+	struct nlmsghdr *nh;
+	struct pollfd pfd;
+	ssize_t len;
+	int updated=0;
+	unsigned int i;
+
+	if(timeout!=0) {
+		pfd.fd=watch->descriptor;
+		pfd.events=POLLIN;
+		pfd.revents=0;
+
+		if(poll(&pfd,1,timeout)<0) {
+			return ERR_NLWATCH_POLL;
+		}
+	}
+
+	while(1) {
+		len=recv(watch->descriptor,buf,sizeof(buf),MSG_DONTWAIT);
+
+		if(len<0) {
+			if(errno==EAGAIN || errno==EWOULDBLOCK) {
+				break;
+			} else if(errno==EINTR) {
+				continue;
+			} else if(errno==ENOBUFS) {
+				// Some notifications were lost: the only way to be consistent is to resolve everything again
+				for(i=0;i<n;i++) {
+					nlwatchResolve(&ifds[i]);
+				}
+				updated+=n;
+				continue;
+			}
+
+			return ERR_NLWATCH_RECV;
+		}
+
+		for(nh=(struct nlmsghdr *) buf;NLMSG_OK(nh,len);nh=NLMSG_NEXT(nh,len)) {
+			switch(nh->nlmsg_type) {
+				case RTM_NEWLINK:
+				case RTM_DELLINK:
+					updated+=nlwatchLink(nh,ifds,n);
+				break;
+
+				case RTM_NEWADDR:
+				case RTM_DELADDR:
+					updated+=nlwatchAddr(nh,ifds,n);
+				break;
+			}
+		}
+	}
+
+	return updated;
+}
+
+/**
+	\brief Fill in a [struct ifdesc](\ref ifdesc) from a [struct ifrecord](\ref ifrecord)
+
+	This function can be used to obtain an interface descriptor, to be passed to the [IP4headPopulate*Ifd()](\ref IP4headPopulateIfd) functions,
+	from a record returned by nlIfDump(), without calling ifdescResolve().
+
+	\param[in]	record 	Pointer to the [struct ifrecord](\ref ifrecord), filled in by nlIfDump().
+	\param[out]	ifd 	Pointer to the [struct ifdesc](\ref ifdesc) to be filled in.
+
+	\return None.
+**/
+void ifrecordToIfdesc(struct ifrecord *record, struct ifdesc *ifd) {
+	memcpy(ifd->name,record->name,IFDESC_NAME_SIZE);
+	ifd->ifindex=record->ifindex;
+	memcpy(ifd->mac,record->mac,MAC_ADDR_SIZE);
+	ifd->ip=record->ip;
+	ifd->ip_valid=record->ip_valid;
+	ifd->mtu=record->mtu;
+}
@@ -0,0 +1,57 @@
+/** \file
+	Netlink (rtnetlink) support for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to keep one or more [struct ifdesc](\ref ifdesc) interface descriptors
+	up to date, by listening to the rtnetlink notifications sent by the kernel whenever a link or an IPv4 address changes (for instance when
+	a new address is assigned by DHCP, or when the MTU is changed).
+
+	The listener does not use any thread: its descriptor can be added to the _poll()_/_select()_ loop of the application, and nlwatchProcess()
+	should be called when it becomes readable (or periodically, with a timeout of **0**).
+
+	__Example of use:__
+
+		struct ifdesc ifd;
+		struct nlwatch watch;
+
+		ifdescResolve(&ifd,devname);
+		nlwatchOpen(&watch);
+
+		while(...) {
+			nlwatchProcess(&watch,&ifd,1,0); // Update 'ifd' if anything changed, without blocking
+			IP4headPopulateSIfd(&ipHeader,&ifd,destIP,0,0,BASIC_UDP_TTL,IPPROTO_UDP,FLAG_NOFRAG_MASK,&ipaddrs);
+			...
+		}
+
+		nlwatchClose(&watch);
+
+	The records returned by nlIfDump(), which is part of the main module (rawsock.h), can be converted into interface descriptors with ifrecordToIfdesc().
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_NETLINK_H_INCLUDED
+#define RAWSOCK_NETLINK_H_INCLUDED
+
+#include "rawsock.h"
+
+#define NLWATCH_BUFFER_SIZE 8192 /**< Size, in _bytes_, of the buffer used to read the netlink notifications. */
+
+/**
+	\brief Netlink listener
+
+	Structure describing an rtnetlink listener, opened with nlwatchOpen(). Its fields should not be modified directly by the user.
+**/
+struct nlwatch {
+	int descriptor; /**< _NETLINK_ROUTE_ socket descriptor, subscribed to the link and IPv4 address notifications. */
+};
+
+rawsockerr_t nlwatchOpen(struct nlwatch *watch);
+void nlwatchClose(struct nlwatch *watch);
+int nlwatchGetDescriptor(struct nlwatch *watch);
+int nlwatchProcess(struct nlwatch *watch, struct ifdesc *ifds, unsigned int n, int timeout);
+
+void ifrecordToIfdesc(struct ifrecord *record, struct ifdesc *ifd);
+#endif
@@ -0,0 +1,200 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_pacer.h"
+#include <errno.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PACER_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define PACER_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define PACER_CPU_RELAX() do {} while(0)
+#endif
+
+#define PACER_CALIB_SLEEP_NS 50000 // Duration of each sleep performed by pacerCalibrateMargin()
+
+// Sleep, with clock_nanosleep(), until the absolute time 'deadline' (in ns), read from the base clock of 'clk'
+// As clock_nanosleep() does not support CLOCK_MONOTONIC_RAW, the deadline is translated, in that case, to the corresponding CLOCK_MONOTONIC
+// instant (the two clocks differ only by the NTP frequency adjustments, negligible over a single sleep, which is anyway followed by a spin)
+// Any error other than EINTR ends the sleep early: the caller then spins until the deadline
+static void pacerSleepUntil(const struct rsclock *clk, uint64_t deadline) {
+	struct timespec ts;
+	clockid_t sleepclk=clk->base;
+	uint64_t now, mono;
+	int ret;
+
+	if(clk->base==CLOCK_MONOTONIC_RAW) {
+		if(clock_gettime(CLOCK_MONOTONIC_RAW,&ts)<0) {
+			return;
+		}
+		now=(uint64_t) ts.tv_sec*1000000000ULL+ts.tv_nsec;
+
+		if(clock_gettime(CLOCK_MONOTONIC,&ts)<0) {
+			return;
+		}
+		mono=(uint64_t) ts.tv_sec*1000000000ULL+ts.tv_nsec;
+
+		if(now>=deadline) {
+			return;
+		}
+
+		deadline=mono+(deadline-now);
+		sleepclk=CLOCK_MONOTONIC;
+	}
+
+	ts.tv_sec=(time_t) (deadline/1000000000ULL);
+	ts.tv_nsec=(long) (deadline%1000000000ULL);
+
+	do {
+		ret=clock_nanosleep(sleepclk,TIMER_ABSTIME,&ts,NULL);
+	} while(ret==EINTR);
+}
+
+/**
+	\brief Initialize a [struct pacerparams](\ref pacerparams) with the default settings
+
+	\param[out]	params 	Pointer to the [struct pacerparams](\ref pacerparams) to be initialized.
+
+	\return None.
+**/
+void pacerParamsDefault(struct pacerparams *params) {
+	params->period_ns=1000000;
+	params->start_ns=0;
+	params->margin_ns=PACER_DEFAULT_MARGIN_NS;
+	params->policy=PACER_CATCHUP;
+	params->skip_threshold_ns=0;
+}
+
+/**
+	\brief Measure the sleep margin of the current system
+
+	This function measures the wakeup latency of _clock_nanosleep()_ on the current system (i.e. how late the calling thread is woken up,
+	with respect to the requested instant), by sleeping [PACER_CALIB_SAMPLES](\ref PACER_CALIB_SAMPLES) times for a short interval, and it returns
+	its 99th percentile, to be used as _margin_ns_ inside a [struct pacerparams](\ref pacerparams). It takes about 10 to 20 _ms_.
+
+	It should be called by the thread which will then send the packets, after setting its priority and CPU affinity, if any.
+
+	\param[in]	clk 	Pointer to the clock which will be used by the pacer.
+
+	\return The measured margin, in _ns_.
+**/
+uint64_t pacerCalibrateMargin(const struct rsclock *clk) {
+	struct lathist overshoot;
+	uint64_t deadline, now;
+	int i;
+
+	lathistInit(&overshoot);
+
+	for(i=0;i<PACER_CALIB_SAMPLES;i++) {
+		deadline=rsclockNowNs(clk)+PACER_CALIB_SLEEP_NS;
+		pacerSleepUntil(clk,deadline);
+		now=rsclockNowNs(clk);
+
+		lathistRecord(&overshoot,now>deadline ? now-deadline : 0);
+	}
+
+	return lathistPercentile(&overshoot,99.0);
+}
+
+/**
+	\brief Initialize a [struct pacer](\ref pacer)
+
+	\param[out]	pacer 		Pointer to the [struct pacer](\ref pacer) to be initialized.
+	\param[in]	clk 		Pointer to the clock used to read the current time, initialized with rsclockInit() or rsclockInitTsc() (it should stay valid as long as the pacer is used). The pacer sleeps on its base clock (on _CLOCK_MONOTONIC_ for a _CLOCK_MONOTONIC_RAW_ base clock, which _clock_nanosleep()_ does not support).
+	\param[in]	params 		Pointer to the pacer settings (see pacerParamsDefault()).
+	\param[in]	lateness 	Pointer to a [struct lathist](\ref lathist), already initialized, in which the release lateness of each packet is recorded, or NULL.
+
+	\return **0** if the pacer was properly initialized, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PACER_PARAMS* -> invalid settings (e.g. zero period)
+**/
+rawsockerr_t pacerInit(struct pacer *pacer, const struct rsclock *clk, struct pacerparams *params, struct lathist *lateness) {
+	if(params->period_ns==0 || (params->policy!=PACER_CATCHUP && params->policy!=PACER_SKIP)) {
+		return ERR_PACER_PARAMS;
+	}
+
+	pacer->clk=clk;
+	pacer->period_ns=params->period_ns;
+	pacer->margin_ns=params->margin_ns;
+	pacer->policy=params->policy;
+	pacer->skip_threshold_ns=params->skip_threshold_ns!=0 ? params->skip_threshold_ns : params->period_ns;
+	pacer->lateness=lateness;
+	pacer->sent=0;
+	pacer->skipped=0;
+
+	pacer->next_ns=params->start_ns!=0 ? params->start_ns : rsclockNowNs(clk)+params->period_ns;
+
+	return 0;
+}
+
+/**
+	\brief Wait until an arbitrary deadline
+
+	This function waits until the absolute time _deadline_, read from the pacer clock, exactly as pacerWait() does for its periodic deadlines
+	(sleeping until _margin_ns_ before it and then spinning), and records the release lateness, if a histogram was specified in pacerInit().
+	It can be used when the deadlines are not periodic, e.g. to replay the original timing of a capture (see rawsock_replay.h).
+
+	The periodic schedule of the pacer (i.e. the deadline of the next pacerWait() call) is not modified.
+
+	\param[in,out]	pacer 		Pointer to the [struct pacer](\ref pacer).
+	\param[in]		deadline 	Absolute time, in _ns_, read from the pacer clock: if it has already passed, the function returns immediately.
+
+	\return The current time, in _ns_, when the function returns.
+**/
+uint64_t pacerWaitUntil(struct pacer *pacer, uint64_t deadline) {
+	uint64_t now;
+
+	now=rsclockNowNs(pacer->clk);
+
+	if(now<deadline) {
+		if(deadline-now>pacer->margin_ns) {
+			pacerSleepUntil(pacer->clk,deadline-pacer->margin_ns);
+		}
+
+		while((now=rsclockNowNs(pacer->clk))<deadline) {
+			PACER_CPU_RELAX();
+		}
+	}
+
+	if(pacer->lateness!=NULL) {
+		lathistRecord(pacer->lateness,now-deadline);
+	}
+
+	pacer->sent++;
+
+	return now;
+}
+
+/**
+	\brief Wait until the next deadline
+
+	This function waits until the next deadline, sleeping until _margin_ns_ before it and then spinning on the pacer clock, and it schedules
+	the following one, one period later. The packet should be sent immediately after this function returns.
+
+	If the deadline has already passed, the function returns immediately ([PACER_CATCHUP](\ref PACER_CATCHUP)), or, with [PACER_SKIP](\ref PACER_SKIP),
+	if it has passed by more than _skip_threshold_ns_, the missed deadlines are skipped (and counted in the _skipped_ field) and the function
+	waits for the next future one.
+
+	\param[in,out]	pacer 	Pointer to the [struct pacer](\ref pacer).
+
+	\return The scheduled deadline (in _ns_) of the packet which should be sent now, which can be used, for instance, as its launch time or as its timestamp.
+**/
+uint64_t pacerWait(struct pacer *pacer) {
+	uint64_t deadline, now, missed;
+
+	now=rsclockNowNs(pacer->clk);
+
+	if(pacer->policy==PACER_SKIP && now>pacer->next_ns+pacer->skip_threshold_ns) {
+		missed=(now-pacer->next_ns)/pacer->period_ns+1;
+		pacer->next_ns+=missed*pacer->period_ns;
+		pacer->skipped+=missed;
+	}
+
+	deadline=pacer->next_ns;
+	pacer->next_ns+=pacer->period_ns;
+
+	pacerWaitUntil(pacer,deadline);
+
+	return deadline;
+}
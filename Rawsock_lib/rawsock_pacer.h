@@ -0,0 +1,102 @@
+/** \file
+	High-precision transmission pacing for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to send periodic packets (e.g. LaMP probes) at very regular
+	instants, even with periods of a few microseconds.
+
+	A [struct pacer](\ref pacer) works with absolute deadlines, so that the errors do not accumulate over time: the deadline of the _n_-th packet
+	is always `start+n*period`. pacerWait() sleeps with _clock_nanosleep()_ until a short margin before the deadline (the typical wakeup latency of the
+	system, measured by pacerCalibrateMargin()), and then spins on the clock (which can be a calibrated TSC, see rsclockInitTsc()) until the deadline is reached.
+	This way, the CPU is released for most of the period, while the wakeup jitter of the scheduler does not affect the transmission instants.
+
+	When the sender falls behind (for instance because it was preempted), the pacer can either send all the missed packets back-to-back
+	([PACER_CATCHUP](\ref PACER_CATCHUP)), or drop them and realign to the next deadline ([PACER_SKIP](\ref PACER_SKIP)).
+
+	If a [struct lathist](\ref lathist) is specified, the difference between the actual and the scheduled release instant of each packet
+	is recorded inside it, to assess the regularity of the stream.
+
+	__Example of use:__
+
+		struct rsclock clk;
+		struct pacer pacer;
+		struct pacerparams params;
+		struct lathist lateness;
+
+		rsclockInitTsc(&clk,CLOCKSRC_MONOTONIC,RSCLOCK_CALIB_MS);
+		lathistInit(&lateness);
+
+		pacerParamsDefault(&params);
+		params.period_ns=20000; // 20 us
+		params.margin_ns=pacerCalibrateMargin(&clk);
+		pacerInit(&pacer,&clk,&params,&lateness);
+
+		while(...) {
+			pacerWait(&pacer);
+			... // Send the packet
+		}
+
+		printf("p99 lateness: %lu ns, skipped: %lu\n",lathistPercentile(&lateness,99.0),pacer.skipped);
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_PACER_H_INCLUDED
+#define RAWSOCK_PACER_H_INCLUDED
+
+#include "rawsock.h"
+#include "rawsock_clock.h"
+#include "rawsock_hist.h"
+
+#define PACER_DEFAULT_MARGIN_NS 100000 /**< Default sleep margin, in _ns_, used when the margin is not calibrated with pacerCalibrateMargin(). */
+#define PACER_CALIB_SAMPLES 200 /**< Number of sleeps performed by pacerCalibrateMargin(). */
+
+/**
+	\brief Pacer late policy enumerator
+
+	Policy applied by pacerWait() when one or more deadlines have already passed.
+**/
+typedef enum {
+	PACER_CATCHUP, /**< The missed packets are released immediately, one per call, until the pacer is back on schedule (the average rate is preserved). */
+	PACER_SKIP /**< If the pacer is late by more than _skip_threshold_ns_, the missed deadlines are skipped and the next packet is scheduled at the next future deadline. */
+} pacerpolicy_t;
+
+/**
+	\brief Pacer settings
+
+	Structure containing the settings of a [struct pacer](\ref pacer): it should be initialized with pacerParamsDefault(), and then
+	the desired fields can be changed before calling pacerInit().
+**/
+struct pacerparams {
+	uint64_t period_ns; /**< Transmission period, in _ns_ (default: 1 _ms_). */
+	uint64_t start_ns; /**< Absolute time, in _ns_ (read from the pacer clock), of the first deadline, or **0** to start one period after pacerInit() (default: **0**). */
+	uint64_t margin_ns; /**< Time, in _ns_, spent spinning before each deadline, instead of sleeping (default: [PACER_DEFAULT_MARGIN_NS](\ref PACER_DEFAULT_MARGIN_NS)); it can be measured with pacerCalibrateMargin(). */
+	pacerpolicy_t policy; /**< Policy applied when the pacer is late (default: [PACER_CATCHUP](\ref PACER_CATCHUP)). */
+	uint64_t skip_threshold_ns; /**< Lateness, in _ns_, beyond which the missed deadlines are skipped, with [PACER_SKIP](\ref PACER_SKIP) (default: one period). */
+};
+
+/**
+	\brief Pacer
+
+	Structure describing a pacer, initialized with pacerInit(). The _sent_ and _skipped_ counters can be read directly by the user, but the fields should not be modified.
+**/
+struct pacer {
+	const struct rsclock *clk; /**< Clock used to read the current time and to express the deadlines. */
+	uint64_t next_ns; /**< Next deadline, in _ns_. */
+	uint64_t period_ns; /**< Transmission period, in _ns_. */
+	uint64_t margin_ns; /**< Time, in _ns_, spent spinning before each deadline. */
+	pacerpolicy_t policy; /**< Late policy. */
+	uint64_t skip_threshold_ns; /**< Lateness, in _ns_, beyond which the missed deadlines are skipped (with [PACER_SKIP](\ref PACER_SKIP)). */
+	struct lathist *lateness; /**< Histogram of the release lateness (actual minus scheduled release time), or NULL. */
+	uint64_t sent; /**< Number of deadlines released by pacerWait() (or pacerWaitUntil()). */
+	uint64_t skipped; /**< Number of deadlines skipped, with [PACER_SKIP](\ref PACER_SKIP). */
+};
+
+void pacerParamsDefault(struct pacerparams *params);
+uint64_t pacerCalibrateMargin(const struct rsclock *clk);
+rawsockerr_t pacerInit(struct pacer *pacer, const struct rsclock *clk, struct pacerparams *params, struct lathist *lateness);
+uint64_t pacerWait(struct pacer *pacer);
+uint64_t pacerWaitUntil(struct pacer *pacer, uint64_t deadline);
+#endif
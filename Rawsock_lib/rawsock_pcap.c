@@ -0,0 +1,792 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_pcap.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// pcapng block types and options
+#define PCAPNG_BT_SHB 0x0A0D0D0A // Section Header Block
+#define PCAPNG_BT_IDB 0x00000001 // Interface Description Block
+#define PCAPNG_BT_EPB 0x00000006 // Enhanced Packet Block
+#define PCAPNG_BT_SPB 0x00000003 // Simple Packet Block
+#define PCAPNG_BT_PB 0x00000002 // Packet Block (obsolete)
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_SHB_USERAPPL 4
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+#define PCAPNG_PAD4(x) (((x)+3) & ~((size_t) 3)) // Round 'x' up to a multiple of 4 bytes, as required for the block and option bodies
+#define PCAPNG_EPB_OVERHEAD 32 // Size of an Enhanced Packet Block, without the frame data
+
+#define PCAPW_USERAPPL "Rawsock_lib 0.3.4"
+
+// Classic pcap magic numbers (microsecond and nanosecond timestamps) and header sizes
+#define PCAP_MAGIC_USEC 0xA1B2C3D4
+#define PCAP_MAGIC_NSEC 0xA1B23C4D
+#define PCAP_FILEHDR_SIZE 24
+#define PCAP_RECHDR_SIZE 16
+
+// Store a 32-bit value at 'ptr' (possibly unaligned), in host byte order, as pcapng blocks are written in the byte order of the writer
+static inline void pcapPut32(byte_t *ptr, uint32_t value) {
+	memcpy(ptr,&value,sizeof(uint32_t));
+}
+
+// Store a pcapng option at 'ptr', padding its value to 4 bytes, and return the total size of the option
+static size_t pcapPutOption(byte_t *ptr, uint16_t code, const void *value, uint16_t len) {
+	memcpy(ptr,&code,sizeof(uint16_t));
+	memcpy(ptr+2,&len,sizeof(uint16_t));
+
+	if(len>0) {
+		memcpy(ptr+4,value,len);
+		memset(ptr+4+len,0,PCAPNG_PAD4(len)-len);
+	}
+
+	return 4+PCAPNG_PAD4(len);
+}
+
+// Write 'size' bytes to the file, retrying after partial writes and signals
+static rawsockerr_t pcapWriteAll(int fd, const byte_t *data, size_t size) {
+	ssize_t ret;
+
+	while(size>0) {
+		ret=write(fd,data,size);
+
+		if(ret<0) {
+			if(errno==EINTR) {
+				continue;
+			}
+
+			return ERR_PCAP_WRITE;
+		}
+
+		data+=ret;
+		size-=ret;
+	}
+
+	return 0;
+}
+
+// Get a pointer to 'size' free bytes at the end of the write buffer, writing the buffer content to the file first, if there is not enough space
+static byte_t *pcapReserve(struct pcapwriter *pw, size_t size) {
+	if(pw->used+size>pw->bufsize && pcapwriterFlush(pw)!=0) {
+		return NULL;
+	}
+
+	return pw->buf+pw->used;
+}
+
+/**
+	\brief Create a pcapng file
+
+	This function creates (or truncates) the file _filename_, allocates the write buffer and writes the Section Header Block.
+	At least one interface should then be added with pcapwriterAddInterface(), before saving any frame.
+
+	\param[out]	pw 			Pointer to the [struct pcapwriter](\ref pcapwriter) to be initialized.
+	\param[in]	filename 	Name of the pcapng file.
+	\param[in]	bufsize 	Size, in _bytes_, of the write buffer, or **0** to use [PCAPW_DEFAULT_BUFSIZE](\ref PCAPW_DEFAULT_BUFSIZE); it is raised to [PCAPW_MIN_BUFSIZE](\ref PCAPW_MIN_BUFSIZE), if smaller.
+
+	\return **0** if the file was successfully created, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_OPEN* -> the file cannot be created (_errno_ is set by _open()_)
+	- *ERR_PCAP_ALLOC* -> the write buffer cannot be allocated
+**/
+rawsockerr_t pcapwriterOpen(struct pcapwriter *pw, const char *filename, size_t bufsize) {
+	byte_t *ptr;
+	size_t optsize, blocksize;
+	uint64_t sectionlen=UINT64_MAX; // Unknown section length
+	uint16_t version[2]={1,0};
+
+	if(bufsize==0) {
+		bufsize=PCAPW_DEFAULT_BUFSIZE;
+	} else if(bufsize<PCAPW_MIN_BUFSIZE) {
+		bufsize=PCAPW_MIN_BUFSIZE;
+	}
+
+	pw->buf=malloc(bufsize);
+	if(pw->buf==NULL) {
+		return ERR_PCAP_ALLOC;
+	}
+
+	pw->fd=open(filename,O_WRONLY | O_CREAT | O_TRUNC,0644);
+	if(pw->fd<0) {
+		free(pw->buf);
+		pw->buf=NULL;
+		return ERR_PCAP_OPEN;
+	}
+
+	pw->bufsize=bufsize;
+	pw->used=0;
+	pw->nifs=0;
+	pw->packets=0;
+	pw->truncated=0;
+
+	// Section Header Block: type, length, byte order magic, version, section length, options, length
+	ptr=pw->buf;
+	optsize=pcapPutOption(ptr+24,PCAPNG_OPT_SHB_USERAPPL,PCAPW_USERAPPL,sizeof(PCAPW_USERAPPL)-1);
+	optsize+=pcapPutOption(ptr+24+optsize,PCAPNG_OPT_ENDOFOPT,NULL,0);
+	blocksize=24+optsize+4;
+
+	pcapPut32(ptr,PCAPNG_BT_SHB);
+	pcapPut32(ptr+4,blocksize);
+	pcapPut32(ptr+8,PCAPNG_BYTE_ORDER_MAGIC);
+	memcpy(ptr+12,version,sizeof(version));
+	memcpy(ptr+16,&sectionlen,sizeof(uint64_t));
+	pcapPut32(ptr+blocksize-4,blocksize);
+
+	pw->used=blocksize;
+
+	return 0;
+}
+
+/**
+	\brief Add a capture interface to a pcapng file
+
+	This function writes an Interface Description Block, describing an interface on which the frames were captured (or sent).
+	The interfaces are numbered starting from **0**, in the same order in which they are added.
+
+	\param[in,out]	pw 			Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+	\param[in]		ifindex 	System index of the interface (e.g. the one returned by wlanLookup()), used by pcapwriterWriteRecvframe() and pcapwriterWriteRxframe()
+								to find the interface of each frame, or **0** if unknown.
+	\param[in]		name 		Name of the interface (e.g. _wlan0_), or NULL.
+	\param[in]		linktype 	Link type of the interface (it should be [PCAP_LINKTYPE_ETHERNET](\ref PCAP_LINKTYPE_ETHERNET) for all the frames handled by the Rawsock library).
+	\param[in]		snaplen 	Maximum number of _bytes_ saved for each frame (the remaining ones are discarded), or **0** to save the whole frames (up to [PCAPW_MAX_SNAPLEN](\ref PCAPW_MAX_SNAPLEN) _bytes_).
+	\param[in]		nsec 		_true_ to store the timestamps with a nanosecond resolution, _false_ to store them with a microsecond resolution.
+
+	\return The identifier of the new interface (to be passed to pcapwriterWrite() and pcapwriterWriteFramebuf()), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_IFACE* -> too many interfaces (see [PCAPW_MAX_INTERFACES](\ref PCAPW_MAX_INTERFACES))
+	- *ERR_PCAP_WRITE* -> the write buffer was full, and writing it to the file failed
+**/
+int pcapwriterAddInterface(struct pcapwriter *pw, int ifindex, const char *name, uint16_t linktype, uint32_t snaplen, bool nsec) {
+	byte_t *ptr;
+	size_t namelen=0, blocksize;
+	uint8_t tsresol=nsec ? 9 : 6;
+	uint16_t reserved=0;
+
+	if(pw->nifs==PCAPW_MAX_INTERFACES) {
+		return ERR_PCAP_IFACE;
+	}
+
+	if(snaplen==0 || snaplen>PCAPW_MAX_SNAPLEN) {
+		snaplen=PCAPW_MAX_SNAPLEN;
+	}
+
+	if(name!=NULL) {
+		namelen=strnlen(name,IFNAMSIZ);
+	}
+
+	ptr=pcapReserve(pw,16+4+PCAPNG_PAD4(namelen)+8+4+4);
+	if(ptr==NULL) {
+		return ERR_PCAP_WRITE;
+	}
+
+	// Interface Description Block: type, length, link type, reserved, snaplen, options (name and timestamp resolution), length
+	blocksize=16;
+	if(namelen>0) {
+		blocksize+=pcapPutOption(ptr+blocksize,PCAPNG_OPT_IF_NAME,name,namelen);
+	}
+	blocksize+=pcapPutOption(ptr+blocksize,PCAPNG_OPT_IF_TSRESOL,&tsresol,sizeof(tsresol));
+	blocksize+=pcapPutOption(ptr+blocksize,PCAPNG_OPT_ENDOFOPT,NULL,0);
+	blocksize+=4;
+
+	pcapPut32(ptr,PCAPNG_BT_IDB);
+	pcapPut32(ptr+4,blocksize);
+	memcpy(ptr+8,&linktype,sizeof(uint16_t));
+	memcpy(ptr+10,&reserved,sizeof(uint16_t));
+	pcapPut32(ptr+12,snaplen);
+	pcapPut32(ptr+blocksize-4,blocksize);
+
+	pw->used+=blocksize;
+
+	pw->ifindex[pw->nifs]=ifindex;
+	pw->snaplen[pw->nifs]=snaplen;
+	pw->nsec[pw->nifs]=nsec;
+
+	return pw->nifs++;
+}
+
+// Store an Enhanced Packet Block for a frame of which 'avail' bytes are available at 'frame', out of 'len', truncating it to the snaplen of interface 'ifid'
+static rawsockerr_t pcapwriterPutEpb(struct pcapwriter *pw, int ifid, const byte_t *frame, size_t avail, size_t len, const struct timespec *ts) {
+	struct timespec now;
+	byte_t *ptr;
+	size_t caplen, blocksize;
+	uint64_t tsval;
+
+	if(ifid<0 || (unsigned int) ifid>=pw->nifs) {
+		return ERR_PCAP_IFACE;
+	}
+
+	caplen=avail<pw->snaplen[ifid] ? avail : pw->snaplen[ifid];
+	blocksize=PCAPNG_EPB_OVERHEAD+PCAPNG_PAD4(caplen);
+
+	ptr=pcapReserve(pw,blocksize);
+	if(ptr==NULL) {
+		return ERR_PCAP_WRITE;
+	}
+
+	if(ts==NULL) {
+		clock_gettime(CLOCK_REALTIME,&now);
+		ts=&now;
+	}
+
+	if(pw->nsec[ifid]) {
+		tsval=(uint64_t) ts->tv_sec*1000000000ULL+ts->tv_nsec;
+	} else {
+		tsval=(uint64_t) ts->tv_sec*1000000ULL+ts->tv_nsec/1000;
+	}
+
+	// Enhanced Packet Block: type, length, interface, timestamp (high and low 32 bits), captured length, original length, data, length
+	pcapPut32(ptr,PCAPNG_BT_EPB);
+	pcapPut32(ptr+4,blocksize);
+	pcapPut32(ptr+8,ifid);
+	pcapPut32(ptr+12,tsval >> 32);
+	pcapPut32(ptr+16,tsval & 0xFFFFFFFF);
+	pcapPut32(ptr+20,caplen);
+	pcapPut32(ptr+24,len);
+	memcpy(ptr+28,frame,caplen);
+	memset(ptr+28+caplen,0,PCAPNG_PAD4(caplen)-caplen);
+	pcapPut32(ptr+blocksize-4,blocksize);
+
+	pw->used+=blocksize;
+	pw->packets++;
+	if(caplen<len) {
+		pw->truncated++;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Save a frame inside a pcapng file
+
+	This function stores a frame inside the write buffer, as an Enhanced Packet Block, truncating it to the snaplen of the interface.
+	The buffer is written to the file only when it is full.
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+	\param[in]		ifid 	Identifier of the interface, returned by pcapwriterAddInterface().
+	\param[in]		frame 	Pointer to the frame, starting from the Ethernet header.
+	\param[in]		len 	Size of the whole frame, in _bytes_.
+	\param[in]		ts 		Timestamp of the frame (e.g. its kernel reception timestamp), or NULL to use the current time (_CLOCK_REALTIME_).
+
+	\return **0** if the frame was saved, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_IFACE* -> invalid interface identifier
+	- *ERR_PCAP_WRITE* -> the write buffer was full, and writing it to the file failed (_errno_ is set by _write()_)
+**/
+rawsockerr_t pcapwriterWrite(struct pcapwriter *pw, int ifid, const byte_t *frame, size_t len, const struct timespec *ts) {
+	return pcapwriterPutEpb(pw,ifid,frame,len,len,ts);
+}
+
+// Get the identifier of the interface added with system index 'ifindex', or 0 (i.e. the first interface) if there is none
+static int pcapwriterFindIf(struct pcapwriter *pw, int ifindex) {
+	unsigned int i;
+
+	for(i=0;i<pw->nifs;i++) {
+		if(pw->ifindex[i]==ifindex) {
+			return i;
+		}
+	}
+
+	return 0;
+}
+
+/**
+	\brief Save a frame received with rawRecvBatch() inside a pcapng file
+
+	This function works like pcapwriterWrite(), but the frame is described by a [struct recvframe](\ref recvframe): its kernel reception timestamp is saved,
+	if available, and the interface is selected by matching the interface index of the frame with the ones specified in pcapwriterAddInterface()
+	(the first interface is used when no one matches).
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+	\param[in]		frame 	Pointer to the [struct recvframe](\ref recvframe) describing the frame.
+
+	\return **0** if the frame was saved, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see pcapwriterWrite()).
+**/
+rawsockerr_t pcapwriterWriteRecvframe(struct pcapwriter *pw, const struct recvframe *frame) {
+	return pcapwriterWrite(pw,pcapwriterFindIf(pw,frame->addrll.sll_ifindex),frame->packet,frame->len,frame->ts_valid ? &frame->ts : NULL);
+}
+
+/**
+	\brief Save a frame received through a memory-mapped ring inside a pcapng file
+
+	This function works like pcapwriterWriteRecvframe(), but the frame is described by a [struct rxframe](\ref rxframe) (see rxringNext()).
+	If the frame was already truncated, its original length is preserved.
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+	\param[in]		frame 	Pointer to the [struct rxframe](\ref rxframe) describing the frame.
+
+	\return **0** if the frame was saved, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see pcapwriterWrite()).
+**/
+rawsockerr_t pcapwriterWriteRxframe(struct pcapwriter *pw, const struct rxframe *frame) {
+	return pcapwriterPutEpb(pw,pcapwriterFindIf(pw,frame->ifindex),frame->data,frame->snaplen<frame->len ? frame->snaplen : frame->len,frame->len,&frame->ts);
+}
+
+/**
+	\brief Save a frame built inside a [struct framebuf](\ref framebuf) inside a pcapng file
+
+	This function works like pcapwriterWrite(), but the frame is described by a [struct framebuf](\ref framebuf), e.g. just before or after sending it.
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+	\param[in]		ifid 	Identifier of the interface, returned by pcapwriterAddInterface().
+	\param[in]		fb 		Pointer to the [struct framebuf](\ref framebuf) containing the whole frame.
+	\param[in]		ts 		Timestamp of the frame (e.g. its kernel transmission timestamp), or NULL to use the current time.
+
+	\return **0** if the frame was saved, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see pcapwriterWrite()).
+**/
+rawsockerr_t pcapwriterWriteFramebuf(struct pcapwriter *pw, int ifid, const struct framebuf *fb, const struct timespec *ts) {
+	return pcapwriterWrite(pw,ifid,fb->data,fb->len,ts);
+}
+
+/**
+	\brief Write the content of the write buffer to a pcapng file
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_WRITE* -> _write()_ failed (_errno_ is set); the content of the buffer is discarded
+**/
+rawsockerr_t pcapwriterFlush(struct pcapwriter *pw) {
+	rawsockerr_t ret;
+
+	ret=pcapWriteAll(pw->fd,pw->buf,pw->used);
+	pw->used=0;
+
+	return ret;
+}
+
+/**
+	\brief Close a pcapng file
+
+	This function writes the remaining content of the write buffer to the file, closes it and frees the write buffer.
+
+	\param[in,out]	pw 		Pointer to the [struct pcapwriter](\ref pcapwriter), opened with pcapwriterOpen().
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see pcapwriterFlush()); the file is closed anyway.
+**/
+rawsockerr_t pcapwriterClose(struct pcapwriter *pw) {
+	rawsockerr_t ret;
+
+	ret=pcapwriterFlush(pw);
+
+	close(pw->fd);
+	free(pw->buf);
+	pw->buf=NULL;
+	pw->fd=-1;
+
+	return ret;
+}
+
+// Read a 32-bit value at 'ptr' (possibly unaligned), written with the byte order of the file
+static inline uint32_t pcapGet32(struct pcapreader *pr, const byte_t *ptr) {
+	uint32_t value;
+
+	memcpy(&value,ptr,sizeof(uint32_t));
+
+	return pr->swapped ? __builtin_bswap32(value) : value;
+}
+
+// Read a 16-bit value at 'ptr' (possibly unaligned), written with the byte order of the file
+static inline uint16_t pcapGet16(struct pcapreader *pr, const byte_t *ptr) {
+	uint16_t value;
+
+	memcpy(&value,ptr,sizeof(uint16_t));
+
+	return pr->swapped ? __builtin_bswap16(value) : value;
+}
+
+// Convert a timestamp expressed in 'units' per second into a struct timespec
+static void pcapTsToTimespec(uint64_t tsval, uint64_t units, struct timespec *ts) {
+	uint64_t frac=tsval%units;
+
+	ts->tv_sec=(time_t) (tsval/units);
+
+	if(units==1000000000ULL) {
+		ts->tv_nsec=frac;
+	} else if(units<1000000000ULL && 1000000000ULL%units==0) {
+		ts->tv_nsec=frac*(1000000000ULL/units);
+	} else {
+		ts->tv_nsec=(long) ((double) frac*1e9/(double) units);
+	}
+}
+
+// Parse the Section Header Block at 'offset', setting the byte order of the section and resetting its interfaces
+static rawsockerr_t pcapngParseShb(struct pcapreader *pr, size_t offset) {
+	uint32_t bom;
+
+	if(offset+28>pr->mapsize) {
+		return ERR_PCAP_FORMAT;
+	}
+
+	memcpy(&bom,pr->map+offset+8,sizeof(uint32_t));
+
+	if(bom==PCAPNG_BYTE_ORDER_MAGIC) {
+		pr->swapped=false;
+	} else if(bom==__builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+		pr->swapped=true;
+	} else {
+		return ERR_PCAP_FORMAT;
+	}
+
+	pr->nifs=0;
+
+	return 0;
+}
+
+// Parse the Interface Description Block at 'offset', of 'blocklen' bytes, adding its interface to the current section
+static rawsockerr_t pcapngParseIdb(struct pcapreader *pr, size_t offset, size_t blocklen) {
+	const byte_t *opt=pr->map+offset+16;
+	const byte_t *end=pr->map+offset+blocklen-4;
+	uint16_t code, len;
+	uint8_t tsresol;
+
+	if(pr->nifs==PCAPR_MAX_INTERFACES || blocklen<20) {
+		return ERR_PCAP_FORMAT;
+	}
+
+	pr->if_linktype[pr->nifs]=pcapGet16(pr,pr->map+offset+8);
+	pr->if_tsunits[pr->nifs]=1000000; // Default resolution: microseconds
+
+	// Look for the if_tsresol option
+	while(opt+4<=end) {
+		code=pcapGet16(pr,opt);
+		len=pcapGet16(pr,opt+2);
+
+		if(code==PCAPNG_OPT_ENDOFOPT || opt+4+len>end) {
+			break;
+		}
+
+		if(code==PCAPNG_OPT_IF_TSRESOL && len>=1) {
+			tsresol=opt[4];
+
+			// The most significant bit selects a power of 2 instead of a power of 10
+			if(tsresol & 0x80) {
+				if((tsresol & 0x7F)>63) {
+					return ERR_PCAP_FORMAT;
+				}
+				pr->if_tsunits[pr->nifs]=1ULL << (tsresol & 0x7F);
+			} else {
+				if(tsresol>19) {
+					return ERR_PCAP_FORMAT;
+				}
+				for(pr->if_tsunits[pr->nifs]=1;tsresol>0;tsresol--) {
+					pr->if_tsunits[pr->nifs]*=10;
+				}
+			}
+		}
+
+		opt+=4+PCAPNG_PAD4(len);
+	}
+
+	pr->nifs++;
+
+	return 0;
+}
+
+/**
+	\brief Open a pcap or pcapng file for reading
+
+	This function maps the whole file _filename_ in memory and checks its header: both classic _pcap_ files (with microsecond or nanosecond timestamps)
+	and _pcapng_ files are supported, with any byte order. The frames can then be read with pcapreaderNext() or pcapreaderNextBatch().
+
+	\param[out]	pr 			Pointer to the [struct pcapreader](\ref pcapreader) to be initialized.
+	\param[in]	filename 	Name of the pcap or pcapng file.
+
+	\return **0** if the file was successfully opened, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_OPEN* -> the file cannot be opened (_errno_ is set by _open()_)
+	- *ERR_PCAP_MMAP* -> the file cannot be mapped in memory
+	- *ERR_PCAP_FORMAT* -> the file is not a valid pcap or pcapng file
+**/
+rawsockerr_t pcapreaderOpen(struct pcapreader *pr, const char *filename) {
+	struct stat st;
+	uint32_t magic;
+	rawsockerr_t ret;
+
+	pr->fd=open(filename,O_RDONLY);
+	if(pr->fd<0) {
+		return ERR_PCAP_OPEN;
+	}
+
+	if(fstat(pr->fd,&st)<0) {
+		close(pr->fd);
+		return ERR_PCAP_OPEN;
+	}
+
+	if(st.st_size<PCAP_FILEHDR_SIZE) {
+		close(pr->fd);
+		return ERR_PCAP_FORMAT;
+	}
+
+	pr->mapsize=st.st_size;
+	pr->map=mmap(NULL,pr->mapsize,PROT_READ,MAP_PRIVATE,pr->fd,0);
+	if(pr->map==MAP_FAILED) {
+		close(pr->fd);
+		pr->map=NULL;
+		return ERR_PCAP_MMAP;
+	}
+
+	// The file is read sequentially, from the beginning to the end
+	madvise(pr->map,pr->mapsize,MADV_SEQUENTIAL);
+
+	memcpy(&magic,pr->map,sizeof(uint32_t));
+
+	pr->nifs=0;
+	pr->linktype=0;
+	pr->frames=0;
+
+	if(magic==PCAPNG_BT_SHB) {
+		pr->pcapng=true;
+		pr->start=0;
+		ret=pcapngParseShb(pr,0);
+	} else {
+		pr->pcapng=false;
+		pr->start=PCAP_FILEHDR_SIZE;
+		ret=0;
+
+		if(magic==PCAP_MAGIC_USEC || magic==PCAP_MAGIC_NSEC) {
+			pr->swapped=false;
+		} else if(magic==__builtin_bswap32(PCAP_MAGIC_USEC) || magic==__builtin_bswap32(PCAP_MAGIC_NSEC)) {
+			pr->swapped=true;
+			magic=__builtin_bswap32(magic);
+		} else {
+			ret=ERR_PCAP_FORMAT;
+		}
+
+		if(ret==0) {
+			pr->if_linktype[0]=pcapGet32(pr,pr->map+20) & 0xFFFF;
+			pr->if_tsunits[0]=magic==PCAP_MAGIC_NSEC ? 1000000000ULL : 1000000ULL;
+		}
+	}
+
+	if(ret!=0) {
+		pcapreaderClose(pr);
+		return ret;
+	}
+
+	pr->offset=pr->start;
+
+	return 0;
+}
+
+// Get the next frame from a classic pcap file
+static int pcapreaderNextPcap(struct pcapreader *pr, struct rxframe *frame) {
+	const byte_t *rec;
+	uint32_t caplen;
+
+	if(pr->offset==pr->mapsize) {
+		return 0;
+	}
+
+	if(pr->offset+PCAP_RECHDR_SIZE>pr->mapsize) {
+		return ERR_PCAP_FORMAT;
+	}
+
+	rec=pr->map+pr->offset;
+	caplen=pcapGet32(pr,rec+8);
+
+	if(caplen>pr->mapsize-pr->offset-PCAP_RECHDR_SIZE) {
+		return ERR_PCAP_FORMAT;
+	}
+
+	frame->data=(byte_t *) rec+PCAP_RECHDR_SIZE;
+	frame->snaplen=caplen;
+	frame->len=pcapGet32(pr,rec+12);
+	pcapTsToTimespec((uint64_t) pcapGet32(pr,rec)*pr->if_tsunits[0]+pcapGet32(pr,rec+4),pr->if_tsunits[0],&frame->ts);
+	frame->ifindex=0;
+
+	pr->linktype=pr->if_linktype[0];
+	pr->offset+=PCAP_RECHDR_SIZE+caplen;
+
+	return 1;
+}
+
+// Get the next frame from a pcapng file, skipping all the blocks not containing a frame
+static int pcapreaderNextPcapng(struct pcapreader *pr, struct rxframe *frame) {
+	const byte_t *blk;
+	uint32_t type, blocklen, ifid, caplen;
+	size_t offset;
+	rawsockerr_t ret;
+
+	while(pr->offset<pr->mapsize) {
+		offset=pr->offset;
+
+		if(offset+12>pr->mapsize) {
+			return ERR_PCAP_FORMAT;
+		}
+
+		blk=pr->map+offset;
+		memcpy(&type,blk,sizeof(uint32_t));
+
+		// A new section may have a different byte order: the Section Header Block type is palindromic, and it can be read before knowing it
+		if(type==PCAPNG_BT_SHB) {
+			ret=pcapngParseShb(pr,offset);
+			if(ret!=0) {
+				return ret;
+			}
+		}
+
+		type=pcapGet32(pr,blk);
+		blocklen=pcapGet32(pr,blk+4);
+
+		if(blocklen<12 || (blocklen & 3)!=0 || blocklen>pr->mapsize-offset) {
+			return ERR_PCAP_FORMAT;
+		}
+
+		pr->offset+=blocklen;
+
+		switch(type) {
+			case PCAPNG_BT_IDB:
+				ret=pcapngParseIdb(pr,offset,blocklen);
+				if(ret!=0) {
+					return ret;
+				}
+			break;
+
+			case PCAPNG_BT_EPB:
+			case PCAPNG_BT_PB:
+				if(blocklen<PCAPNG_EPB_OVERHEAD) {
+					return ERR_PCAP_FORMAT;
+				}
+
+				// The obsolete Packet Block stores a 16-bit interface identifier, followed by a 16-bit drops counter
+				ifid=type==PCAPNG_BT_EPB ? pcapGet32(pr,blk+8) : pcapGet16(pr,blk+8);
+				caplen=pcapGet32(pr,blk+20);
+
+				if(ifid>=pr->nifs || caplen>blocklen-PCAPNG_EPB_OVERHEAD) {
+					return ERR_PCAP_FORMAT;
+				}
+
+				frame->data=(byte_t *) blk+28;
+				frame->snaplen=caplen;
+				frame->len=pcapGet32(pr,blk+24);
+				pcapTsToTimespec(((uint64_t) pcapGet32(pr,blk+12) << 32) | pcapGet32(pr,blk+16),pr->if_tsunits[ifid],&frame->ts);
+				frame->ifindex=ifid;
+
+				pr->linktype=pr->if_linktype[ifid];
+
+				return 1;
+
+			case PCAPNG_BT_SPB:
+				// The Simple Packet Block carries no timestamp and refers to the first interface
+				if(blocklen<16 || pr->nifs==0) {
+					return ERR_PCAP_FORMAT;
+				}
+
+				frame->len=pcapGet32(pr,blk+8);
+				frame->snaplen=frame->len<blocklen-16 ? frame->len : blocklen-16;
+				frame->data=(byte_t *) blk+12;
+				frame->ts.tv_sec=0;
+				frame->ts.tv_nsec=0;
+				frame->ifindex=0;
+
+				pr->linktype=pr->if_linktype[0];
+
+				return 1;
+
+			default:
+				// Any other block (statistics, name resolution, custom blocks, ...) is skipped
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+	\brief Get the next frame from a pcap or pcapng file
+
+	This function fills _frame_ with the description of the next frame of the file, exactly as rxringNext() does for a PACKET_RX_RING:
+	_data_ points directly inside the mapped file (no copy is performed), _snaplen_ is the number of captured _bytes_, _len_ the original
+	length of the frame and _ts_ its timestamp. _ifindex_ is set to the identifier of the interface inside the pcapng file (**0** for a classic pcap file).
+
+	The link type of the frame is stored inside the _linktype_ field of _pr_: only the frames with [PCAP_LINKTYPE_ETHERNET](\ref PCAP_LINKTYPE_ETHERNET)
+	can be passed to UDPgetpacketpointers() and to the other functions of the library.
+
+	\note Unlike the frames returned by rxringNext(), the data pointed by _frame_ remains valid until pcapreaderClose() is called.
+
+	\param[in,out]	pr 		Pointer to a [struct pcapreader](\ref pcapreader), opened with pcapreaderOpen().
+	\param[out]		frame 	Pointer to the [struct rxframe](\ref rxframe) to be filled in.
+
+	\return **1** if a new frame is available, **0** at the end of the file, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_FORMAT* -> the file is truncated or corrupted (the frames returned before the error are valid)
+**/
+int pcapreaderNext(struct pcapreader *pr, struct rxframe *frame) {
+	int ret;
+
+	ret=pr->pcapng ? pcapreaderNextPcapng(pr,frame) : pcapreaderNextPcap(pr,frame);
+
+	if(ret==1) {
+		pr->frames++;
+	}
+
+	return ret;
+}
+
+/**
+	\brief Get a batch of frames from a pcap or pcapng file
+
+	This function works like pcapreaderNext(), but it fills up to _n_ [struct rxframe](\ref rxframe) structures at once, as rxringNextBatch() does.
+
+	\param[in,out]	pr 		Pointer to a [struct pcapreader](\ref pcapreader), opened with pcapreaderOpen().
+	\param[out]		frames 	Array of [struct rxframe](\ref rxframe) to be filled in.
+	\param[in]		n 		Number of elements of _frames_.
+
+	\return The number of frames stored inside _frames_ (**0** at the end of the file), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error
+	(see pcapreaderNext()), if it occurred before reading any frame.
+**/
+int pcapreaderNextBatch(struct pcapreader *pr, struct rxframe *frames, unsigned int n) {
+	unsigned int i;
+	int ret;
+
+	for(i=0;i<n;i++) {
+		ret=pcapreaderNext(pr,&frames[i]);
+
+		if(ret!=1) {
+			return i==0 ? ret : (int) i;
+		}
+	}
+
+	return i;
+}
+
+/**
+	\brief Go back to the first frame of a pcap or pcapng file
+
+	\param[in,out]	pr 		Pointer to a [struct pcapreader](\ref pcapreader), opened with pcapreaderOpen().
+
+	\return None.
+**/
+void pcapreaderRewind(struct pcapreader *pr) {
+	pr->offset=pr->start;
+	pr->frames=0;
+
+	if(pr->pcapng) {
+		pcapngParseShb(pr,0);
+	}
+}
+
+/**
+	\brief Close a pcap or pcapng file opened for reading
+
+	This function unmaps and closes the file: the frames returned by pcapreaderNext() are no longer valid after this call.
+
+	\param[in,out]	pr 		Pointer to the [struct pcapreader](\ref pcapreader) to be closed.
+
+	\return None.
+**/
+void pcapreaderClose(struct pcapreader *pr) {
+	if(pr->map!=NULL) {
+		munmap(pr->map,pr->mapsize);
+	}
+
+	if(pr->fd>=0) {
+		close(pr->fd);
+	}
+
+	pr->map=NULL;
+	pr->mapsize=0;
+	pr->fd=-1;
+}
@@ -0,0 +1,130 @@
+/** \file
+	Packet capture files (pcap and pcapng) support for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to save the received frames (and the frames built for transmission)
+	inside a _pcapng_ file, which can then be opened with Wireshark or tcpdump, instead of printing them with display_packet().
+
+	A [struct pcapwriter](\ref pcapwriter) accumulates the pcapng blocks inside a large memory buffer, which is written to the file with a single
+	_write()_ call only when it is full (or when pcapwriterFlush() is called): saving a frame costs a single copy, with no system call, so that
+	the capture can be kept enabled without slowing down the traffic path. Each frame can also be truncated to a certain _snaplen_ (e.g. to keep
+	only the headers), to reduce both the copy and the file size.
+
+	Each capture interface is described by an Interface Description Block, storing its name, link type, snaplen and timestamp resolution
+	(microseconds or nanoseconds); each frame is then stored inside an Enhanced Packet Block, together with its timestamp (the kernel reception
+	timestamp, when available, e.g. from rawRecvBatch() or rxringNext()).
+
+	__Example of use:__
+
+		struct pcapwriter pw;
+		struct recvframe frames[N];
+
+		pcapwriterOpen(&pw,"capture.pcapng",0);
+		pcapwriterAddInterface(&pw,ifindex,"eth0",PCAP_LINKTYPE_ETHERNET,128,true); // Keep the first 128 bytes of each frame, nanosecond timestamps
+
+		rawRecvBatchEnableTimestamps(sFd);
+
+		while(...) {
+			n=rawRecvBatch(sFd,frames,N,0);
+
+			for(i=0;i<n;i++) {
+				pcapwriterWriteRecvframe(&pw,&frames[i]);
+			}
+		}
+
+		pcapwriterClose(&pw);
+
+	Captured traces can be read back with a [struct pcapreader](\ref pcapreader), which maps a whole _pcap_ or _pcapng_ file in memory and returns
+	its frames as [struct rxframe](\ref rxframe) structures, exactly as rxringNext() does for the frames received through a PACKET_RX_RING.
+	The parsing, validation and statistics code (e.g. UDPgetpacketpointers(), validateEthCsum(), lampHeadGetData()) can thus be run over real traffic
+	at memory speed, without any interface, network or special privilege:
+
+		struct pcapreader pr;
+		struct rxframe frame;
+
+		pcapreaderOpen(&pr,"capture.pcapng");
+
+		while(pcapreaderNext(&pr,&frame)==1) {
+			if(pr.linktype==PCAP_LINKTYPE_ETHERNET && frame.snaplen==frame.len) {
+				payload=UDPgetpacketpointers(frame.data,&etherHeader,&IPheader,&udpHeader);
+				... // Process the frame
+			}
+		}
+
+		pcapreaderClose(&pr);
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_PCAP_H_INCLUDED
+#define RAWSOCK_PCAP_H_INCLUDED
+
+#include "rawsock.h"
+#include <stdint.h>
+
+#define PCAP_LINKTYPE_ETHERNET 1 /**< Ethernet link type (_LINKTYPE_ETHERNET_), to be used for all the frames handled by the Rawsock library. */
+
+#define PCAPW_DEFAULT_BUFSIZE (1024*1024) /**< Default size, in _bytes_, of the write buffer of a [struct pcapwriter](\ref pcapwriter). */
+#define PCAPW_MAX_SNAPLEN 65535 /**< Maximum number of _bytes_ saved for each frame (larger frames are always truncated to this size). */
+#define PCAPW_MIN_BUFSIZE (PCAPW_MAX_SNAPLEN+1024) /**< Minimum size, in _bytes_, of the write buffer, so that any block can be stored inside it. */
+#define PCAPW_MAX_INTERFACES 16 /**< Maximum number of interfaces which can be added to a single [struct pcapwriter](\ref pcapwriter). */
+
+/**
+	\brief pcapng writer
+
+	Structure describing a pcapng file opened for writing with pcapwriterOpen(). The _packets_ and _truncated_ counters can be read directly by the user,
+	but the fields should not be modified.
+**/
+struct pcapwriter {
+	int fd; /**< Descriptor of the pcapng file. */
+	byte_t *buf; /**< Write buffer. */
+	size_t bufsize; /**< Size, in _bytes_, of _buf_. */
+	size_t used; /**< Number of _bytes_ stored inside _buf_ and not yet written to the file. */
+	unsigned int nifs; /**< Number of interfaces added with pcapwriterAddInterface(). */
+	int ifindex[PCAPW_MAX_INTERFACES]; /**< System index of each interface (used to find the interface of a received frame), or **0** if unknown. */
+	uint32_t snaplen[PCAPW_MAX_INTERFACES]; /**< Maximum number of _bytes_ saved for each frame, for each interface. */
+	bool nsec[PCAPW_MAX_INTERFACES]; /**< _true_ if the timestamps of each interface are stored with a nanosecond resolution, _false_ if with a microsecond one. */
+	uint64_t packets; /**< Number of frames saved. */
+	uint64_t truncated; /**< Number of frames which were truncated to the interface snaplen. */
+};
+
+#define PCAPR_MAX_INTERFACES 64 /**< Maximum number of interfaces inside each section of a pcapng file read by a [struct pcapreader](\ref pcapreader). */
+
+/**
+	\brief pcap/pcapng reader
+
+	Structure describing a _pcap_ or _pcapng_ file opened for reading with pcapreaderOpen(). The _linktype_ and _frames_ fields can be read directly by the user,
+	but the fields should not be modified.
+**/
+struct pcapreader {
+	int fd; /**< Descriptor of the file. */
+	byte_t *map; /**< Memory-mapped file. */
+	size_t mapsize; /**< Size, in _bytes_, of _map_ (i.e. of the file). */
+	size_t offset; /**< Offset of the next record (or block) to be read. */
+	size_t start; /**< Offset of the first record (or block), used by pcapreaderRewind(). */
+	bool pcapng; /**< _true_ if the file is a pcapng file, _false_ if it is a classic pcap file. */
+	bool swapped; /**< _true_ if the file was written with a byte order different from the one of this system. */
+	unsigned int nifs; /**< Number of interfaces described inside the current section (pcapng only). */
+	uint16_t if_linktype[PCAPR_MAX_INTERFACES]; /**< Link type of each interface (for a classic pcap file, only the first element is used). */
+	uint64_t if_tsunits[PCAPR_MAX_INTERFACES]; /**< Number of timestamp units per second of each interface (for a classic pcap file, only the first element is used). */
+	uint16_t linktype; /**< Link type of the last frame returned by pcapreaderNext() (e.g. [PCAP_LINKTYPE_ETHERNET](\ref PCAP_LINKTYPE_ETHERNET)). */
+	uint64_t frames; /**< Number of frames returned since the file was opened (or rewound). */
+};
+
+rawsockerr_t pcapwriterOpen(struct pcapwriter *pw, const char *filename, size_t bufsize);
+int pcapwriterAddInterface(struct pcapwriter *pw, int ifindex, const char *name, uint16_t linktype, uint32_t snaplen, bool nsec);
+rawsockerr_t pcapwriterWrite(struct pcapwriter *pw, int ifid, const byte_t *frame, size_t len, const struct timespec *ts);
+rawsockerr_t pcapwriterWriteRecvframe(struct pcapwriter *pw, const struct recvframe *frame);
+rawsockerr_t pcapwriterWriteRxframe(struct pcapwriter *pw, const struct rxframe *frame);
+rawsockerr_t pcapwriterWriteFramebuf(struct pcapwriter *pw, int ifid, const struct framebuf *fb, const struct timespec *ts);
+rawsockerr_t pcapwriterFlush(struct pcapwriter *pw);
+rawsockerr_t pcapwriterClose(struct pcapwriter *pw);
+
+rawsockerr_t pcapreaderOpen(struct pcapreader *pr, const char *filename);
+int pcapreaderNext(struct pcapreader *pr, struct rxframe *frame);
+int pcapreaderNextBatch(struct pcapreader *pr, struct rxframe *frames, unsigned int n);
+void pcapreaderRewind(struct pcapreader *pr);
+void pcapreaderClose(struct pcapreader *pr);
+#endif
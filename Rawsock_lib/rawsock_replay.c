@@ -0,0 +1,444 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_replay.h"
+#include "rawsock_csum.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#define REPLAY_TCP_HDR_SIZE 20 // Minimum size of a TCP header
+#define REPLAY_TCP_CSUM_OFFSET 16 // Offset of the checksum field inside the TCP header
+
+// Convert a struct timespec into nanoseconds
+static inline uint64_t replayTsNs(const struct timespec *ts) {
+	return (uint64_t) ts->tv_sec*1000000000ULL+ts->tv_nsec;
+}
+
+// Compute the release instant, read from the replay clock, of a frame captured at 'tsns', when the first frame of the current loop,
+//  captured at 'base_ts', was released at 'base_clk'
+static inline uint64_t replayReleaseTime(struct replay *rp, uint64_t base_ts, uint64_t base_clk, uint64_t tsns) {
+	// Frames with a timestamp earlier than the first one (e.g. reordered by the capture) are released immediately
+	if(tsns<=base_ts) {
+		return base_clk;
+	}
+
+	return base_clk+(uint64_t) ((double) (tsns-base_ts)/rp->params.speed);
+}
+
+// Make sure that the next frame to be sent is stored inside 'rp->next', reading it from the file if needed
+static int replayPeek(struct replay *rp) {
+	int ret;
+
+	if(rp->next_valid) {
+		return 1;
+	}
+
+	ret=pcapreaderNext(&rp->pr,&rp->next);
+	rp->next_valid=(ret==1);
+
+	return ret;
+}
+
+// Apply the remapping rules (and the source MAC replacement) to the frame stored inside 'packet'
+static void replayRewrite(struct replay *rp, byte_t *packet, size_t len) {
+	struct replayparams *params=&rp->params;
+	struct ether_header *etherHeader=(struct ether_header *) packet;
+	struct iphdr *IPheader;
+	csum16_t *l4check=NULL; // UDP or TCP checksum, which covers the IPv4 addresses too (pseudo-header)
+	bool l4udp=false;
+	__be32 *addrs[2];
+	__be32 oldaddr;
+	unsigned int i, j;
+	size_t ihl;
+
+	if(len<sizeof(struct ether_header)) {
+		return;
+	}
+
+	for(i=0;i<params->nmacremap;i++) {
+		if(memcmp(etherHeader->ether_dhost,params->macfrom[i],MAC_ADDR_SIZE)==0) {
+			memcpy(etherHeader->ether_dhost,params->macto[i],MAC_ADDR_SIZE);
+			break;
+		}
+	}
+
+	for(i=0;i<params->nmacremap;i++) {
+		if(memcmp(etherHeader->ether_shost,params->macfrom[i],MAC_ADDR_SIZE)==0) {
+			memcpy(etherHeader->ether_shost,params->macto[i],MAC_ADDR_SIZE);
+			break;
+		}
+	}
+
+	if(params->set_srcmac) {
+		memcpy(etherHeader->ether_shost,rp->srcmac,MAC_ADDR_SIZE);
+	}
+
+	if(params->nipremap==0 || ntohs(etherHeader->ether_type)!=ETHERTYPE_IP || len<sizeof(struct ether_header)+sizeof(struct iphdr)) {
+		return;
+	}
+
+	IPheader=(struct iphdr *) (packet+sizeof(struct ether_header));
+	ihl=IPheader->ihl*4;
+
+	if(ihl<sizeof(struct iphdr) || len<sizeof(struct ether_header)+ihl) {
+		return;
+	}
+
+	// The UDP and TCP checksums cover the addresses too (pseudo-header), but only the first fragment carries the transport header
+	// Any other transport protocol checksum (e.g. ICMP, which does not cover the addresses) is left as it is
+	if((ntohs(IPheader->frag_off) & 0x1FFF)==0) {
+		if(IPheader->protocol==IPPROTO_UDP && len>=sizeof(struct ether_header)+ihl+sizeof(struct udphdr)) {
+			l4check=&((struct udphdr *) (packet+sizeof(struct ether_header)+ihl))->check;
+			l4udp=true;
+		} else if(IPheader->protocol==IPPROTO_TCP && len>=sizeof(struct ether_header)+ihl+REPLAY_TCP_HDR_SIZE) {
+			l4check=(csum16_t *) (packet+sizeof(struct ether_header)+ihl+REPLAY_TCP_CSUM_OFFSET);
+		}
+	}
+
+	addrs[0]=&IPheader->saddr;
+	addrs[1]=&IPheader->daddr;
+
+	for(j=0;j<2;j++) {
+		for(i=0;i<params->nipremap;i++) {
+			if(*addrs[j]==params->ipfrom[i].s_addr) {
+				oldaddr=*addrs[j];
+				*addrs[j]=params->ipto[i].s_addr;
+
+				if(params->update_csum) {
+					IPheader->check=csum_replace4(IPheader->check,oldaddr,*addrs[j]);
+
+					// A zero UDP checksum means that no checksum was computed: it should be left as it is
+					if(l4check!=NULL && (!l4udp || *l4check!=0)) {
+						*l4check=csum_replace4(*l4check,oldaddr,*addrs[j]);
+						if(l4udp && *l4check==0) {
+							*l4check=0xFFFF;
+						}
+					}
+				}
+
+				break;
+			}
+		}
+	}
+}
+
+// Prepare the batch frame descriptor 'bframe' (slot 'slot' of the current batch) for the frame stored inside 'rp->next',
+//  copying and modifying it if needed; it returns false if the frame should be skipped
+static bool replayPrepare(struct replay *rp, struct batchframe *bframe, unsigned int slot) {
+	struct rxframe *frame=&rp->next;
+	byte_t *copy;
+
+	// Frames truncated by the capture snaplen are not sent, as they would reach the receiver as runt or malformed frames
+	if(rp->pr.linktype!=PCAP_LINKTYPE_ETHERNET || frame->snaplen<frame->len) {
+		return false;
+	}
+
+	// No modification is needed: the frame is sent directly from the mapped file
+	if(rp->copybuf==NULL) {
+		bframe->packet=frame->data;
+		bframe->len=frame->snaplen;
+
+		return true;
+	}
+
+	if(frame->snaplen>REPLAY_FRAME_MAX) {
+		return false;
+	}
+
+	copy=rp->copybuf+slot*REPLAY_FRAME_MAX;
+	memcpy(copy,frame->data,frame->snaplen);
+	replayRewrite(rp,copy,frame->snaplen);
+
+	bframe->packet=copy;
+	bframe->len=frame->snaplen;
+
+	return true;
+}
+
+// Send a batch of 'n' frames and update the counters
+static void replaySend(struct replay *rp, struct batchframe *frames, unsigned int n) {
+	unsigned int i;
+
+	rawSendBatch(rp->descriptor,rp->addrll,frames,n);
+
+	for(i=0;i<n;i++) {
+		if(frames[i].err==0) {
+			rp->sent++;
+			rp->bytes+=frames[i].len;
+		} else {
+			rp->failed++;
+		}
+	}
+}
+
+/**
+	\brief Initialize a [struct replayparams](\ref replayparams) with the default settings
+
+	By default, the file is sent once, keeping the original timing, without modifying the frames.
+
+	\param[out]	params 	Pointer to the [struct replayparams](\ref replayparams) to be initialized.
+
+	\return None.
+**/
+void replayParamsDefault(struct replayparams *params) {
+	params->mode=REPLAY_TIMED;
+	params->speed=1.0;
+	params->loops=1;
+	params->batch=RAWSEND_BATCH_MAX;
+	params->batch_window_ns=0;
+	params->margin_ns=PACER_DEFAULT_MARGIN_NS;
+	params->set_srcmac=false;
+	params->update_csum=true;
+	params->nmacremap=0;
+	params->nipremap=0;
+}
+
+/**
+	\brief Add a MAC address remapping rule
+
+	All the occurrences of the MAC address _from_, both as destination and as source address, are replaced with _to_ before sending each frame.
+
+	\param[in,out]	params 	Pointer to the [struct replayparams](\ref replayparams), initialized with replayParamsDefault().
+	\param[in]		from 	Original MAC address.
+	\param[in]		to 		New MAC address.
+
+	\return **0** if the rule was added, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_REPLAY_PARAMS* -> too many rules (see [REPLAY_MAX_REMAP](\ref REPLAY_MAX_REMAP))
+**/
+rawsockerr_t replayRemapMac(struct replayparams *params, macaddr_t from, macaddr_t to) {
+	if(params->nmacremap==REPLAY_MAX_REMAP) {
+		return ERR_REPLAY_PARAMS;
+	}
+
+	memcpy(params->macfrom[params->nmacremap],from,MAC_ADDR_SIZE);
+	memcpy(params->macto[params->nmacremap],to,MAC_ADDR_SIZE);
+	params->nmacremap++;
+
+	return 0;
+}
+
+/**
+	\brief Add an IPv4 address remapping rule
+
+	All the occurrences of the IPv4 address _from_, both as destination and as source address, are replaced with _to_ before sending each frame.
+	The IPv4, UDP and TCP checksums are then incrementally updated, if _update_csum_ is _true_ (the checksums of the other transport protocols are left untouched).
+
+	\param[in,out]	params 	Pointer to the [struct replayparams](\ref replayparams), initialized with replayParamsDefault().
+	\param[in]		from 	Original IPv4 address.
+	\param[in]		to 		New IPv4 address.
+
+	\return **0** if the rule was added, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_REPLAY_PARAMS* -> too many rules (see [REPLAY_MAX_REMAP](\ref REPLAY_MAX_REMAP))
+**/
+rawsockerr_t replayRemapIP(struct replayparams *params, struct in_addr from, struct in_addr to) {
+	if(params->nipremap==REPLAY_MAX_REMAP) {
+		return ERR_REPLAY_PARAMS;
+	}
+
+	params->ipfrom[params->nipremap]=from;
+	params->ipto[params->nipremap]=to;
+	params->nipremap++;
+
+	return 0;
+}
+
+/**
+	\brief Open a replay session
+
+	This function looks for the output interface with wlanLookup() (using the same _index_ and _mode_ arguments), opens a raw socket
+	to send the frames on it and opens the capture file _filename_ (see pcapreaderOpen()).
+
+	The replay clock is a calibrated TSC, if available (see rsclockInitTsc()), or the monotonic clock: this function may thus take about 100 _ms_.
+
+	\param[out]	rp 			Pointer to the [struct replay](\ref replay) to be initialized.
+	\param[in]	filename 	Name of the pcap or pcapng file to be sent.
+	\param[in]	index 		Index of the output interface, as in wlanLookup() (e.g. **0** for the first interface of the selected type).
+	\param[in]	mode 		Type of the output interface, as in wlanLookup() ([WLANLOOKUP_WLAN](\ref WLANLOOKUP_WLAN) or [WLANLOOKUP_NONWLAN](\ref WLANLOOKUP_NONWLAN)).
+	\param[in]	params 		Pointer to the replay settings (see replayParamsDefault()).
+
+	\return **0** if the session was opened, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_REPLAY_PARAMS* -> invalid settings (e.g. non-positive speed or batch size out of range)
+	- *ERR_REPLAY_IFACE* -> the output interface cannot be found (see wlanLookup())
+	- *ERR_REPLAY_SOCKET* -> the raw socket cannot be created (root privileges, or _CAP_NET_RAW_, are needed)
+	- *ERR_REPLAY_ALLOC* -> the buffer for the modified frames cannot be allocated
+	- any error returned by pcapreaderOpen()
+**/
+rawsockerr_t replayOpen(struct replay *rp, const char *filename, int index, int mode, struct replayparams *params) {
+	int ifindex;
+	rawsockerr_t ret;
+
+	if(params->loops==0 || params->batch==0 || params->batch>RAWSEND_BATCH_MAX || (params->mode==REPLAY_TIMED && !(params->speed>0))) {
+		return ERR_REPLAY_PARAMS;
+	}
+
+	rp->params=*params;
+
+	if(wlanLookup(rp->devname,&ifindex,rp->srcmac,NULL,index,mode)<=0) {
+		return ERR_REPLAY_IFACE;
+	}
+
+	// Protocol 0: the socket is used only to send frames, and it does not receive any frame
+	rp->descriptor=socket(AF_PACKET,SOCK_RAW,0);
+	if(rp->descriptor<0) {
+		return ERR_REPLAY_SOCKET;
+	}
+
+	memset(&rp->addrll,0,sizeof(rp->addrll));
+	rp->addrll.sll_family=AF_PACKET;
+	rp->addrll.sll_ifindex=ifindex;
+	rp->addrll.sll_protocol=htons(ETH_P_ALL);
+
+	ret=pcapreaderOpen(&rp->pr,filename);
+	if(ret!=0) {
+		close(rp->descriptor);
+		return ret;
+	}
+
+	rp->copybuf=NULL;
+	if(params->nmacremap>0 || params->nipremap>0 || params->set_srcmac) {
+		rp->copybuf=malloc(params->batch*REPLAY_FRAME_MAX);
+
+		if(rp->copybuf==NULL) {
+			pcapreaderClose(&rp->pr);
+			close(rp->descriptor);
+			return ERR_REPLAY_ALLOC;
+		}
+	}
+
+	if(rsclockInitTsc(&rp->clk,CLOCKSRC_MONOTONIC,RSCLOCK_CALIB_MS)!=0) {
+		rsclockInit(&rp->clk,CLOCKSRC_MONOTONIC);
+	}
+
+	rp->next_valid=false;
+	rp->stop=0;
+	rp->sent=0;
+	rp->failed=0;
+	rp->skipped=0;
+	rp->bytes=0;
+
+	return 0;
+}
+
+/**
+	\brief Send all the frames of the capture file
+
+	This function sends all the frames of the file, _loops_ times, as described by the replay settings, and returns when all of them have been sent
+	(or when replayStop() is called). The counters of _rp_ are updated while the frames are sent.
+
+	With [REPLAY_TIMED](\ref REPLAY_TIMED), the first frame of each loop is sent immediately, and each following frame is released at the same
+	distance from it as in the capture, divided by _speed_.
+
+	\param[in,out]	rp 			Pointer to the [struct replay](\ref replay), opened with replayOpen().
+	\param[in]		lateness 	Pointer to a [struct lathist](\ref lathist), already initialized, in which the release lateness of each batch is recorded
+								(with [REPLAY_TIMED](\ref REPLAY_TIMED) only), or NULL.
+
+	\return **0** if the whole file was sent (the frames refused by the kernel are counted in _failed_), or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_PCAP_FORMAT* -> the file is truncated or corrupted (the frames before the error were sent)
+**/
+rawsockerr_t replayRun(struct replay *rp, struct lathist *lateness) {
+	struct batchframe frames[RAWSEND_BATCH_MAX];
+	struct pacerparams pacerparams;
+	bool timed=rp->params.mode==REPLAY_TIMED;
+	bool first;
+	uint64_t base_ts=0, base_clk=0, tsns, now=0;
+	unsigned int loop, n;
+	int ret=0;
+
+	pacerParamsDefault(&pacerparams);
+	pacerparams.margin_ns=rp->params.margin_ns;
+	pacerInit(&rp->pacer,&rp->clk,&pacerparams,lateness);
+
+	for(loop=0;loop<rp->params.loops;loop++) {
+		pcapreaderRewind(&rp->pr);
+		rp->next_valid=false;
+		first=true;
+
+		while(!__atomic_load_n(&rp->stop,__ATOMIC_RELAXED)) {
+			ret=replayPeek(rp);
+			if(ret<=0) {
+				break;
+			}
+
+			// Wait until the first frame of the batch is due
+			if(timed) {
+				tsns=replayTsNs(&rp->next.ts);
+
+				if(first) {
+					base_ts=tsns;
+					base_clk=rsclockNowNs(&rp->clk);
+					first=false;
+				}
+
+				now=pacerWaitUntil(&rp->pacer,replayReleaseTime(rp,base_ts,base_clk,tsns));
+			}
+
+			// Add to the batch all the following frames which are already due (or all of them, at top speed)
+			n=0;
+			do {
+				if(replayPrepare(rp,&frames[n],n)) {
+					n++;
+				} else {
+					rp->skipped++;
+				}
+
+				rp->next_valid=false;
+
+				if(n==rp->params.batch) {
+					break;
+				}
+
+				ret=replayPeek(rp);
+			} while(ret==1 && (!timed || replayReleaseTime(rp,base_ts,base_clk,replayTsNs(&rp->next.ts))<=now+rp->params.batch_window_ns));
+
+			if(n>0) {
+				replaySend(rp,frames,n);
+			}
+
+			if(ret<0) {
+				break;
+			}
+		}
+
+		if(ret<0) {
+			return ret;
+		}
+
+		if(__atomic_load_n(&rp->stop,__ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+	\brief Stop a replay session
+
+	This function asks replayRun() to return as soon as possible, after sending the current batch. It can be safely called from a signal handler
+	or from another thread.
+
+	\param[in,out]	rp 		Pointer to the [struct replay](\ref replay), opened with replayOpen().
+
+	\return None.
+**/
+void replayStop(struct replay *rp) {
+	__atomic_store_n(&rp->stop,1,__ATOMIC_RELAXED);
+}
+
+/**
+	\brief Close a replay session
+
+	This function closes the capture file and the raw socket, and frees the buffer of the modified frames.
+
+	\param[in,out]	rp 		Pointer to the [struct replay](\ref replay) to be closed.
+
+	\return None.
+**/
+void replayClose(struct replay *rp) {
+	pcapreaderClose(&rp->pr);
+	close(rp->descriptor);
+	free(rp->copybuf);
+
+	rp->copybuf=NULL;
+	rp->descriptor=-1;
+}
@@ -0,0 +1,121 @@
+/** \file
+	Capture replay for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to send again the frames stored inside a _pcap_ or _pcapng_ file
+	(see rawsock_pcap.h), for instance to load-test a receiver with recorded V2X/GeoNetworking traffic, in a similar way to _tcpreplay_.
+
+	A [struct replay](\ref replay) resolves the output interface with wlanLookup(), opens its own raw socket on it and reads the file through
+	a [struct pcapreader](\ref pcapreader). The frames can be sent:
+	- keeping the original inter-frame gaps, divided by a _speed_ factor ([REPLAY_TIMED](\ref REPLAY_TIMED)): each frame is released at an absolute
+	  instant computed from its capture timestamp, waiting with a [struct pacer](\ref pacer) (see pacerWaitUntil()), so that the errors do not accumulate.
+	  All the frames which are already due (or which will be due within _batch_window_ns_) are sent together, with a single rawSendBatch() call, so that
+	  the replay can keep up with the original timestamps even at high rates.
+	- as fast as possible ([REPLAY_TOPSPEED](\ref REPLAY_TOPSPEED)), in batches of _batch_ frames.
+
+	The frames are sent directly from the memory-mapped file, unless they have to be modified: the MAC and IPv4 addresses can be remapped
+	(see replayRemapMac() and replayRemapIP()) and the source MAC address can be replaced with the one of the output interface. In this case,
+	each frame is copied once, and the IPv4, UDP and TCP checksums are incrementally updated (see csum_replace4()), unless _update_csum_ is _false_.
+	The checksums of the other transport protocols are left as they are (the ICMP one, for instance, does not cover the IPv4 addresses).
+	The frames which were truncated by the capture snaplen are never sent, and they are counted as skipped.
+
+	__Example of use:__
+
+		struct replay rp;
+		struct replayparams params;
+		struct in_addr from, to;
+
+		replayParamsDefault(&params);
+		params.speed=2.0; // Twice as fast as the original capture
+
+		inet_pton(AF_INET,"192.168.1.10",&from);
+		inet_pton(AF_INET,"10.0.0.10",&to);
+		replayRemapIP(&params,from,to);
+
+		replayOpen(&rp,"v2x_capture.pcapng",0,WLANLOOKUP_WLAN,&params);
+		replayRun(&rp,NULL);
+
+		printf("Sent: %lu, failed: %lu, skipped: %lu\n",rp.sent,rp.failed,rp.skipped);
+
+		replayClose(&rp);
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_REPLAY_H_INCLUDED
+#define RAWSOCK_REPLAY_H_INCLUDED
+
+#include "rawsock.h"
+#include "rawsock_pcap.h"
+#include "rawsock_clock.h"
+#include "rawsock_pacer.h"
+
+#define REPLAY_MAX_REMAP 16 /**< Maximum number of MAC and IPv4 address remapping rules (each). */
+#define REPLAY_FRAME_MAX 9216 /**< Maximum size, in _bytes_, of a frame which is modified before being sent (larger frames are skipped). */
+
+/**
+	\brief Replay mode enumerator
+**/
+typedef enum {
+	REPLAY_TIMED, /**< The original inter-frame gaps are kept, divided by the _speed_ factor. */
+	REPLAY_TOPSPEED /**< The frames are sent as fast as possible. */
+} replaymode_t;
+
+/**
+	\brief Replay settings
+
+	Structure containing the settings of a [struct replay](\ref replay): it should be initialized with replayParamsDefault(), and then
+	the desired fields can be changed (and the remapping rules added) before calling replayOpen().
+**/
+struct replayparams {
+	replaymode_t mode; /**< Replay mode (default: [REPLAY_TIMED](\ref REPLAY_TIMED)). */
+	double speed; /**< Speed factor, with [REPLAY_TIMED](\ref REPLAY_TIMED): the original gaps are divided by this value (default: **1.0**, i.e. the original timing). */
+	unsigned int loops; /**< Number of times the whole file is sent (default: **1**). */
+	unsigned int batch; /**< Maximum number of frames sent with a single system call, up to [RAWSEND_BATCH_MAX](\ref RAWSEND_BATCH_MAX) (default: [RAWSEND_BATCH_MAX](\ref RAWSEND_BATCH_MAX)). */
+	uint64_t batch_window_ns; /**< With [REPLAY_TIMED](\ref REPLAY_TIMED), the frames which will be due within this time, in _ns_, are sent in advance, together with the current one (default: **0**). */
+	uint64_t margin_ns; /**< Sleep margin of the pacer, in _ns_ (default: [PACER_DEFAULT_MARGIN_NS](\ref PACER_DEFAULT_MARGIN_NS); see pacerCalibrateMargin()). */
+	bool set_srcmac; /**< If _true_, the source MAC address of each frame is replaced with the one of the output interface (default: _false_). */
+	bool update_csum; /**< If _true_, the IPv4, UDP and TCP checksums are incrementally updated when the IPv4 addresses are remapped (default: _true_). */
+	unsigned int nmacremap; /**< Number of MAC address remapping rules. */
+	uint8_t macfrom[REPLAY_MAX_REMAP][MAC_ADDR_SIZE]; /**< Original MAC address of each MAC remapping rule. */
+	uint8_t macto[REPLAY_MAX_REMAP][MAC_ADDR_SIZE]; /**< New MAC address of each MAC remapping rule. */
+	unsigned int nipremap; /**< Number of IPv4 address remapping rules. */
+	struct in_addr ipfrom[REPLAY_MAX_REMAP]; /**< Original IPv4 address of each IPv4 remapping rule. */
+	struct in_addr ipto[REPLAY_MAX_REMAP]; /**< New IPv4 address of each IPv4 remapping rule. */
+};
+
+/**
+	\brief Replay session
+
+	Structure describing a replay session, opened with replayOpen(). The counters (_sent_, _failed_, _skipped_ and _bytes_) can be read directly
+	by the user, but the other fields should not be modified.
+**/
+struct replay {
+	struct replayparams params; /**< Replay settings. */
+	struct pcapreader pr; /**< Reader of the capture file. */
+	int descriptor; /**< Raw socket used to send the frames. */
+	struct sockaddr_ll addrll; /**< Link layer address of the output interface. */
+	char devname[IFDESC_NAME_SIZE]; /**< Name of the output interface. */
+	uint8_t srcmac[MAC_ADDR_SIZE]; /**< MAC address of the output interface. */
+	struct rsclock clk; /**< Clock used to release the frames. */
+	struct pacer pacer; /**< Pacer used to wait until the release instant of each batch. */
+	byte_t *copybuf; /**< Buffer storing the modified frames of the current batch, or NULL if the frames are never modified. */
+	struct rxframe next; /**< Frame already read from the file but not yet sent. */
+	bool next_valid; /**< _true_ if _next_ contains a frame. */
+	int stop; /**< Set by replayStop() to stop replayRun() as soon as possible. */
+	uint64_t sent; /**< Number of frames successfully sent. */
+	uint64_t failed; /**< Number of frames refused by the kernel. */
+	uint64_t skipped; /**< Number of frames which were not sent (not Ethernet, truncated by the capture snaplen, or too large to be modified). */
+	uint64_t bytes; /**< Number of _bytes_ successfully sent. */
+};
+
+void replayParamsDefault(struct replayparams *params);
+rawsockerr_t replayRemapMac(struct replayparams *params, macaddr_t from, macaddr_t to);
+rawsockerr_t replayRemapIP(struct replayparams *params, struct in_addr from, struct in_addr to);
+rawsockerr_t replayOpen(struct replay *rp, const char *filename, int index, int mode, struct replayparams *params);
+rawsockerr_t replayRun(struct replay *rp, struct lathist *lateness);
+void replayStop(struct replay *rp);
+void replayClose(struct replay *rp);
+#endif
@@ -0,0 +1,735 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_ring.h"
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Offset of the frame data with respect to the beginning of each TPACKET_V2 slot (it is the one used by the kernel when PACKET_TX_HAS_OFF is not set)
+#define TXRING_DATA_OFFSET (TPACKET2_HDRLEN-sizeof(struct sockaddr_ll))
+
+// Get the pointer to the slot header of the slot with index 'index'
+static inline struct tpacket2_hdr *txringSlot(struct txring *ring, unsigned int index) {
+	return (struct tpacket2_hdr *) (ring->map+(index/ring->frames_per_block)*ring->block_size+(index%ring->frames_per_block)*ring->frame_size);
+}
+
+/**
+	\brief Initialize a [struct txringparams](\ref txringparams) with the default settings
+
+	The default settings are [TXRING_DEFAULT_FRAME_SIZE](\ref TXRING_DEFAULT_FRAME_SIZE), [TXRING_DEFAULT_FRAME_NR](\ref TXRING_DEFAULT_FRAME_NR) and
+	[TXRING_DEFAULT_FLUSH_THRESHOLD](\ref TXRING_DEFAULT_FLUSH_THRESHOLD). Any of them can then be changed before calling txringOpen().
+
+	\param[out]	params 	Pointer to the [struct txringparams](\ref txringparams) to be initialized.
+
+	\return None.
+**/
+void txringParamsDefault(struct txringparams *params) {
+	params->frame_size=TXRING_DEFAULT_FRAME_SIZE;
+	params->frame_nr=TXRING_DEFAULT_FRAME_NR;
+	params->flush_threshold=TXRING_DEFAULT_FLUSH_THRESHOLD;
+}
+
+/**
+	\brief Set up a PACKET_TX_RING over an existing raw socket
+
+	This function sets up a _TPACKET_V2_ transmission ring over the specified *AF_PACKET* socket, and maps it inside the memory of the
+	current process. The socket should have been created with `socket(AF_PACKET,SOCK_RAW,...)`, and it should be dedicated to the ring
+	(i.e. no other ring should be set on it).
+
+	The number of slots may be larger than the requested one, as the ring is made of memory blocks with a size which is a multiple of the page size,
+	which are always completely filled with slots. The actual values can be obtained with txringFrameSize() and txringFrameNr().
+
+	\param[out]	ring 		Pointer to the [struct txring](\ref txring) to be initialized.
+	\param[in]	descriptor 	*AF_PACKET* socket descriptor.
+	\param[in]	addrll 		Socket address structure (*struct sockaddr_ll*, i.e. the same structure you would pass to a call to <i>sendto()</i>), used every time the ring is flushed.
+	\param[in]	params 		Ring settings (it can be NULL to use the default ones, see txringParamsDefault()).
+
+	\return **0** if the ring was properly set up, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_TXRING_PARAMS* -> invalid frame size or number of frames
+	- *ERR_TXRING_SOCKOPT* -> unable to set up the ring on the socket (_errno_ is set by _setsockopt()_)
+	- *ERR_TXRING_MMAP* -> unable to map the ring (_errno_ is set by _mmap()_)
+**/
+rawsockerr_t txringOpen(struct txring *ring, int descriptor, struct sockaddr_ll addrll, struct txringparams *params) {
+	struct txringparams defparams;
+	struct tpacket_req req;
+	long pagesize;
+	int version=TPACKET_V2;
+	int hasoff=1;
+
+	if(params==NULL) {
+		txringParamsDefault(&defparams);
+		params=&defparams;
+	}
+
+	ring->frame_size=TPACKET_ALIGN(params->frame_size);
+	if(ring->frame_size<=TXRING_DATA_OFFSET || params->frame_nr==0) {
+		return ERR_TXRING_PARAMS;
+	}
+
+	pagesize=sysconf(_SC_PAGESIZE);
+	if(pagesize<=0) {
+		pagesize=4096;
+	}
+
+	// Each block should be a multiple of the page size, and it should contain at least one slot
+	ring->block_size=pagesize;
+	while(ring->block_size<ring->frame_size) {
+		ring->block_size<<=1;
+	}
+
+	ring->frames_per_block=ring->block_size/ring->frame_size;
+
+	req.tp_block_size=ring->block_size;
+	req.tp_block_nr=(params->frame_nr+ring->frames_per_block-1)/ring->frames_per_block;
+	req.tp_frame_size=ring->frame_size;
+	req.tp_frame_nr=req.tp_block_nr*ring->frames_per_block;
+
+	if(setsockopt(descriptor,SOL_PACKET,PACKET_VERSION,&version,sizeof(version))<0 ||
+		setsockopt(descriptor,SOL_PACKET,PACKET_TX_HAS_OFF,&hasoff,sizeof(hasoff))<0 ||
+		setsockopt(descriptor,SOL_PACKET,PACKET_TX_RING,&req,sizeof(req))<0) {
+		return ERR_TXRING_SOCKOPT;
+	}
+
+	ring->mapsize=(size_t) req.tp_block_size*req.tp_block_nr;
+	ring->map=mmap(NULL,ring->mapsize,PROT_READ | PROT_WRITE,MAP_SHARED,descriptor,0);
+	if(ring->map==MAP_FAILED) {
+		ring->map=NULL;
+		return ERR_TXRING_MMAP;
+	}
+
+	ring->descriptor=descriptor;
+	ring->addrll=addrll;
+	ring->frame_nr=req.tp_frame_nr;
+	ring->flush_threshold=params->flush_threshold;
+	ring->head=0;
+	ring->tail=0;
+	ring->inflight=0;
+	ring->pending=0;
+	ring->pending_txtime=0;
+
+	return 0;
+}
+
+/**
+	\brief Unmap a PACKET_TX_RING
+
+	This function unmaps a ring set up with txringOpen(). The socket is not closed, and the frames which were committed
+	but not yet flushed are discarded: txringFlush() should be called before this function, if needed.
+
+	\param[in]	ring 	Pointer to the [struct txring](\ref txring) to be closed.
+
+	\return None.
+**/
+void txringClose(struct txring *ring) {
+	if(ring->map!=NULL) {
+		munmap(ring->map,ring->mapsize);
+	}
+
+	ring->map=NULL;
+	ring->mapsize=0;
+	ring->inflight=0;
+	ring->pending=0;
+	ring->pending_txtime=0;
+}
+
+/**
+	\brief Get the maximum frame size supported by a PACKET_TX_RING
+
+	\param[in]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+
+	\return The maximum size, in _bytes_, of a frame which can be stored inside each slot of the ring.
+**/
+unsigned int txringFrameSize(struct txring *ring) {
+	return ring->frame_size-TXRING_DATA_OFFSET;
+}
+
+/**
+	\brief Get the number of slots of a PACKET_TX_RING
+
+	\param[in]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+
+	\return The actual number of slots of the ring.
+**/
+unsigned int txringFrameNr(struct txring *ring) {
+	return ring->frame_nr;
+}
+
+/**
+	\brief Change the flush threshold of a PACKET_TX_RING
+
+	\param[in,out]	ring 				Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]		flush_threshold 	Number of committed frames after which the ring is automatically flushed (**0** to disable the automatic flush).
+
+	\return None.
+**/
+void txringSetFlushThreshold(struct txring *ring, unsigned int flush_threshold) {
+	ring->flush_threshold=flush_threshold;
+}
+
+/**
+	\brief Get the next free slot of a PACKET_TX_RING
+
+	This function returns the pointer to the memory area, inside the next free slot of the ring, in which a frame (starting from the
+	Ethernet header) can be directly written. After writing it, txringCommit() should be called.
+
+	If all the slots are in use, the ones which were already sent by the kernel are reclaimed (see txringReclaim()). If no slot is free even
+	after that, NULL is returned: the ring should be flushed with txringFlush(), then a new attempt can be made (possibly after waiting for
+	the socket to become writable with _poll()_).
+
+	\param[in]	ring 		Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[out]	maxsize 	If not NULL, the maximum size, in _bytes_, of the frame which can be written is stored here.
+
+	\return The pointer to the frame area inside the next free slot, or NULL if the ring is full.
+**/
+byte_t *txringGetFrame(struct txring *ring, size_t *maxsize) {
+	if(ring->inflight==ring->frame_nr) {
+		txringReclaim(ring,NULL);
+
+		if(ring->inflight==ring->frame_nr) {
+			return NULL;
+		}
+	}
+
+	if(maxsize!=NULL) {
+		*maxsize=txringFrameSize(ring);
+	}
+
+	return (byte_t *) txringSlot(ring,ring->head)+TXRING_DATA_OFFSET;
+}
+
+/**
+	\brief Prepare a [struct framebuf](\ref framebuf) over the next free slot of a PACKET_TX_RING
+
+	This function works like txringGetFrame(), but it initializes a [struct framebuf](\ref framebuf) over the whole slot,
+	so that a frame can be built in place (with framebufCopyPayload() and the [*EncapsulateInPlace()](\ref UDPencapsulateInPlace)
+	functions) directly inside the ring. After building it, txringCommitFramebuf() should be called.
+
+	If not all the headroom is used, the frame is sent starting from the first header which was added, without moving it.
+
+	\param[in]	ring 		Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[out]	fb 			Pointer to the [struct framebuf](\ref framebuf) to be initialized (it should not be freed with framebufFree()).
+	\param[in]	headroom 	Space, in _bytes_, to be reserved for the headers (for instance [ETH_IP_UDP_HEADROOM](\ref ETH_IP_UDP_HEADROOM)).
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_TXRING_FULL* -> no free slot is available
+	- *ERR_FRAMEBUF_HEADROOM* -> the headroom is larger than the slot
+**/
+rawsockerr_t txringGetFramebuf(struct txring *ring, struct framebuf *fb, size_t headroom) {
+	size_t maxsize;
+	byte_t *frame=txringGetFrame(ring,&maxsize);
+
+	if(frame==NULL) {
+		return ERR_TXRING_FULL;
+	}
+
+	return framebufInit(fb,frame,maxsize,headroom);
+}
+
+// Mark the slot at the head of the ring as ready to be sent, with the frame starting 'offset' bytes after the beginning of the slot
+//  and with launch time 'txtime' (0 to send it immediately)
+static rawsockerr_t txringCommitOffset(struct txring *ring, size_t offset, size_t framesize, uint64_t txtime) {
+	struct tpacket2_hdr *hdr;
+	rawsockerr_t ret;
+
+	if(ring->inflight==ring->frame_nr) {
+		return ERR_TXRING_FULL;
+	}
+
+	if(offset<TXRING_DATA_OFFSET || offset+framesize>ring->frame_size) {
+		return ERR_TXRING_FRAMESIZE;
+	}
+
+	// The kernel applies a single launch time to all the frames sent with the same system call: the slots which were
+	//  committed with a different launch time are flushed before marking this one
+	if(ring->pending>0 && ring->pending_txtime!=txtime) {
+		ret=txringFlush(ring);
+
+		if(ret!=0) {
+			return ret;
+		}
+	}
+
+	hdr=txringSlot(ring,ring->head);
+	hdr->tp_len=framesize;
+	hdr->tp_mac=offset;
+	hdr->tp_net=offset;
+
+	// The frame content should be visible to the kernel before the status change
+	__atomic_store_n(&hdr->tp_status,TP_STATUS_SEND_REQUEST,__ATOMIC_RELEASE);
+
+	ring->head=(ring->head+1)%ring->frame_nr;
+	ring->inflight++;
+	ring->pending++;
+	ring->pending_txtime=txtime;
+
+	if(ring->flush_threshold>0 && ring->pending>=ring->flush_threshold) {
+		return txringFlush(ring);
+	}
+
+	return 0;
+}
+
+/**
+	\brief Commit a frame written inside a PACKET_TX_RING
+
+	This function marks the slot returned by the last call to txringGetFrame() as ready to be sent, with a frame of _framesize_ bytes.
+	The frame is actually sent only when the ring is flushed: this happens automatically every _flush_threshold_ committed frames
+	(see [struct txringparams](\ref txringparams)), or when txringFlush() is called.
+
+	\param[in,out]	ring 		Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]		framesize 	Size, in _bytes_, of the frame written inside the slot.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_TXRING_FULL* -> no slot was available (txringGetFrame() returned NULL)
+	- *ERR_TXRING_FRAMESIZE* -> the frame does not fit inside the slot
+	- *ERR_TXRING_SEND* -> the ring was automatically flushed, but the flush failed (see txringFlush())
+**/
+rawsockerr_t txringCommit(struct txring *ring, size_t framesize) {
+	return txringCommitOffset(ring,TXRING_DATA_OFFSET,framesize,0);
+}
+
+/**
+	\brief Commit a frame built inside a PACKET_TX_RING through a [struct framebuf](\ref framebuf)
+
+	This function works like txringCommit(), but the frame to be sent is described by a [struct framebuf](\ref framebuf),
+	previously prepared with txringGetFramebuf().
+
+	\param[in,out]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]		fb 		Pointer to the [struct framebuf](\ref framebuf) containing the frame.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see txringCommit()).
+**/
+rawsockerr_t txringCommitFramebuf(struct txring *ring, struct framebuf *fb) {
+	return txringCommitOffset(ring,fb->data-(byte_t *) txringSlot(ring,ring->head),fb->len,0);
+}
+
+/**
+	\brief Commit a frame written inside a PACKET_TX_RING, with a launch time
+
+	This function works like txringCommit(), but the frame will be sent by the qdisc at the launch time _txtime_ (see rawSendTxtime()),
+	which requires _SO_TXTIME_ to be enabled on the ring socket with rawTxtimeEnable().
+
+	As the kernel applies a single launch time to all the frames sent with the same flush, the frames committed after the last flush are
+	grouped by launch time: when a frame with a different launch time is committed, the previous ones are flushed first. Frames sharing the
+	same launch time (e.g. a whole burst to be released at once) are instead sent together.
+
+	\note The flushes of frames with a launch time do not wait for the frames to be sent (they use _MSG_DONTWAIT_), as the qdisc may hold them
+	for a long time: their slots are reclaimed later (see txringReclaim()).
+
+	\param[in,out]	ring 		Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]		framesize 	Size, in _bytes_, of the frame written inside the slot.
+	\param[in]		txtime 		Launch time, in _ns_, read from the clock specified in rawTxtimeEnable(), or **0** to send the frame immediately.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see txringCommit()).
+**/
+rawsockerr_t txringCommitTxtime(struct txring *ring, size_t framesize, uint64_t txtime) {
+	return txringCommitOffset(ring,TXRING_DATA_OFFSET,framesize,txtime);
+}
+
+/**
+	\brief Commit a frame built inside a PACKET_TX_RING through a [struct framebuf](\ref framebuf), with a launch time
+
+	This function works like txringCommitTxtime(), but the frame to be sent is described by a [struct framebuf](\ref framebuf),
+	previously prepared with txringGetFramebuf().
+
+	\param[in,out]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]		fb 		Pointer to the [struct framebuf](\ref framebuf) containing the frame.
+	\param[in]		txtime 	Launch time, in _ns_, or **0** to send the frame immediately.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see txringCommit()).
+**/
+rawsockerr_t txringCommitFramebufTxtime(struct txring *ring, struct framebuf *fb, uint64_t txtime) {
+	return txringCommitOffset(ring,fb->data-(byte_t *) txringSlot(ring,ring->head),fb->len,txtime);
+}
+
+/**
+	\brief Flush a PACKET_TX_RING
+
+	This function asks the kernel to send all the frames which were committed, with a single _send()_ call.
+	It blocks until all the frames have been processed by the kernel, unless they were committed with a launch time (see txringCommitTxtime()).
+
+	\param[in,out]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_TXRING_SEND* -> the kernel returned an error (_errno_ is set by _sendto()_); the status of each slot can be checked with txringSlotStatus()
+**/
+rawsockerr_t txringFlush(struct txring *ring) {
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	union {
+		char buf[CMSG_SPACE(sizeof(uint64_t))];
+		struct cmsghdr align;
+	} control;
+	ssize_t ret;
+
+	if(ring->pending==0) {
+		return 0;
+	}
+
+	ring->pending=0;
+
+	if(ring->pending_txtime==0) {
+		ret=sendto(ring->descriptor,NULL,0,0,(struct sockaddr *)&ring->addrll,sizeof(struct sockaddr_ll));
+	} else {
+		// Pass the launch time of the pending slots as an SCM_TXTIME control message
+		memset(&msg,0,sizeof(msg));
+		msg.msg_name=&ring->addrll;
+		msg.msg_namelen=sizeof(struct sockaddr_ll);
+		msg.msg_control=control.buf;
+		msg.msg_controllen=sizeof(control.buf);
+
+		cmsg=CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level=SOL_SOCKET;
+		cmsg->cmsg_type=SCM_TXTIME;
+		cmsg->cmsg_len=CMSG_LEN(sizeof(uint64_t));
+		memcpy(CMSG_DATA(cmsg),&ring->pending_txtime,sizeof(uint64_t));
+
+		ring->pending_txtime=0;
+
+		ret=sendmsg(ring->descriptor,&msg,MSG_DONTWAIT);
+	}
+
+	return ret<0 ? ERR_TXRING_SEND : 0;
+}
+
+/**
+	\brief Get the status of a slot of a PACKET_TX_RING
+
+	This function can be used to know if the frame committed in a certain slot has already been sent or not.
+
+	\param[in]	ring 	Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[in]	index 	Index of the slot (from **0** to txringFrameNr()-1).
+
+	\return The status of the slot, as [txslotstatus_t](\ref txslotstatus_t).
+**/
+txslotstatus_t txringSlotStatus(struct txring *ring, unsigned int index) {
+	unsigned int status=__atomic_load_n(&txringSlot(ring,index%ring->frame_nr)->tp_status,__ATOMIC_ACQUIRE);
+
+	// When PACKET_TIMESTAMP is enabled, the kernel also reports the kind of TX timestamp of the sent frames, inside the TP_STATUS_TS_* bits
+	status&=~(TP_STATUS_TS_SOFTWARE | TP_STATUS_TS_SYS_HARDWARE | TP_STATUS_TS_RAW_HARDWARE);
+
+	switch(status) {
+		case TP_STATUS_AVAILABLE:
+			return TXSLOT_AVAILABLE;
+		case TP_STATUS_SEND_REQUEST:
+			return TXSLOT_SEND_REQUEST;
+		case TP_STATUS_WRONG_FORMAT:
+			return TXSLOT_WRONG_FORMAT;
+		default:
+			// TP_STATUS_SENDING, or any other status which is not (yet) known: the slot is considered as still owned by the kernel
+			return TXSLOT_SENDING;
+	}
+}
+
+/**
+	\brief Reclaim the slots of a PACKET_TX_RING which were already sent
+
+	This function walks the committed slots, from the oldest one, and makes the ones which were already processed by the kernel
+	available again, stopping at the first one which was not yet sent.
+
+	It is automatically called by txringGetFrame() when the ring is full, but it can be called at any time to know how many frames were
+	successfully sent and how many were refused by the kernel.
+
+	\param[in,out]	ring 			Pointer to a [struct txring](\ref txring), set up with txringOpen().
+	\param[out]		wrongformat 	If not NULL, the number of reclaimed frames which were refused by the kernel (see [TXSLOT_WRONG_FORMAT](\ref txslotstatus_t)) is stored here.
+
+	\return The number of reclaimed frames which were successfully sent.
+**/
+unsigned int txringReclaim(struct txring *ring, unsigned int *wrongformat) {
+	unsigned int sent=0, wrong=0;
+	txslotstatus_t status;
+
+	while(ring->inflight>0) {
+		status=txringSlotStatus(ring,ring->tail);
+
+		if(status==TXSLOT_AVAILABLE) {
+			sent++;
+		} else if(status==TXSLOT_WRONG_FORMAT) {
+			__atomic_store_n(&txringSlot(ring,ring->tail)->tp_status,TP_STATUS_AVAILABLE,__ATOMIC_RELEASE);
+			wrong++;
+		} else {
+			break;
+		}
+
+		ring->tail=(ring->tail+1)%ring->frame_nr;
+		ring->inflight--;
+	}
+
+	if(wrongformat!=NULL) {
+		*wrongformat=wrong;
+	}
+
+	return sent;
+}
+
+// Get the pointer to the descriptor of the block with index 'index'
+static inline struct tpacket_block_desc *rxringBlock(struct rxring *ring, unsigned int index) {
+	return (struct tpacket_block_desc *) (ring->map+(size_t) index*ring->block_size);
+}
+
+/**
+	\brief Initialize a [struct rxringparams](\ref rxringparams) with the default settings
+
+	The default settings are [RXRING_DEFAULT_BLOCK_SIZE](\ref RXRING_DEFAULT_BLOCK_SIZE), [RXRING_DEFAULT_BLOCK_NR](\ref RXRING_DEFAULT_BLOCK_NR),
+	[RXRING_DEFAULT_FRAME_SIZE](\ref RXRING_DEFAULT_FRAME_SIZE) and [RXRING_DEFAULT_RETIRE_TIMEOUT](\ref RXRING_DEFAULT_RETIRE_TIMEOUT).
+	Any of them can then be changed before calling rxringOpen().
+
+	\param[out]	params 	Pointer to the [struct rxringparams](\ref rxringparams) to be initialized.
+
+	\return None.
+**/
+void rxringParamsDefault(struct rxringparams *params) {
+	params->block_size=RXRING_DEFAULT_BLOCK_SIZE;
+	params->block_nr=RXRING_DEFAULT_BLOCK_NR;
+	params->frame_size=RXRING_DEFAULT_FRAME_SIZE;
+	params->retire_timeout=RXRING_DEFAULT_RETIRE_TIMEOUT;
+}
+
+/**
+	\brief Set up a _TPACKET_V3_ PACKET_RX_RING over an existing raw socket
+
+	This function sets up a _TPACKET_V3_ reception ring over the specified *AF_PACKET* socket, and maps it inside the memory of the
+	current process. The socket should have been created with `socket(AF_PACKET,SOCK_RAW,...)` and, if needed, bound to an interface;
+	it should be dedicated to the ring (i.e. no other ring should be set on it).
+
+	From this moment on, the received frames are stored by the kernel inside the ring, and they should be read with rxringNext().
+
+	\param[out]	ring 		Pointer to the [struct rxring](\ref rxring) to be initialized.
+	\param[in]	descriptor 	*AF_PACKET* socket descriptor.
+	\param[in]	params 		Ring settings (it can be NULL to use the default ones, see rxringParamsDefault()).
+
+	\return **0** if the ring was properly set up, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RXRING_PARAMS* -> invalid block size, number of blocks or frame size
+	- *ERR_RXRING_SOCKOPT* -> unable to set up the ring on the socket (_errno_ is set by _setsockopt()_)
+	- *ERR_RXRING_MMAP* -> unable to map the ring (_errno_ is set by _mmap()_)
+**/
+rawsockerr_t rxringOpen(struct rxring *ring, int descriptor, struct rxringparams *params) {
+	struct rxringparams defparams;
+	struct tpacket_req3 req;
+	unsigned int frame_size;
+	long pagesize;
+	int version=TPACKET_V3;
+
+	if(params==NULL) {
+		rxringParamsDefault(&defparams);
+		params=&defparams;
+	}
+
+	frame_size=TPACKET_ALIGN(params->frame_size);
+	if(frame_size<=TPACKET3_HDRLEN || params->block_nr==0) {
+		return ERR_RXRING_PARAMS;
+	}
+
+	pagesize=sysconf(_SC_PAGESIZE);
+	if(pagesize<=0) {
+		pagesize=4096;
+	}
+
+	ring->block_size=pagesize;
+	while(ring->block_size<params->block_size || ring->block_size<frame_size) {
+		ring->block_size<<=1;
+	}
+
+	memset(&req,0,sizeof(req));
+	req.tp_block_size=ring->block_size;
+	req.tp_block_nr=params->block_nr;
+	req.tp_frame_size=frame_size;
+	req.tp_frame_nr=(ring->block_size/frame_size)*params->block_nr;
+	req.tp_retire_blk_tov=params->retire_timeout;
+
+	if(setsockopt(descriptor,SOL_PACKET,PACKET_VERSION,&version,sizeof(version))<0 ||
+		setsockopt(descriptor,SOL_PACKET,PACKET_RX_RING,&req,sizeof(req))<0) {
+		return ERR_RXRING_SOCKOPT;
+	}
+
+	ring->mapsize=(size_t) req.tp_block_size*req.tp_block_nr;
+	ring->map=mmap(NULL,ring->mapsize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_LOCKED,descriptor,0);
+	if(ring->map==MAP_FAILED) {
+		// MAP_LOCKED may fail because of RLIMIT_MEMLOCK: try again without it
+		ring->map=mmap(NULL,ring->mapsize,PROT_READ | PROT_WRITE,MAP_SHARED,descriptor,0);
+		if(ring->map==MAP_FAILED) {
+			ring->map=NULL;
+			return ERR_RXRING_MMAP;
+		}
+	}
+
+	ring->descriptor=descriptor;
+	ring->block_nr=req.tp_block_nr;
+	ring->current=0;
+	ring->block_in_use=false;
+	ring->nextframe=NULL;
+	ring->remaining=0;
+
+	return 0;
+}
+
+/**
+	\brief Unmap a _TPACKET_V3_ PACKET_RX_RING
+
+	This function unmaps a ring set up with rxringOpen(). The socket is not closed.
+	After calling this function, the [struct rxframe](\ref rxframe) structures returned by rxringNext() are no longer valid.
+
+	\param[in]	ring 	Pointer to the [struct rxring](\ref rxring) to be closed.
+
+	\return None.
+**/
+void rxringClose(struct rxring *ring) {
+	if(ring->map!=NULL) {
+		munmap(ring->map,ring->mapsize);
+	}
+
+	ring->map=NULL;
+	ring->mapsize=0;
+	ring->block_in_use=false;
+	ring->remaining=0;
+}
+
+/**
+	\brief Get the next frame received through a _TPACKET_V3_ PACKET_RX_RING
+
+	This function fills _frame_ with the description of the next received frame, stored in place inside the ring (no copy is performed).
+	When all the frames of a block have been read, the block is given back to the kernel, and the next one is considered:
+	if it was not yet passed to the application (i.e. it is not full and its retire timeout has not expired yet), this function waits
+	for it, up to _timeout_ milliseconds.
+
+	\warning The data pointed by _frame_ remains valid only until the next call to this function, as the memory area may be given back to the kernel.
+
+	\param[in,out]	ring 		Pointer to a [struct rxring](\ref rxring), set up with rxringOpen().
+	\param[out]		frame 		Pointer to the [struct rxframe](\ref rxframe) to be filled in.
+	\param[in]		timeout 	Maximum time to wait for new frames, in _milliseconds_ (**-1** to wait indefinitely, **0** to return immediately).
+
+	\return **1** if a new frame is available, **0** if no frame was received within the timeout, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RXRING_POLL* -> error while waiting for new frames (_errno_ is set by _poll()_)
+**/
+int rxringNext(struct rxring *ring, struct rxframe *frame, int timeout) {
+	struct tpacket_block_desc *block;
+	struct tpacket3_hdr *hdr;
+	struct sockaddr_ll *sll;
+	struct pollfd pfd;
+	int pollret;
+
+	while(ring->remaining==0) {
+		// All the frames of the current block were read: give it back to the kernel
+		if(ring->block_in_use) {
+			__atomic_store_n(&rxringBlock(ring,ring->current)->hdr.bh1.block_status,TP_STATUS_KERNEL,__ATOMIC_RELEASE);
+			ring->current=(ring->current+1)%ring->block_nr;
+			ring->block_in_use=false;
+		}
+
+		block=rxringBlock(ring,ring->current);
+
+		if((__atomic_load_n(&block->hdr.bh1.block_status,__ATOMIC_ACQUIRE) & TP_STATUS_USER)==0) {
+			if(timeout==0) {
+				return 0;
+			}
+
+			pfd.fd=ring->descriptor;
+			pfd.events=POLLIN | POLLERR;
+			pfd.revents=0;
+
+			pollret=poll(&pfd,1,timeout);
+			if(pollret<0) {
+				return ERR_RXRING_POLL;
+			} else if(pollret==0) {
+				return 0;
+			}
+
+			continue;
+		}
+
+		// A block may be retired with no frames inside: in this case, it is immediately given back to the kernel at the next iteration
+		ring->block_in_use=true;
+		ring->remaining=block->hdr.bh1.num_pkts;
+		ring->nextframe=(byte_t *) block+block->hdr.bh1.offset_to_first_pkt;
+	}
+
+	hdr=(struct tpacket3_hdr *) ring->nextframe;
+	sll=(struct sockaddr_ll *) (ring->nextframe+TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+	frame->data=ring->nextframe+hdr->tp_mac;
+	frame->snaplen=hdr->tp_snaplen;
+	frame->len=hdr->tp_len;
+	frame->ts.tv_sec=hdr->tp_sec;
+	frame->ts.tv_nsec=hdr->tp_nsec;
+	frame->ifindex=sll->sll_ifindex;
+
+	ring->nextframe+=hdr->tp_next_offset;
+	ring->remaining--;
+
+	return 1;
+}
+
+/**
+	\brief Get a batch of frames received through a _TPACKET_V3_ PACKET_RX_RING
+
+	This function works like rxringNext(), but it fills up to _n_ [struct rxframe](\ref rxframe) structures at once, taking them
+	from the same block of the ring: as the block is given back to the kernel only at the next call, all the returned frames remain valid
+	until then. It waits for new frames, up to _timeout_ milliseconds, only when no frame is available.
+
+	\param[in,out]	ring 		Pointer to a [struct rxring](\ref rxring), set up with rxringOpen().
+	\param[out]		frames 		Array of [struct rxframe](\ref rxframe) to be filled in.
+	\param[in]		n 			Number of elements of _frames_.
+	\param[in]		timeout 	Maximum time to wait for new frames, in _milliseconds_ (**-1** to wait indefinitely, **0** to return immediately).
+
+	\return The number of frames stored inside _frames_ (**0** if no frame was received within the timeout), or, in case of error,
+	a [rawsockerr_t](\ref rawsockerr_t) error (see rxringNext()).
+**/
+int rxringNextBatch(struct rxring *ring, struct rxframe *frames, unsigned int n, int timeout) {
+	unsigned int i;
+	int ret;
+
+	if(n==0) {
+		return 0;
+	}
+
+	ret=rxringNext(ring,&frames[0],timeout);
+	if(ret<=0) {
+		return ret;
+	}
+
+	// The remaining frames of the current block can be read without releasing it
+	for(i=1;i<n && ring->remaining>0;i++) {
+		rxringNext(ring,&frames[i],0);
+	}
+
+	return i;
+}
+
+/**
+	\brief Get the statistics of a _TPACKET_V3_ PACKET_RX_RING
+
+	This function reads the number of frames received and dropped by the kernel (for instance because the ring was full) since
+	the last call to this function (the kernel counters are reset every time they are read).
+
+	\param[in]	ring 		Pointer to a [struct rxring](\ref rxring), set up with rxringOpen().
+	\param[out]	packets 	If not NULL, the number of received frames (including the dropped ones) is stored here.
+	\param[out]	drops 		If not NULL, the number of dropped frames is stored here.
+	\param[out]	freezes 	If not NULL, the number of times the ring was found full (i.e. the kernel had to stop filling it) is stored here.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_RXRING_SOCKOPT* -> unable to read the statistics (_errno_ is set by _getsockopt()_)
+**/
+rawsockerr_t rxringStats(struct rxring *ring, unsigned int *packets, unsigned int *drops, unsigned int *freezes) {
+	struct tpacket_stats_v3 stats;
+	socklen_t statslen=sizeof(stats);
+
+	if(getsockopt(ring->descriptor,SOL_PACKET,PACKET_STATISTICS,&stats,&statslen)<0) {
+		return ERR_RXRING_SOCKOPT;
+	}
+
+	if(packets!=NULL) {
+		*packets=stats.tp_packets;
+	}
+
+	if(drops!=NULL) {
+		*drops=stats.tp_drops;
+	}
+
+	if(freezes!=NULL) {
+		*freezes=stats.tp_freeze_q_cnt;
+	}
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+/** \file
+	Memory-mapped packet rings (PACKET_MMAP) support for the Rawsock library.
+
+	This file represents an additional module of the Rawsock library, allowing to transmit frames through a PACKET_TX_RING
+	(_TPACKET_V2_), i.e. a ring of frame slots which is shared between the application and the kernel, and to receive frames
+	through a PACKET_RX_RING (_TPACKET_V3_).
+
+	Instead of passing each frame to the kernel with a separate _sendto()_ call, the application writes the frames (headers included)
+	directly inside the slots of the ring, marks them as ready and then asks the kernel to send all of them with a single _send()_ call
+	(a _flush_). This removes one system call (and one copy) per frame, which is the main limiting factor when generating traffic at
+	high packet rates.
+
+	A ring should be opened over an already existing *AF_PACKET* socket, with txringOpen(), and closed with txringClose().
+	Its geometry (frame size and number of frames) and the number of frames after which it is automatically flushed
+	can be configured through a [struct txringparams](\ref txringparams).
+
+	__Example of use:__
+
+		struct txringparams params;
+		struct txring ring;
+		struct framebuf fb;
+
+		txringParamsDefault(&params);
+		txringOpen(&ring,sFd,addrll,&params);
+
+		while(...) {
+			if(txringGetFramebuf(&ring,&fb,ETH_IP_UDP_HEADROOM)!=0) {
+				// Ring full: flush it and reclaim the slots which were already sent
+				txringFlush(&ring);
+				txringReclaim(&ring,NULL);
+				continue;
+			}
+
+			framebufCopyPayload(&fb,data,datasize);
+			UDPencapsulateInPlace(&fb,&udpHeader,ipaddrs);
+			IP4EncapsulateInPlace(&fb,&ipHeader);
+			etherEncapsulateInPlace(&fb,&etherHeader);
+
+			txringCommitFramebuf(&ring,&fb); // The ring is automatically flushed every 'params.flush_threshold' frames
+		}
+
+		txringFlush(&ring);
+		txringClose(&ring);
+
+	On the receiving side, the kernel stores the received frames, one after the other, inside blocks of the RX ring, together with their timestamp.
+	rxringNext() walks the frames of each block in place, without any copy, and gives back each block to the kernel as soon as all its frames
+	have been read. A block is handed to the application when it is full or, at the latest, when its _retire timeout_ expires.
+	Each frame is described by a [struct rxframe](\ref rxframe), whose _data_ can be directly passed to UDPgetpacketpointers().
+
+	__Example of use:__
+
+		struct rxring rxring;
+		struct rxframe frame;
+
+		rxringOpen(&rxring,sFd,NULL);
+
+		while(rxringNext(&rxring,&frame,-1)==1) {
+			payload=UDPgetpacketpointers(frame.data,&etherHeader,&IPheader,&udpHeader);
+			...
+		}
+
+		rxringClose(&rxring);
+
+	A TX ring and an RX ring should always be set up on two different sockets.
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_RING_H_INCLUDED
+#define RAWSOCK_RING_H_INCLUDED
+
+#include "rawsock.h"
+#include <linux/if_packet.h>
+
+#define TXRING_DEFAULT_FRAME_SIZE 2048 /**< __TX ring default setting__: size, in _bytes_, of each slot (it should be able to contain the ring slot header, i.e. _struct tpacket2_hdr_, and the largest frame to be sent). */
+#define TXRING_DEFAULT_FRAME_NR 512 /**< __TX ring default setting__: number of slots in the ring. */
+#define TXRING_DEFAULT_FLUSH_THRESHOLD 32 /**< __TX ring default setting__: number of committed frames after which the ring is automatically flushed. */
+
+#define RXRING_DEFAULT_BLOCK_SIZE (1 << 20) /**< __RX ring default setting__: size, in _bytes_, of each block of the ring. */
+#define RXRING_DEFAULT_BLOCK_NR 16 /**< __RX ring default setting__: number of blocks of the ring. */
+#define RXRING_DEFAULT_FRAME_SIZE 2048 /**< __RX ring default setting__: nominal frame size, in _bytes_ (with _TPACKET_V3_ frames are tightly packed inside each block, and this value is only used to compute the nominal number of frames required by the kernel). */
+#define RXRING_DEFAULT_RETIRE_TIMEOUT 10 /**< __RX ring default setting__: block retire timeout, in _milliseconds_. */
+
+/**
+	\brief TX ring slot status
+
+	Status of a slot of a [struct txring](\ref txring), as returned by txringSlotStatus(). It can be used to know whether a
+	frame, which was previously committed, has already been sent by the kernel or not.
+**/
+typedef enum {
+	TXSLOT_AVAILABLE,		/**< The slot is free: it was never used, or its frame has already been sent. */
+	TXSLOT_SEND_REQUEST,	/**< The frame was committed, but the ring has not been flushed yet (or the kernel has not yet started sending it). */
+	TXSLOT_SENDING,			/**< The frame is currently being sent by the kernel. */
+	TXSLOT_WRONG_FORMAT		/**< The kernel refused to send the frame, as it was malformed (for instance it was too long). */
+} txslotstatus_t;
+
+/**
+	\brief TX ring settings
+
+	Structure containing the settings of a [struct txring](\ref txring), to be passed to txringOpen().
+	It can be initialized with the default values through txringParamsDefault().
+**/
+struct txringparams {
+	unsigned int frame_size; /**< Size of each slot, in _bytes_ (it is rounded up to a multiple of _TPACKET_ALIGNMENT_). */
+	unsigned int frame_nr; /**< Minimum number of slots (it may be rounded up to fill the last memory block). */
+	unsigned int flush_threshold; /**< Number of committed frames after which the ring is automatically flushed (**0** to disable the automatic flush, and call txringFlush() manually). */
+};
+
+/**
+	\brief TX ring descriptor
+
+	Structure describing a PACKET_TX_RING, opened with txringOpen(). Its fields should not be modified directly by the user.
+**/
+struct txring {
+	int descriptor; /**< _AF_PACKET_ socket the ring is attached to. */
+	struct sockaddr_ll addrll; /**< Link layer address used when flushing the ring. */
+	byte_t *map; /**< Memory-mapped ring. */
+	size_t mapsize; /**< Size, in _bytes_, of _map_. */
+	unsigned int block_size; /**< Size, in _bytes_, of each memory block of the ring. */
+	unsigned int frames_per_block; /**< Number of slots inside each memory block. */
+	unsigned int frame_size; /**< Actual size, in _bytes_, of each slot. */
+	unsigned int frame_nr; /**< Actual number of slots. */
+	unsigned int flush_threshold; /**< Number of committed frames after which the ring is automatically flushed. */
+	unsigned int head; /**< Index of the next slot to be filled. */
+	unsigned int tail; /**< Index of the oldest slot which was committed and not yet reclaimed with txringReclaim(). */
+	unsigned int inflight; /**< Number of slots between _tail_ and _head_. */
+	unsigned int pending; /**< Number of slots committed after the last flush. */
+	uint64_t pending_txtime; /**< Launch time, in _ns_, shared by the slots committed after the last flush (**0** if they should be sent immediately). */
+};
+
+/**
+	\brief RX ring settings
+
+	Structure containing the settings of a [struct rxring](\ref rxring), to be passed to rxringOpen().
+	It can be initialized with the default values through rxringParamsDefault().
+**/
+struct rxringparams {
+	unsigned int block_size; /**< Size of each block, in _bytes_ (it is rounded up to a power of two multiple of the page size). */
+	unsigned int block_nr; /**< Number of blocks. */
+	unsigned int frame_size; /**< Nominal frame size, in _bytes_ (see [RXRING_DEFAULT_FRAME_SIZE](\ref RXRING_DEFAULT_FRAME_SIZE)). */
+	unsigned int retire_timeout; /**< Time, in _milliseconds_, after which a block which is not full is anyway passed to the application (**0** to let the kernel choose it). */
+};
+
+/**
+	\brief RX ring descriptor
+
+	Structure describing a _TPACKET_V3_ PACKET_RX_RING, opened with rxringOpen(). Its fields should not be modified directly by the user.
+**/
+struct rxring {
+	int descriptor; /**< _AF_PACKET_ socket the ring is attached to. */
+	byte_t *map; /**< Memory-mapped ring. */
+	size_t mapsize; /**< Size, in _bytes_, of _map_. */
+	unsigned int block_size; /**< Actual size, in _bytes_, of each block. */
+	unsigned int block_nr; /**< Number of blocks. */
+	unsigned int current; /**< Index of the block which is currently being read (or which will be read next). */
+	bool block_in_use; /**< _true_ if the current block was passed to the application and has not been given back to the kernel yet. */
+	byte_t *nextframe; /**< Pointer to the next frame to be read, inside the current block. */
+	unsigned int remaining; /**< Number of frames still to be read inside the current block. */
+};
+
+void txringParamsDefault(struct txringparams *params);
+rawsockerr_t txringOpen(struct txring *ring, int descriptor, struct sockaddr_ll addrll, struct txringparams *params);
+void txringClose(struct txring *ring);
+unsigned int txringFrameSize(struct txring *ring); // Returns the maximum size of a frame which can be stored inside a slot
+unsigned int txringFrameNr(struct txring *ring);
+void txringSetFlushThreshold(struct txring *ring, unsigned int flush_threshold);
+
+byte_t *txringGetFrame(struct txring *ring, size_t *maxsize);
+rawsockerr_t txringGetFramebuf(struct txring *ring, struct framebuf *fb, size_t headroom);
+rawsockerr_t txringCommit(struct txring *ring, size_t framesize);
+rawsockerr_t txringCommitFramebuf(struct txring *ring, struct framebuf *fb);
+rawsockerr_t txringCommitTxtime(struct txring *ring, size_t framesize, uint64_t txtime);
+rawsockerr_t txringCommitFramebufTxtime(struct txring *ring, struct framebuf *fb, uint64_t txtime);
+rawsockerr_t txringFlush(struct txring *ring);
+
+txslotstatus_t txringSlotStatus(struct txring *ring, unsigned int index);
+unsigned int txringReclaim(struct txring *ring, unsigned int *wrongformat);
+
+void rxringParamsDefault(struct rxringparams *params);
+rawsockerr_t rxringOpen(struct rxring *ring, int descriptor, struct rxringparams *params);
+void rxringClose(struct rxring *ring);
+int rxringNext(struct rxring *ring, struct rxframe *frame, int timeout);
+int rxringNextBatch(struct rxring *ring, struct rxframe *frames, unsigned int n, int timeout);
+rawsockerr_t rxringStats(struct rxring *ring, unsigned int *packets, unsigned int *drops, unsigned int *freezes);
+#endif
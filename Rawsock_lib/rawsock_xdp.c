@@ -0,0 +1,752 @@
+// Rawsock library, licensed under GPLv2
+// Version 0.3.4
+#include "rawsock.h"
+#include "rawsock_xdp.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#ifndef AF_XDP
+	#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+	#define SOL_XDP 283
+#endif
+
+#ifndef XDP_FLAGS_REPLACE
+	#define XDP_FLAGS_REPLACE (1U << 4)
+#endif
+#define XSK_IFLA_XDP_EXPECTED_FD 8 // IFLA_XDP_EXPECTED_FD (an enumerator, not available in the headers older than Linux 5.7)
+
+#define XSK_MIN_FRAME_SIZE 2048 // Minimum UMEM chunk size accepted by the kernel
+
+// Get the UMEM offset of the beginning of the frame containing 'addr'
+#define XSK_FRAME_BASE(xsk,addr) ((addr) & ~((uint64_t) (xsk)->frame_size-1))
+
+// Number of frames which are always kept for transmission, and never moved to the fill ring by xskRecv()
+#define XSK_TX_RESERVE(xsk) ((xsk)->frame_nr/4)
+
+static inline int bpf(int cmd, union bpf_attr *attr) {
+	return syscall(__NR_bpf,cmd,attr,sizeof(*attr));
+}
+
+// Number of entries which can be written to a producer ring (fill or TX)
+static inline uint32_t xskRingFree(struct xskring *ring) {
+	uint32_t free_entries=ring->mask+1-(ring->cached_prod-ring->cached_cons);
+
+	if(free_entries==0) {
+		ring->cached_cons=__atomic_load_n(ring->consumer,__ATOMIC_ACQUIRE);
+		free_entries=ring->mask+1-(ring->cached_prod-ring->cached_cons);
+	}
+
+	return free_entries;
+}
+
+// Number of entries which can be read from a consumer ring (completion or RX)
+static inline uint32_t xskRingAvailable(struct xskring *ring) {
+	uint32_t available=ring->cached_prod-ring->cached_cons;
+
+	if(available==0) {
+		ring->cached_prod=__atomic_load_n(ring->producer,__ATOMIC_ACQUIRE);
+		available=ring->cached_prod-ring->cached_cons;
+	}
+
+	return available;
+}
+
+// Map one of the rings of an AF_XDP socket
+static int xskRingMap(int fd, struct xskring *ring, struct xdp_ring_offset *off, unsigned int size, size_t descsize, off_t pgoff) {
+	ring->mapsize=off->desc+size*descsize;
+	ring->map=mmap(NULL,ring->mapsize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,fd,pgoff);
+	if(ring->map==MAP_FAILED) {
+		ring->map=NULL;
+		return -1;
+	}
+
+	ring->producer=(uint32_t *) ((byte_t *) ring->map+off->producer);
+	ring->consumer=(uint32_t *) ((byte_t *) ring->map+off->consumer);
+	ring->flags=(uint32_t *) ((byte_t *) ring->map+off->flags);
+	ring->descs=(byte_t *) ring->map+off->desc;
+	ring->mask=size-1;
+	ring->cached_prod=*ring->producer;
+	ring->cached_cons=*ring->consumer;
+
+	return 0;
+}
+
+// Move free frames to the fill ring, always keeping XSK_TX_RESERVE() frames for transmission
+static void xskRefill(struct xsksocket *xsk) {
+	uint32_t free_entries=xskRingFree(&xsk->fill);
+	uint64_t *addrs=xsk->fill.descs;
+	unsigned int moved=0;
+
+	while(moved<free_entries && xsk->nfree>XSK_TX_RESERVE(xsk)) {
+		addrs[xsk->fill.cached_prod++ & xsk->fill.mask]=xsk->freeframes[--xsk->nfree];
+		moved++;
+	}
+
+	if(moved>0) {
+		__atomic_store_n(xsk->fill.producer,xsk->fill.cached_prod,__ATOMIC_RELEASE);
+	}
+}
+
+// Get back the frames which were already sent, from the completion ring
+static void xskReapCompletions(struct xsksocket *xsk) {
+	uint32_t available=xskRingAvailable(&xsk->comp);
+	uint64_t *addrs=xsk->comp.descs;
+	uint32_t i;
+
+	if(available==0) {
+		return;
+	}
+
+	for(i=0;i<available;i++) {
+		xsk->freeframes[xsk->nfree++]=XSK_FRAME_BASE(xsk,addrs[xsk->comp.cached_cons++ & xsk->comp.mask]);
+	}
+
+	__atomic_store_n(xsk->comp.consumer,xsk->comp.cached_cons,__ATOMIC_RELEASE);
+	xsk->txoutstanding-=available;
+}
+
+// Load the XDP program redirecting all the frames received on 'queue' to the sockets inside the XSKMAP 'mapfd'
+//  (the frames received on the other queues are passed to the network stack)
+static int xskLoadProgram(int mapfd) {
+	union bpf_attr attr;
+	static const char license[]="GPL";
+	struct bpf_insn prog[]={
+		// r2 = ctx->rx_queue_index
+		{.code=BPF_LDX | BPF_MEM | BPF_W, .dst_reg=BPF_REG_2, .src_reg=BPF_REG_1, .off=offsetof(struct xdp_md,rx_queue_index), .imm=0},
+		// r1 = XSKMAP (64-bit immediate load, spanning two instructions)
+		{.code=BPF_LD | BPF_DW | BPF_IMM, .dst_reg=BPF_REG_1, .src_reg=BPF_PSEUDO_MAP_FD, .off=0, .imm=mapfd},
+		{.code=0, .dst_reg=0, .src_reg=0, .off=0, .imm=0},
+		// r3 = XDP_PASS (action to be returned if no socket is bound to the current queue)
+		{.code=BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg=BPF_REG_3, .src_reg=0, .off=0, .imm=XDP_PASS},
+		// r0 = bpf_redirect_map(r1, r2, r3)
+		{.code=BPF_JMP | BPF_CALL, .dst_reg=0, .src_reg=0, .off=0, .imm=BPF_FUNC_redirect_map},
+		// return r0
+		{.code=BPF_JMP | BPF_EXIT, .dst_reg=0, .src_reg=0, .off=0, .imm=0}
+	};
+
+	memset(&attr,0,sizeof(attr));
+	attr.prog_type=BPF_PROG_TYPE_XDP;
+	attr.insns=(uint64_t) (unsigned long) prog;
+	attr.insn_cnt=sizeof(prog)/sizeof(struct bpf_insn);
+	attr.license=(uint64_t) (unsigned long) license;
+
+	return bpf(BPF_PROG_LOAD,&attr);
+}
+
+// Create the XSKMAP and insert the AF_XDP socket, as entry 'queue'
+static int xskCreateMap(int xskfd, unsigned int queue) {
+	union bpf_attr attr;
+	uint32_t key=queue;
+	uint32_t value=xskfd;
+	int mapfd;
+
+	memset(&attr,0,sizeof(attr));
+	attr.map_type=BPF_MAP_TYPE_XSKMAP;
+	attr.key_size=sizeof(uint32_t);
+	attr.value_size=sizeof(uint32_t);
+	attr.max_entries=queue+1;
+
+	mapfd=bpf(BPF_MAP_CREATE,&attr);
+	if(mapfd<0) {
+		return -1;
+	}
+
+	memset(&attr,0,sizeof(attr));
+	attr.map_fd=mapfd;
+	attr.key=(uint64_t) (unsigned long) &key;
+	attr.value=(uint64_t) (unsigned long) &value;
+
+	if(bpf(BPF_MAP_UPDATE_ELEM,&attr)<0) {
+		close(mapfd);
+		return -1;
+	}
+
+	return mapfd;
+}
+
+// Attach (or detach, if 'progfd' is -1) an XDP program to an interface, through an RTM_SETLINK netlink message
+// If 'flags' contains XDP_FLAGS_REPLACE, the operation is performed only if the program currently attached is 'expectedfd'
+static int xskSetLinkXdp(int ifindex, int progfd, uint32_t flags, int expectedfd) {
+	struct {
+		struct nlmsghdr nh;
+		struct ifinfomsg ifinfo;
+		byte_t attrbuf[64];
+	} req;
+	struct {
+		struct nlmsghdr nh;
+		struct nlmsgerr err;
+		byte_t pad[64];
+	} ack;
+	struct sockaddr_nl sanl;
+	struct nlattr *nest, *attr;
+	ssize_t len;
+	int nlfd;
+
+	nlfd=socket(AF_NETLINK,SOCK_RAW | SOCK_CLOEXEC,NETLINK_ROUTE);
+	if(nlfd<0) {
+		return -1;
+	}
+
+	memset(&req,0,sizeof(req));
+	req.nh.nlmsg_len=NLMSG_LENGTH(sizeof(struct ifinfomsg));
+	req.nh.nlmsg_type=RTM_SETLINK;
+	req.nh.nlmsg_flags=NLM_F_REQUEST | NLM_F_ACK;
+	req.ifinfo.ifi_family=AF_UNSPEC;
+	req.ifinfo.ifi_index=ifindex;
+
+	// IFLA_XDP, containing IFLA_XDP_FD and IFLA_XDP_FLAGS
+	nest=(struct nlattr *) ((byte_t *) &req+NLMSG_ALIGN(req.nh.nlmsg_len));
+	nest->nla_type=NLA_F_NESTED | IFLA_XDP;
+	nest->nla_len=NLA_HDRLEN;
+
+	attr=(struct nlattr *) ((byte_t *) nest+nest->nla_len);
+	attr->nla_type=IFLA_XDP_FD;
+	attr->nla_len=NLA_HDRLEN+sizeof(int);
+	memcpy((byte_t *) attr+NLA_HDRLEN,&progfd,sizeof(int));
+	nest->nla_len+=NLA_ALIGN(attr->nla_len);
+
+	if(flags!=0) {
+		attr=(struct nlattr *) ((byte_t *) nest+nest->nla_len);
+		attr->nla_type=IFLA_XDP_FLAGS;
+		attr->nla_len=NLA_HDRLEN+sizeof(uint32_t);
+		memcpy((byte_t *) attr+NLA_HDRLEN,&flags,sizeof(uint32_t));
+		nest->nla_len+=NLA_ALIGN(attr->nla_len);
+	}
+
+	if(flags & XDP_FLAGS_REPLACE) {
+		attr=(struct nlattr *) ((byte_t *) nest+nest->nla_len);
+		attr->nla_type=XSK_IFLA_XDP_EXPECTED_FD;
+		attr->nla_len=NLA_HDRLEN+sizeof(int);
+		memcpy((byte_t *) attr+NLA_HDRLEN,&expectedfd,sizeof(int));
+		nest->nla_len+=NLA_ALIGN(attr->nla_len);
+	}
+
+	req.nh.nlmsg_len=NLMSG_ALIGN(req.nh.nlmsg_len)+nest->nla_len;
+
+	memset(&sanl,0,sizeof(sanl));
+	sanl.nl_family=AF_NETLINK;
+
+	if(sendto(nlfd,&req,req.nh.nlmsg_len,0,(struct sockaddr *) &sanl,sizeof(sanl))<0) {
+		close(nlfd);
+		return -1;
+	}
+
+	len=recv(nlfd,&ack,sizeof(ack),0);
+	close(nlfd);
+
+	if(len<(ssize_t) NLMSG_LENGTH(sizeof(struct nlmsgerr)) || ack.nh.nlmsg_type!=NLMSG_ERROR) {
+		errno=EPROTO;
+		return -1;
+	}
+
+	if(ack.err.error!=0) {
+		errno=-ack.err.error;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+	\brief Initialize a [struct xskparams](\ref xskparams) with the default settings
+
+	The default settings are [XSK_DEFAULT_FRAME_SIZE](\ref XSK_DEFAULT_FRAME_SIZE), [XSK_DEFAULT_FRAME_NR](\ref XSK_DEFAULT_FRAME_NR),
+	[XSK_DEFAULT_RING_SIZE](\ref XSK_DEFAULT_RING_SIZE), copy mode and generic XDP, with the redirect XDP program automatically loaded.
+
+	\param[out]	params 	Pointer to the [struct xskparams](\ref xskparams) to be initialized.
+
+	\return None.
+**/
+void xskParamsDefault(struct xskparams *params) {
+	params->frame_size=XSK_DEFAULT_FRAME_SIZE;
+	params->frame_nr=XSK_DEFAULT_FRAME_NR;
+	params->ring_size=XSK_DEFAULT_RING_SIZE;
+	params->mode=XSK_MODE_COPY;
+	params->native=false;
+	params->load_program=true;
+}
+
+/**
+	\brief Open an AF_XDP socket, bound to a given queue of an interface
+
+	This function creates an AF_XDP socket, together with its UMEM and its rings, binds it to the queue _queue_ of the interface
+	with index _ifindex_ and, unless differently specified in _params_, loads and attaches to the interface the XDP program redirecting to the
+	socket all the frames received on that queue.
+
+	Half of the UMEM frames are initially given to the kernel for reception, while the other half is available for transmission.
+
+	\warning Only one AF_XDP socket per interface can be opened with the automatically loaded XDP program. If another XDP program is already
+	attached to the interface, this function fails with *ERR_XSK_ATTACH*.
+
+	\param[out]	xsk 		Pointer to the [struct xsksocket](\ref xsksocket) to be initialized.
+	\param[in]	ifindex 	Interface index (it can be obtained, for instance, with wlanLookup()).
+	\param[in]	queue 		Interface queue (**0** for interfaces with a single queue, such as veth interfaces).
+	\param[in]	params 		Socket settings (it can be NULL to use the default ones, see xskParamsDefault()).
+
+	\return **0** if the socket was properly opened, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (_errno_ is set by the failing system call):
+	- *ERR_XSK_PARAMS* -> invalid frame size, number of frames or ring size
+	- *ERR_XSK_SOCKET* -> unable to create the AF_XDP socket
+	- *ERR_XSK_UMEM* -> unable to allocate or register the UMEM
+	- *ERR_XSK_RINGS* -> unable to set up or map the rings
+	- *ERR_XSK_BIND* -> unable to bind the socket to the interface queue (e.g. the requested mode is not supported)
+	- *ERR_XSK_PROG* -> unable to load the XDP program or to create the XSKMAP
+	- *ERR_XSK_ATTACH* -> unable to attach the XDP program to the interface
+**/
+rawsockerr_t xskOpen(struct xsksocket *xsk, int ifindex, unsigned int queue, struct xskparams *params) {
+	struct xskparams defparams;
+	struct xdp_umem_reg umemreg;
+	struct xdp_mmap_offsets off;
+	struct sockaddr_xdp sxdp;
+	socklen_t optlen=sizeof(off);
+	int ringsize;
+	unsigned int i, initfill;
+	rawsockerr_t err;
+
+	if(params==NULL) {
+		xskParamsDefault(&defparams);
+		params=&defparams;
+	}
+
+	memset(xsk,0,sizeof(struct xsksocket));
+	xsk->descriptor=-1;
+	xsk->progfd=-1;
+	xsk->mapfd=-1;
+
+	// Both the frame size and the ring size should be powers of two
+	if(params->frame_size<XSK_MIN_FRAME_SIZE || (params->frame_size & (params->frame_size-1))!=0 ||
+		params->ring_size==0 || (params->ring_size & (params->ring_size-1))!=0 || params->frame_nr==0) {
+		return ERR_XSK_PARAMS;
+	}
+
+	xsk->ifindex=ifindex;
+	xsk->queue=queue;
+	xsk->frame_size=params->frame_size;
+	xsk->frame_nr=params->frame_nr;
+
+	xsk->descriptor=socket(AF_XDP,SOCK_RAW | SOCK_CLOEXEC,0);
+	if(xsk->descriptor<0) {
+		err=ERR_XSK_SOCKET;
+		goto error;
+	}
+
+	// UMEM
+	xsk->umemsize=(size_t) xsk->frame_size*xsk->frame_nr;
+	xsk->umem=mmap(NULL,xsk->umemsize,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+	xsk->freeframes=malloc(xsk->frame_nr*sizeof(uint64_t));
+	if(xsk->umem==MAP_FAILED || xsk->freeframes==NULL) {
+		if(xsk->umem==MAP_FAILED) {
+			xsk->umem=NULL;
+		}
+		err=ERR_XSK_UMEM;
+		goto error;
+	}
+
+	memset(&umemreg,0,sizeof(umemreg));
+	umemreg.addr=(uint64_t) (unsigned long) xsk->umem;
+	umemreg.len=xsk->umemsize;
+	umemreg.chunk_size=xsk->frame_size;
+	umemreg.headroom=0;
+
+	if(setsockopt(xsk->descriptor,SOL_XDP,XDP_UMEM_REG,&umemreg,sizeof(umemreg))<0) {
+		err=ERR_XSK_UMEM;
+		goto error;
+	}
+
+	// Rings
+	ringsize=params->ring_size;
+	if(setsockopt(xsk->descriptor,SOL_XDP,XDP_UMEM_FILL_RING,&ringsize,sizeof(ringsize))<0 ||
+		setsockopt(xsk->descriptor,SOL_XDP,XDP_UMEM_COMPLETION_RING,&ringsize,sizeof(ringsize))<0 ||
+		setsockopt(xsk->descriptor,SOL_XDP,XDP_RX_RING,&ringsize,sizeof(ringsize))<0 ||
+		setsockopt(xsk->descriptor,SOL_XDP,XDP_TX_RING,&ringsize,sizeof(ringsize))<0 ||
+		getsockopt(xsk->descriptor,SOL_XDP,XDP_MMAP_OFFSETS,&off,&optlen)<0) {
+		err=ERR_XSK_RINGS;
+		goto error;
+	}
+
+	if(xskRingMap(xsk->descriptor,&xsk->fill,&off.fr,params->ring_size,sizeof(uint64_t),XDP_UMEM_PGOFF_FILL_RING)<0 ||
+		xskRingMap(xsk->descriptor,&xsk->comp,&off.cr,params->ring_size,sizeof(uint64_t),XDP_UMEM_PGOFF_COMPLETION_RING)<0 ||
+		xskRingMap(xsk->descriptor,&xsk->rx,&off.rx,params->ring_size,sizeof(struct xdp_desc),XDP_PGOFF_RX_RING)<0 ||
+		xskRingMap(xsk->descriptor,&xsk->tx,&off.tx,params->ring_size,sizeof(struct xdp_desc),XDP_PGOFF_TX_RING)<0) {
+		err=ERR_XSK_RINGS;
+		goto error;
+	}
+
+	// All the frames are initially free: give half of them (at most as many as the fill ring can contain) to the kernel for reception
+	for(i=0;i<xsk->frame_nr;i++) {
+		xsk->freeframes[i]=(uint64_t) (xsk->frame_nr-1-i)*xsk->frame_size;
+	}
+	xsk->nfree=xsk->frame_nr;
+
+	initfill=xsk->frame_nr/2<params->ring_size ? xsk->frame_nr/2 : params->ring_size;
+	for(i=0;i<initfill;i++) {
+		((uint64_t *) xsk->fill.descs)[xsk->fill.cached_prod++ & xsk->fill.mask]=xsk->freeframes[--xsk->nfree];
+	}
+	__atomic_store_n(xsk->fill.producer,xsk->fill.cached_prod,__ATOMIC_RELEASE);
+
+	// Bind
+	memset(&sxdp,0,sizeof(sxdp));
+	sxdp.sxdp_family=AF_XDP;
+	sxdp.sxdp_ifindex=ifindex;
+	sxdp.sxdp_queue_id=queue;
+	sxdp.sxdp_flags=XDP_USE_NEED_WAKEUP;
+	if(params->mode==XSK_MODE_COPY) {
+		sxdp.sxdp_flags|=XDP_COPY;
+	} else if(params->mode==XSK_MODE_ZEROCOPY) {
+		sxdp.sxdp_flags|=XDP_ZEROCOPY;
+	}
+
+	if(bind(xsk->descriptor,(struct sockaddr *) &sxdp,sizeof(sxdp))<0) {
+		err=ERR_XSK_BIND;
+		goto error;
+	}
+
+	// XDP program
+	if(params->load_program) {
+		xsk->mapfd=xskCreateMap(xsk->descriptor,queue);
+		if(xsk->mapfd<0) {
+			err=ERR_XSK_PROG;
+			goto error;
+		}
+
+		xsk->progfd=xskLoadProgram(xsk->mapfd);
+		if(xsk->progfd<0) {
+			err=ERR_XSK_PROG;
+			goto error;
+		}
+
+		xsk->xdpflags=XDP_FLAGS_UPDATE_IF_NOEXIST | (params->native ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE);
+		if(xskSetLinkXdp(ifindex,xsk->progfd,xsk->xdpflags,-1)<0) {
+			close(xsk->progfd);
+			xsk->progfd=-1;
+			err=ERR_XSK_ATTACH;
+			goto error;
+		}
+	}
+
+	return 0;
+
+error:
+	{
+		int saved_errno=errno;
+		xskClose(xsk);
+		errno=saved_errno;
+	}
+
+	return err;
+}
+
+/**
+	\brief Close an AF_XDP socket
+
+	This function detaches the XDP program (if it was loaded by xskOpen() and it was not replaced in the meantime), closes the socket and frees the UMEM and all the rings.
+	The frames which were queued for transmission, but not yet flushed with xskFlush(), are discarded.
+
+	\param[in]	xsk 	Pointer to the [struct xsksocket](\ref xsksocket) to be closed.
+
+	\return None.
+**/
+void xskClose(struct xsksocket *xsk) {
+	struct xskring *rings[]={&xsk->fill,&xsk->comp,&xsk->rx,&xsk->tx};
+	unsigned int i;
+
+	if(xsk->progfd>=0) {
+		// Detach the program only if it is still the one attached by xskOpen() (EEXIST is returned otherwise): the kernels older than 5.7 do not
+		//  support XDP_FLAGS_REPLACE (EINVAL), and the program is then detached without any check
+		if(xskSetLinkXdp(xsk->ifindex,-1,(xsk->xdpflags & ~XDP_FLAGS_UPDATE_IF_NOEXIST) | XDP_FLAGS_REPLACE,xsk->progfd)<0 && errno==EINVAL) {
+			xskSetLinkXdp(xsk->ifindex,-1,xsk->xdpflags & ~XDP_FLAGS_UPDATE_IF_NOEXIST,-1);
+		}
+		close(xsk->progfd);
+		xsk->progfd=-1;
+	}
+
+	if(xsk->mapfd>=0) {
+		close(xsk->mapfd);
+		xsk->mapfd=-1;
+	}
+
+	for(i=0;i<sizeof(rings)/sizeof(rings[0]);i++) {
+		if(rings[i]->map!=NULL) {
+			munmap(rings[i]->map,rings[i]->mapsize);
+			rings[i]->map=NULL;
+		}
+	}
+
+	if(xsk->descriptor>=0) {
+		close(xsk->descriptor);
+		xsk->descriptor=-1;
+	}
+
+	if(xsk->umem!=NULL) {
+		munmap(xsk->umem,xsk->umemsize);
+		xsk->umem=NULL;
+	}
+
+	free(xsk->freeframes);
+	xsk->freeframes=NULL;
+	xsk->nfree=0;
+}
+
+/**
+	\brief Get the descriptor of an AF_XDP socket
+
+	This function can be used to get the descriptor of the AF_XDP socket, for instance to wait for new frames with _poll()_, or
+	to insert it inside an XSKMAP of an XDP program loaded by the application (when _load_program_ is _false_ inside [struct xskparams](\ref xskparams)).
+
+	\param[in]	xsk 	Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+
+	\return The AF_XDP socket descriptor.
+**/
+int xskGetDescriptor(struct xsksocket *xsk) {
+	return xsk->descriptor;
+}
+
+/**
+	\brief Get a free UMEM frame for transmission
+
+	This function returns the pointer to a free UMEM frame, in which a frame (starting from the Ethernet header) can be directly written.
+	After writing it, xskSend() should be called (or xskRelease(), if the frame is not going to be sent).
+
+	If no frame is free, the frames which were already sent are reclaimed; if no frame is free even after that, NULL is returned:
+	xskFlush() should be called before trying again.
+
+	\param[in]	xsk 		Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[out]	maxsize 	If not NULL, the maximum size, in _bytes_, of the frame which can be written is stored here.
+
+	\return The pointer to the UMEM frame, or NULL if no frame is free.
+**/
+byte_t *xskGetFrame(struct xsksocket *xsk, size_t *maxsize) {
+	if(xsk->nfree==0) {
+		xskReapCompletions(xsk);
+
+		if(xsk->nfree==0) {
+			return NULL;
+		}
+	}
+
+	if(maxsize!=NULL) {
+		*maxsize=xsk->frame_size;
+	}
+
+	return xsk->umem+xsk->freeframes[--xsk->nfree];
+}
+
+/**
+	\brief Prepare a [struct framebuf](\ref framebuf) over a free UMEM frame
+
+	This function works like xskGetFrame(), but it initializes a [struct framebuf](\ref framebuf) over the UMEM frame,
+	so that a frame can be built in place (with framebufCopyPayload() and the [*EncapsulateInPlace()](\ref UDPencapsulateInPlace)
+	functions). After building it, xskSendFramebuf() should be called.
+
+	\param[in]	xsk 		Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[out]	fb 			Pointer to the [struct framebuf](\ref framebuf) to be initialized (it should not be freed with framebufFree()).
+	\param[in]	headroom 	Space, in _bytes_, to be reserved for the headers (for instance [ETH_IP_UDP_HEADROOM](\ref ETH_IP_UDP_HEADROOM)).
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_XSK_NOFRAME* -> no free UMEM frame is available
+	- *ERR_FRAMEBUF_HEADROOM* -> the headroom is larger than the UMEM frame
+**/
+rawsockerr_t xskGetFramebuf(struct xsksocket *xsk, struct framebuf *fb, size_t headroom) {
+	size_t maxsize;
+	byte_t *frame=xskGetFrame(xsk,&maxsize);
+	rawsockerr_t err;
+
+	if(frame==NULL) {
+		return ERR_XSK_NOFRAME;
+	}
+
+	err=framebufInit(fb,frame,maxsize,headroom);
+	if(err!=0) {
+		xskRelease(xsk,frame);
+	}
+
+	return err;
+}
+
+/**
+	\brief Queue a UMEM frame for transmission
+
+	This function puts a frame, stored inside a UMEM frame obtained with xskGetFrame() (or received with xskRecv()), inside the TX ring.
+	The frame is actually sent when xskFlush() is called. Once sent, the UMEM frame is automatically reused.
+
+	\param[in,out]	xsk 		Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[in]		frame 		Pointer to the first byte of the frame, inside a UMEM frame.
+	\param[in]		framesize 	Size, in _bytes_, of the frame.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_XSK_TXFULL* -> the TX ring is full, even after a flush
+	- *ERR_FRAMEBUF_NOSPACE* -> the frame is not completely contained inside a UMEM frame
+**/
+rawsockerr_t xskSend(struct xsksocket *xsk, byte_t *frame, size_t framesize) {
+	struct xdp_desc *desc;
+	uint64_t addr=frame-xsk->umem;
+
+	if(frame<xsk->umem || addr+framesize>XSK_FRAME_BASE(xsk,addr)+xsk->frame_size) {
+		return ERR_FRAMEBUF_NOSPACE;
+	}
+
+	if(xskRingFree(&xsk->tx)==0) {
+		xskFlush(xsk);
+
+		if(xskRingFree(&xsk->tx)==0) {
+			return ERR_XSK_TXFULL;
+		}
+	}
+
+	desc=&((struct xdp_desc *) xsk->tx.descs)[xsk->tx.cached_prod++ & xsk->tx.mask];
+	desc->addr=addr;
+	desc->len=framesize;
+	desc->options=0;
+
+	xsk->txpending++;
+
+	return 0;
+}
+
+/**
+	\brief Queue a frame built inside a [struct framebuf](\ref framebuf) for transmission
+
+	This function works like xskSend(), but the frame to be sent is described by a [struct framebuf](\ref framebuf),
+	previously prepared with xskGetFramebuf().
+
+	\param[in,out]	xsk 	Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[in]		fb 		Pointer to the [struct framebuf](\ref framebuf) containing the frame.
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error (see xskSend()).
+**/
+rawsockerr_t xskSendFramebuf(struct xsksocket *xsk, struct framebuf *fb) {
+	return xskSend(xsk,fb->data,fb->len);
+}
+
+/**
+	\brief Send the queued frames of an AF_XDP socket
+
+	This function passes to the kernel all the frames queued with xskSend(), waking it up if needed, and reclaims the UMEM frames
+	which were already sent.
+
+	\param[in,out]	xsk 	Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+
+	\return **0** if no error occurred, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_XSK_SEND* -> the kernel returned an error when woken up (_errno_ is set by _sendto()_)
+**/
+rawsockerr_t xskFlush(struct xsksocket *xsk) {
+	rawsockerr_t err=0;
+
+	if(xsk->txpending>0) {
+		__atomic_store_n(xsk->tx.producer,xsk->tx.cached_prod,__ATOMIC_RELEASE);
+		xsk->txoutstanding+=xsk->txpending;
+		xsk->txpending=0;
+	}
+
+	if(xsk->txoutstanding>0 && (__atomic_load_n(xsk->tx.flags,__ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)) {
+		// EAGAIN and EBUSY only mean that the kernel is still processing the previous frames
+		if(sendto(xsk->descriptor,NULL,0,MSG_DONTWAIT,NULL,0)<0 && errno!=EAGAIN && errno!=EBUSY && errno!=ENOBUFS) {
+			err=ERR_XSK_SEND;
+		}
+	}
+
+	xskReapCompletions(xsk);
+
+	return err;
+}
+
+/**
+	\brief Receive frames through an AF_XDP socket
+
+	This function fills up to _n_ [struct rxframe](\ref rxframe) structures with the frames received through the socket, which are stored in place
+	inside the UMEM. If no frame is available, it waits for new frames, up to _timeout_ milliseconds.
+
+	Each received frame should be given back to the socket with xskRelease() after processing it, or sent (e.g. after modifying it)
+	with xskSend().
+
+	\note AF_XDP does not provide any kernel timestamp: the _ts_ field of each [struct rxframe](\ref rxframe) is set to the time (_CLOCK_REALTIME_)
+	at which the frames were read from the RX ring.
+
+	\param[in,out]	xsk 		Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[out]		frames 		Array of [struct rxframe](\ref rxframe) to be filled in.
+	\param[in]		n 			Number of elements of _frames_.
+	\param[in]		timeout 	Maximum time to wait for new frames, in _milliseconds_ (**-1** to wait indefinitely, **0** to return immediately).
+
+	\return The number of received frames, or, in case of error, a [rawsockerr_t](\ref rawsockerr_t) error:
+	- *ERR_XSK_POLL* -> error while waiting for new frames (_errno_ is set by _poll()_)
+**/
+int xskRecv(struct xsksocket *xsk, struct rxframe *frames, unsigned int n, int timeout) {
+	struct xdp_desc *desc;
+	struct pollfd pfd;
+	struct timespec now;
+	uint32_t available;
+	unsigned int i;
+
+	xskRefill(xsk);
+
+	available=xskRingAvailable(&xsk->rx);
+
+	if(available==0) {
+		if(__atomic_load_n(xsk->fill.flags,__ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP) {
+			recvfrom(xsk->descriptor,NULL,0,MSG_DONTWAIT,NULL,NULL);
+		}
+
+		if(timeout==0) {
+			return 0;
+		}
+
+		pfd.fd=xsk->descriptor;
+		pfd.events=POLLIN;
+		pfd.revents=0;
+
+		if(poll(&pfd,1,timeout)<0) {
+			return ERR_XSK_POLL;
+		}
+
+		available=xskRingAvailable(&xsk->rx);
+		if(available==0) {
+			return 0;
+		}
+	}
+
+	if(available>n) {
+		available=n;
+	}
+
+	clock_gettime(CLOCK_REALTIME,&now);
+
+	for(i=0;i<available;i++) {
+		desc=&((struct xdp_desc *) xsk->rx.descs)[xsk->rx.cached_cons++ & xsk->rx.mask];
+
+		frames[i].data=xsk->umem+desc->addr;
+		frames[i].snaplen=desc->len;
+		frames[i].len=desc->len;
+		frames[i].ts=now;
+		frames[i].ifindex=xsk->ifindex;
+	}
+
+	__atomic_store_n(xsk->rx.consumer,xsk->rx.cached_cons,__ATOMIC_RELEASE);
+
+	return available;
+}
+
+/**
+	\brief Give back a UMEM frame to an AF_XDP socket
+
+	This function makes a UMEM frame, received with xskRecv() or obtained with xskGetFrame(), available again, once it is no longer needed.
+	It should not be called for the frames passed to xskSend(), as they are automatically reused after being sent.
+
+	\param[in,out]	xsk 	Pointer to a [struct xsksocket](\ref xsksocket), opened with xskOpen().
+	\param[in]		frame 	Pointer to any byte inside the UMEM frame.
+
+	\return None.
+**/
+void xskRelease(struct xsksocket *xsk, byte_t *frame) {
+	xsk->freeframes[xsk->nfree++]=XSK_FRAME_BASE(xsk,(uint64_t) (frame-xsk->umem));
+}
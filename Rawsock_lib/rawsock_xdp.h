@@ -0,0 +1,156 @@
+/** \file
+	AF_XDP (XSK) sockets support for the Rawsock library.
+
+	This file represents an optional module of the Rawsock library, allowing to send and receive frames through an AF_XDP socket,
+	i.e. a socket which exchanges the frames with the driver (or with the generic XDP layer) through a memory area shared with the kernel
+	(the _UMEM_), without going through the network stack.
+
+	The UMEM is divided into frames of the same size. Their ownership is passed between the application and the kernel through four rings:
+	the _fill_ ring (frames given to the kernel to store received frames), the _RX_ ring (received frames), the _TX_ ring (frames to be sent)
+	and the _completion_ ring (frames which were sent and can be reused).
+	All these rings are managed internally: the application only gets and gives back frames, using the same helpers it would use with a raw socket.
+
+	A minimal XDP program is automatically loaded and attached to the interface, redirecting to the AF_XDP socket all the frames received
+	on the chosen queue (all the frames received on the other queues are passed to the network stack as usual).
+
+	__Example of use (frame generation):__
+
+		struct xsksocket xsk;
+		struct framebuf fb;
+
+		xskOpen(&xsk,ifindex,0,NULL);
+
+		while(...) {
+			if(xskGetFramebuf(&xsk,&fb,ETH_IP_UDP_HEADROOM)!=0) {
+				xskFlush(&xsk); // No free frame: send the queued ones and reclaim the ones which were already sent
+				continue;
+			}
+
+			framebufCopyPayload(&fb,data,datasize);
+			UDPencapsulateInPlace(&fb,&udpHeader,ipaddrs);
+			IP4EncapsulateInPlace(&fb,&ipHeader);
+			etherEncapsulateInPlace(&fb,&etherHeader);
+
+			xskSendFramebuf(&xsk,&fb);
+		}
+
+		xskFlush(&xsk);
+		xskClose(&xsk);
+
+	__Example of use (reception):__
+
+		struct rxframe frames[N];
+
+		received=xskRecv(&xsk,frames,N,-1);
+
+		for(i=0;i<received;i++) {
+			payload=UDPgetpacketpointers(frames[i].data,&etherHeader,&IPheader,&udpHeader);
+			...
+			xskRelease(&xsk,frames[i].data); // Or xskSend(&xsk,frames[i].data,frames[i].len), to send it back after modifying it
+		}
+
+	By default, the socket works in _copy_ mode, and the XDP program is attached in _generic_ (SKB) mode: this works on any interface, including veth
+	pairs, without requiring any special support by the driver. Zero-copy and native (driver) XDP can be requested through [struct xskparams](\ref xskparams).
+
+	\warning This module requires Linux 5.4 or later (the sockets are bound with _XDP_USE_NEED_WAKEUP_), and it needs the _CAP_NET_ADMIN_ and _CAP_BPF_ (or _CAP_SYS_ADMIN_) capabilities.
+	It is optional: rawsock_xdp.c should be compiled only if this module is actually used.
+
+	The version number of this module is set to be the same as the main Rawsock library version number.
+
+	\version 0.3.4
+	\date 2020-04-24
+	\copyright Licensed under GPLv2
+**/
+#ifndef RAWSOCK_XDP_H_INCLUDED
+#define RAWSOCK_XDP_H_INCLUDED
+
+#include "rawsock.h"
+#include <linux/if_xdp.h>
+
+#define XSK_DEFAULT_FRAME_SIZE 2048 /**< __AF_XDP default setting__: size, in _bytes_, of each UMEM frame (it should be a power of two between 2048 and the page size, in order to work in any mode). */
+#define XSK_DEFAULT_FRAME_NR 4096 /**< __AF_XDP default setting__: number of UMEM frames. */
+#define XSK_DEFAULT_RING_SIZE 2048 /**< __AF_XDP default setting__: number of entries of each ring (it should be a power of two). */
+
+/**
+	\brief AF_XDP socket binding mode
+
+	Mode in which the AF_XDP socket is bound to the interface queue (see [struct xskparams](\ref xskparams)).
+**/
+typedef enum {
+	XSK_MODE_COPY,		/**< Copy mode: the frames are copied between the driver buffers and the UMEM (it always works, also with generic XDP). */
+	XSK_MODE_ZEROCOPY,	/**< Zero-copy mode: the driver directly uses the UMEM frames (it requires driver support and native XDP). */
+	XSK_MODE_AUTO		/**< Let the kernel choose: zero-copy if supported, copy mode otherwise. */
+} xskmode_t;
+
+/**
+	\brief AF_XDP socket settings
+
+	Structure containing the settings of a [struct xsksocket](\ref xsksocket), to be passed to xskOpen().
+	It can be initialized with the default values through xskParamsDefault().
+**/
+struct xskparams {
+	unsigned int frame_size; /**< Size, in _bytes_, of each UMEM frame. */
+	unsigned int frame_nr; /**< Number of UMEM frames. */
+	unsigned int ring_size; /**< Number of entries of the fill, completion, RX and TX rings (it should be a power of two). */
+	xskmode_t mode; /**< Socket binding mode (default: [XSK_MODE_COPY](\ref xskmode_t)). */
+	bool native; /**< _true_ to attach the XDP program in native (driver) mode, _false_ to attach it in generic (SKB) mode (default: _false_). */
+	bool load_program; /**< _true_ to load and attach the redirect XDP program (default: _true_); if _false_, the application should redirect the frames to the socket by itself (see xskGetDescriptor()). */
+};
+
+/**
+	\brief AF_XDP ring
+
+	Structure describing one of the four rings of an AF_XDP socket. It is managed internally by the AF_XDP module.
+**/
+struct xskring {
+	uint32_t *producer; /**< Pointer to the producer index, shared with the kernel. */
+	uint32_t *consumer; /**< Pointer to the consumer index, shared with the kernel. */
+	uint32_t *flags; /**< Pointer to the ring flags, shared with the kernel. */
+	void *descs; /**< Pointer to the ring entries. */
+	void *map; /**< Memory-mapped area containing the ring. */
+	size_t mapsize; /**< Size, in _bytes_, of _map_. */
+	uint32_t mask; /**< Number of entries of the ring, minus one. */
+	uint32_t cached_prod; /**< Local copy of the producer index. */
+	uint32_t cached_cons; /**< Local copy of the consumer index. */
+};
+
+/**
+	\brief AF_XDP socket descriptor
+
+	Structure describing an AF_XDP socket, opened with xskOpen(). Its fields should not be modified directly by the user.
+**/
+struct xsksocket {
+	int descriptor; /**< AF_XDP socket descriptor. */
+	int ifindex; /**< Index of the interface the socket is bound to. */
+	unsigned int queue; /**< Queue the socket is bound to. */
+	byte_t *umem; /**< UMEM area. */
+	size_t umemsize; /**< Size, in _bytes_, of _umem_. */
+	unsigned int frame_size; /**< Size, in _bytes_, of each UMEM frame. */
+	unsigned int frame_nr; /**< Number of UMEM frames. */
+	struct xskring fill; /**< Fill ring. */
+	struct xskring comp; /**< Completion ring. */
+	struct xskring rx; /**< RX ring. */
+	struct xskring tx; /**< TX ring. */
+	uint64_t *freeframes; /**< Stack of the UMEM frames which are currently owned by the application and not used. */
+	unsigned int nfree; /**< Number of elements of _freeframes_. */
+	unsigned int txpending; /**< Number of frames put in the TX ring after the last flush. */
+	unsigned int txoutstanding; /**< Number of frames put in the TX ring, whose completion has not been received yet. */
+	int progfd; /**< Descriptor of the XDP program (or **-1** if it was not loaded). */
+	int mapfd; /**< Descriptor of the XSKMAP used by the XDP program (or **-1** if it was not created). */
+	uint32_t xdpflags; /**< Flags used to attach the XDP program. */
+};
+
+void xskParamsDefault(struct xskparams *params);
+rawsockerr_t xskOpen(struct xsksocket *xsk, int ifindex, unsigned int queue, struct xskparams *params);
+void xskClose(struct xsksocket *xsk);
+int xskGetDescriptor(struct xsksocket *xsk);
+
+byte_t *xskGetFrame(struct xsksocket *xsk, size_t *maxsize);
+rawsockerr_t xskGetFramebuf(struct xsksocket *xsk, struct framebuf *fb, size_t headroom);
+rawsockerr_t xskSend(struct xsksocket *xsk, byte_t *frame, size_t framesize);
+rawsockerr_t xskSendFramebuf(struct xsksocket *xsk, struct framebuf *fb);
+rawsockerr_t xskFlush(struct xsksocket *xsk);
+
+int xskRecv(struct xsksocket *xsk, struct rxframe *frames, unsigned int n, int timeout);
+void xskRelease(struct xsksocket *xsk, byte_t *frame);
+#endif